@@ -190,6 +190,7 @@ struct switch_core_session {
 	switch_core_video_thread_callback_func_t video_read_callback;
 	void *video_read_user_data;
 	switch_slin_data_t *sdata;
+	switch_media_copy_stats_t copy_stats;
 };
 
 struct switch_media_bug {
@@ -128,6 +128,10 @@
 #include "switch_buffer.h"
 #include "switch_event.h"
 #include "switch_resample.h"
+#include "switch_simd.h"
+#include "switch_slab.h"
+#include "switch_expand.h"
+#include "switch_call_registry.h"
 #include "switch_ivr.h"
 #include "switch_rtp.h"
 #include "switch_log.h"
@@ -1110,6 +1110,21 @@ SWITCH_DECLARE(int32_t) switch_sockaddr_get_family(switch_sockaddr_t *sa);
 SWITCH_DECLARE(switch_status_t) switch_sockaddr_ip_get(char **addr, switch_sockaddr_t *sa);
 SWITCH_DECLARE(int) switch_sockaddr_equal(const switch_sockaddr_t *sa1, const switch_sockaddr_t *sa2);
 
+/**
+ * Fill a switch_sockaddr_t from a native OS socket address (as returned by recvfrom/recvmmsg).
+ * @param sa The address to fill.
+ * @param os_sa The native struct sockaddr.
+ * @param os_salen The length of os_sa.
+ */
+SWITCH_DECLARE(switch_status_t) switch_sockaddr_set_os(switch_sockaddr_t *sa, const void *os_sa, uint32_t os_salen);
+
+/**
+ * Get the native OS socket address (struct sockaddr) of a switch_sockaddr_t.
+ * @param sa The address.
+ * @param os_salen Optional, filled with the length of the native address.
+ */
+SWITCH_DECLARE(const void *) switch_sockaddr_get_os(switch_sockaddr_t *sa, uint32_t *os_salen);
+
 
 /**
  * Create apr_sockaddr_t from hostname, address family, and port.
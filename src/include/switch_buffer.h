@@ -74,6 +74,16 @@ SWITCH_DECLARE(switch_status_t) switch_buffer_create(_In_ switch_memory_pool_t *
 SWITCH_DECLARE(switch_status_t) switch_buffer_create_dynamic(_Out_ switch_buffer_t **buffer, _In_ switch_size_t blocksize, _In_ switch_size_t start_len,
 															 _In_ switch_size_t max_len);
 
+/*! \brief Allocate a new lock free ring buffer for exactly one writer thread and one reader thread
+ * \param buffer returned pointer to the new buffer
+ * \param len minimum capacity, rounded up to a power of two
+ * \return status
+ * \note the usual api works on it without any mutex: write, zwrite and slide_write belong to the writer,
+ *       read, peek, toss and zero to the reader and inuse/freespace are safe from either side.
+ *       A write that does not fit is refused as a whole, zwrite and slide_write will not make room for it.
+ */
+SWITCH_DECLARE(switch_status_t) switch_buffer_create_spsc(_Out_ switch_buffer_t **buffer, _In_ switch_size_t len);
+
 SWITCH_DECLARE(void) switch_buffer_add_mutex(_In_ switch_buffer_t *buffer, _In_ switch_mutex_t *mutex);
 SWITCH_DECLARE(void) switch_buffer_lock(_In_ switch_buffer_t *buffer);
 SWITCH_DECLARE(switch_status_t) switch_buffer_trylock(_In_ switch_buffer_t *buffer);
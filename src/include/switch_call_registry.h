@@ -0,0 +1,177 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_call_registry.h -- In memory registry of channels and calls
+ *
+ */
+/*! \file switch_call_registry.h
+    \brief In memory registry of channels and calls
+
+	The core keeps one row per channel and one per bridged call, built from the same CHANNEL_* events that
+	used to be written to the channels and calls tables.  Rows are indexed by uuid, presence_id, call_uuid
+	and hostname and are handed to callers through the usual switch_core_db_callback_func_t, with the
+	columns in the same order and under the same names as the tables and the basic_calls and detailed_calls
+	views, so code written against the tables can move over without touching its callbacks.
+
+	The tables themselves are only written when core-channel-sql-export is enabled in switch.conf, and then
+	a channel is written once per second at most no matter how many events it saw in between.
+*/
+
+#ifndef SWITCH_CALL_REGISTRY_H
+#define SWITCH_CALL_REGISTRY_H
+
+#include <switch.h>
+
+SWITCH_BEGIN_EXTERN_C
+/*!
+  \defgroup call_registry Call Registry
+  \ingroup core1
+  \{
+*/
+
+/*! the columns of a channel row, in the order of the channels table */
+typedef enum {
+	SCR_COL_UUID,
+	SCR_COL_DIRECTION,
+	SCR_COL_CREATED,
+	SCR_COL_CREATED_EPOCH,
+	SCR_COL_NAME,
+	SCR_COL_STATE,
+	SCR_COL_CID_NAME,
+	SCR_COL_CID_NUM,
+	SCR_COL_IP_ADDR,
+	SCR_COL_DEST,
+	SCR_COL_APPLICATION,
+	SCR_COL_APPLICATION_DATA,
+	SCR_COL_DIALPLAN,
+	SCR_COL_CONTEXT,
+	SCR_COL_READ_CODEC,
+	SCR_COL_READ_RATE,
+	SCR_COL_READ_BIT_RATE,
+	SCR_COL_WRITE_CODEC,
+	SCR_COL_WRITE_RATE,
+	SCR_COL_WRITE_BIT_RATE,
+	SCR_COL_SECURE,
+	SCR_COL_HOSTNAME,
+	SCR_COL_PRESENCE_ID,
+	SCR_COL_PRESENCE_DATA,
+	SCR_COL_CALLSTATE,
+	SCR_COL_CALLEE_NAME,
+	SCR_COL_CALLEE_NUM,
+	SCR_COL_CALLEE_DIRECTION,
+	SCR_COL_CALL_UUID,
+	SCR_COL_SENT_CALLEE_NAME,
+	SCR_COL_SENT_CALLEE_NUM,
+	SCR_COL_INITIAL_CID_NAME,
+	SCR_COL_INITIAL_CID_NUM,
+	SCR_COL_INITIAL_IP_ADDR,
+	SCR_COL_INITIAL_DEST,
+	SCR_COL_INITIAL_DIALPLAN,
+	SCR_COL_INITIAL_CONTEXT,
+	SCR_COL_MAX
+} switch_call_registry_col_t;
+
+/*! the shape of the rows a query returns */
+typedef enum {
+	/*! one row per channel, the columns of switch_call_registry_col_t */
+	SCR_VIEW_CHANNELS,
+	/*! one row per call or unbridged channel, the columns of the basic_calls view */
+	SCR_VIEW_CALLS,
+	/*! as SCR_VIEW_CALLS with the columns of the detailed_calls view */
+	SCR_VIEW_DETAILED_CALLS,
+	/*! SCR_VIEW_CALLS limited to rows with a b leg */
+	SCR_VIEW_BRIDGED_CALLS,
+	/*! SCR_VIEW_DETAILED_CALLS limited to rows with a b leg */
+	SCR_VIEW_DETAILED_BRIDGED_CALLS
+} switch_call_registry_view_t;
+
+/*! the index a query looks its key up in, calls are matched on their a leg */
+typedef enum {
+	SCR_INDEX_NONE,
+	SCR_INDEX_UUID,
+	SCR_INDEX_PRESENCE_ID,
+	SCR_INDEX_CALL_UUID,
+	SCR_INDEX_HOSTNAME
+} switch_call_registry_index_t;
+
+SWITCH_DECLARE(void) switch_call_registry_init(switch_memory_pool_t *pool);
+SWITCH_DECLARE(void) switch_call_registry_shutdown(void);
+
+/*!
+  \brief Apply a channel event to the registry
+  \param event a CHANNEL_*, CALL_UPDATE, CALL_SECURE, CODEC or SHUTDOWN event, anything else is ignored
+  \note the core feeds every event it sees through here, it is exposed for callers replaying events of their own
+*/
+SWITCH_DECLARE(void) switch_call_registry_apply_event(switch_event_t *event);
+
+/*!
+  \brief Run a callback over the rows of a view
+  \param view the rows to return
+  \param index the index to look key up in, SCR_INDEX_NONE for every row
+  \param key the value to match, ignored with SCR_INDEX_NONE
+  \param callback called per row in creation order, NULL columns are NULL pointers, a non zero return stops the walk
+  \param pdata passed to the callback
+  \return the number of rows handed to the callback, or the number that matched when callback is NULL
+  \note the registry is read locked for the duration, the callback must not feed events back into it
+*/
+SWITCH_DECLARE(uint32_t) switch_call_registry_query(switch_call_registry_view_t view, switch_call_registry_index_t index, const char *key,
+													 switch_core_db_callback_func_t callback, void *pdata);
+
+/*!
+  \brief Copy one column of a channel
+  \param uuid the channel uuid
+  \param col the column
+  \return a copy to free(), or NULL if the channel or the value is unknown
+*/
+SWITCH_DECLARE(char *) switch_call_registry_get(const char *uuid, switch_call_registry_col_t col);
+
+/*!
+  \brief The column name used in the channels table and the views
+*/
+SWITCH_DECLARE(const char *) switch_call_registry_col_name(switch_call_registry_col_t col);
+
+/*!
+  \brief Write the channels that changed since the last call to the channels table
+  \note does nothing unless core-channel-sql-export is enabled, the core sql thread calls it once a second
+*/
+SWITCH_DECLARE(void) switch_call_registry_export(void);
+
+///\}
+
+SWITCH_END_EXTERN_C
+#endif
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
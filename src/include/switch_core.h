@@ -831,6 +831,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_thread_pool_launch(switch_co
 */
 	 _Ret_ SWITCH_DECLARE(switch_channel_t *) switch_core_session_get_channel(_In_ switch_core_session_t *session);
 
+/*! 
+  \brief Retrieve the media payload copy counters of a session, callers may add to them
+  \param session the session to retrieve from
+  \return a pointer to the counters
+*/
+	 _Ret_ SWITCH_DECLARE(switch_media_copy_stats_t *) switch_core_session_get_copy_stats(_In_ switch_core_session_t *session);
+
 /*! 
   \brief Signal a session's state machine thread that a state change has occured
 */
@@ -2382,6 +2389,12 @@ SWITCH_DECLARE(void) switch_time_set_timerfd(int enable);
 SWITCH_DECLARE(void) switch_time_set_nanosleep(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_matrix(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_cond_yield(switch_bool_t enable);
+/*!
+  \brief Write the counters of the "wheel" timer (timers, wake groups, tick cost and jitter) to a stream
+  \param stream the stream to write to
+  \param reset clear the counters after reporting them
+*/
+SWITCH_DECLARE(void) switch_time_wheel_stats(switch_stream_handle_t *stream, switch_bool_t reset);
 SWITCH_DECLARE(void) switch_time_set_use_system_time(switch_bool_t enable);
 SWITCH_DECLARE(uint32_t) switch_core_min_dtmf_duration(uint32_t duration);
 SWITCH_DECLARE(uint32_t) switch_core_max_dtmf_duration(uint32_t duration);
@@ -2656,6 +2669,25 @@ SWITCH_DECLARE(void) switch_sql_queue_manager_resume(switch_sql_queue_manager_t
 SWITCH_DECLARE(int) switch_sql_queue_manager_size(switch_sql_queue_manager_t *qm, uint32_t index);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_confirm(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup);
+/*!
+  \brief Register a named statement with a queue manager so callers can queue parameters instead of sql text
+  \param qm the queue manager
+  \param name the name used with switch_sql_queue_manager_push_stmt()
+  \param sql the statement, with a ? for each parameter
+  \return SWITCH_STATUS_SUCCESS, or SWITCH_STATUS_FALSE if the name is already taken by a different statement
+  \note the core db compiles the statement once on the queue thread and rebinds it per row, other backends get the parameters quoted into the text
+*/
+SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_prepare(switch_sql_queue_manager_t *qm, const char *name, const char *sql);
+/*!
+  \brief Queue one execution of a statement registered with switch_sql_queue_manager_prepare()
+  \param qm the queue manager
+  \param name the statement name
+  \param pos the queue index
+  \param argc the number of parameters, which must match the statement
+  \param argv the parameters, copied before return, NULL entries bind as NULL
+  \return SWITCH_STATUS_SUCCESS if queued or dropped while paused, SWITCH_STATUS_FALSE for an unknown statement
+*/
+SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_stmt(switch_sql_queue_manager_t *qm, const char *name, uint32_t pos, int argc, const char **argv);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_destroy(switch_sql_queue_manager_t **qmp);
 SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_init_name(const char *name,
 																   switch_sql_queue_manager_t **qmp, 
@@ -73,6 +73,8 @@ typedef enum {
 	SCMF_RTP_AUTOFLUSH_DURING_BRIDGE,
 	SCMF_MULTI_ANSWER_AUDIO,
 	SCMF_MULTI_ANSWER_VIDEO,
+	SCMF_RTP_BATCH_RECV,
+	SCMF_RTP_BATCH_SEND,
 	SCMF_MAX
 } switch_core_media_flag_t;
 
@@ -41,11 +41,12 @@
 	Builtin events are fired by the core at various points in the execution of the application and custom events can be 
 	reserved and registered so events from an external module can be rendered and handled by an another even handler module.
 
-	If the work time to process an event in a callback is anticipated to grow beyond a very small amount of time it is recommended
-	that you implement your own handler thread and FIFO queue so you can accept the events in the callback and queue them 
-	into your own thread rather than tie up the delivery agent.  It is in the opinion of the author that such a necessity 
-	should be judged on a per-use basis and therefore it does not fall within the scope of this system to provide that 
-	functionality at a core level.
+	If the work time to process an event in a callback is anticipated to grow beyond a very small amount of time, bind with
+	switch_event_bind_queued() instead.  The binding then gets its own bounded queues and worker threads so a slow consumer
+	only ever holds up itself.  Events of the same channel (Unique-ID) always land on the same worker so they stay in order.
+
+	Once an event is fired it is sealed (EF_SEALED) and switch_event_dup() of it shares the headers instead of copying them.
+	Treat the headers of an event you did not create as read only; modify them through the switch_event_* calls, never in place.
 
 */
 
@@ -74,6 +75,8 @@ SWITCH_BEGIN_EXTERN_C
 	/*! hash of the header name */
 	unsigned long hash;
 	struct switch_event_header *next;
+	/*! the header before this one */
+	struct switch_event_header *prev;
 };
 
 /*! \brief Representation of an event */
@@ -100,6 +103,10 @@ struct switch_event {
 	unsigned long key;
 	struct switch_event *next;
 	int flags;
+	/*! the memory the headers live in, shared between copies of a sealed event */
+	struct switch_event_arena *arena;
+	/*! name index over the headers, see switch_event_index_headers() */
+	struct switch_event_index *index;
 };
 
 typedef struct switch_serial_event_s {
@@ -119,7 +126,8 @@ typedef struct switch_serial_event_header_s {
 typedef enum {
 	EF_UNIQ_HEADERS = (1 << 0),
 	EF_NO_CHAT_EXEC = (1 << 1),
-	EF_DEFAULT_ALLOW = (1 << 2)
+	EF_DEFAULT_ALLOW = (1 << 2),
+	EF_SEALED = (1 << 3)
 } switch_event_flag_t;
 
 
@@ -175,6 +183,15 @@ _Ret_opt_z_ SWITCH_DECLARE(char *) switch_event_get_header_idx(switch_event_t *e
 
 SWITCH_DECLARE(switch_status_t) switch_event_rename_header(switch_event_t *event, const char *header_name, const char *new_header_name);
 
+/*!
+  \brief Keep a hash index over the header names of an event
+  \param event the event to index
+  \note Lookups, replacements and deletes become O(1) regardless of how many headers the event has,
+        the headers keep their order.  Worth it for long lived events that are read a lot (channel variables),
+        copies made with switch_event_dup() are not indexed.
+*/
+SWITCH_DECLARE(void) switch_event_index_headers(switch_event_t *event);
+
 /*!
   \brief Retrieve the body value from an event
   \param event the event to read the body from
@@ -268,6 +285,25 @@ SWITCH_DECLARE(switch_status_t) switch_event_get_custom_events(switch_console_ca
 */
 SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, switch_event_types_t event, const char *subclass_name,
 															switch_event_callback_t callback, void *user_data, switch_event_node_t **node);
+/*!
+  \brief Bind an event callback that runs on its own worker threads instead of the dispatch thread
+  \param id an identifier token of the binder
+  \param event the event enumeration to bind to
+  \param subclass_name the event subclass to bind to in the case if SWITCH_EVENT_CUSTOM
+  \param callback the callback functon to bind
+  \param user_data optional user specific data to pass whenever the callback is invoked
+  \param queue_len the number of events each worker may have waiting, rounded up to a power of two
+  \param workers the number of worker threads, events are spread over them by channel so each channel stays in order
+  \param overflow what to do when a worker's queue is full
+  \param node bind handle to later remove the binding.
+  \return SWITCH_STATUS_SUCCESS if the event was binded
+  \note switch_event_unbind() lets the workers finish what is already queued before it returns
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_bind_queued(const char *id, switch_event_types_t event, const char *subclass_name,
+														 switch_event_callback_t callback, void *user_data,
+														 uint32_t queue_len, uint32_t workers, switch_event_overflow_t overflow,
+														 switch_event_node_t **node);
+
 /*!
   \brief Unbind a bound event consumer
   \param node node to unbind
@@ -276,6 +312,69 @@ SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, swit
 SWITCH_DECLARE(switch_status_t) switch_event_unbind(switch_event_node_t **node);
 SWITCH_DECLARE(switch_status_t) switch_event_unbind_callback(switch_event_callback_t callback);
 
+/*!
+  \brief Create an empty event filter, an empty filter passes every event
+  \param filter the new filter
+  \return SWITCH_STATUS_SUCCESS
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_filter_create(switch_event_filter_t **filter);
+SWITCH_DECLARE(void) switch_event_filter_destroy(switch_event_filter_t **filter);
+
+/*!
+  \brief Add a rule to a filter, regex rules are compiled here and never again
+  \param filter the filter to add to
+  \param header_name the header the rule looks at, events without it are not affected by the rule
+  \param op how the value is compared
+  \param value the value, prefix or regex to compare with
+  \param exclude SWITCH_TRUE to reject events that match instead of passing them
+  \return SWITCH_STATUS_SUCCESS, or SWITCH_STATUS_FALSE if the regex does not compile, the rule is then kept and never matches
+
+  An event passes when any include rule matches and no exclude rule does.
+  A filter with only exclude rules rejects everything, the same as the event socket filters.
+  In match all mode (switch_event_filter_set_match_all()) every rule whose header is present must agree instead.
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_filter_add(switch_event_filter_t *filter, const char *header_name, switch_event_filter_op_t op,
+														const char *value, switch_bool_t exclude);
+
+SWITCH_DECLARE(void) switch_event_filter_set_match_all(switch_event_filter_t *filter, switch_bool_t match_all);
+
+/*!
+  \brief Add a rule written the way event socket filters are, an optional leading + or - then a value or a /regex/
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_filter_add_string(switch_event_filter_t *filter, const char *header_name, const char *value);
+
+/*!
+  \brief Compile every header of an event holding event socket style filters
+  \param filter the new filter, NULL when the event has no headers
+  \param filters the header names and values to compile
+  \param match_all SWITCH_TRUE for the rules of mod_erlang_event where every present header has to agree
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_filter_create_from_event(switch_event_filter_t **filter, switch_event_t *filters, switch_bool_t match_all);
+
+/*!
+  \brief Check an event against a filter
+  \return SWITCH_TRUE if the event passes
+*/
+SWITCH_DECLARE(switch_bool_t) switch_event_filter_match(switch_event_filter_t *filter, switch_event_t *event);
+
+/*!
+  \brief Attach a filter to a binding so only passing events reach its callback or queue
+  \param node the binding
+  \param filter the filter, the binding owns it from here on, NULL removes the current one
+  \return SWITCH_STATUS_SUCCESS
+  \note the filter runs on the dispatch thread before anything is copied, do not call this from an event callback
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_bind_filter(switch_event_node_t *node, switch_event_filter_t *filter);
+
+/*!
+  \brief Write the depth, high water mark and queued, delivered and dropped counts of every queued binding
+  \param stream the stream to write to
+  \param reset clear the counters afterwards
+*/
+SWITCH_DECLARE(void) switch_event_queue_stats(switch_stream_handle_t *stream, switch_bool_t reset);
+SWITCH_DECLARE(const char *) switch_event_overflow_str(switch_event_overflow_t overflow);
+SWITCH_DECLARE(switch_event_overflow_t) switch_event_overflow_from_str(const char *str);
+
 /*!
   \brief Render the name of an event id enumeration
   \param event the event id to render the name of
@@ -316,6 +415,31 @@ SWITCH_DECLARE(switch_status_t) switch_event_binary_serialize(switch_event_t *ev
 SWITCH_DECLARE(switch_status_t) switch_event_serialize(switch_event_t *event, char **str, switch_bool_t encode);
 SWITCH_DECLARE(switch_status_t) switch_event_serialize_json(switch_event_t *event, char **str);
 SWITCH_DECLARE(switch_status_t) switch_event_serialize_json_obj(switch_event_t *event, cJSON **json);
+
+/*!
+  \brief Render an event in the text format of switch_event_serialize() straight into a stream
+  \param event the event to render
+  \param stream the stream to append to, grown as needed (see SWITCH_STANDARD_STREAM)
+  \param encode url encode the headers
+  \return SWITCH_STATUS_SUCCESS if the operation was successful
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_serialize_stream(switch_event_t *event, switch_stream_handle_t *stream, switch_bool_t encode);
+
+/*!
+  \brief Render an event as the JSON text of switch_event_serialize_json() straight into a stream, no cJSON tree is built
+  \param event the event to render
+  \param stream the stream to append to
+  \return SWITCH_STATUS_SUCCESS if the operation was successful
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_serialize_json_stream(switch_event_t *event, switch_stream_handle_t *stream);
+
+/*!
+  \brief Render an event as the XML text switch_xml_toxml() makes of switch_event_xmlize() straight into a stream
+  \param event the event to render
+  \param stream the stream to append to
+  \return SWITCH_STATUS_SUCCESS if the operation was successful
+*/
+SWITCH_DECLARE(switch_status_t) switch_event_xmlize_stream(switch_event_t *event, switch_stream_handle_t *stream);
 SWITCH_DECLARE(switch_status_t) switch_event_create_json(switch_event_t **event, const char *json);
 SWITCH_DECLARE(switch_status_t) switch_event_create_brackets(char *data, char a, char b, char c, switch_event_t **event, char **new_data, switch_bool_t dup);
 SWITCH_DECLARE(switch_status_t) switch_event_create_array_pair(switch_event_t **event, char **names, char **vals, int len);
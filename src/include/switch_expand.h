@@ -0,0 +1,156 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_expand.h -- Compiled variable expansion templates
+ *
+ */
+/*! \file switch_expand.h
+    \brief Compiled variable expansion templates
+
+	switch_channel_expand_variables() and switch_event_expand_headers() see the same handful of strings
+	(dialplan actions, dial strings, profile params) on every call.  Instead of parsing the ${...} and $${...}
+	syntax each time, a string is compiled once into a list of ops (literal text, variable references and
+	api calls) and kept in a cache keyed by the string itself.  Expanding is then a walk over the ops.
+
+	The ops record exactly what the parser would have found, names and arguments that contain expansions
+	of their own are flagged and expanded at run time the same way as before.
+*/
+
+#ifndef SWITCH_EXPAND_H
+#define SWITCH_EXPAND_H
+
+#include <switch.h>
+
+SWITCH_BEGIN_EXTERN_C
+/*!
+  \defgroup expand Variable Expansion Templates
+  \ingroup core1
+  \{
+*/
+
+typedef enum {
+	/*! text copied to the output as is */
+	SWITCH_EXPAND_LITERAL,
+	/*! ${name} */
+	SWITCH_EXPAND_VAR,
+	/*! $${name} */
+	SWITCH_EXPAND_GLOBAL,
+	/*! ${api args} or ${api(args)} */
+	SWITCH_EXPAND_API
+} switch_expand_op_type_t;
+
+typedef struct switch_expand_op_s {
+	switch_expand_op_type_t type;
+	/*! the literal text, the variable name or the api command */
+	char *str;
+	/*! length of a literal */
+	switch_size_t len;
+	/*! the api arguments */
+	char *arg;
+	/*! ${name:offset:length} and ${name[idx]}, parsed up front when the name is fixed */
+	int offset;
+	int ooffset;
+	int idx;
+	/*! str or arg contain expansions of their own */
+	switch_bool_t expand_str;
+	switch_bool_t expand_arg;
+} switch_expand_op_t;
+
+typedef struct switch_expand_template_s {
+	switch_expand_op_t *ops;
+	uint32_t op_count;
+	/*! the bytes the literals contribute, a starting point for the output size */
+	switch_size_t literal_len;
+	/*! the cache holds one reference, every expansion in progress another */
+	switch_atomic_t refs;
+} switch_expand_template_t;
+
+SWITCH_DECLARE(void) switch_expand_init(switch_memory_pool_t *pool);
+SWITCH_DECLARE(void) switch_expand_shutdown(void);
+
+/*!
+  \brief Parse an expansion string into a template
+  \param in the string as passed to switch_channel_expand_variables()
+  \return the template, free it with switch_expand_template_release()
+*/
+SWITCH_DECLARE(switch_expand_template_t *) switch_expand_template_compile(const char *in);
+
+/*!
+  \brief Get the cached template for a string, compiling and caching it on first use
+  \param in the string as passed to switch_channel_expand_variables()
+  \return the template or NULL when the string is not cached (too long, cache not running),
+          release it with switch_expand_template_release() when done
+*/
+SWITCH_DECLARE(switch_expand_template_t *) switch_expand_template_get(const char *in);
+SWITCH_DECLARE(void) switch_expand_template_release(switch_expand_template_t **tpl);
+
+/*!
+  \brief Set up a malloc backed stream sized for the output of a template
+  \param stream the stream to set up, its data belongs to the caller afterwards
+  \param tpl the template about to be expanded into it
+*/
+SWITCH_DECLARE(void) switch_expand_stream_init(switch_stream_handle_t *stream, switch_expand_template_t *tpl);
+
+/*!
+  \brief Cut a substring out of a variable value the way ${name:offset:length} does
+  \param offset where to start, negative counts from the end
+  \param ooffset how many bytes to keep, 0 keeps the rest
+  \param val the value, updated to the start of the substring
+  \param len the length of the value, updated to the length of the substring
+*/
+SWITCH_DECLARE(void) switch_expand_substr(int offset, int ooffset, const char **val, switch_size_t *len);
+
+/*!
+  \brief Split the :offset:length and [idx] suffixes off a variable name in place
+  \param name the variable name, cut short at the first suffix
+  \param offset set from :offset
+  \param ooffset set from :offset:length
+  \param idx set from [idx]
+*/
+SWITCH_DECLARE(void) switch_expand_parse_name(char *name, int *offset, int *ooffset, int *idx);
+
+/*!
+  \brief Write the number of cached templates, hits and misses
+  \param stream the stream to write to
+  \param reset clear the counters and drop the cached templates
+*/
+SWITCH_DECLARE(void) switch_expand_stats(switch_stream_handle_t *stream, switch_bool_t reset);
+///\}
+
+SWITCH_END_EXTERN_C
+#endif
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
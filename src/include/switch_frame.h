@@ -75,6 +75,8 @@ SWITCH_BEGIN_EXTERN_C
 	void *user_data;
 	payload_map_t *pmap;
 	switch_image_t *img;
+	/*! reference counted storage holding packet/data, shared between clones */
+	switch_frame_data_t *ref;
 };
 
 SWITCH_END_EXTERN_C
@@ -40,6 +40,7 @@ SWITCH_BEGIN_EXTERN_C
  * @ingroup FREESWITCH
  * @{
  */
+/*! a compiled pattern, free it with switch_regex_safe_free() */
 	typedef struct real_pcre switch_regex_t;
 
 SWITCH_DECLARE(switch_regex_t *) switch_regex_compile(const char *pattern, int options, const char **errorptr, int *erroroffset,
@@ -49,6 +50,19 @@ SWITCH_DECLARE(int) switch_regex_copy_substring(const char *subject, int *ovecto
 
 SWITCH_DECLARE(void) switch_regex_free(void *data);
 
+/*!
+ \brief Compile an expression once so it can be run many times with switch_regex_exec()
+ \param expression a regex in any form switch_regex_perform() accepts (plain, /re/flags or _asterisk pattern)
+ \return the compiled regex, shared through the pattern cache, release it with switch_regex_safe_free(), or NULL if it does not compile
+*/
+SWITCH_DECLARE(switch_regex_t *) switch_regex_compile_expression(const char *expression);
+
+/*!
+ \brief Run a compiled regex
+ \return the number of captured substrings plus one, 0 when there is no match
+*/
+SWITCH_DECLARE(int) switch_regex_exec(switch_regex_t *re, const char *field, int *ovector, uint32_t olen);
+
 SWITCH_DECLARE(int) switch_regex_perform(const char *field, const char *expression, switch_regex_t **new_re, int *ovector, uint32_t olen);
 SWITCH_DECLARE(void) switch_perform_substitution(switch_regex_t *re, int match_count, const char *data, const char *field_data,
 												 char *substituted, switch_size_t len, int *ovector);
@@ -76,6 +90,16 @@ SWITCH_DECLARE(void) switch_capture_regex(switch_regex_t *re, int match_count, c
 SWITCH_DECLARE_NONSTD(void) switch_regex_set_var_callback(const char *var, const char *val, void *user_data);
 SWITCH_DECLARE_NONSTD(void) switch_regex_set_event_header_callback(const char *var, const char *val, void *user_data);
 
+SWITCH_DECLARE(void) switch_regex_init(switch_memory_pool_t *pool);
+SWITCH_DECLARE(void) switch_regex_shutdown(void);
+
+/*!
+ \brief Write the number of cached patterns, hits, misses and evictions
+ \param stream the stream to write to
+ \param reset clear the counters and drop the cached patterns
+*/
+SWITCH_DECLARE(void) switch_regex_cache_stats(switch_stream_handle_t *stream, switch_bool_t reset);
+
 #define switch_regex_safe_free(re)	if (re) {\
 				switch_regex_free(re);\
 				re = NULL;\
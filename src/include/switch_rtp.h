@@ -204,6 +204,26 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_remote_ssrc(switch_rtp_t *rtp_ses
 */
 SWITCH_DECLARE(switch_port_t) switch_rtp_set_end_port(switch_port_t port);
 
+/*!
+  \brief Set the number of batched receive poller threads
+  \param threads number of threads (0 disables batched receive)
+  \note Sessions opt in with SWITCH_RTP_FLAG_BATCH_RECV, the pollers are started on first use
+*/
+SWITCH_DECLARE(void) switch_rtp_set_batch_recv_threads(uint32_t threads);
+
+/*!
+  \brief Set the number of batched send threads
+  \param threads number of threads (0 disables batched send)
+  \note Sessions opt in with SWITCH_RTP_FLAG_BATCH_SEND, the senders are started on first use
+*/
+SWITCH_DECLARE(void) switch_rtp_set_batch_send_threads(uint32_t threads);
+
+/*!
+  \brief Write the batched receive/send counters (packets, syscalls, packets per syscall) to a stream
+  \param stream the stream to write to
+*/
+SWITCH_DECLARE(void) switch_rtp_batch_stats(switch_stream_handle_t *stream);
+
 /*! 
   \brief Request a new port to be used for media
   \param ip the ip to request a port from
@@ -0,0 +1,158 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_simd.h -- Vectorized PCM kernels
+ *
+ */
+/*! \file switch_simd.h
+    \brief Vectorized PCM kernels
+
+	Block versions of the G.711 codecs and the signed linear helpers used on every frame.
+	The implementation is picked at runtime (SSE2 or AVX2 on x86, NEON on aarch64) and every
+	variant produces exactly the same output as the portable scalar code it replaces.
+*/
+
+#ifndef SWITCH_SIMD_H
+#define SWITCH_SIMD_H
+
+#include <switch.h>
+
+SWITCH_BEGIN_EXTERN_C
+/*!
+  \defgroup simd Vectorized PCM Functions
+  \ingroup core1
+  \{
+*/
+
+typedef enum {
+	SWITCH_SIMD_NONE = 0,
+	SWITCH_SIMD_SSE2,
+	SWITCH_SIMD_AVX2,
+	SWITCH_SIMD_NEON
+} switch_simd_level_t;
+
+/*!
+  \brief Select the best kernels this cpu supports
+*/
+SWITCH_DECLARE(void) switch_simd_init(void);
+
+/*!
+  \brief Find the best instruction set this cpu supports
+  \return the detected level
+*/
+SWITCH_DECLARE(switch_simd_level_t) switch_simd_detect(void);
+
+/*!
+  \brief Get the instruction set currently in use
+  \return the active level
+*/
+SWITCH_DECLARE(switch_simd_level_t) switch_simd_level(void);
+
+/*!
+  \brief Force a specific instruction set
+  \param level the level to use, SWITCH_SIMD_NONE selects the scalar code
+  \return SWITCH_STATUS_SUCCESS or SWITCH_STATUS_NOTIMPL when the cpu does not support the level
+*/
+SWITCH_DECLARE(switch_status_t) switch_simd_set_level(switch_simd_level_t level);
+
+SWITCH_DECLARE(const char *) switch_simd_level_name(switch_simd_level_t level);
+SWITCH_DECLARE(switch_simd_level_t) switch_simd_level_from_name(const char *name);
+
+/*!
+  \brief Encode a block of signed linear samples to u-law
+  \param ebuf the encoded output, one byte per sample
+  \param dbuf the linear input
+  \param samples the number of samples
+*/
+SWITCH_DECLARE(void) switch_g711u_encode_block(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples);
+SWITCH_DECLARE(void) switch_g711u_decode_block(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples);
+SWITCH_DECLARE(void) switch_g711a_encode_block(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples);
+SWITCH_DECLARE(void) switch_g711a_decode_block(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples);
+
+/*!
+  \brief Add other_data into data with 16 bit saturation
+  \param data the audio data, updated in place
+  \param other_data the audio to mix in
+  \param samples the number of 2 byte samples
+*/
+SWITCH_DECLARE(void) switch_sln_add_saturate(int16_t *data, const int16_t *other_data, uint32_t samples);
+
+/*!
+  \brief Subtract other_data from data (wrapping, the inverse of an unsaturated add)
+*/
+SWITCH_DECLARE(void) switch_sln_subtract(int16_t *data, const int16_t *other_data, uint32_t samples);
+
+/*!
+  \brief Multiply every sample by factor, truncating and clamping to 16 bit
+*/
+SWITCH_DECLARE(void) switch_sln_scale(int16_t *data, uint32_t samples, double factor);
+
+/*!
+  \brief Fold interleaved stereo to mono in place with 16 bit saturation
+  \param data the audio data, samples * 2 values on input and samples on output
+  \param samples the number of sample frames
+*/
+SWITCH_DECLARE(void) switch_sln_downmix_stereo(int16_t *data, uint32_t samples);
+
+/*!
+  \brief Duplicate mono to interleaved stereo in place
+  \param data the audio data, must have room for samples * 2 values
+  \param samples the number of sample frames
+*/
+SWITCH_DECLARE(void) switch_sln_upmix_mono(int16_t *data, uint32_t samples);
+
+/*!
+  \brief Add a frame into a 32 bit mix without clipping
+  \param mix the running sum
+  \param data the audio to add
+  \param samples the number of 2 byte samples
+*/
+SWITCH_DECLARE(void) switch_sln_accumulate(int32_t *mix, const int16_t *data, uint32_t samples);
+
+/*!
+  \brief Produce a 16 bit frame from a 32 bit mix, optionally taking one contribution back out
+  \param out the saturated output
+  \param mix the running sum
+  \param self the audio to subtract, or NULL for the full mix
+  \param samples the number of 2 byte samples
+*/
+SWITCH_DECLARE(void) switch_sln_mix_minus(int16_t *out, const int32_t *mix, const int16_t *self, uint32_t samples);
+///\}
+
+SWITCH_END_EXTERN_C
+#endif
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
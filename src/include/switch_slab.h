@@ -0,0 +1,105 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_slab.h -- Size class allocator for short lived core objects
+ *
+ */
+/*! \file switch_slab.h
+    \brief Size class allocator for short lived core objects
+
+	Events, their headers and header names are created and freed by the thousand on every call.
+	Those small, individually freed allocations come from per size class free lists here instead
+	of the system heap.  Each thread keeps a small cache per class so the common alloc/free pair
+	takes no lock at all; the shared depot behind it is only visited in batches.
+	Memory handed out by a pool still belongs in a pool, this is for objects that are freed one by one.
+*/
+
+#ifndef SWITCH_SLAB_H
+#define SWITCH_SLAB_H
+
+#include <switch.h>
+
+SWITCH_BEGIN_EXTERN_C
+/*!
+  \defgroup slab Slab Allocator
+  \ingroup core1
+  \{
+*/
+
+/*!
+  \brief Set up the size classes, called once from the core memory init
+  \param pool the pool the depot mutexes live in
+*/
+SWITCH_DECLARE(void) switch_slab_init(switch_memory_pool_t *pool);
+SWITCH_DECLARE(void) switch_slab_shutdown(void);
+
+/*!
+  \brief Allocate a block from the size class that fits, larger requests go to the system heap
+  \param size the number of bytes needed
+  \return the memory, release it with switch_slab_free()
+*/
+SWITCH_DECLARE(void *) switch_slab_alloc(switch_size_t size);
+SWITCH_DECLARE(void *) switch_slab_zalloc(switch_size_t size);
+SWITCH_DECLARE(char *) switch_slab_strdup(const char *str);
+
+/*!
+  \brief Return a block to the allocator, NULL is ignored
+  \param ptr memory from switch_slab_alloc(), switch_slab_zalloc() or switch_slab_strdup()
+*/
+SWITCH_DECLARE(void) switch_slab_free(void *ptr);
+
+/*!
+  \brief Hand the calling thread's cached blocks and counters back to the shared depot
+*/
+SWITCH_DECLARE(void) switch_slab_thread_flush(void);
+
+/*!
+  \brief Write per class requests, bytes in use and thread cache hit rate
+  \param stream the stream to write to
+  \param reset clear the request and hit counters afterwards
+*/
+SWITCH_DECLARE(void) switch_slab_stats(switch_stream_handle_t *stream, switch_bool_t reset);
+
+/*!
+  \brief Get the number of allocation requests served and how many of them reached the system heap
+*/
+SWITCH_DECLARE(void) switch_slab_get_totals(uint64_t *requests, uint64_t *system_allocs);
+///\}
+
+SWITCH_END_EXTERN_C
+#endif
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -369,7 +369,8 @@ typedef enum {
 	SCF_DEBUG_SQL = (1 << 21),
 	SCF_API_EXPANSION = (1 << 22),
 	SCF_SESSION_THREAD_POOL = (1 << 23),
-	SCF_DIALPLAN_TIMESTAMPS = (1 << 24)
+	SCF_DIALPLAN_TIMESTAMPS = (1 << 24),
+	SCF_CHANNEL_SQL_EXPORT = (1 << 25)
 } switch_core_flag_enum_t;
 typedef uint32_t switch_core_flag_t;
 
@@ -716,6 +717,8 @@ typedef enum {
 	SWITCH_RTP_FLAG_BUGGY_2833    - Emulate the bug in cisco equipment to allow interop
 	SWITCH_RTP_FLAG_PASS_RFC2833  - Pass 2833 (ignore it)
 	SWITCH_RTP_FLAG_AUTO_CNG      - Generate outbound CNG frames when idle    
+	SWITCH_RTP_FLAG_BATCH_RECV    - Receive through the shared recvmmsg() poller threads
+	SWITCH_RTP_FLAG_BATCH_SEND    - Send through the shared sendmmsg() sender threads
 </pre>
  */
 typedef enum {
@@ -762,6 +765,8 @@ typedef enum {
 	SWITCH_RTP_FLAG_NACK,
 	SWITCH_RTP_FLAG_TMMBR,
 	SWITCH_RTP_FLAG_GEN_TS_DELTA,
+	SWITCH_RTP_FLAG_BATCH_RECV,
+	SWITCH_RTP_FLAG_BATCH_SEND,
 	SWITCH_RTP_FLAG_INVALID
 } switch_rtp_flag_t;
 
@@ -2015,6 +2020,36 @@ typedef enum {
 	SWITCH_EVENT_ALL
 } switch_event_types_t;
 
+/*!
+  \enum switch_event_overflow_t
+  \brief What a queued event binding does when its queue is full
+<pre>
+    SWITCH_EVENT_OVERFLOW_DROP_NEW - discard the event being queued
+    SWITCH_EVENT_OVERFLOW_DROP_OLD - discard the oldest queued event to make room
+    SWITCH_EVENT_OVERFLOW_BLOCK    - hold the dispatch thread until the worker catches up
+</pre>
+ */
+typedef enum {
+	SWITCH_EVENT_OVERFLOW_DROP_NEW,
+	SWITCH_EVENT_OVERFLOW_DROP_OLD,
+	SWITCH_EVENT_OVERFLOW_BLOCK
+} switch_event_overflow_t;
+
+/*!
+  \enum switch_event_filter_op_t
+  \brief How an event filter rule compares a header value
+<pre>
+    SWITCH_EVENT_FILTER_EQUAL  - the value equals the rule (case insensitive)
+    SWITCH_EVENT_FILTER_PREFIX - the value starts with the rule (case insensitive)
+    SWITCH_EVENT_FILTER_REGEX  - the value matches the rule compiled as a regex
+</pre>
+ */
+typedef enum {
+	SWITCH_EVENT_FILTER_EQUAL,
+	SWITCH_EVENT_FILTER_PREFIX,
+	SWITCH_EVENT_FILTER_REGEX
+} switch_event_filter_op_t;
+
 typedef enum {
 	SWITCH_INPUT_TYPE_DTMF,
 	SWITCH_INPUT_TYPE_EVENT
@@ -2162,6 +2197,7 @@ typedef struct switch_event_header switch_event_header_t;
 typedef struct switch_event switch_event_t;
 typedef struct switch_event_subclass switch_event_subclass_t;
 typedef struct switch_event_node switch_event_node_t;
+typedef struct switch_event_filter switch_event_filter_t;
 typedef struct switch_loadable_module switch_loadable_module_t;
 typedef struct switch_frame switch_frame_t;
 typedef struct switch_rtcp_frame switch_rtcp_frame_t;
@@ -2581,6 +2617,25 @@ typedef struct switch_img_txt_handle_s switch_img_txt_handle_t;
 struct switch_frame_buffer_s;
 typedef struct switch_frame_buffer_s switch_frame_buffer_t;
 
+struct switch_frame_data_s;
+typedef struct switch_frame_data_s switch_frame_data_t;
+
+/*! \brief Bytes of media payload copied on behalf of a session, by stage */
+typedef struct {
+	/*! inside the RTP stack on receive (batch ring, jitter buffer) */
+	switch_size_t rtp_read;
+	/*! into/out of the resampler */
+	switch_size_t resample;
+	/*! re-framing through the raw read/write buffers */
+	switch_size_t reframe;
+	/*! into media bug buffers */
+	switch_size_t bugs;
+	/*! payload into the RTP send buffer */
+	switch_size_t rtp_write;
+	/*! payload sent straight from the packet it was received in */
+	switch_size_t rtp_write_zerocopy;
+} switch_media_copy_stats_t;
+
 typedef enum {
 	SVR_BLOCK = (1 << 0),
 	SVR_FLUSH = (1 << 1),
@@ -437,7 +437,31 @@ SWITCH_DECLARE(switch_size_t) switch_fp_read_dline(FILE *fd, char **buf, switch_
 
 SWITCH_DECLARE(switch_status_t) switch_frame_alloc(switch_frame_t **frame, switch_size_t size);
 SWITCH_DECLARE(switch_status_t) switch_frame_dup(switch_frame_t *orig, switch_frame_t **clone);
+/*!
+  \brief Like switch_frame_dup() but a frame already in reference counted storage shares it instead of copying
+  \param orig the frame
+  \param clone the new frame, free it with switch_frame_free()
+  \note neither frame's payload may be modified afterwards, only use it for frames nothing writes to (not read frames)
+*/
+SWITCH_DECLARE(switch_status_t) switch_frame_share(switch_frame_t *orig, switch_frame_t **clone);
 SWITCH_DECLARE(switch_status_t) switch_frame_free(switch_frame_t **frame);
+
+/*!
+  \brief Allocate reference counted frame storage, the caller holds the first reference
+  \param fdP the new storage
+  \param size the usable size in bytes
+*/
+SWITCH_DECLARE(switch_status_t) switch_frame_data_create(switch_frame_data_t **fdP, switch_size_t size);
+/*!
+  \brief Take another reference on frame storage
+  \return the same storage
+*/
+SWITCH_DECLARE(switch_frame_data_t *) switch_frame_data_ref(switch_frame_data_t *fd);
+/*!
+  \brief Drop a reference on frame storage, freeing it with the last one
+*/
+SWITCH_DECLARE(void) switch_frame_data_release(switch_frame_data_t **fdP);
+SWITCH_DECLARE(void *) switch_frame_data_ptr(switch_frame_data_t *fd);
 SWITCH_DECLARE(switch_bool_t) switch_is_number(const char *str);
 SWITCH_DECLARE(switch_bool_t) switch_is_leading_number(const char *str);
 SWITCH_DECLARE(char *) switch_find_parameter(const char *str, const char *param, switch_memory_pool_t *pool);
@@ -1054,6 +1078,12 @@ static inline int switch_needs_url_encode(const char *s)
 
 SWITCH_DECLARE(char *) switch_url_encode_opt(const char *url, char *buf, size_t len, switch_bool_t double_encode);
 SWITCH_DECLARE(char *) switch_url_encode(const char *url, char *buf, size_t len);
+/*!
+  \brief URL encode a string straight into a stream, same result as switch_url_encode() without the intermediate buffer
+  \param stream the stream to append to, it has to have a raw_write_function
+  \param url the string to encode
+*/
+SWITCH_DECLARE(void) switch_url_encode_stream(switch_stream_handle_t *stream, const char *url);
 SWITCH_DECLARE(char *) switch_url_decode(char *s);
 SWITCH_DECLARE(switch_bool_t) switch_simple_email(const char *to,
 												  const char *from,
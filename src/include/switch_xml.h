@@ -98,7 +98,8 @@ struct switch_xml {
 	uint32_t flags;
 	/*! is_switch_xml_root bool */
 	switch_bool_t is_switch_xml_root_t;
-	uint32_t refs;
+	/*! references on the main root, changed atomically */
+	switch_atomic_t refs;
 };
 
 /*! 
@@ -217,6 +218,11 @@ SWITCH_DECLARE(char *) switch_xml_toxml(_In_ switch_xml_t xml, _In_ switch_bool_
 SWITCH_DECLARE(char *) switch_xml_toxml_nolock(switch_xml_t xml, _In_ switch_bool_t prn_header);
 SWITCH_DECLARE(char *) switch_xml_tohtml(_In_ switch_xml_t xml, _In_ switch_bool_t prn_header);
 
+///\brief Appends text to a stream escaped the way switch_xml_toxml() escapes character data.
+///\param stream the stream to append to, it has to have a raw_write_function
+///\param txt the text to escape
+SWITCH_DECLARE(void) switch_xml_ampencode_stream(switch_stream_handle_t *stream, const char *txt);
+
 ///\brief Converts an switch_xml structure back to xml using the buffer passed in the parameters.
 ///\param xml the xml node
 ///\param buf buffer to use
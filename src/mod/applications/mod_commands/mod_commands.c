@@ -2092,6 +2092,42 @@ SWITCH_STANDARD_API(lan_addr_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_STANDARD_API(rtp_batch_stats_function)
+{
+	switch_rtp_batch_stats(stream);
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(timer_wheel_stats_function)
+{
+	switch_time_wheel_stats(stream, !zstr(cmd) && !strcasecmp(cmd, "reset"));
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(slab_stats_function)
+{
+	switch_slab_stats(stream, !zstr(cmd) && !strcasecmp(cmd, "reset"));
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(expand_cache_stats_function)
+{
+	switch_expand_stats(stream, !zstr(cmd) && !strcasecmp(cmd, "reset"));
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(regex_cache_stats_function)
+{
+	switch_regex_cache_stats(stream, !zstr(cmd) && !strcasecmp(cmd, "reset"));
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_STANDARD_API(event_queue_stats_function)
+{
+	switch_event_queue_stats(stream, !zstr(cmd) && !strcasecmp(cmd, "reset"));
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(status_function)
 {
 	switch_core_time_duration_t duration = { 0 };
@@ -5130,6 +5166,168 @@ static int show_callback(void *pArg, int argc, char **argv, char **columnNames)
 	return 0;
 }
 
+/* show calls, channels and friends are answered from the core call registry rather than the channels and calls tables */
+struct show_registry {
+	int active;
+	switch_call_registry_view_t view;
+	/* show calls was ordered by call_created_epoch, the registry hands calls back in channel order */
+	int by_call_created;
+	const char *like;
+	switch_core_db_callback_func_t callback;
+	void *pdata;
+};
+
+/* the match sql like does, % for any run of characters and _ for any one, ignoring case */
+static int show_like_match(const char *pattern, const char *str)
+{
+	for (; *pattern; pattern++, str++) {
+		if (*pattern == '%') {
+			while (*pattern == '%') {
+				pattern++;
+			}
+
+			if (!*pattern) {
+				return 1;
+			}
+
+			for (; *str; str++) {
+				if (show_like_match(pattern, str)) {
+					return 1;
+				}
+			}
+
+			return 0;
+		}
+
+		if (!*str || (*pattern != '_' && tolower((unsigned char) *pattern) != tolower((unsigned char) *str))) {
+			return 0;
+		}
+	}
+
+	return !*str;
+}
+
+static int show_registry_like_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	struct show_registry *registry = (struct show_registry *) pArg;
+	switch_call_registry_col_t cols[] = { SCR_COL_UUID, SCR_COL_NAME, SCR_COL_CID_NAME, SCR_COL_CID_NUM, SCR_COL_PRESENCE_DATA };
+	size_t x;
+
+	for (x = 0; x < sizeof(cols) / sizeof(cols[0]); x++) {
+		if (argv[cols[x]] && show_like_match(registry->like, argv[cols[x]])) {
+			return registry->callback(registry->pdata, argc, argv, columnNames);
+		}
+	}
+
+	return 0;
+}
+
+struct show_row {
+	int argc;
+	char **argv;
+	char **names;
+	long call_created;
+	int pos;
+};
+
+struct show_rows {
+	struct show_row *rows;
+	int count;
+	int size;
+};
+
+static int show_rows_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	struct show_rows *rows = (struct show_rows *) pArg;
+	struct show_row *row;
+	int x;
+
+	if (rows->count == rows->size) {
+		rows->size = rows->size ? rows->size * 2 : 64;
+		rows->rows = realloc(rows->rows, rows->size * sizeof(*rows->rows));
+		switch_assert(rows->rows);
+	}
+
+	row = &rows->rows[rows->count];
+	row->argc = argc;
+	row->pos = rows->count++;
+	/* like the sql did, calls without a bridge (a NULL call_created_epoch) sort first */
+	row->call_created = -1;
+	switch_zmalloc(row->argv, argc * sizeof(char *));
+	switch_zmalloc(row->names, argc * sizeof(char *));
+
+	for (x = 0; x < argc; x++) {
+		row->argv[x] = argv[x] ? strdup(argv[x]) : NULL;
+		row->names[x] = strdup(columnNames[x]);
+
+		if (argv[x] && !strcmp(columnNames[x], "call_created_epoch")) {
+			row->call_created = atol(argv[x]);
+		}
+	}
+
+	return 0;
+}
+
+static int show_rows_compare(const void *a, const void *b)
+{
+	const struct show_row *ra = (const struct show_row *) a, *rb = (const struct show_row *) b;
+
+	if (ra->call_created != rb->call_created) {
+		return ra->call_created < rb->call_created ? -1 : 1;
+	}
+
+	return ra->pos - rb->pos;
+}
+
+static void show_execute_sorted(struct show_registry *registry, switch_core_db_callback_func_t callback, struct holder *holder)
+{
+	struct show_rows rows = { 0 };
+	int i, x, stop = 0;
+
+	switch_call_registry_query(registry->view, SCR_INDEX_NONE, NULL, show_rows_callback, &rows);
+	qsort(rows.rows, rows.count, sizeof(*rows.rows), show_rows_compare);
+
+	for (i = 0; i < rows.count; i++) {
+		struct show_row *row = &rows.rows[i];
+
+		if (!stop && callback(holder, row->argc, row->argv, row->names)) {
+			stop = 1;
+		}
+
+		for (x = 0; x < row->argc; x++) {
+			switch_safe_free(row->argv[x]);
+			free(row->names[x]);
+		}
+		free(row->argv);
+		free(row->names);
+	}
+
+	switch_safe_free(rows.rows);
+}
+
+static void show_execute(switch_cache_db_handle_t *db, const char *sql, struct show_registry *registry,
+						 switch_core_db_callback_func_t callback, struct holder *holder, char **errmsg)
+{
+	if (!registry->active) {
+		switch_cache_db_execute_sql_callback(db, sql, callback, holder, errmsg);
+	} else if (holder->justcount) {
+		char count[32];
+		char *argv[1] = { count };
+		char *names[1] = { "count(*)" };
+
+		switch_snprintf(count, sizeof(count), "%u", switch_call_registry_query(registry->view, SCR_INDEX_NONE, NULL, NULL, NULL));
+		callback(holder, 1, argv, names);
+	} else if (registry->like) {
+		registry->callback = callback;
+		registry->pdata = holder;
+		switch_call_registry_query(registry->view, SCR_INDEX_NONE, NULL, show_registry_like_callback, registry);
+	} else if (registry->by_call_created) {
+		show_execute_sorted(registry, callback, holder);
+	} else {
+		switch_call_registry_query(registry->view, SCR_INDEX_NONE, NULL, callback, holder);
+	}
+}
+
 #define COMPLETE_SYNTAX "add <word>|del [<word>|*]"
 SWITCH_STANDARD_API(complete_function)
 {
@@ -5190,10 +5388,12 @@ SWITCH_STANDARD_API(coalesce_function)
 #define SHOW_SYNTAX "codec|endpoint|application|api|dialplan|file|timer|calls [count]|channels [count|like <match string>]|calls|detailed_calls|bridged_calls|detailed_bridged_calls|aliases|complete|chat|management|modules|nat_map|say|interfaces|interface_types|tasks|limits|status"
 SWITCH_STANDARD_API(show_function)
 {
-	char sql[1024];
-	char *errmsg;
-	switch_cache_db_handle_t *db;
+	char sql[1024] = "";
+	char like[256];
+	char *errmsg = NULL;
+	switch_cache_db_handle_t *db = NULL;
 	struct holder holder = { 0 };
+	struct show_registry registry = { 0 };
 	int help = 0;
 	char *mydata = NULL, *argv[6] = { 0 };
 	char *command = NULL, *as = NULL;
@@ -5207,16 +5407,6 @@ SWITCH_STANDARD_API(show_function)
 	set_format(holder.format, stream);
 	html = holder.format->html; /* html is just a shortcut */
 
-	if (!(cflags & SCF_USE_SQL)) {
-		stream->write_function(stream, "-ERR SQL disabled, no data available!\n");
-		return SWITCH_STATUS_SUCCESS;
-	}
-
-	if (switch_core_db_handle(&db) != SWITCH_STATUS_SUCCESS) {
-		stream->write_function(stream, "%s", "-ERR Database error!\n");
-		return SWITCH_STATUS_SUCCESS;
-	}
-
 	holder.justcount = 0;
 
 	if (cmd && *cmd && (mydata = strdup(cmd))) {
@@ -5316,9 +5506,10 @@ SWITCH_STANDARD_API(show_function)
 		}
 
 		if (!strcasecmp(command, "calls")) {
-			sprintf(sql, "select * from basic_calls where hostname='%s' order by call_created_epoch", switch_core_get_switchname());
+			registry.active = 1;
+			registry.view = SCR_VIEW_CALLS;
+			registry.by_call_created = 1;
 			if (argv[1] && !strcasecmp(argv[1], "count")) {
-				sprintf(sql, "select count(*) from basic_calls where hostname='%s'", switch_core_get_switchname());
 				holder.justcount = 1;
 				if (argv[3] && !strcasecmp(argv[2], "as")) {
 					as = argv[3];
@@ -5334,49 +5525,43 @@ SWITCH_STANDARD_API(show_function)
 				}
 			}
 		} else if (!strcasecmp(command, "channels") && argv[1] && !strcasecmp(argv[1], "like")) {
+			registry.active = 1;
+			registry.view = SCR_VIEW_CHANNELS;
 			if (argv[2]) {
-				char *p;
-				for (p = argv[2]; p && *p; p++) {
-					if (*p == '\'' || *p == ';') {
-						*p = ' ';
-					}
-				}
 				if (strchr(argv[2], '%')) {
-					sprintf(sql,
-						"select * from channels where hostname='%s' and uuid like '%s' or name like '%s' or cid_name like '%s' or cid_num like '%s' or presence_data like '%s' order by created_epoch",
-						switch_core_get_switchname(), argv[2], argv[2], argv[2], argv[2], argv[2]);
+					switch_snprintf(like, sizeof(like), "%s", argv[2]);
 				} else {
-					sprintf(sql,
-						"select * from channels where hostname='%s' and uuid like '%%%s%%' or name like '%%%s%%' or cid_name like '%%%s%%' or cid_num like '%%%s%%' or presence_data like '%%%s%%' order by created_epoch",
-						switch_core_get_switchname(), argv[2], argv[2], argv[2], argv[2], argv[2]);
+					switch_snprintf(like, sizeof(like), "%%%s%%", argv[2]);
 				}
+				registry.like = like;
 				if (argv[4] && !strcasecmp(argv[3], "as")) {
 					as = argv[4];
 				}
-			} else {
-				sprintf(sql, "select * from channels where hostname='%s' order by created_epoch", switch_core_get_switchname());
 			}
 		} else if (!strcasecmp(command, "channels")) {
-			sprintf(sql, "select * from channels where hostname='%s' order by created_epoch", switch_core_get_switchname());
+			registry.active = 1;
+			registry.view = SCR_VIEW_CHANNELS;
 			if (argv[1] && !strcasecmp(argv[1], "count")) {
-				sprintf(sql, "select count(*) from channels where hostname='%s'", switch_core_get_switchname());
 				holder.justcount = 1;
 				if (argv[3] && !strcasecmp(argv[2], "as")) {
 					as = argv[3];
 				}
 			}
 		} else if (!strcasecmp(command, "detailed_calls")) {
-			sprintf(sql, "select * from detailed_calls where hostname='%s' order by created_epoch", switch_core_get_switchname());
+			registry.active = 1;
+			registry.view = SCR_VIEW_DETAILED_CALLS;
 			if (argv[2] && !strcasecmp(argv[1], "as")) {
 				as = argv[2];
 			}
 		} else if (!strcasecmp(command, "bridged_calls")) {
-			sprintf(sql, "select * from basic_calls where b_uuid is not null and hostname='%s' order by created_epoch", switch_core_get_switchname());
+			registry.active = 1;
+			registry.view = SCR_VIEW_BRIDGED_CALLS;
 			if (argv[2] && !strcasecmp(argv[1], "as")) {
 				as = argv[2];
 			}
 		} else if (!strcasecmp(command, "detailed_bridged_calls")) {
-			sprintf(sql, "select * from detailed_calls where b_uuid is not null and hostname='%s' order by created_epoch", switch_core_get_switchname());
+			registry.active = 1;
+			registry.view = SCR_VIEW_DETAILED_BRIDGED_CALLS;
 			if (argv[2] && !strcasecmp(argv[1], "as")) {
 				as = argv[2];
 			}
@@ -5387,6 +5572,18 @@ SWITCH_STANDARD_API(show_function)
 		}
 	}
 
+	if (!registry.active) {
+		if (!(cflags & SCF_USE_SQL)) {
+			stream->write_function(stream, "-ERR SQL disabled, no data available!\n");
+			goto end;
+		}
+
+		if (switch_core_db_handle(&db) != SWITCH_STATUS_SUCCESS) {
+			stream->write_function(stream, "%s", "-ERR Database error!\n");
+			goto end;
+		}
+	}
+
 	holder.stream = stream;
 	holder.count = 0;
 
@@ -5413,7 +5610,7 @@ SWITCH_STANDARD_API(show_function)
 				holder.delim = ",";
 			}
 		}
-		switch_cache_db_execute_sql_callback(db, sql, show_callback, &holder, &errmsg);
+		show_execute(db, sql, &registry, show_callback, &holder, &errmsg);
 		if (html) {
 			holder.stream->write_function(holder.stream, "</table>");
 		}
@@ -5429,7 +5626,7 @@ SWITCH_STANDARD_API(show_function)
 			stream->write_function(stream, "%s%u total.%s", nl, holder.count, nl);
 		}
 	} else if (!strcasecmp(as, "xml")) {
-		switch_cache_db_execute_sql_callback(db, sql, show_as_xml_callback, &holder, &errmsg);
+		show_execute(db, sql, &registry, show_as_xml_callback, &holder, &errmsg);
 
 		if (errmsg) {
 			stream->write_function(stream, "-ERR SQL error [%s]\n", errmsg);
@@ -5457,7 +5654,7 @@ SWITCH_STANDARD_API(show_function)
 		}
 	} else if (!strcasecmp(as, "json")) {
 
-		switch_cache_db_execute_sql_callback(db, sql, show_as_json_callback, &holder, &errmsg);
+		show_execute(db, sql, &registry, show_as_json_callback, &holder, &errmsg);
 
 		if (errmsg) {
 			stream->write_function(stream, "-ERR SQL Error [%s]\n", errmsg);
@@ -7032,6 +7229,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "reloadxml", "Reload XML", reload_xml_function, "");
 	SWITCH_ADD_API(commands_api_interface, "replace", "Replace a string", replace_function, "<data>|<string1>|<string2>");
 	SWITCH_ADD_API(commands_api_interface, "say_string", "", say_string_function, SAY_STRING_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "rtp_batch_stats", "Show batched RTP receive/send counters", rtp_batch_stats_function, "");
 	SWITCH_ADD_API(commands_api_interface, "sched_api", "Schedule an api command", sched_api_function, SCHED_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "sched_broadcast", "Schedule a broadcast event to a running call", sched_broadcast_function, SCHED_BROADCAST_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "sched_del", "Delete a scheduled task", sched_del_function, "<task_id>|<group_id>");
@@ -7044,6 +7242,11 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "stun", "Execute STUN lookup", stun_function, "<stun_server>[:port] [<source_ip>[:<source_port]]");
 	SWITCH_ADD_API(commands_api_interface, "time_test", "Show time jitter", time_test_function, "<mss> [count]");
 	SWITCH_ADD_API(commands_api_interface, "timer_test", "Exercise FS timer", timer_test_function, TIMER_TEST_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "timer_wheel_stats", "Show wheel timer counters", timer_wheel_stats_function, "[reset]");
+	SWITCH_ADD_API(commands_api_interface, "slab_stats", "Show slab allocator counters", slab_stats_function, "[reset]");
+	SWITCH_ADD_API(commands_api_interface, "event_queue_stats", "Show queued event binding counters", event_queue_stats_function, "[reset]");
+	SWITCH_ADD_API(commands_api_interface, "expand_cache_stats", "Show variable expansion template cache counters", expand_cache_stats_function, "[reset]");
+	SWITCH_ADD_API(commands_api_interface, "regex_cache_stats", "Show compiled regex cache counters", regex_cache_stats_function, "[reset]");
 	SWITCH_ADD_API(commands_api_interface, "tone_detect", "Start tone detection on a channel", tone_detect_session_function, TONE_DETECT_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "unload", "Unload module", unload_function, UNLOAD_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "unsched_api", "Unschedule an api command", unsched_api_function, UNSCHED_SYNTAX);
@@ -183,6 +183,8 @@ switch_status_t conference_api_main_real(const char *cmd, switch_core_session_t
 				conference_api_sub_list(NULL, stream, argc, argv);
 			} else if (strcasecmp(argv[0], "xml_list") == 0) {
 				conference_api_sub_xml_list(NULL, stream, argc, argv);
+			} else if (strcasecmp(argv[0], "mix-bench") == 0) {
+				conference_mix_bench(stream, argc, argv);
 			} else if (strcasecmp(argv[0], "help") == 0 || strcasecmp(argv[0], "commands") == 0) {
 				stream->write_function(stream, "%s\n", api_syntax);
 			} else if (argv[1] && strcasecmp(argv[1], "dial") == 0) {
@@ -1250,6 +1250,8 @@ void conference_loop_output(conference_member_t *member)
 			}
 		}
 
+		conference_mix_enc_group_check(member);
+
 		use_buffer = NULL;
 		mux_used = (uint32_t) switch_buffer_inuse(member->mux_buffer);
 
@@ -1302,6 +1304,21 @@ void conference_loop_output(conference_member_t *member)
 			}
 
 			switch_mutex_unlock(member->audio_out_mutex);
+		} else if (member->enc_group) {
+			/* the mix was already encoded once for everybody in the group, send it as is */
+			write_frame.data = data;
+
+			if (conference_mix_enc_group_read(member, &write_frame) == SWITCH_STATUS_SUCCESS) {
+				low_count = 0;
+				write_frame.timestamp = timer.samplecount;
+				st = switch_core_session_write_frame(member->session, &write_frame, SWITCH_IO_FLAG_NONE, 0);
+				write_frame.codec = &member->write_codec;
+
+				if (st != SWITCH_STATUS_SUCCESS) {
+					switch_mutex_unlock(member->write_mutex);
+					break;
+				}
+			}
 		}
 
 		if (conference_utils_member_test_flag(member, MFLAG_FLUSH_BUFFER)) {
@@ -1310,6 +1327,12 @@ void conference_loop_output(conference_member_t *member)
 				switch_buffer_zero(member->mux_buffer);
 				switch_mutex_unlock(member->audio_out_mutex);
 			}
+			if (member->enc_buffer && switch_buffer_inuse(member->enc_buffer)) {
+				switch_mutex_lock(member->audio_out_mutex);
+				switch_buffer_zero(member->enc_buffer);
+				member->enc_queued = 0;
+				switch_mutex_unlock(member->audio_out_mutex);
+			}
 			conference_utils_member_clear_flag_locked(member, MFLAG_FLUSH_BUFFER);
 		}
 
@@ -1383,6 +1406,7 @@ void conference_loop_output(conference_member_t *member)
 	}
 
 	switch_core_timer_destroy(&timer);
+	conference_mix_enc_group_leave(member);
 
 	if (member->loop_loop) {
 		return;
@@ -1717,7 +1717,7 @@ int conference_member_setup_media(conference_member_t *member, conference_obj_t
 	}
 
 	/* Setup an audio buffer for the outgoing audio */
-	if (!member->mux_buffer && switch_buffer_create_dynamic(&member->mux_buffer, CONF_DBLOCK_SIZE, CONF_DBUFFER_SIZE, CONF_DBUFFER_MAX) != SWITCH_STATUS_SUCCESS) {
+	if (!member->mux_buffer && switch_buffer_create_spsc(&member->mux_buffer, CONF_DBUFFER_SIZE) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(member->session), SWITCH_LOG_CRIT, "Memory Error Creating Audio Buffer!\n");
 		goto codec_done1;
 	}
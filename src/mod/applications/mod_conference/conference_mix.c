@@ -0,0 +1,734 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * conference_mix.c -- Conference audio output fan-out
+ *
+ */
+#include <mod_conference.h>
+
+struct conference_mix_pool_s {
+	conference_obj_t *conference;
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *work_cond;
+	switch_thread_cond_t *done_cond;
+	switch_thread_t **threads;
+	int thread_count;
+	int running;
+	uint32_t generation;
+	int pending;
+	int failed;
+
+	/* the tick being fanned out, only valid while pending is set */
+	conference_member_t **members;
+	uint32_t member_count;
+	uint32_t member_alloc;
+	const int32_t *main_frame;
+	const int16_t *mix_frame;
+	uint32_t bytes;
+};
+
+struct conference_enc_group_s {
+	conference_obj_t *conference;
+	const switch_codec_implementation_t *implementation;
+	char *fmtp;
+	switch_codec_t codec;
+	switch_audio_resampler_t *resampler;
+	switch_mutex_t *mutex;
+	switch_memory_pool_t *pool;
+	int refs;
+
+	/* the mix of the current tick encoded once for the whole group */
+	uint32_t tick;
+	int encoded;
+	uint8_t data[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	uint32_t datalen;
+
+	struct conference_enc_group_s *next;
+};
+
+/* Listen-only members who get the plain mix and whose session would encode it exactly like everybody
+   else on the same codec can share one encoder; anything that makes their output unique keeps them out. */
+static switch_bool_t conference_mix_enc_group_eligible(conference_member_t *member, switch_codec_t *write_codec)
+{
+	conference_obj_t *conference = member->conference;
+	const switch_codec_implementation_t *impl;
+
+	if (!conference_utils_test_flag(conference, CFLAG_MINIMIZE_AUDIO_ENCODING) ||
+		conference_utils_member_test_flag(member, MFLAG_NO_MINIMIZE_ENCODING) ||
+		conference_utils_member_test_flag(member, MFLAG_CAN_SPEAK) ||
+		!conference_utils_member_test_flag(member, MFLAG_CAN_HEAR) ||
+		conference_utils_member_test_flag(member, MFLAG_POSITIONAL) ||
+		member->volume_out_level || member->fnode || member->relationships) {
+		return SWITCH_FALSE;
+	}
+
+	if (!write_codec || !switch_core_codec_ready(write_codec) || !(impl = write_codec->implementation)) {
+		return SWITCH_FALSE;
+	}
+
+	if (impl->codec_type != SWITCH_CODEC_TYPE_AUDIO ||
+		impl->number_of_channels != conference->channels || member->read_impl.number_of_channels != conference->channels ||
+		impl->microseconds_per_packet != conference->interval * 1000 ||
+		member->read_impl.microseconds_per_packet != impl->microseconds_per_packet) {
+		return SWITCH_FALSE;
+	}
+
+	if (switch_channel_test_app_flag(member->channel, CF_APP_TAGGED) || switch_core_media_bug_count(member->session, NULL)) {
+		return SWITCH_FALSE;
+	}
+
+	return SWITCH_TRUE;
+}
+
+static void conference_mix_enc_group_destroy(conference_enc_group_t *group)
+{
+	switch_memory_pool_t *pool = group->pool;
+
+	switch_core_codec_destroy(&group->codec);
+
+	if (group->resampler) {
+		switch_resample_destroy(&group->resampler);
+	}
+
+	switch_core_destroy_memory_pool(&pool);
+}
+
+/* conference->mutex must be held */
+static conference_enc_group_t *conference_mix_enc_group_find(conference_obj_t *conference, switch_codec_t *write_codec)
+{
+	const switch_codec_implementation_t *impl = write_codec->implementation;
+	conference_enc_group_t *group;
+	switch_memory_pool_t *pool = NULL;
+
+	for (group = conference->enc_groups; group; group = group->next) {
+		if (group->implementation == impl && !strcmp(group->fmtp, switch_str_nil(write_codec->fmtp_in))) {
+			return group;
+		}
+	}
+
+	switch_core_new_memory_pool(&pool);
+	group = switch_core_alloc(pool, sizeof(*group));
+	group->pool = pool;
+	group->conference = conference;
+	group->implementation = impl;
+	group->fmtp = switch_core_strdup(pool, switch_str_nil(write_codec->fmtp_in));
+	switch_mutex_init(&group->mutex, SWITCH_MUTEX_NESTED, pool);
+
+	if (switch_core_codec_copy(write_codec, &group->codec, NULL, pool) != SWITCH_STATUS_SUCCESS) {
+		switch_core_destroy_memory_pool(&pool);
+		return NULL;
+	}
+
+	/* the encoded frames are handed to the session as is so they must be bit for bit what its own codec would send */
+	if (group->codec.implementation != impl) {
+		conference_mix_enc_group_destroy(group);
+		return NULL;
+	}
+
+	if (impl->actual_samples_per_second != conference->rate &&
+		switch_resample_create(&group->resampler, conference->rate, impl->actual_samples_per_second,
+							   SWITCH_RECOMMENDED_BUFFER_SIZE, SWITCH_RESAMPLE_QUALITY, conference->channels) != SWITCH_STATUS_SUCCESS) {
+		conference_mix_enc_group_destroy(group);
+		return NULL;
+	}
+
+	group->next = conference->enc_groups;
+	conference->enc_groups = group;
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Conference %s: new shared encoder %s@%uh@%ui\n", conference->name,
+					  impl->iananame, impl->actual_samples_per_second, impl->microseconds_per_packet / 1000);
+
+	return group;
+}
+
+static void conference_mix_enc_group_set(conference_member_t *member, conference_enc_group_t *group)
+{
+	switch_mutex_lock(member->audio_out_mutex);
+	member->enc_group = group;
+	member->enc_queued = 0;
+	switch_buffer_zero(member->mux_buffer);
+	if (member->enc_buffer) {
+		switch_buffer_zero(member->enc_buffer);
+	}
+	switch_mutex_unlock(member->audio_out_mutex);
+}
+
+void conference_mix_enc_group_leave(conference_member_t *member)
+{
+	conference_obj_t *conference = member->conference;
+	conference_enc_group_t *group, *gp, *last = NULL;
+
+	if (!member->enc_group) {
+		return;
+	}
+
+	/* the mixer keeps this lock for the whole tick so it never sees a group go away under it */
+	switch_mutex_lock(conference->mutex);
+	group = member->enc_group;
+	conference_mix_enc_group_set(member, NULL);
+
+	if (--group->refs == 0) {
+		for (gp = conference->enc_groups; gp; gp = gp->next) {
+			if (gp == group) {
+				if (last) {
+					last->next = gp->next;
+				} else {
+					conference->enc_groups = gp->next;
+				}
+				break;
+			}
+			last = gp;
+		}
+		conference_mix_enc_group_destroy(group);
+	}
+	switch_mutex_unlock(conference->mutex);
+}
+
+/* Called from the member output thread to move it in or out of a shared encoder group as its state changes */
+void conference_mix_enc_group_check(conference_member_t *member)
+{
+	switch_codec_t *write_codec = switch_core_session_get_write_codec(member->session);
+	conference_obj_t *conference = member->conference;
+	conference_enc_group_t *group;
+	switch_bool_t want = conference_mix_enc_group_eligible(member, write_codec);
+
+	if (member->enc_group) {
+		if (want && member->enc_group->implementation == write_codec->implementation &&
+			!strcmp(member->enc_group->fmtp, switch_str_nil(write_codec->fmtp_in))) {
+			return;
+		}
+
+		conference_mix_enc_group_leave(member);
+	}
+
+	if (!want) {
+		return;
+	}
+
+	if (!member->enc_buffer &&
+		switch_buffer_create_dynamic(&member->enc_buffer, CONF_DBLOCK_SIZE, CONF_DBUFFER_SIZE, CONF_DBUFFER_MAX) != SWITCH_STATUS_SUCCESS) {
+		return;
+	}
+
+	switch_mutex_lock(conference->mutex);
+	if ((group = conference_mix_enc_group_find(conference, write_codec))) {
+		group->refs++;
+		conference_mix_enc_group_set(member, group);
+	}
+	switch_mutex_unlock(conference->mutex);
+}
+
+/* Encode the shared mix for this tick unless another member of the group already did */
+static switch_status_t conference_mix_enc_group_encode(conference_enc_group_t *group, const int16_t *mix_frame, uint32_t bytes)
+{
+	conference_obj_t *conference = group->conference;
+	switch_status_t status;
+
+	switch_mutex_lock(group->mutex);
+
+	if (group->tick != conference->mix_tick) {
+		int16_t *pcm = (int16_t *) mix_frame;
+		uint32_t pcm_len = bytes, rate = group->implementation->samples_per_second;
+		unsigned int flag = 0;
+
+		group->tick = conference->mix_tick;
+
+		if (group->resampler) {
+			switch_resample_process(group->resampler, pcm, bytes / 2 / conference->channels);
+			pcm = group->resampler->to;
+			pcm_len = group->resampler->to_len * 2 * conference->channels;
+		}
+
+		group->datalen = sizeof(group->data);
+		group->encoded = switch_core_codec_encode(&group->codec, NULL, pcm, pcm_len, group->implementation->actual_samples_per_second,
+												  group->data, &group->datalen, &rate, &flag) == SWITCH_STATUS_SUCCESS && group->datalen;
+	}
+
+	status = group->encoded ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+	switch_mutex_unlock(group->mutex);
+
+	return status;
+}
+
+/* Pop one encoded frame queued by the mixer, the frame keeps pointing at the group codec so the core sends it untouched */
+switch_status_t conference_mix_enc_group_read(conference_member_t *member, switch_frame_t *frame)
+{
+	conference_enc_group_t *group = member->enc_group;
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	uint32_t len = 0;
+
+	if (!group || !member->enc_buffer) {
+		return status;
+	}
+
+	switch_mutex_lock(member->audio_out_mutex);
+
+	if (member->enc_queued > 500 / member->conference->interval) {
+		/* getting behind, clear the buffer */
+		switch_buffer_zero(member->enc_buffer);
+		member->enc_queued = 0;
+	} else if (member->enc_queued && switch_buffer_read(member->enc_buffer, &len, sizeof(len)) == sizeof(len) && len <= frame->buflen &&
+			   switch_buffer_read(member->enc_buffer, frame->data, len) == len) {
+		member->enc_queued--;
+		frame->datalen = len;
+		frame->codec = &group->codec;
+		frame->samples = group->implementation->samples_per_packet;
+		frame->rate = group->implementation->samples_per_second;
+		status = SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_unlock(member->audio_out_mutex);
+
+	return status;
+}
+
+/* Build and queue one member's output for this tick, returns 0 when the mux buffer refused the write */
+switch_size_t conference_mix_member_output(conference_obj_t *conference, conference_member_t *omember,
+										   const int32_t *main_frame, const int16_t *mix_frame, int16_t *write_frame, uint32_t bytes)
+{
+	conference_member_t *imember;
+	const int16_t *out_frame = write_frame;
+	int16_t *bptr;
+	switch_size_t ok = 1;
+	uint32_t x;
+	int32_t z;
+
+	if (!conference_utils_member_test_flag(omember, MFLAG_RUNNING)) {
+		return 1;
+	}
+
+	if (!conference_utils_member_test_flag(omember, MFLAG_CAN_HEAR)) {
+		memset(write_frame, 255, bytes);
+		switch_buffer_write(omember->mux_buffer, write_frame, bytes);
+		return 1;
+	}
+
+	if (omember->enc_group && !conference->relationship_total && !conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) &&
+		conference_mix_enc_group_encode(omember->enc_group, mix_frame, bytes) == SWITCH_STATUS_SUCCESS) {
+		conference_enc_group_t *group = omember->enc_group;
+		uint32_t len = group->datalen;
+
+		switch_mutex_lock(omember->audio_out_mutex);
+		if ((ok = switch_buffer_write(omember->enc_buffer, &len, sizeof(len)))) {
+			ok = switch_buffer_write(omember->enc_buffer, group->data, len);
+			omember->enc_queued++;
+		}
+		switch_mutex_unlock(omember->audio_out_mutex);
+
+		return ok;
+	}
+
+	if (!conference->relationship_total) {
+		if (conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO)) {
+			uint32_t mine = omember->read / 2;
+
+			/* subtract our own contribution so we don't hear ourselves */
+			switch_sln_mix_minus(write_frame, main_frame, (int16_t *) omember->frame, mine);
+			if (mine < bytes / 2) {
+				switch_sln_mix_minus(write_frame + mine, main_frame + mine, NULL, bytes / 2 - mine);
+			}
+		} else {
+			out_frame = mix_frame;
+		}
+	} else {
+		bptr = (int16_t *) omember->frame;
+
+		for (x = 0; x < bytes / 2 ; x++) {
+			z = main_frame[x];
+
+			/* bptr[x] represents my own contribution to this audio sample */
+			if (conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) && x <= omember->read / 2) {
+				z -= (int32_t) bptr[x];
+			}
+
+			/* when there are relationships, we have to do more work by scouring all the members to see if there are any
+			   reasons why we should not be hearing a paticular member, and if not, delete their samples as well.
+			*/
+			for (imember = conference->members; imember; imember = imember->next) {
+				if (imember != omember && conference_utils_member_test_flag(imember, MFLAG_HAS_AUDIO)) {
+					conference_relationship_t *rel;
+					switch_size_t found = 0;
+					int16_t *rptr = (int16_t *) imember->frame;
+					for (rel = imember->relationships; rel; rel = rel->next) {
+						if ((rel->id == omember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_SPEAK)) {
+							z -= (int32_t) rptr[x];
+							found = 1;
+							break;
+						}
+					}
+					if (!found) {
+						for (rel = omember->relationships; rel; rel = rel->next) {
+							if ((rel->id == imember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_HEAR)) {
+								z -= (int32_t) rptr[x];
+								break;
+							}
+						}
+					}
+
+				}
+			}
+
+			/* Now we can convert to 16 bit. */
+			switch_normalize_to_16bit(z);
+			write_frame[x] = (int16_t) z;
+		}
+	}
+
+	/* mux_buffer is a lock free ring and the mixer (or the one worker holding this member's slice) is its only writer,
+	   a member that fell that far behind flushes on its own so the frame is simply dropped */
+	switch_buffer_write(omember->mux_buffer, out_frame, bytes);
+
+	return ok;
+}
+
+static int conference_mix_output_slice(conference_mix_pool_t *mix_pool, int slice, int16_t *write_frame)
+{
+	uint32_t start = (uint32_t) (((uint64_t) mix_pool->member_count * slice) / (mix_pool->thread_count + 1));
+	uint32_t end = (uint32_t) (((uint64_t) mix_pool->member_count * (slice + 1)) / (mix_pool->thread_count + 1));
+	uint32_t i;
+
+	for (i = start; i < end; i++) {
+		if (!conference_mix_member_output(mix_pool->conference, mix_pool->members[i],
+										  mix_pool->main_frame, mix_pool->mix_frame, write_frame, mix_pool->bytes)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+typedef struct {
+	conference_mix_pool_t *mix_pool;
+	int slice;
+} conference_mix_worker_t;
+
+static void *SWITCH_THREAD_FUNC conference_mix_worker_run(switch_thread_t *thread, void *obj)
+{
+	conference_mix_worker_t *worker = (conference_mix_worker_t *) obj;
+	conference_mix_pool_t *mix_pool = worker->mix_pool;
+	int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	uint32_t seen = 0;
+	int ok;
+
+	switch_mutex_lock(mix_pool->mutex);
+
+	while (mix_pool->running) {
+		if (mix_pool->generation == seen) {
+			switch_thread_cond_wait(mix_pool->work_cond, mix_pool->mutex);
+			continue;
+		}
+
+		seen = mix_pool->generation;
+		switch_mutex_unlock(mix_pool->mutex);
+
+		ok = conference_mix_output_slice(mix_pool, worker->slice, write_frame);
+
+		switch_mutex_lock(mix_pool->mutex);
+
+		if (!ok) {
+			mix_pool->failed = 1;
+		}
+
+		if (--mix_pool->pending == 0) {
+			switch_thread_cond_signal(mix_pool->done_cond);
+		}
+	}
+
+	switch_mutex_unlock(mix_pool->mutex);
+
+	return NULL;
+}
+
+switch_status_t conference_mix_pool_start(conference_obj_t *conference, int threads)
+{
+	conference_mix_pool_t *mix_pool;
+	switch_memory_pool_t *pool = NULL;
+	switch_threadattr_t *thd_attr = NULL;
+	int i;
+
+	if (threads <= 0 || conference->mix_pool) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (threads > CONF_MIX_MAX_THREADS) {
+		threads = CONF_MIX_MAX_THREADS;
+	}
+
+	switch_core_new_memory_pool(&pool);
+	mix_pool = switch_core_alloc(pool, sizeof(*mix_pool));
+	mix_pool->pool = pool;
+	mix_pool->conference = conference;
+	mix_pool->running = 1;
+	switch_mutex_init(&mix_pool->mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&mix_pool->work_cond, pool);
+	switch_thread_cond_create(&mix_pool->done_cond, pool);
+	mix_pool->threads = switch_core_alloc(pool, sizeof(switch_thread_t *) * threads);
+
+	switch_threadattr_create(&thd_attr, pool);
+	switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	for (i = 0; i < threads; i++) {
+		conference_mix_worker_t *worker = switch_core_alloc(pool, sizeof(*worker));
+
+		worker->mix_pool = mix_pool;
+		worker->slice = i;
+
+		if (switch_thread_create(&mix_pool->threads[i], thd_attr, conference_mix_worker_run, worker, pool) != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+	}
+
+	mix_pool->thread_count = i;
+
+	if (!mix_pool->thread_count) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Conference %s: unable to start mix output threads\n", conference->name);
+		switch_core_destroy_memory_pool(&pool);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Conference %s: %d mix output threads\n", conference->name, mix_pool->thread_count);
+	conference->mix_pool = mix_pool;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+void conference_mix_pool_stop(conference_obj_t *conference)
+{
+	conference_mix_pool_t *mix_pool = conference->mix_pool;
+	switch_memory_pool_t *pool;
+	switch_status_t st;
+	int i;
+
+	if (!mix_pool) {
+		return;
+	}
+
+	conference->mix_pool = NULL;
+
+	switch_mutex_lock(mix_pool->mutex);
+	mix_pool->running = 0;
+	switch_thread_cond_broadcast(mix_pool->work_cond);
+	switch_mutex_unlock(mix_pool->mutex);
+
+	for (i = 0; i < mix_pool->thread_count; i++) {
+		switch_thread_join(&st, mix_pool->threads[i]);
+	}
+
+	switch_safe_free(mix_pool->members);
+	pool = mix_pool->pool;
+	switch_core_destroy_memory_pool(&pool);
+}
+
+/* Hand the saturated mix (or mix-minus) to every member of the conference, the conference mutex must be held.
+   Big rooms with a worker pool are split in slices with the calling thread taking the last one;
+   the mix itself is read only by then so the workers share it without any locking. */
+switch_size_t conference_mix_output(conference_obj_t *conference, const int32_t *main_frame, const int16_t *mix_frame, uint32_t bytes)
+{
+	conference_mix_pool_t *mix_pool = conference->mix_pool;
+	conference_member_t *omember;
+	int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE];
+	int ok;
+
+	conference->mix_tick++;
+
+	if (!mix_pool || conference->count < CONF_MIX_MIN_MEMBERS) {
+		for (omember = conference->members; omember; omember = omember->next) {
+			if (!conference_mix_member_output(conference, omember, main_frame, mix_frame, write_frame, bytes)) {
+				return 0;
+			}
+		}
+
+		return 1;
+	}
+
+	mix_pool->member_count = 0;
+
+	for (omember = conference->members; omember; omember = omember->next) {
+		if (mix_pool->member_count == mix_pool->member_alloc) {
+			uint32_t len = mix_pool->member_alloc ? mix_pool->member_alloc * 2 : 256;
+			conference_member_t **members = realloc(mix_pool->members, len * sizeof(*members));
+
+			switch_assert(members);
+			mix_pool->members = members;
+			mix_pool->member_alloc = len;
+		}
+
+		mix_pool->members[mix_pool->member_count++] = omember;
+	}
+
+	mix_pool->main_frame = main_frame;
+	mix_pool->mix_frame = mix_frame;
+	mix_pool->bytes = bytes;
+
+	switch_mutex_lock(mix_pool->mutex);
+	mix_pool->pending = mix_pool->thread_count;
+	mix_pool->generation++;
+	switch_thread_cond_broadcast(mix_pool->work_cond);
+	switch_mutex_unlock(mix_pool->mutex);
+
+	ok = conference_mix_output_slice(mix_pool, mix_pool->thread_count, write_frame);
+
+	switch_mutex_lock(mix_pool->mutex);
+	while (mix_pool->pending) {
+		switch_thread_cond_wait(mix_pool->done_cond, mix_pool->mutex);
+	}
+	if (mix_pool->failed) {
+		mix_pool->failed = 0;
+		ok = 0;
+	}
+	switch_mutex_unlock(mix_pool->mutex);
+
+	return ok;
+}
+
+static int conference_mix_bench_cmp(const void *a, const void *b)
+{
+	switch_time_t x = *(const switch_time_t *) a, y = *(const switch_time_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void conference_mix_bench_run(switch_stream_handle_t *stream, int members, int threads, int ticks)
+{
+	switch_memory_pool_t *pool = NULL;
+	conference_obj_t *conference;
+	conference_member_t *member, **all;
+	int32_t main_frame[CONF_MIX_BENCH_SAMPLES];
+	int16_t mix_frame[CONF_MIX_BENCH_SAMPLES];
+	uint32_t bytes = CONF_MIX_BENCH_SAMPLES * 2;
+	switch_time_t *took, start, total = 0;
+	int i, t;
+
+	switch_core_new_memory_pool(&pool);
+	conference = switch_core_alloc(pool, sizeof(*conference));
+	conference->name = "mix-bench";
+	conference->pool = pool;
+	conference->count = members;
+	all = switch_core_alloc(pool, sizeof(*all) * members);
+	took = switch_core_alloc(pool, sizeof(*took) * ticks);
+
+	for (i = 0; i < members; i++) {
+		member = switch_core_alloc(pool, sizeof(*member));
+		member->id = i + 1;
+		member->frame = switch_core_alloc(pool, bytes);
+		switch_mutex_init(&member->audio_out_mutex, SWITCH_MUTEX_NESTED, pool);
+		switch_buffer_create_spsc(&member->mux_buffer, CONF_DBUFFER_SIZE);
+		conference_utils_member_set_flag(member, MFLAG_RUNNING);
+		conference_utils_member_set_flag(member, MFLAG_CAN_HEAR);
+		member->next = conference->members;
+		conference->members = member;
+		all[i] = member;
+	}
+
+	if (threads) {
+		conference_mix_pool_start(conference, threads);
+	}
+
+	for (t = 0; t < ticks; t++) {
+		start = switch_time_now();
+
+		/* a few people talking at a time like a real room */
+		memset(main_frame, 0, sizeof(main_frame));
+		for (i = 0; i < members; i++) {
+			member = all[i];
+			if ((i + t / 50) % 50 < 3) {
+				int16_t *data = (int16_t *) member->frame;
+				uint32_t x;
+
+				for (x = 0; x < bytes / 2; x++) {
+					data[x] = (int16_t) ((x * (i + 1) * 37) & 0x3FFF) - 0x2000;
+				}
+				member->read = bytes;
+				conference_utils_member_set_flag(member, MFLAG_HAS_AUDIO);
+				switch_sln_accumulate(main_frame, data, bytes / 2);
+			} else {
+				member->read = 0;
+				conference_utils_member_clear_flag(member, MFLAG_HAS_AUDIO);
+			}
+		}
+		switch_sln_mix_minus(mix_frame, main_frame, NULL, bytes / 2);
+
+		conference_mix_output(conference, main_frame, mix_frame, bytes);
+
+		took[t] = switch_time_now() - start;
+		total += took[t];
+
+		for (i = 0; i < members; i++) {
+			switch_buffer_zero(all[i]->mux_buffer);
+		}
+	}
+
+	conference_mix_pool_stop(conference);
+
+	qsort(took, ticks, sizeof(*took), conference_mix_bench_cmp);
+	stream->write_function(stream, "%5d members %2d threads: avg %6.1fus p50 %6ldus p99 %6ldus max %6ldus per tick\n",
+						   members, threads, (double) total / ticks, (long) took[ticks / 2], (long) took[(ticks * 99) / 100], (long) took[ticks - 1]);
+
+	for (i = 0; i < members; i++) {
+		switch_buffer_destroy(&all[i]->mux_buffer);
+	}
+
+	switch_core_destroy_memory_pool(&pool);
+}
+
+/* conference mix-bench [<threads>] [<ticks>] */
+switch_status_t conference_mix_bench(switch_stream_handle_t *stream, int argc, char **argv)
+{
+	int sizes[] = { 100, 500, 1000 };
+	int threads = argc > 1 ? atoi(argv[1]) : 4;
+	int ticks = argc > 2 ? atoi(argv[2]) : 500;
+	int i;
+
+	if (threads < 0 || threads > CONF_MIX_MAX_THREADS || ticks <= 0) {
+		stream->write_function(stream, "-ERR usage: conference mix-bench [<threads 0-%d>] [<ticks>]\n", CONF_MIX_MAX_THREADS);
+		return SWITCH_STATUS_GENERR;
+	}
+
+	stream->write_function(stream, "Output fan-out of one %d sample frame per tick, %d ticks\n", CONF_MIX_BENCH_SAMPLES, ticks);
+
+	for (i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); i++) {
+		conference_mix_bench_run(stream, sizes[i], 0, ticks);
+		if (threads) {
+			conference_mix_bench_run(stream, sizes[i], threads, ticks);
+		}
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -214,8 +214,8 @@ void *SWITCH_THREAD_FUNC conference_record_thread_run(switch_thread_t *thread, v
 		goto end;
 	}
 
-	/* Setup an audio buffer for the outgoing audio */
-	if (switch_buffer_create_dynamic(&member->mux_buffer, CONF_DBLOCK_SIZE, CONF_DBUFFER_SIZE, 0) != SWITCH_STATUS_SUCCESS) {
+	/* Setup an audio buffer for the outgoing audio, roomy enough to ride out slow disk writes */
+	if (switch_buffer_create_spsc(&member->mux_buffer, CONF_DBUFFER_SIZE * 8) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Memory Error Creating Audio Buffer!\n");
 		goto end;
 	}
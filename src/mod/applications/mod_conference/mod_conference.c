@@ -227,6 +227,10 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 	conference_globals.threads++;
 	switch_mutex_unlock(conference_globals.hash_mutex);
 
+	if (conference->mix_output_threads > 0) {
+		conference_mix_pool_start(conference, conference->mix_output_threads);
+	}
+
 	conference->auto_recording = 0;
 	conference->record_count = 0;
 
@@ -480,8 +484,8 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 
 		if (ready || has_file_data) {
 			/* Use more bits in the main_frame to preserve the exact sum of the audio samples. */
-			int main_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
-			int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+			int32_t main_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+			int16_t mix_frame[SWITCH_RECOMMENDED_BUFFER_SIZE];
 
 
 			/* Init the main frame with file data if there is any. */
@@ -517,10 +521,13 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					}
 				}
 
-				bptr = (int16_t *) omember->frame;
-				for (x = 0; x < omember->read / 2; x++) {
-					main_frame[x] += (int32_t) bptr[x];
+				/* Too quiet to matter, leave it out of the mix and it will get the plain mix back like any other listener. */
+				if (conference->mix_energy_floor && omember->score < conference->mix_energy_floor) {
+					conference_utils_member_clear_flag_locked(omember, MFLAG_HAS_AUDIO);
+					continue;
 				}
+
+				switch_sln_accumulate(main_frame, (int16_t *) omember->frame, omember->read / 2);
 			}
 
 			if (conference->agc_level && conference->member_loop_count) {
@@ -538,78 +545,15 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 				if (!conference->avg_itt) conference->avg_tally = conference->score;
 			}
 
-			/* Create write frame once per member who is not deaf for each sample in the main frame
-			   check if our audio is involved and if so, subtract it from the sample so we don't hear ourselves.
-			   Since main frame was 32 bit int, we did not lose any detail, now that we have to convert to 16 bit we can
-			   cut it off at the min and max range if need be and write the frame to the output buffer.
+			/* Since main frame was 32 bit int, we did not lose any detail, now that we have to convert to 16 bit we can
+			   cut it off at the min and max range.  Members who are not in the mix all hear exactly this frame so it is
+			   only built once; only the members whose audio is in the mix need their own copy with their samples taken out.
 			*/
-			for (omember = conference->members; omember; omember = omember->next) {
-				switch_size_t ok = 1;
-
-				if (!conference_utils_member_test_flag(omember, MFLAG_RUNNING)) {
-					continue;
-				}
-
-				if (!conference_utils_member_test_flag(omember, MFLAG_CAN_HEAR)) {
-					switch_mutex_lock(omember->audio_out_mutex);
-					memset(write_frame, 255, bytes);
-					ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
-					switch_mutex_unlock(omember->audio_out_mutex);
-					continue;
-				}
-
-				bptr = (int16_t *) omember->frame;
+			switch_sln_mix_minus(mix_frame, main_frame, NULL, bytes / 2);
 
-				for (x = 0; x < bytes / 2 ; x++) {
-					z = main_frame[x];
-
-					/* bptr[x] represents my own contribution to this audio sample */
-					if (conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) && x <= omember->read / 2) {
-						z -= (int32_t) bptr[x];
-					}
-
-					/* when there are relationships, we have to do more work by scouring all the members to see if there are any
-					   reasons why we should not be hearing a paticular member, and if not, delete their samples as well.
-					*/
-					if (conference->relationship_total) {
-						for (imember = conference->members; imember; imember = imember->next) {
-							if (imember != omember && conference_utils_member_test_flag(imember, MFLAG_HAS_AUDIO)) {
-								conference_relationship_t *rel;
-								switch_size_t found = 0;
-								int16_t *rptr = (int16_t *) imember->frame;
-								for (rel = imember->relationships; rel; rel = rel->next) {
-									if ((rel->id == omember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_SPEAK)) {
-										z -= (int32_t) rptr[x];
-										found = 1;
-										break;
-									}
-								}
-								if (!found) {
-									for (rel = omember->relationships; rel; rel = rel->next) {
-										if ((rel->id == imember->id || rel->id == 0) && !switch_test_flag(rel, RFLAG_CAN_HEAR)) {
-											z -= (int32_t) rptr[x];
-											break;
-										}
-									}
-								}
-
-							}
-						}
-					}
-
-					/* Now we can convert to 16 bit. */
-					switch_normalize_to_16bit(z);
-					write_frame[x] = (int16_t) z;
-				}
-
-				switch_mutex_lock(omember->audio_out_mutex);
-				ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
-				switch_mutex_unlock(omember->audio_out_mutex);
-
-				if (!ok) {
-					switch_mutex_unlock(conference->mutex);
-					goto end;
-				}
+			if (!conference_mix_output(conference, main_frame, mix_frame, bytes)) {
+				switch_mutex_unlock(conference->mutex);
+				goto end;
 			}
 		} else { /* There is no source audio.  Push silence into all of the buffers */
 			int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
@@ -621,20 +565,12 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 			}
 
 			for (omember = conference->members; omember; omember = omember->next) {
-				switch_size_t ok = 1;
-
 				if (!conference_utils_member_test_flag(omember, MFLAG_RUNNING)) {
 					continue;
 				}
 
-				switch_mutex_lock(omember->audio_out_mutex);
-				ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
-				switch_mutex_unlock(omember->audio_out_mutex);
-
-				if (!ok) {
-					switch_mutex_unlock(conference->mutex);
-					goto end;
-				}
+				/* mux_buffer is a lock free ring with this thread as its only writer, a member too far behind just misses the frame */
+				switch_buffer_write(omember->mux_buffer, write_frame, bytes);
 			}
 		}
 
@@ -779,6 +715,7 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 	switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Action", "conference-destroy");
 	switch_event_fire(&event);
 
+	conference_mix_pool_stop(conference);
 	switch_core_timer_destroy(&timer);
 	switch_mutex_lock(conference_globals.hash_mutex);
 	if (conference_utils_test_flag(conference, CFLAG_INHASH)) {
@@ -2253,6 +2190,7 @@ SWITCH_STANDARD_APP(conference_function)
 	switch_buffer_destroy(&member.resample_buffer);
 	switch_buffer_destroy(&member.audio_buffer);
 	switch_buffer_destroy(&member.mux_buffer);
+	switch_buffer_destroy(&member.enc_buffer);
 
 	if (member.fb) {
 		switch_frame_buffer_destroy(&member.fb);
@@ -2389,6 +2327,8 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	char *pin_sound = NULL;
 	char *bad_pin_sound = NULL;
 	char *energy_level = NULL;
+	char *mix_energy_floor = NULL;
+	char *mix_output_threads = NULL;
 	char *auto_gain_level = NULL;
 	char *caller_id_name = NULL;
 	char *caller_id_number = NULL;
@@ -2635,6 +2575,10 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 				bad_pin_sound = val;
 			} else if (!strcasecmp(var, "energy-level") && !zstr(val)) {
 				energy_level = val;
+			} else if (!strcasecmp(var, "mix-energy-floor") && !zstr(val)) {
+				mix_energy_floor = val;
+			} else if (!strcasecmp(var, "mix-output-threads") && !zstr(val)) {
+				mix_output_threads = val;
 			} else if (!strcasecmp(var, "auto-gain-level") && !zstr(val)) {
 				auto_gain_level = val;
 			} else if (!strcasecmp(var, "caller-id-name") && !zstr(val)) {
@@ -3044,6 +2988,21 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 		}
 	}
 
+	if (!zstr(mix_energy_floor)) {
+		int tmp = atoi(mix_energy_floor);
+
+		conference->mix_energy_floor = tmp > 0 ? tmp : 0;
+	}
+
+	if (!zstr(mix_output_threads)) {
+		int tmp = atoi(mix_output_threads);
+
+		if (tmp > CONF_MIX_MAX_THREADS) {
+			tmp = CONF_MIX_MAX_THREADS;
+		}
+		conference->mix_output_threads = tmp > 0 ? tmp : 0;
+	}
+
 	if (!zstr(auto_gain_level)) {
 		int level = 0;
 
@@ -67,6 +67,10 @@
 #define CONF_DBLOCK_SIZE CONF_BUFFER_SIZE
 #define CONF_DBUFFER_SIZE CONF_BUFFER_SIZE
 #define CONF_DBUFFER_MAX 0
+/* Output fan-out worker pool, rooms smaller than CONF_MIX_MIN_MEMBERS are always done by the mixer thread alone */
+#define CONF_MIX_MAX_THREADS 32
+#define CONF_MIX_MIN_MEMBERS 64
+#define CONF_MIX_BENCH_SAMPLES 960
 #define CONF_CHAT_PROTO "conf"
 
 #ifndef MIN
@@ -246,6 +250,7 @@ typedef enum {
 	CFLAG_VIDEO_REQUIRED_FOR_CANVAS,
 	CFLAG_PERSONAL_CANVAS,
 	CFLAG_REFRESH_LAYOUT,
+	CFLAG_MINIMIZE_AUDIO_ENCODING,
 	/////////////////////////////////
 	CFLAG_MAX
 } conference_flag_t;
@@ -519,6 +524,9 @@ typedef enum {
 	CONF_VIDEO_MODE_MUX
 } conference_video_mode_t;
 
+typedef struct conference_mix_pool_s conference_mix_pool_t;
+typedef struct conference_enc_group_s conference_enc_group_t;
+
 /* Conference Object */
 typedef struct conference_obj {
 	char *name;
@@ -600,6 +608,11 @@ typedef struct conference_obj {
 	switch_thread_rwlock_t *rwlock;
 	uint32_t count;
 	int32_t energy_level;
+	uint32_t mix_energy_floor;
+	int mix_output_threads;
+	conference_mix_pool_t *mix_pool;
+	conference_enc_group_t *enc_groups;
+	uint32_t mix_tick;
 	uint8_t min;
 	switch_speech_handle_t lsh;
 	switch_speech_handle_t *sh;
@@ -677,6 +690,10 @@ struct conference_member {
 	switch_memory_pool_t *pool;
 	switch_buffer_t *audio_buffer;
 	switch_buffer_t *mux_buffer;
+	/* encoded frames from a shared encoder group, used instead of mux_buffer by listen-only members */
+	switch_buffer_t *enc_buffer;
+	conference_enc_group_t *enc_group;
+	uint32_t enc_queued;
 	switch_buffer_t *resample_buffer;
 	member_flag_t flags[MFLAG_MAX];
 	uint32_t score;
@@ -892,6 +909,15 @@ void conference_video_release_canvas(mcu_canvas_t **canvasP);
 int conference_member_setup_media(conference_member_t *member, conference_obj_t *conference);
 
 al_handle_t *conference_al_create(switch_memory_pool_t *pool);
+switch_size_t conference_mix_member_output(conference_obj_t *conference, conference_member_t *omember,
+										   const int32_t *main_frame, const int16_t *mix_frame, int16_t *write_frame, uint32_t bytes);
+switch_size_t conference_mix_output(conference_obj_t *conference, const int32_t *main_frame, const int16_t *mix_frame, uint32_t bytes);
+switch_status_t conference_mix_pool_start(conference_obj_t *conference, int threads);
+void conference_mix_pool_stop(conference_obj_t *conference);
+void conference_mix_enc_group_check(conference_member_t *member);
+void conference_mix_enc_group_leave(conference_member_t *member);
+switch_status_t conference_mix_enc_group_read(conference_member_t *member, switch_frame_t *frame);
+switch_status_t conference_mix_bench(switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_member_parse_position(conference_member_t *member, const char *data);
 video_layout_t *conference_video_find_best_layout(conference_obj_t *conference, layout_group_t *lg, uint32_t count);
 void conference_list_count_only(conference_obj_t *conference, switch_stream_handle_t *stream);
@@ -825,15 +825,18 @@ SWITCH_STANDARD_APP(intercept_function)
 struct e_data {
 	char *uuid_list[MAX_SPY];
 	int total;
+	const char *self;
 };
 
 static int e_callback(void *pArg, int argc, char **argv, char **columnNames)
 {
-	char *uuid = argv[0];
+	char *uuid = argv[SCR_COL_UUID];
 	struct e_data *e_data = (struct e_data *) pArg;
 
-	if (uuid && e_data) {
-		e_data->uuid_list[e_data->total++] = strdup(uuid);
+	if (uuid && e_data && e_data->total < MAX_SPY) {
+		if (strcmp(uuid, e_data->self)) {
+			e_data->uuid_list[e_data->total++] = strdup(uuid);
+		}
 		return 0;
 	}
 
@@ -875,10 +878,7 @@ SWITCH_STANDARD_APP(eavesdrop_function)
 		}
 
 		if (!strcasecmp((char *) data, "all")) {
-			switch_cache_db_handle_t *db = NULL;
-			char *errmsg = NULL;
 			struct e_data e_data = { {0} };
-			char *sql = switch_mprintf("select uuid from channels where uuid != '%q'", switch_core_session_get_uuid(session));
 			const char *file = NULL;
 			int x = 0;
 			char buf[2] = "";
@@ -891,22 +891,10 @@ SWITCH_STANDARD_APP(eavesdrop_function)
 					switch_safe_free(e_data.uuid_list[x]);
 				}
 				e_data.total = 0;
-				
-				if (switch_core_db_handle(&db) != SWITCH_STATUS_SUCCESS) {
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Database Error!\n");
-					break;
-				}
-				switch_cache_db_execute_sql_callback(db, sql, e_callback, &e_data, &errmsg);
-				switch_cache_db_release_db_handle(&db);
-				if (errmsg) {
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Error: %s\n", errmsg);
-					free(errmsg);
-					if ((file = switch_channel_get_variable(channel, "eavesdrop_indicate_failed"))) {
-						switch_ivr_play_file(session, NULL, file, NULL);
-					}
-					switch_ivr_collect_digits_count(session, buf, buflen, 1, "*", &terminator, 5000, 0, 0);
-					continue;
-				}
+				e_data.self = switch_core_session_get_uuid(session);
+
+				switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_NONE, NULL, e_callback, &e_data);
+
 				if (e_data.total) {
 					for (x = 0; x < e_data.total && switch_channel_ready(channel); x++) {
 						if (!switch_ivr_uuid_exists(e_data.uuid_list[x])) continue;
@@ -939,8 +927,6 @@ SWITCH_STANDARD_APP(eavesdrop_function)
 				switch_safe_free(e_data.uuid_list[x]);
 			}
 
-			free(sql);
-
 		} else {
 			switch_ivr_eavesdrop_session(session, data, require_group, flags);
 		}
@@ -937,6 +937,22 @@ static switch_status_t fifo_execute_sql_queued(char **sqlp, switch_bool_t sql_al
 
 	return SWITCH_STATUS_SUCCESS;
 }
+
+/* the fifo_bridge statements are prepared with the queue manager in load_config() so only the values are queued */
+static void fifo_bridge_del(const char *consumer_uuid)
+{
+	const char *args[] = { consumer_uuid };
+
+	switch_sql_queue_manager_push_stmt(globals.qm, "fifo_bridge_del", 1, 1, args);
+}
+
+static void fifo_bridge_set_caller_id(const char *consumer_uuid, const char *name, const char *number)
+{
+	const char *args[] = { switch_str_nil(name), switch_str_nil(number), consumer_uuid };
+
+	switch_sql_queue_manager_push_stmt(globals.qm, "fifo_bridge_caller_id", 1, 3, args);
+}
+
 #if 0
 static switch_status_t fifo_execute_sql(char *sql, switch_mutex_t *mutex)
 {
@@ -1128,8 +1144,7 @@ static void do_unbridge(switch_core_session_t *consumer_session, switch_core_ses
 		switch_time_exp_lt(&tm, ts);
 		switch_strftime_nocheck(date, &retsize, sizeof(date), "%Y-%m-%d %T", &tm);
 
-		sql = switch_mprintf("delete from fifo_bridge where consumer_uuid='%q'", switch_core_session_get_uuid(consumer_session));
-		fifo_execute_sql_queued(&sql, SWITCH_TRUE, SWITCH_FALSE);
+		fifo_bridge_del(switch_core_session_get_uuid(consumer_session));
 
 		switch_channel_set_variable(consumer_channel, "fifo_status", "WAITING");
 		switch_channel_set_variable(consumer_channel, "fifo_timestamp", date);
@@ -1224,11 +1239,7 @@ static switch_status_t messagehook (switch_core_session_t *session, switch_core_
 		}
 		break;
 	case SWITCH_MESSAGE_INDICATE_DISPLAY:
-		sql = switch_mprintf("update fifo_bridge set caller_caller_id_name='%q', caller_caller_id_number='%q' where consumer_uuid='%q'",
-							 switch_str_nil(msg->string_array_arg[0]),
-							 switch_str_nil(msg->string_array_arg[1]),
-							 switch_core_session_get_uuid(session));
-		fifo_execute_sql_queued(&sql, SWITCH_TRUE, SWITCH_FALSE);
+		fifo_bridge_set_caller_id(switch_core_session_get_uuid(session), msg->string_array_arg[0], msg->string_array_arg[1]);
 		goto end;
 	default:
 		goto end;
@@ -2389,8 +2400,7 @@ static void dec_use_count(switch_core_session_t *session, const char *type)
 	if ((outbound_id = switch_channel_get_variable(channel, "fifo_outbound_uuid"))) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s untracking call on uuid %s!\n", switch_channel_get_name(channel), outbound_id);
 
-		sql = switch_mprintf("delete from fifo_bridge where consumer_uuid='%q'", switch_core_session_get_uuid(session));
-		fifo_execute_sql_queued(&sql, SWITCH_TRUE, SWITCH_FALSE);
+		fifo_bridge_del(switch_core_session_get_uuid(session));
 
 		del_bridge_call(outbound_id);
 		sql = switch_mprintf("update fifo_outbound set use_count=use_count-1, stop_time=%ld, next_avail=%ld + lag + 1 where use_count > 0 and uuid='%q'",
@@ -3500,8 +3510,7 @@ SWITCH_STANDARD_APP(fifo_function)
 				switch_channel_set_variable_printf(other_channel, "fifo_epoch_stop_bridge", "%ld", epoch_end);
 				switch_channel_set_variable_printf(other_channel, "fifo_bridge_seconds", "%d", epoch_end - epoch_start);
 
-				sql = switch_mprintf("delete from fifo_bridge where consumer_uuid='%q'", switch_core_session_get_uuid(session));
-				fifo_execute_sql_queued(&sql, SWITCH_TRUE, SWITCH_FALSE);
+				fifo_bridge_del(switch_core_session_get_uuid(session));
 
 				if (switch_channel_ready(channel)) {
 					switch_core_media_bug_pause(session);
@@ -4450,6 +4459,9 @@ static switch_status_t load_config(int reload, int del_all)
 										   globals.inner_pre_trans_execute,
 										   globals.inner_post_trans_execute);
 		switch_sql_queue_manager_start(globals.qm);
+		switch_sql_queue_manager_prepare(globals.qm, "fifo_bridge_del", "delete from fifo_bridge where consumer_uuid=?");
+		switch_sql_queue_manager_prepare(globals.qm, "fifo_bridge_caller_id",
+										 "update fifo_bridge set caller_caller_id_name=?, caller_caller_id_number=? where consumer_uuid=?");
 
 		switch_cache_db_test_reactive(dbh, "delete from fifo_outbound where static = 1 or taking_calls < 0 or stop_time < 0",
 									  "drop table fifo_outbound", outbound_sql);
@@ -35,7 +35,8 @@
 #include <fcntl.h>
 
 SWITCH_MODULE_LOAD_FUNCTION(mod_dialplan_xml_load);
-SWITCH_MODULE_DEFINITION(mod_dialplan_xml, mod_dialplan_xml_load, NULL, NULL);
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_dialplan_xml_shutdown);
+SWITCH_MODULE_DEFINITION(mod_dialplan_xml, mod_dialplan_xml_load, mod_dialplan_xml_shutdown, NULL);
 
 typedef enum {
 	BREAK_ON_TRUE,
@@ -44,6 +45,93 @@ typedef enum {
 	BREAK_NEVER
 } break_t;
 
+/*
+ * A context is compiled into the structures below the first time it is hunted and kept until the next reloadxml.
+ * They hold everything parse_exten() used to look up in the xml on every call, plus the compiled regex of every
+ * expression that does not contain variables.  Contexts that do not come from the main xml root (alternate paths,
+ * xml_curl and other bindings) are compiled for the one call without the regexes.
+ */
+
+typedef struct dp_action_s {
+	const char *application;
+	const char *data;
+	int xinline;
+	int loop_count;
+} dp_action_t;
+
+typedef struct dp_regex_s {
+	switch_xml_t xregex;
+	int has_time;
+	const char *field;
+	const char *expression;
+	switch_regex_t *re;
+} dp_regex_t;
+
+struct dp_condition_s;
+
+/* an extension, or a condition with nested conditions */
+typedef struct dp_block_s {
+	const char *name;
+	int req_nest;
+	struct dp_condition_s *conditions;
+	uint32_t condition_count;
+} dp_block_t;
+
+typedef struct dp_condition_s {
+	switch_xml_t xcond;
+	int has_time;
+	const char *field;
+	const char *do_break_a;
+	break_t do_break_i;
+	const char *regex_rule;
+	dp_regex_t *regexes;
+	uint32_t regex_count;
+	const char *expression;
+	switch_regex_t *re;
+	dp_action_t *actions;
+	uint32_t action_count;
+	dp_action_t *anti_actions;
+	uint32_t anti_action_count;
+	dp_block_t nested;
+} dp_condition_t;
+
+typedef struct dp_extension_s {
+	dp_block_t block;
+	const char *cont;
+} dp_extension_t;
+
+/* the extensions, in order, that are worth trying for a destination_number prefix */
+typedef struct dp_index_s {
+	uint32_t *ext;
+	uint32_t count;
+	uint32_t size;
+} dp_index_t;
+
+#define DP_PREFIX_MAX 32
+
+typedef struct dp_context_s {
+	char *name;
+	switch_xml_t xcontext;
+	/* the reference on the main xml root that keeps a cached context valid, NULL when it is not cached */
+	switch_xml_t root;
+	switch_memory_pool_t *pool;
+	dp_extension_t *extensions;
+	uint32_t extension_count;
+	/* extensions whose first condition needs destination_number to start with a literal prefix, by prefix */
+	switch_hash_t *prefixes;
+	/* bit n - 1 is set when one of the prefixes is n bytes long */
+	uint32_t prefix_lens;
+	/* the rest of the extensions */
+	dp_index_t always;
+	int refs;
+} dp_context_t;
+
+static struct {
+	switch_mutex_t *mutex;
+	switch_hash_t *contexts;
+	switch_event_node_t *node;
+} globals;
+
 
 static switch_status_t exec_app(switch_core_session_t *session, const char *app, const char *arg)
 {
@@ -95,23 +183,55 @@ static switch_status_t exec_app(switch_core_session_t *session, const char *app,
 		}																\
 	} while(tzoff)														
 
-static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *caller_profile, switch_xml_t xexten, 
+/* only regexes compiled by the call itself are freed, the ones compiled with the context belong to it */
+#define dp_regex_free(_re, _owned)				\
+	do {										\
+		if (_owned) {							\
+			switch_regex_safe_free(_re);		\
+		}										\
+		_re = NULL;								\
+		_owned = 0;								\
+	} while(0)
+
+/* switch_regex_perform() with the compiled regex when there is one */
+static int dp_regex_perform(const char *field_data, const char *expression, switch_regex_t *compiled,
+							switch_regex_t **re, int *owned, int *ovector, uint32_t olen)
+{
+	int match_count;
+
+	if (!compiled) {
+		*owned = 1;
+		return switch_regex_perform(field_data, expression, re, ovector, olen);
+	}
+
+	*owned = 0;
+
+	if ((match_count = switch_regex_exec(compiled, field_data, ovector, olen))) {
+		*re = compiled;
+	}
+
+	return match_count;
+}
+
+static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *caller_profile, dp_block_t *xexten,
 					   switch_caller_extension_t **extension, const char *exten_name, int recur)
 {
-	switch_xml_t xcond, xaction, xexpression, xregex;
+	dp_condition_t *xcond;
+	dp_action_t *xaction;
+	dp_regex_t *xregex;
+	uint32_t x, y;
 	switch_channel_t *channel = switch_core_session_get_channel(session);
 	int proceed = 0, save_proceed = 0;
 	char *expression_expanded = NULL, *field_expanded = NULL;
 	switch_regex_t *re = NULL, *save_re = NULL;
+	int re_owned = 0, save_re_owned = 0;
 	int offset = 0;
-	const char *tmp, *tzoff = NULL, *tzname_ = NULL, *req_nesta = NULL;
+	const char *tzoff = NULL, *tzname_ = NULL;
 	char nbuf[128] = "";
 	int req_nest = 1;
 	char space[MAX_RECUR_SPACE] = "";
 	const char *orig_exten_name = exten_name;
 
-	check_tz();
-
 	if (!exten_name) {
 		exten_name = "_anon_";
 	}
@@ -144,9 +264,7 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 			}
 		}
 		
-		if ((req_nesta = switch_xml_attr(xexten, "require-nested"))) {
-			req_nest = switch_true(req_nesta);
-		}
+		req_nest = xexten->req_nest;
 
 		if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, 
@@ -158,13 +276,13 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 						  recur, exten_name, req_nest ? "TRUE" : "FALSE");
 		}
 	} else {
-		if ((tmp = switch_xml_attr(xexten, "name"))) {
-			exten_name = tmp;
+		if (xexten->name) {
+			exten_name = xexten->name;
 		}
 	}
 
 
-	for (xcond = switch_xml_child(xexten, "condition"); xcond; xcond = xcond->next) {
+	for (x = 0; x < xexten->condition_count; x++) {
 		char *field = NULL;
 		char *do_break_a = NULL;
 		char *expression = NULL, *save_expression = NULL, *save_field_data = NULL;
@@ -173,30 +291,21 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 		int ovector[30];
 		switch_bool_t anti_action = SWITCH_TRUE;
 		break_t do_break_i = BREAK_ON_FALSE;
-		int time_match;
+		int time_match = -1;
 
-		check_tz();
-		time_match = switch_xml_std_datetime_check(xcond, tzoff ? &offset : NULL, tzname_);
+		xcond = &xexten->conditions[x];
+
+		if (xcond->has_time) {
+			check_tz();
+			time_match = switch_xml_std_datetime_check(xcond->xcond, tzoff ? &offset : NULL, tzname_);
+		}
 
 		switch_safe_free(field_expanded);
 		switch_safe_free(expression_expanded);
 
-		field = (char *) switch_xml_attr(xcond, "field");
-
-
-		if ((do_break_a = (char *) switch_xml_attr(xcond, "break"))) {
-			if (!strcasecmp(do_break_a, "on-true")) {
-				do_break_i = BREAK_ON_TRUE;
-			} else if (!strcasecmp(do_break_a, "on-false")) {
-				do_break_i = BREAK_ON_FALSE;
-			} else if (!strcasecmp(do_break_a, "always")) {
-				do_break_i = BREAK_ALWAYS;
-			} else if (!strcasecmp(do_break_a, "never")) {
-				do_break_i = BREAK_NEVER;
-			} else {
-				do_break_a = NULL;
-			}
-		}
+		field = (char *) xcond->field;
+		do_break_a = (char *) xcond->do_break_a;
+		do_break_i = xcond->do_break_i;
 		
 		if (time_match == 1) {
 			if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
@@ -224,7 +333,7 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 		}
 		
 		
-		if ((regex_rule = (char *) switch_xml_attr(xcond, "regex"))) {
+		if ((regex_rule = (char *) xcond->regex_rule)) {
 			int all = !strcasecmp(regex_rule, "all");
 			int xor = !strcasecmp(regex_rule, "xor");
 			int pass = 0;
@@ -233,10 +342,15 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 
 			switch_channel_del_variable_prefix(channel, "DP_REGEX_MATCH");
 
-			for (xregex = switch_xml_child(xcond, "regex"); xregex; xregex = xregex->next) {
-				int regex_time_match;
-				check_tz();
-				regex_time_match = switch_xml_std_datetime_check(xregex, tzoff ? &offset : NULL, tzname_);
+			for (y = 0; y < xcond->regex_count; y++) {
+				int regex_time_match = -1;
+
+				xregex = &xcond->regexes[y];
+
+				if (xregex->has_time) {
+					check_tz();
+					regex_time_match = switch_xml_std_datetime_check(xregex->xregex, tzoff ? &offset : NULL, tzname_);
+				}
 				
 				if (regex_time_match == 1) {
 					if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
@@ -261,11 +375,7 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 				}
 
 
-				if ((xexpression = switch_xml_child(xregex, "expression"))) {
-					expression = switch_str_nil(xexpression->txt);
-				} else {
-					expression = (char *) switch_xml_attr_soft(xregex, "expression");
-				}
+				expression = (char *) xregex->expression;
 				
 				if ((expression_expanded = switch_channel_expand_variables(channel, expression)) == expression) {
 					expression_expanded = NULL;
@@ -275,7 +385,7 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 				
 				total++;
 				
-				field = (char *) switch_xml_attr(xregex, "field");
+				field = (char *) xregex->field;
 				
 				if (field) {
 					if (strchr(field, '$')) {
@@ -292,7 +402,8 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 						field_data = "";
 					}
 					
-					if ((proceed = switch_regex_perform(field_data, expression, &re, ovector, sizeof(ovector) / sizeof(ovector[0])))) {
+					if ((proceed = dp_regex_perform(field_data, expression, expression_expanded ? NULL : xregex->re,
+													&re, &re_owned, ovector, sizeof(ovector) / sizeof(ovector[0])))) {
 						if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
 							switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG,
 										  "%sDialplan: %s Regex (PASS) [%s] %s(%s) =~ /%s/ match=%s\n", space,
@@ -348,17 +459,19 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 					
 					switch_safe_free(save_expression);
 					switch_safe_free(save_field_data);
-					switch_regex_safe_free(save_re);
+					dp_regex_free(save_re, save_re_owned);
 					
 					save_expression = strdup(expression);
 					save_field_data = strdup(field_data);
 					save_re = re;
+					save_re_owned = re_owned;
 					save_proceed = proceed;
 					
 					re = NULL;
+					re_owned = 0;
 				}
 
-				switch_regex_safe_free(re);
+				dp_regex_free(re, re_owned);
 
 				switch_safe_free(field_expanded);
 				switch_safe_free(expression_expanded);
@@ -377,11 +490,7 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 			switch_safe_free(field_expanded);
 			switch_safe_free(expression_expanded);
 		} else {
-			if ((xexpression = switch_xml_child(xcond, "expression"))) {
-				expression = switch_str_nil(xexpression->txt);
-			} else {
-				expression = (char *) switch_xml_attr_soft(xcond, "expression");
-			}
+			expression = (char *) xcond->expression;
 
 			if ((expression_expanded = switch_channel_expand_variables(channel, expression)) == expression) {
 				expression_expanded = NULL;
@@ -404,7 +513,8 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 					field_data = "";
 				}
 
-				if ((proceed = switch_regex_perform(field_data, expression, &re, ovector, sizeof(ovector) / sizeof(ovector[0])))) {
+				if ((proceed = dp_regex_perform(field_data, expression, expression_expanded ? NULL : xcond->re,
+												&re, &re_owned, ovector, sizeof(ovector) / sizeof(ovector[0])))) {
 					if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
 						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG,
 									  "%sDialplan: %s Regex (PASS) [%s] %s(%s) =~ /%s/ break=%s\n", space,
@@ -444,7 +554,9 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 
 		if (save_re) {
 			re = save_re;
+			re_owned = save_re_owned;
 			save_re = NULL;
+			save_re_owned = 0;
 			
 			expression = expression_expanded = save_expression;
 			save_expression = NULL;
@@ -456,19 +568,15 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 
 
 		if (anti_action) {
-			for (xaction = switch_xml_child(xcond, "anti-action"); xaction; xaction = xaction->next) {
-				const char *application = switch_xml_attr_soft(xaction, "application");
-				const char *loop = switch_xml_attr(xaction, "loop");
-				const char *data;
-				const char *inline_ = switch_xml_attr_soft(xaction, "inline");
-				int xinline = switch_true(inline_);
-				int loop_count = 1;
-
-				if (!zstr(xaction->txt)) {
-					data = xaction->txt;
-				} else {
-					data = (char *) switch_xml_attr_soft(xaction, "data");
-				}
+			for (y = 0; y < xcond->anti_action_count; y++) {
+				const char *application, *data;
+				int xinline, loop_count;
+
+				xaction = &xcond->anti_actions[y];
+				application = xaction->application;
+				data = xaction->data;
+				xinline = xaction->xinline;
+				loop_count = xaction->loop_count;
 
 				if (!*extension) {
 					if ((*extension = switch_caller_extension_new(session, exten_name, caller_profile->destination_number)) == 0) {
@@ -478,10 +586,6 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 					}
 				}
 
-				if (loop) {
-					loop_count = atoi(loop);
-				}
-
 				for (;loop_count > 0; loop_count--) {
 					if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
 						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG,
@@ -507,22 +611,18 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 				switch_capture_regex(re, proceed, field_data, ovector, "DP_MATCH", switch_regex_set_var_callback, session);
 			}
 
-			for (xaction = switch_xml_child(xcond, "action"); xaction; xaction = xaction->next) {
-				char *application = (char *) switch_xml_attr_soft(xaction, "application");
-				const char *loop = switch_xml_attr(xaction, "loop");
-				char *data = NULL;
+			for (y = 0; y < xcond->action_count; y++) {
+				const char *application, *data;
 				char *substituted = NULL;
 				uint32_t len = 0;
-				char *app_data = NULL;
-				const char *inline_ = switch_xml_attr_soft(xaction, "inline");
-				int xinline = switch_true(inline_);
-				int loop_count = 1;
+				const char *app_data = NULL;
+				int xinline, loop_count;
 
-				if (!zstr(xaction->txt)) {
-					data = xaction->txt;
-				} else {
-					data = (char *) switch_xml_attr_soft(xaction, "data");
-				}
+				xaction = &xcond->actions[y];
+				application = xaction->application;
+				data = xaction->data;
+				xinline = xaction->xinline;
+				loop_count = xaction->loop_count;
 
 				if (field && strchr(expression, '(')) {
 					len = (uint32_t) (strlen(data) + strlen(field_data) + 10) * proceed;
@@ -546,9 +646,6 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 					}
 				}
 
-				if (loop) {
-					loop_count = atoi(loop);
-				}
 				for (;loop_count > 0; loop_count--) {
 					if ( switch_core_test_flag(SCF_DIALPLAN_TIMESTAMPS) ) {
 						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG,
@@ -569,7 +666,7 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 				switch_safe_free(substituted);
 			}
 		}
-		switch_regex_safe_free(re);
+		dp_regex_free(re, re_owned);
 
 		if (((anti_action == SWITCH_FALSE && do_break_i == BREAK_ON_TRUE) ||
 			 (anti_action == SWITCH_TRUE && do_break_i == BREAK_ON_FALSE)) || do_break_i == BREAK_ALWAYS) {
@@ -577,8 +674,8 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 		}
 
 		if (proceed) {
-			if (switch_xml_child(xcond, "condition")) {
-				if (!(proceed = parse_exten(session, caller_profile, xcond, extension, orig_exten_name, recur + 1))) {
+			if (xcond->nested.condition_count) {
+				if (!(proceed = parse_exten(session, caller_profile, &xcond->nested, extension, orig_exten_name, recur + 1))) {
 					if (do_break_i == BREAK_NEVER) {
 						continue;
 					}
@@ -589,7 +686,7 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 	}
 
   done:
-	switch_regex_safe_free(re);
+	dp_regex_free(re, re_owned);
 	switch_safe_free(field_expanded);
 	switch_safe_free(expression_expanded);
 
@@ -598,6 +695,502 @@ static int parse_exten(switch_core_session_t *session, switch_caller_profile_t *
 	return proceed;
 }
 
+static int dp_has_time(switch_xml_t x)
+{
+	static const char *attrs[] = { "date-time", "year", "yday", "mon", "mday", "week", "mweek", "wday",
+								   "hour", "minute", "minute-of-day", "time-of-day", "tz-offset", "dst", NULL };
+	int i;
+
+	for (i = 0; attrs[i]; i++) {
+		if (switch_xml_attr(x, attrs[i])) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static const char *dp_expression(switch_xml_t x)
+{
+	switch_xml_t xexpression;
+
+	if ((xexpression = switch_xml_child(x, "expression"))) {
+		return switch_str_nil(xexpression->txt);
+	}
+
+	return switch_xml_attr_soft(x, "expression");
+}
+
+static int dp_expression_static(const char *expression)
+{
+	return !(switch_string_var_check_const(expression) || switch_string_has_escaped_data(expression));
+}
+
+static switch_regex_t *dp_compile_regex(dp_context_t *dpc, const char *expression)
+{
+	if (!dpc->root || !dp_expression_static(expression)) {
+		return NULL;
+	}
+
+	return switch_regex_compile_expression(expression);
+}
+
+static dp_action_t *dp_compile_actions(dp_context_t *dpc, switch_xml_t xcond, const char *name, uint32_t *count)
+{
+	switch_xml_t xaction;
+	dp_action_t *actions, *action;
+	const char *loop;
+
+	for (*count = 0, xaction = switch_xml_child(xcond, name); xaction; xaction = xaction->next) {
+		(*count)++;
+	}
+
+	if (!*count) {
+		return NULL;
+	}
+
+	actions = action = switch_core_alloc(dpc->pool, *count * sizeof(*actions));
+
+	for (xaction = switch_xml_child(xcond, name); xaction; xaction = xaction->next, action++) {
+		action->application = switch_xml_attr_soft(xaction, "application");
+		action->xinline = switch_true(switch_xml_attr_soft(xaction, "inline"));
+		action->loop_count = (loop = switch_xml_attr(xaction, "loop")) ? atoi(loop) : 1;
+
+		if (!zstr(xaction->txt)) {
+			action->data = xaction->txt;
+		} else {
+			action->data = switch_xml_attr_soft(xaction, "data");
+		}
+	}
+
+	return actions;
+}
+
+static void dp_compile_block(dp_context_t *dpc, switch_xml_t xblock, dp_block_t *block)
+{
+	switch_xml_t xcond, xregex;
+	dp_condition_t *cond;
+	dp_regex_t *regex;
+	const char *req_nesta;
+
+	block->name = switch_xml_attr(xblock, "name");
+	block->req_nest = (req_nesta = switch_xml_attr(xblock, "require-nested")) ? switch_true(req_nesta) : 1;
+
+	for (xcond = switch_xml_child(xblock, "condition"); xcond; xcond = xcond->next) {
+		block->condition_count++;
+	}
+
+	if (!block->condition_count) {
+		return;
+	}
+
+	block->conditions = cond = switch_core_alloc(dpc->pool, block->condition_count * sizeof(*cond));
+
+	for (xcond = switch_xml_child(xblock, "condition"); xcond; xcond = xcond->next, cond++) {
+		cond->xcond = xcond;
+		cond->has_time = dp_has_time(xcond);
+		cond->field = switch_xml_attr(xcond, "field");
+		cond->do_break_i = BREAK_ON_FALSE;
+
+		if ((cond->do_break_a = switch_xml_attr(xcond, "break"))) {
+			if (!strcasecmp(cond->do_break_a, "on-true")) {
+				cond->do_break_i = BREAK_ON_TRUE;
+			} else if (!strcasecmp(cond->do_break_a, "on-false")) {
+				cond->do_break_i = BREAK_ON_FALSE;
+			} else if (!strcasecmp(cond->do_break_a, "always")) {
+				cond->do_break_i = BREAK_ALWAYS;
+			} else if (!strcasecmp(cond->do_break_a, "never")) {
+				cond->do_break_i = BREAK_NEVER;
+			} else {
+				cond->do_break_a = NULL;
+			}
+		}
+
+		if ((cond->regex_rule = switch_xml_attr(xcond, "regex"))) {
+			for (xregex = switch_xml_child(xcond, "regex"); xregex; xregex = xregex->next) {
+				cond->regex_count++;
+			}
+
+			if (cond->regex_count) {
+				cond->regexes = regex = switch_core_alloc(dpc->pool, cond->regex_count * sizeof(*regex));
+
+				for (xregex = switch_xml_child(xcond, "regex"); xregex; xregex = xregex->next, regex++) {
+					regex->xregex = xregex;
+					regex->has_time = dp_has_time(xregex);
+					regex->field = switch_xml_attr(xregex, "field");
+					regex->expression = dp_expression(xregex);
+
+					if (regex->field) {
+						regex->re = dp_compile_regex(dpc, regex->expression);
+					}
+				}
+			}
+		} else {
+			cond->expression = dp_expression(xcond);
+
+			if (cond->field) {
+				cond->re = dp_compile_regex(dpc, cond->expression);
+			}
+		}
+
+		cond->actions = dp_compile_actions(dpc, xcond, "action", &cond->action_count);
+		cond->anti_actions = dp_compile_actions(dpc, xcond, "anti-action", &cond->anti_action_count);
+
+		dp_compile_block(dpc, xcond, &cond->nested);
+	}
+}
+
+static void dp_free_block(dp_block_t *block)
+{
+	uint32_t x, y;
+
+	for (x = 0; x < block->condition_count; x++) {
+		dp_condition_t *cond = &block->conditions[x];
+
+		for (y = 0; y < cond->regex_count; y++) {
+			switch_regex_safe_free(cond->regexes[y].re);
+		}
+
+		switch_regex_safe_free(cond->re);
+		dp_free_block(&cond->nested);
+	}
+}
+
+/* the literal text a subject has to start with for ^expression to match, 0 when there is none */
+static switch_size_t dp_regex_prefix(const char *expression, char *buf, switch_size_t len)
+{
+	const char *p;
+	int depth = 0, class = 0;
+	switch_size_t n = 0;
+
+	if (*expression != '^') {
+		return 0;
+	}
+
+	/* an alternative outside of any group can match without the prefix */
+	for (p = expression; *p; p++) {
+		if (*p == '\\' && *(p + 1)) {
+			p++;
+		} else if (class) {
+			if (*p == ']') {
+				class = 0;
+			}
+		} else if (*p == '[') {
+			class = 1;
+		} else if (*p == '(') {
+			depth++;
+		} else if (*p == ')') {
+			depth--;
+		} else if (*p == '|' && depth <= 0) {
+			return 0;
+		}
+	}
+
+	for (p = expression + 1; *p && n < len - 1; p++) {
+		char c = *p;
+
+		if (c == '\\') {
+			if (!*(p + 1) || !strchr("+*.#-", *(p + 1))) {
+				break;
+			}
+			c = *++p;
+		} else if (!(switch_isalnum(c) || c == '#' || c == '-' || c == '_' || c == '@')) {
+			break;
+		}
+
+		/* a quantifier makes the last character optional */
+		if (*(p + 1) && strchr("?*+{", *(p + 1))) {
+			break;
+		}
+
+		buf[n++] = c;
+	}
+
+	buf[n] = '\0';
+
+	return n;
+}
+
+/*
+ * An extension can be left out for a destination_number that does not start with the prefix of its first condition
+ * when failing that condition has no effect: no time, regex="..." or anti-actions to look at and break="on-false".
+ */
+static switch_size_t dp_extension_prefix(dp_extension_t *ext, char *buf, switch_size_t len)
+{
+	dp_condition_t *cond;
+
+	if (!ext->block.condition_count) {
+		return 0;
+	}
+
+	cond = &ext->block.conditions[0];
+
+	if (cond->has_time || cond->regex_rule || cond->anti_action_count || cond->do_break_i != BREAK_ON_FALSE) {
+		return 0;
+	}
+
+	if (!cond->field || strchr(cond->field, '$') || strcasecmp(cond->field, "destination_number")) {
+		return 0;
+	}
+
+	if (!dp_expression_static(cond->expression)) {
+		return 0;
+	}
+
+	return dp_regex_prefix(cond->expression, buf, len);
+}
+
+static void dp_index_add(dp_context_t *dpc, dp_index_t *index, uint32_t ext)
+{
+	if (!index->ext) {
+		index->ext = switch_core_alloc(dpc->pool, index->size * sizeof(*index->ext));
+	}
+
+	index->ext[index->count++] = ext;
+}
+
+static void dp_context_index(dp_context_t *dpc)
+{
+	char prefix[DP_PREFIX_MAX + 1];
+	char **prefixes;
+	dp_index_t *index;
+	switch_size_t len;
+	uint32_t x;
+
+	switch_core_hash_init(&dpc->prefixes);
+	prefixes = switch_core_alloc(dpc->pool, dpc->extension_count * sizeof(*prefixes));
+
+	for (x = 0; x < dpc->extension_count; x++) {
+		if ((len = dp_extension_prefix(&dpc->extensions[x], prefix, sizeof(prefix)))) {
+			if (!(index = switch_core_hash_find(dpc->prefixes, prefix))) {
+				index = switch_core_alloc(dpc->pool, sizeof(*index));
+				switch_core_hash_insert(dpc->prefixes, prefix, index);
+			}
+			index->size++;
+			prefixes[x] = switch_core_strdup(dpc->pool, prefix);
+			dpc->prefix_lens |= 1U << (len - 1);
+		} else {
+			dpc->always.size++;
+		}
+	}
+
+	for (x = 0; x < dpc->extension_count; x++) {
+		dp_index_add(dpc, prefixes[x] ? switch_core_hash_find(dpc->prefixes, prefixes[x]) : &dpc->always, x);
+	}
+}
+
+static dp_context_t *dp_context_compile(switch_xml_t xcontext, const char *name, switch_xml_t root)
+{
+	switch_memory_pool_t *pool = NULL;
+	dp_context_t *dpc;
+	switch_xml_t xexten;
+	uint32_t x = 0;
+
+	switch_core_new_memory_pool(&pool);
+	dpc = switch_core_alloc(pool, sizeof(*dpc));
+	dpc->pool = pool;
+	dpc->name = switch_core_strdup(pool, name);
+	dpc->xcontext = xcontext;
+	dpc->root = root;
+
+	for (xexten = switch_xml_child(xcontext, "extension"); xexten; xexten = xexten->next) {
+		dpc->extension_count++;
+	}
+
+	if (dpc->extension_count) {
+		dpc->extensions = switch_core_alloc(pool, dpc->extension_count * sizeof(*dpc->extensions));
+	}
+
+	for (xexten = switch_xml_child(xcontext, "extension"); xexten; xexten = xexten->next, x++) {
+		dpc->extensions[x].cont = switch_xml_attr(xexten, "continue");
+		dp_compile_block(dpc, xexten, &dpc->extensions[x].block);
+	}
+
+	dp_context_index(dpc);
+
+	if (root) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Compiled context %s: %u extensions, %u always checked\n",
+						  name, dpc->extension_count, dpc->always.count);
+	}
+
+	return dpc;
+}
+
+static void dp_context_destroy(dp_context_t **dpcp)
+{
+	dp_context_t *dpc = *dpcp;
+	switch_memory_pool_t *pool = dpc->pool;
+	uint32_t x;
+
+	*dpcp = NULL;
+
+	for (x = 0; x < dpc->extension_count; x++) {
+		dp_free_block(&dpc->extensions[x].block);
+	}
+
+	switch_core_hash_destroy(&dpc->prefixes);
+
+	if (dpc->root) {
+		switch_xml_free(dpc->root);
+	}
+
+	switch_core_destroy_memory_pool(&pool);
+}
+
+static void dp_context_release(dp_context_t **dpcp)
+{
+	int refs;
+
+	if (!*dpcp) {
+		return;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	refs = --(*dpcp)->refs;
+	switch_mutex_unlock(globals.mutex);
+
+	if (refs) {
+		*dpcp = NULL;
+	} else {
+		dp_context_destroy(dpcp);
+	}
+}
+
+/*
+ * The compiled context for xcontext, from the cache when it is in the main xml root.  The cache holds one reference
+ * on each context and on the root it came from, every call in progress another on the context.
+ */
+static dp_context_t *dp_context_get(switch_xml_t xml, switch_xml_t xcontext, const char *name)
+{
+	dp_context_t *dpc, *old, *drop = NULL, *lost = NULL;
+	switch_xml_t root;
+
+	switch_mutex_lock(globals.mutex);
+	if ((dpc = switch_core_hash_find(globals.contexts, name)) && dpc->xcontext == xcontext) {
+		dpc->refs++;
+		switch_mutex_unlock(globals.mutex);
+		return dpc;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	if ((root = switch_xml_root()) != xml) {
+		switch_xml_free(root);
+		dpc = dp_context_compile(xcontext, name, NULL);
+		dpc->refs++;
+		return dpc;
+	}
+
+	dpc = dp_context_compile(xcontext, name, root);
+
+	switch_mutex_lock(globals.mutex);
+	if ((old = switch_core_hash_find(globals.contexts, name)) && old->xcontext == xcontext) {
+		/* another call got there first, nobody else has seen ours */
+		lost = dpc;
+		dpc = old;
+	} else {
+		drop = old;
+		switch_core_hash_insert(globals.contexts, name, dpc);
+		dpc->refs++;
+	}
+	dpc->refs++;
+	switch_mutex_unlock(globals.mutex);
+
+	if (lost) {
+		dp_context_destroy(&lost);
+	}
+
+	dp_context_release(&drop);
+
+	return dpc;
+}
+
+static void dp_context_flush(void)
+{
+	switch_hash_index_t *hi;
+	dp_context_t *dpc;
+	void *val;
+
+	switch_mutex_lock(globals.mutex);
+	while ((hi = switch_core_hash_first(globals.contexts))) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		dpc = (dp_context_t *) val;
+		switch_core_hash_delete(globals.contexts, dpc->name);
+		switch_safe_free(hi);
+
+		if (!--dpc->refs) {
+			dp_context_destroy(&dpc);
+		}
+	}
+	switch_mutex_unlock(globals.mutex);
+}
+
+static void dp_reload_handler(switch_event_t *event)
+{
+	dp_context_flush();
+}
+
+/* walks the extensions a destination_number can match in order, by merging the index lists for each of its prefixes */
+typedef struct dp_cursor_s {
+	dp_index_t *lists[DP_PREFIX_MAX + 1];
+	uint32_t pos[DP_PREFIX_MAX + 1];
+	int count;
+} dp_cursor_t;
+
+static void dp_cursor_init(dp_cursor_t *cur, dp_context_t *dpc, const char *destination_number)
+{
+	char prefix[DP_PREFIX_MAX + 1];
+	switch_size_t len, max;
+	dp_index_t *index;
+
+	memset(cur, 0, sizeof(*cur));
+	cur->lists[cur->count++] = &dpc->always;
+
+	switch_copy_string(prefix, switch_str_nil(destination_number), sizeof(prefix));
+	max = strlen(prefix);
+
+	for (len = 1; len <= max; len++) {
+		char c;
+
+		if (!(dpc->prefix_lens & (1U << (len - 1)))) {
+			continue;
+		}
+
+		c = prefix[len];
+		prefix[len] = '\0';
+
+		if ((index = switch_core_hash_find(dpc->prefixes, prefix))) {
+			cur->lists[cur->count++] = index;
+		}
+
+		prefix[len] = c;
+	}
+}
+
+static int dp_cursor_next(dp_cursor_t *cur, uint32_t start, uint32_t *ext)
+{
+	int i, best = -1;
+
+	for (i = 0; i < cur->count; i++) {
+		dp_index_t *index = cur->lists[i];
+
+		while (cur->pos[i] < index->count && index->ext[cur->pos[i]] < start) {
+			cur->pos[i]++;
+		}
+
+		if (cur->pos[i] < index->count && (best < 0 || index->ext[cur->pos[i]] < cur->lists[best]->ext[cur->pos[best]])) {
+			best = i;
+		}
+	}
+
+	if (best < 0) {
+		return 0;
+	}
+
+	*ext = cur->lists[best]->ext[cur->pos[best]++];
+
+	return 1;
+}
+
 static switch_status_t dialplan_xml_locate(switch_core_session_t *session, switch_caller_profile_t *caller_profile, switch_xml_t *root,
 										   switch_xml_t *node)
 {
@@ -619,9 +1212,13 @@ SWITCH_STANDARD_DIALPLAN(dialplan_hunt)
 {
 	switch_caller_extension_t *extension = NULL;
 	switch_channel_t *channel = switch_core_session_get_channel(session);
-	switch_xml_t alt_root = NULL, cfg, xml = NULL, xcontext, xexten = NULL;
+	switch_xml_t alt_root = NULL, cfg, xml = NULL, xcontext;
 	char *alt_path = (char *) arg;
 	const char *hunt = NULL;
+	dp_context_t *dpc = NULL;
+	dp_cursor_t cur;
+	const char *destination_number;
+	uint32_t x, start = 0;
 
 	if (!caller_profile) {
 		if (!(caller_profile = switch_channel_get_caller_profile(channel))) {
@@ -669,18 +1266,26 @@ SWITCH_STANDARD_DIALPLAN(dialplan_hunt)
 		}
 	}
 
-	if ((hunt = switch_channel_get_variable(channel, "auto_hunt")) && switch_true(hunt)) {
-		xexten = switch_xml_find_child(xcontext, "extension", "name", caller_profile->destination_number);
-	}
+	dpc = dp_context_get(xml, xcontext, caller_profile->context);
+
+	if ((hunt = switch_channel_get_variable(channel, "auto_hunt")) && switch_true(hunt) && caller_profile->destination_number) {
+		for (x = 0; x < dpc->extension_count; x++) {
+			const char *name = dpc->extensions[x].block.name;
 
-	if (!xexten) {
-		xexten = switch_xml_child(xcontext, "extension");
+			if (name && !strcasecmp(name, caller_profile->destination_number)) {
+				start = x;
+				break;
+			}
+		}
 	}
 
-	while (xexten) {
+	destination_number = caller_profile->destination_number;
+	dp_cursor_init(&cur, dpc, destination_number);
+
+	while (dp_cursor_next(&cur, start, &x)) {
 		int proceed = 0;
-		const char *cont = switch_xml_attr(xexten, "continue");
-		const char *exten_name = switch_xml_attr(xexten, "name");
+		const char *cont = dpc->extensions[x].cont;
+		const char *exten_name = dpc->extensions[x].block.name;
 
 		if (!exten_name) {
 			exten_name = "UNKNOWN";
@@ -696,15 +1301,22 @@ SWITCH_STANDARD_DIALPLAN(dialplan_hunt)
 						  switch_channel_get_name(channel), caller_profile->context, exten_name, cont ? cont : "false");
 		}
 
-		proceed = parse_exten(session, caller_profile, xexten, &extension, exten_name, 0);
+		proceed = parse_exten(session, caller_profile, &dpc->extensions[x].block, &extension, exten_name, 0);
 
 		if (proceed && !switch_true(cont)) {
 			break;
 		}
 
-		xexten = xexten->next;
+		start = x + 1;
+
+		if (caller_profile->destination_number != destination_number) {
+			/* an inline set_profile_var changed it, the rest of the context has to be walked for the new one */
+			destination_number = caller_profile->destination_number;
+			dp_cursor_init(&cur, dpc, destination_number);
+		}
 	}
 
+	dp_context_release(&dpc);
 	switch_xml_free(xml);
 	xml = NULL;
 
@@ -717,6 +1329,16 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_dialplan_xml_load)
 {
 	switch_dialplan_interface_t *dp_interface;
 
+	memset(&globals, 0, sizeof(globals));
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_core_hash_init(&globals.contexts);
+
+	if ((switch_event_bind_removable(modname, SWITCH_EVENT_RELOADXML, NULL, dp_reload_handler, NULL, &globals.node) != SWITCH_STATUS_SUCCESS)) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Couldn't bind!\n");
+		switch_core_hash_destroy(&globals.contexts);
+		return SWITCH_STATUS_TERM;
+	}
+
 	/* connect my internal structure to the blank pointer passed to me */
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
 	SWITCH_ADD_DIALPLAN(dp_interface, "XML", dialplan_hunt);
@@ -725,6 +1347,15 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_dialplan_xml_load)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_dialplan_xml_shutdown)
+{
+	switch_event_unbind(&globals.node);
+	dp_context_flush();
+	switch_core_hash_destroy(&globals.contexts);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 /* For Emacs:
  * Local Variables:
  * mode:c
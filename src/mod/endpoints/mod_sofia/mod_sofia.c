@@ -2771,6 +2771,8 @@ static switch_status_t cmd_status(char **argv, int argc, switch_stream_handle_t
 					stream->write_function(stream, "CALLS-OUT        \t%u\n", profile->ob_calls);
 					stream->write_function(stream, "FAILED-CALLS-OUT \t%u\n", profile->ob_failed_calls);
 					stream->write_function(stream, "REGISTRATIONS    \t%lu\n", sofia_profile_reg_count(profile));
+					stream->write_function(stream, "NOTIFY-SENT      \t%u\n", profile->notify_sent);
+					stream->write_function(stream, "NOTIFY-SUPPRESSED\t%u\n", profile->notify_suppressed);
 				}
 
 				cb.profile = profile;
@@ -2894,6 +2896,10 @@ static switch_status_t cmd_status(char **argv, int argc, switch_stream_handle_t
 	switch_mutex_unlock(mod_sofia_globals.hash_mutex);
 	stream->write_function(stream, "%s\n", line);
 	stream->write_function(stream, "%d profile%s %d alias%s\n", c, c == 1 ? "" : "s", ac, ac == 1 ? "" : "es");
+	if (mod_sofia_globals.presence_coalesce_ms) {
+		stream->write_function(stream, "%u presence event%s coalesced\n", mod_sofia_globals.presence_coalesced,
+							   mod_sofia_globals.presence_coalesced == 1 ? "" : "s");
+	}
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -3076,6 +3082,8 @@ static switch_status_t cmd_xml_status(char **argv, int argc, switch_stream_handl
 					stream->write_function(stream, "    <failed-calls-in>%u</failed-calls-in>\n", profile->ib_failed_calls);
 					stream->write_function(stream, "    <failed-calls-out>%u</failed-calls-out>\n", profile->ob_failed_calls);
 					stream->write_function(stream, "    <registrations>%lu</registrations>\n", sofia_profile_reg_count(profile));
+					stream->write_function(stream, "    <notify-sent>%u</notify-sent>\n", profile->notify_sent);
+					stream->write_function(stream, "    <notify-suppressed>%u</notify-suppressed>\n", profile->notify_suppressed);
 					stream->write_function(stream, "  </profile-info>\n");
 				}
 
@@ -145,6 +145,7 @@ typedef struct private_object private_object_t;
 #include "sofia-sip/tport_tag.h"
 #include <sofia-sip/msg.h>
 #include <sofia-sip/uniqueid.h>
+#include "sofia_reg_store.h"
 
 typedef enum {
 	SOFIA_CONFIG_LOAD = 0,
@@ -291,6 +292,9 @@ typedef enum {
 	PFLAG_PROXY_REFER,
 	PFLAG_CHANNEL_XML_FETCH_ON_NIGHTMARE_TRANSFER,
 	PFLAG_FIRE_TRANFER_EVENTS,
+	PFLAG_REG_STORE_MEMORY,
+	PFLAG_REG_WRITE_BEHIND,
+	PFLAG_PRESENCE_STORE_MEMORY,
 
 	/* No new flags below this line */
 	PFLAG_MAX
@@ -383,6 +387,9 @@ struct mod_sofia_globals {
 	uint32_t max_reg_threads;
 	time_t presence_epoch;
 	int presence_year;
+	/* how long a presence event waits for a newer one about the same thing, 0 to send right away */
+	uint32_t presence_coalesce_ms;
+	uint32_t presence_coalesced;
 };
 extern struct mod_sofia_globals mod_sofia_globals;
 
@@ -568,6 +575,48 @@ typedef enum {
 
 #define MAX_RTPIP 50
 
+/* subscriptions held in memory, see sofia_presence_sub_store_create() */
+typedef enum {
+	SOFIA_SUB_IDX_SUB_TO_USER,
+	SOFIA_SUB_IDX_CALL_ID,
+	SOFIA_SUB_IDX_MAX
+} sofia_sub_idx_t;
+
+typedef struct sofia_sub_s sofia_sub_t;
+struct sofia_sub_s {
+	/* the sip_subscriptions columns the presence fan-out needs */
+	char *proto;
+	char *sip_user;
+	char *sip_host;
+	char *sub_to_user;
+	char *sub_to_host;
+	char *presence_hosts;
+	char *event;
+	char *contact;
+	char *call_id;
+	char *full_from;
+	char *full_via;
+	char *user_agent;
+	char *accept;
+	char *network_port;
+	char *network_ip;
+	char *orig_proto;
+	char *full_to;
+	long expires;
+	int version;
+	/* what the last NOTIFY for the subscription said, a state that did not change is not sent again */
+	uint32_t last_hash;
+	sofia_sub_t *next[SOFIA_SUB_IDX_MAX];
+	sofia_sub_t *prev[SOFIA_SUB_IDX_MAX];
+};
+
+typedef struct {
+	switch_mutex_t *mutex;
+	/* each key maps to the first of a list of subscriptions linked through next[] */
+	switch_hash_t *index[SOFIA_SUB_IDX_MAX];
+	uint32_t count;
+} sofia_sub_store_t;
+
 typedef enum {
 	KA_MESSAGE,
 	KA_INFO
@@ -756,6 +805,14 @@ struct sofia_profile {
 	ka_type_t keepalive;
 	int bind_attempts;
 	int bind_attempt_interval;
+	sofia_reg_store_t *reg_store;
+	sofia_sub_store_t *sub_store;
+	/* NOTIFYs per second the presence thread paces itself to, 0 for no limit */
+	uint32_t notify_rate;
+	uint32_t notify_tokens;
+	switch_time_t notify_refill;
+	uint32_t notify_sent;
+	uint32_t notify_suppressed;
 };
 
 
@@ -1181,6 +1238,10 @@ void sofia_process_dispatch_event(sofia_dispatch_event_t **dep);
 void sofia_process_dispatch_event_in_thread(sofia_dispatch_event_t **dep);
 char *sofia_glue_get_host(const char *str, switch_memory_pool_t *pool);
 void sofia_presence_check_subscriptions(sofia_profile_t *profile, time_t now);
+void sofia_presence_sub_store_create(sofia_profile_t *profile);
+void sofia_presence_sub_store_destroy(sofia_profile_t *profile);
+void sofia_presence_sub_store_add(sofia_profile_t *profile, const sofia_sub_t *sub);
+void sofia_presence_sub_store_del(sofia_profile_t *profile, const char *call_id);
 void sofia_msg_thread_start(int idx);
 void crtp_init(switch_loadable_module_interface_t *module_interface);
 int sofia_recover_callback(switch_core_session_t *session);
@@ -1196,6 +1257,16 @@ switch_status_t sofia_glue_ext_address_lookup(sofia_profile_t *profile, char **i
 											  const char *sourceip, switch_memory_pool_t *pool);
 void sofia_reg_check_socket(sofia_profile_t *profile, const char *call_id, const char *network_addr, const char *network_ip);
 void sofia_reg_close_handles(sofia_profile_t *profile);
+void sofia_reg_store_create(sofia_profile_t *profile);
+void sofia_reg_store_destroy(sofia_profile_t *profile);
+void sofia_reg_store_add(sofia_profile_t *profile, const sofia_reg_t *reg);
+uint32_t sofia_reg_store_update(sofia_profile_t *profile, const sofia_reg_match_t *match, const sofia_reg_t *changes);
+uint32_t sofia_reg_store_del(sofia_profile_t *profile, const sofia_reg_match_t *match, int reboot, switch_bool_t fire);
+uint32_t sofia_reg_store_count(sofia_profile_t *profile, const sofia_reg_match_t *match);
+uint32_t sofia_reg_store_find(sofia_profile_t *profile, const sofia_reg_match_t *match, switch_core_db_callback_func_t callback, void *pArg);
+void sofia_reg_store_expire(sofia_profile_t *profile, time_t now, int reboot);
+/* registers the statements registration-write-behind queues, once the profile queue manager is up */
+void sofia_reg_prepare_sql(sofia_profile_t *profile);
 
 void write_csta_xml_chunk(switch_event_t *event, switch_stream_handle_t stream, const char *csta_event, char *fwd_type);
 /* For Emacs:
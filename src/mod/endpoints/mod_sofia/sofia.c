@@ -96,6 +96,7 @@ void sofia_handle_sip_r_notify(switch_core_session_t *session, int status,
 		sql = switch_mprintf("delete from sip_subscriptions where call_id='%q'", sip->sip_call_id->i_id);
 		switch_assert(sql != NULL);
 		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+		sofia_presence_sub_store_del(profile, sip->sip_call_id->i_id);
 		nua_handle_destroy(nh);
 	}
 
@@ -1760,6 +1761,34 @@ static void our_sofia_event_callback(nua_event_t event,
 
 				sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
 
+				if (profile->sub_store) {
+					sofia_sub_t sub = { 0 };
+					char port[16];
+
+					switch_snprintf(port, sizeof(port), "%d", np.network_port);
+					sub.proto = proto;
+					sub.sip_user = (char *) from_user;
+					sub.sip_host = (char *) from_host;
+					sub.sub_to_user = (char *) to_user;
+					sub.sub_to_host = (char *) to_host;
+					sub.presence_hosts = profile->presence_hosts;
+					sub.event = event_str;
+					sub.contact = contact_str;
+					sub.call_id = (char *) call_id;
+					sub.full_from = (char *) full_from;
+					sub.full_via = (char *) full_via;
+					sub.expires = (long) switch_epoch_time_now(NULL) + 60;
+					sub.user_agent = (char *) full_agent;
+					sub.accept = accept_header;
+					sub.network_port = port;
+					sub.network_ip = np.network_ip;
+					sub.version = -1;
+					sub.orig_proto = orig_proto;
+					sub.full_to = switch_mprintf("%s;tag=%s", full_to, to_tag);
+					sofia_presence_sub_store_add(profile, &sub);
+					free(sub.full_to);
+				}
+
 				sip_to_tag(nh->nh_home, sip->sip_to, to_tag);
 			}
 
@@ -1781,6 +1810,12 @@ static void our_sofia_event_callback(nua_event_t event,
 			if (sofia_private && sofia_private->call_id && sofia_private->network_ip && sofia_private->network_port) {
 				char *sql;
 				switch_event_t *event = NULL;
+				sofia_reg_match_t match = { 0 };
+
+				match.call_id = sofia_private->call_id;
+				match.network_ip = sofia_private->network_ip;
+				match.network_port = sofia_private->network_port;
+				sofia_reg_store_del(profile, &match, 0, SWITCH_FALSE);
 
 				sql = switch_mprintf("delete from sip_registrations where call_id='%q' and network_ip='%q' and network_port='%q'",
 										   sofia_private->call_id, sofia_private->network_ip, sofia_private->network_port);
@@ -2436,6 +2471,7 @@ void event_handler(switch_event_t *event)
 		char *from_host = switch_event_get_header_nil(event, "orig-from-host");
 		char *call_id = switch_event_get_header_nil(event, "orig-call-id");
 		char *contact_str = switch_event_get_header_nil(event, "orig-contact");
+		sofia_reg_match_t match = { 0 };
 
 		sofia_profile_t *profile = NULL;
 
@@ -2446,10 +2482,14 @@ void event_handler(switch_event_t *event)
 
 		if (sofia_test_pflag(profile, PFLAG_MULTIREG)) {
 			sql = switch_mprintf("delete from sip_registrations where call_id='%q'", call_id);
+			match.call_id = call_id;
 		} else {
 			sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q'", from_user, from_host);
+			match.sip_user = from_user;
+			match.sip_host = from_host;
 		}
 
+		sofia_reg_store_del(profile, &match, 0, SWITCH_FALSE);
 		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Expired propagated registration for %s@%s->%s\n", from_user, from_host, contact_str);
 
@@ -2476,6 +2516,8 @@ void event_handler(switch_event_t *event)
 		char *orig_server_host = switch_event_get_header_nil(event, "orig-FreeSWITCH-IPv4");
 		char *orig_hostname = switch_event_get_header_nil(event, "orig-FreeSWITCH-Hostname");
 		char *fixed_contact_str = NULL;
+		sofia_reg_match_t match = { 0 };
+		sofia_reg_t reg = { 0 };
 
 		sofia_profile_t *profile = NULL;
 		char guess_ip4[256];
@@ -2512,8 +2554,11 @@ void event_handler(switch_event_t *event)
 		}
 		if (sofia_test_pflag(profile, PFLAG_MULTIREG)) {
 			sql = switch_mprintf("delete from sip_registrations where call_id='%q'", call_id);
+			match.call_id = call_id;
 		} else {
 			sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q'", from_user, from_host);
+			match.sip_user = from_user;
+			match.sip_host = from_host;
 		}
 
 		if (mod_sofia_globals.rewrite_multicasted_fs_path && contact_str) {
@@ -2552,6 +2597,7 @@ void event_handler(switch_event_t *event)
 		}
 
 
+		sofia_reg_store_del(profile, &match, 0, SWITCH_FALSE);
 		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 
 		switch_find_local_ip(guess_ip4, sizeof(guess_ip4), NULL, AF_INET);
@@ -2564,6 +2610,23 @@ void event_handler(switch_event_t *event)
 							 profile_name, mod_sofia_globals.hostname, network_ip, network_port, username, realm, mwi_user, mwi_host,
 							 orig_server_host, orig_hostname, "Reachable", 0);
 
+		reg.call_id = call_id;
+		reg.sip_user = from_user;
+		reg.sip_host = from_host;
+		reg.presence_hosts = presence_hosts;
+		reg.contact = contact_str;
+		reg.status = "Registered";
+		reg.rpid = rpid;
+		reg.expires = expires;
+		reg.user_agent = user_agent;
+		reg.server_user = to_user;
+		reg.server_host = guess_ip4;
+		reg.network_ip = network_ip;
+		reg.network_port = network_port;
+		reg.sip_username = username;
+		reg.sip_realm = realm;
+		sofia_reg_store_add(profile, &reg);
+
 		if (sql) {
 			sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Propagating registration for %s@%s->%s\n", from_user, from_host, contact_str);
@@ -2841,6 +2904,19 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 		goto end;
 	}
 
+	if (sofia_test_pflag(profile, PFLAG_REG_STORE_MEMORY)) {
+		sofia_reg_store_create(profile);
+
+		if (sofia_test_pflag(profile, PFLAG_REG_WRITE_BEHIND) && !zstr(profile->odbc_dsn)) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Profile %s shares its database, registrations are written through\n",
+							  profile->name);
+		}
+	}
+
+	if (sofia_test_pflag(profile, PFLAG_PRESENCE_STORE_MEMORY)) {
+		sofia_presence_sub_store_create(profile);
+	}
+
 	supported = switch_core_sprintf(profile->pool, "%s%s%spath, replaces", use_100rel ? "precondition, 100rel, " : "", use_timer ? "timer, " : "", use_rfc_5626 ? "outbound, " : "");
 
 	if (sofia_test_pflag(profile, PFLAG_AUTO_NAT) && switch_nat_get_type()) {
@@ -3064,6 +3140,7 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 									   profile->inner_pre_trans_execute,
 									   profile->inner_post_trans_execute);
 	switch_sql_queue_manager_start(profile->qm);
+	sofia_reg_prepare_sql(profile);
 
 	if (switch_event_create(&s_event, SWITCH_EVENT_PUBLISH) == SWITCH_STATUS_SUCCESS) {
 		switch_event_add_header(s_event, SWITCH_STACK_BOTTOM, "service", "_sip._udp,_sip._tcp,_sip._sctp%s",
@@ -3193,6 +3270,8 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 	switch_core_hash_destroy(&profile->chat_hash);
 	switch_core_hash_destroy(&profile->reg_nh_hash);
 	switch_core_hash_destroy(&profile->mwi_debounce_hash);
+	sofia_reg_store_destroy(profile);
+	sofia_presence_sub_store_destroy(profile);
 
 	switch_thread_rwlock_unlock(profile->rwlock);
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Write unlock %s\n", profile->name);
@@ -4060,6 +4139,10 @@ switch_status_t config_sofia(sofia_config_t reload, char *profile_name)
 				mod_sofia_globals.debug_presence = atoi(val);
 			} else if (!strcasecmp(var, "debug-sla")) {
 				mod_sofia_globals.debug_sla = atoi(val);
+			} else if (!strcasecmp(var, "presence-coalesce-ms")) {
+				int x = atoi(val);
+
+				mod_sofia_globals.presence_coalesce_ms = x > 0 ? x : 0;
 			} else if (!strcasecmp(var, "max-reg-threads") && val) {
 				int x = atoi(val);
 
@@ -4186,6 +4269,7 @@ switch_status_t config_sofia(sofia_config_t reload, char *profile_name)
 					sofia_set_pflag(profile, PFLAG_ALLOW_UPDATE);
 					sofia_set_pflag(profile, PFLAG_SEND_DISPLAY_UPDATE);
 					sofia_set_pflag(profile, PFLAG_MESSAGE_QUERY_ON_FIRST_REGISTER);
+					sofia_set_pflag(profile, PFLAG_REG_WRITE_BEHIND);
 					//sofia_set_pflag(profile, PFLAG_PRESENCE_ON_FIRST_REGISTER);
 
 					sofia_clear_pflag(profile, PFLAG_CHANNEL_XML_FETCH_ON_NIGHTMARE_TRANSFER);
@@ -4375,6 +4459,34 @@ switch_status_t config_sofia(sofia_config_t reload, char *profile_name)
 						} else {
 							sofia_clear_pflag(profile, PFLAG_MWI_USE_REG_CALLID);
 						}
+					} else if (!strcasecmp(var, "registration-store")) {
+						/* only looked at when the profile starts */
+						if (!strcasecmp(val, "memory")) {
+							sofia_set_pflag(profile, PFLAG_REG_STORE_MEMORY);
+						} else {
+							sofia_clear_pflag(profile, PFLAG_REG_STORE_MEMORY);
+						}
+					} else if (!strcasecmp(var, "notify-rate")) {
+						int x = atoi(val);
+
+						if (x >= 0 && x <= 100000) {
+							profile->notify_rate = x;
+						} else {
+							switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Invalid notify-rate %s, must be between 0 and 100000\n", val);
+						}
+					} else if (!strcasecmp(var, "presence-store")) {
+						/* only looked at when the profile starts */
+						if (!strcasecmp(val, "memory")) {
+							sofia_set_pflag(profile, PFLAG_PRESENCE_STORE_MEMORY);
+						} else {
+							sofia_clear_pflag(profile, PFLAG_PRESENCE_STORE_MEMORY);
+						}
+					} else if (!strcasecmp(var, "registration-write-behind")) {
+						if (switch_true(val)) {
+							sofia_set_pflag(profile, PFLAG_REG_WRITE_BEHIND);
+						} else {
+							sofia_clear_pflag(profile, PFLAG_REG_WRITE_BEHIND);
+						}
 					} else if (!strcasecmp(var, "tcp-unreg-on-socket-close")) {
 						if (switch_true(val)) {
 							sofia_set_pflag(profile, PFLAG_TCP_UNREG_ON_SOCKET_CLOSE);
@@ -5043,6 +5155,18 @@ switch_status_t config_sofia(sofia_config_t reload, char *profile_name)
 						} else {
 							sofia_clear_media_flag(profile, SCMF_DISABLE_TRANSCODING);
 						}
+					} else if (!strcasecmp(var, "rtp-batch-recv")) {
+						if (switch_true(val)) {
+							sofia_set_media_flag(profile, SCMF_RTP_BATCH_RECV);
+						} else {
+							sofia_clear_media_flag(profile, SCMF_RTP_BATCH_RECV);
+						}
+					} else if (!strcasecmp(var, "rtp-batch-send")) {
+						if (switch_true(val)) {
+							sofia_set_media_flag(profile, SCMF_RTP_BATCH_SEND);
+						} else {
+							sofia_clear_media_flag(profile, SCMF_RTP_BATCH_SEND);
+						}
 					} else if (!strcasecmp(var, "rtp-rewrite-timestamps")) {
 						if (switch_true(val)) {
 							sofia_set_media_flag(profile, SCMF_REWRITE_TIMESTAMPS);
@@ -5892,6 +6016,17 @@ static void sofia_handle_sip_r_options(switch_core_session_t *session, int statu
 											 (long) now, ping_time, sip->sip_to->a_url->url_user, sip->sip_to->a_url->url_host, call_id);
 						sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 						switch_safe_free(sql);
+
+						if (profile->reg_store) {
+							sofia_reg_match_t match = { 0 };
+							sofia_reg_t reg = { 0 };
+
+							match.sip_user = sip->sip_to->a_url->url_user;
+							match.sip_host = sip->sip_to->a_url->url_host;
+							match.call_id = call_id;
+							reg.expires = (long) now;
+							sofia_reg_store_update(profile, &match, &reg);
+						}
 					}
 				}
 			}
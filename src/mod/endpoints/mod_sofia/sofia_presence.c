@@ -64,6 +64,7 @@ struct pres_sql_cb {
 };
 
 static int sofia_presence_send_sql(void *pArg, int argc, char **argv, char **columnNames);
+static switch_bool_t sofia_presence_execute_sql_notify(sofia_profile_t *profile, char *sql, switch_core_db_callback_func_t callback, void *pArg);
 
 struct dialog_helper {
 	char state[128];
@@ -95,7 +96,8 @@ struct presence_helper {
 	char last_uuid[512];
 	int hup;
 	int calls_up;
-
+	/* a fan-out to every watcher, rather than an answer to one subscription */
+	int fanout;
 };
 
 switch_status_t sofia_presence_chat_send(switch_event_t *message_event)
@@ -433,7 +435,7 @@ void sofia_presence_cancel(void)
 										 "event='presence' and hostname='%q' and profile_name='%q'",
 										 mod_sofia_globals.hostname, profile->name);
 
-					r = sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_sub_callback, &helper);
+					r = sofia_presence_execute_sql_notify(profile, sql, sofia_presence_sub_callback, &helper);
 					switch_safe_free(sql);
 
 					if (r != SWITCH_TRUE) {
@@ -601,7 +603,7 @@ static void actual_sofia_presence_mwi_event_handler(switch_event_t *event)
 
 
 	if (sql) {
-		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_mwi_callback, &h);
+		sofia_presence_execute_sql_notify(profile, sql, sofia_presence_mwi_callback, &h);
 		free(sql);
 		sql = NULL;
 
@@ -619,7 +621,7 @@ static void actual_sofia_presence_mwi_event_handler(switch_event_t *event)
 
 	if (sql) {
 		switch_assert(sql != NULL);
-		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_mwi_callback2, &h);
+		sofia_presence_execute_sql_notify(profile, sql, sofia_presence_mwi_callback2, &h);
 		free(sql);
 		sql = NULL;
 	}
@@ -678,6 +680,522 @@ static int sofia_presence_dialog_callback(void *pArg, int argc, char **argv, cha
 }
 
 
+/*
+ * The subscription store keeps a profile's SUBSCRIBE dialogs in memory when presence-store is set to memory, indexed by
+ * the user they watch and by call-id, so a presence event finds its watchers without joining sip_subscriptions.  The
+ * table is still written as subscriptions come and go and stays the source for the probes, MWI and SLA.
+ */
+
+static const size_t sofia_sub_fields[] = {
+	offsetof(sofia_sub_t, proto),
+	offsetof(sofia_sub_t, sip_user),
+	offsetof(sofia_sub_t, sip_host),
+	offsetof(sofia_sub_t, sub_to_user),
+	offsetof(sofia_sub_t, sub_to_host),
+	offsetof(sofia_sub_t, presence_hosts),
+	offsetof(sofia_sub_t, event),
+	offsetof(sofia_sub_t, contact),
+	offsetof(sofia_sub_t, call_id),
+	offsetof(sofia_sub_t, full_from),
+	offsetof(sofia_sub_t, full_via),
+	offsetof(sofia_sub_t, user_agent),
+	offsetof(sofia_sub_t, accept),
+	offsetof(sofia_sub_t, network_port),
+	offsetof(sofia_sub_t, network_ip),
+	offsetof(sofia_sub_t, orig_proto),
+	offsetof(sofia_sub_t, full_to)
+};
+
+#define SOFIA_SUB_FIELD_COUNT (sizeof(sofia_sub_fields) / sizeof(sofia_sub_fields[0]))
+#define sofia_sub_field(_sub, _i) (*(char **) ((char *) (_sub) + sofia_sub_fields[_i]))
+
+/* the columns of the select the fan-out used to run, for sofia_presence_sub_callback() */
+static char *sofia_sub_columns[] = {
+	"proto", "sip_user", "sip_host", "sub_to_user", "sub_to_host", "event", "contact", "call_id", "full_from", "full_via",
+	"expires", "user_agent", "accept", "profile_name", "status", "rpid", "host", "presence_status", "presence_rpid",
+	"open_closed", "dialog_status", "dialog_rpid", "version", "presence_id", "orig_proto", "full_to", "network_ip", "network_port"
+};
+
+#define SOFIA_SUB_COLUMN_COUNT (sizeof(sofia_sub_columns) / sizeof(sofia_sub_columns[0]))
+
+/* one allocation for the subscription and its strings, missing columns become empty strings like in the table */
+static sofia_sub_t *sofia_sub_dup(const sofia_sub_t *src)
+{
+	sofia_sub_t *sub;
+	switch_size_t len = sizeof(*sub), flen[SOFIA_SUB_FIELD_COUNT];
+	const char *val;
+	char *p;
+	uint32_t i;
+
+	for (i = 0; i < SOFIA_SUB_FIELD_COUNT; i++) {
+		val = sofia_sub_field(src, i);
+		flen[i] = val ? strlen(val) + 1 : 1;
+		len += flen[i];
+	}
+
+	switch_zmalloc(sub, len);
+	p = (char *) (sub + 1);
+
+	for (i = 0; i < SOFIA_SUB_FIELD_COUNT; i++) {
+		val = sofia_sub_field(src, i);
+		sofia_sub_field(sub, i) = p;
+		if (val) {
+			memcpy(p, val, flen[i]);
+		}
+		p += flen[i];
+	}
+
+	sub->expires = src->expires;
+	sub->version = src->version;
+	sub->last_hash = src->last_hash;
+
+	return sub;
+}
+
+static const char *sofia_sub_key(sofia_sub_t *sub, sofia_sub_idx_t idx)
+{
+	return idx == SOFIA_SUB_IDX_CALL_ID ? sub->call_id : sub->sub_to_user;
+}
+
+static void sofia_sub_link(sofia_sub_store_t *store, sofia_sub_t *sub)
+{
+	sofia_sub_t *head;
+	const char *key;
+	int i;
+
+	for (i = 0; i < SOFIA_SUB_IDX_MAX; i++) {
+		key = sofia_sub_key(sub, i);
+		if ((head = switch_core_hash_find(store->index[i], key))) {
+			head->prev[i] = sub;
+		}
+		sub->next[i] = head;
+		sub->prev[i] = NULL;
+		switch_core_hash_insert(store->index[i], key, sub);
+	}
+
+	store->count++;
+}
+
+static void sofia_sub_unlink(sofia_sub_store_t *store, sofia_sub_t *sub)
+{
+	int i;
+
+	for (i = 0; i < SOFIA_SUB_IDX_MAX; i++) {
+		if (sub->next[i]) {
+			sub->next[i]->prev[i] = sub->prev[i];
+		}
+		if (sub->prev[i]) {
+			sub->prev[i]->next[i] = sub->next[i];
+		} else if (sub->next[i]) {
+			switch_core_hash_insert(store->index[i], sofia_sub_key(sub, i), sub->next[i]);
+		} else {
+			switch_core_hash_delete(store->index[i], sofia_sub_key(sub, i));
+		}
+	}
+
+	store->count--;
+}
+
+/* a call-id names one subscription, the table just does not say so; call with the store locked */
+static sofia_sub_t *sofia_sub_find(sofia_sub_store_t *store, const char *call_id)
+{
+	return (sofia_sub_t *) switch_core_hash_find(store->index[SOFIA_SUB_IDX_CALL_ID], call_id);
+}
+
+/* take the subscriptions that expired by now, or all of them, out of the store; call with the store locked */
+static void sofia_sub_prune(sofia_sub_store_t *store, time_t now)
+{
+	switch_hash_index_t *hi;
+	sofia_sub_t *sub, *next;
+	void *val;
+
+	for (hi = switch_core_hash_first(store->index[SOFIA_SUB_IDX_CALL_ID]); hi; ) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		/* the current entry may go away with its last subscription */
+		hi = switch_core_hash_next(&hi);
+		for (sub = (sofia_sub_t *) val; sub; sub = next) {
+			next = sub->next[SOFIA_SUB_IDX_CALL_ID];
+			if (!now || (sub->expires > 0 && sub->expires <= now)) {
+				sofia_sub_unlink(store, sub);
+				free(sub);
+			}
+		}
+	}
+}
+
+static int sofia_sub_load_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	sofia_profile_t *profile = (sofia_profile_t *) pArg;
+	sofia_sub_t sub = { 0 };
+
+	sub.proto = argv[0];
+	sub.sip_user = argv[1];
+	sub.sip_host = argv[2];
+	sub.sub_to_user = argv[3];
+	sub.sub_to_host = argv[4];
+	sub.presence_hosts = argv[5];
+	sub.event = argv[6];
+	sub.contact = argv[7];
+	sub.call_id = argv[8];
+	sub.full_from = argv[9];
+	sub.full_via = argv[10];
+	sub.expires = argv[11] ? atol(argv[11]) : 0;
+	sub.user_agent = argv[12];
+	sub.accept = argv[13];
+	sub.network_port = argv[14];
+	sub.network_ip = argv[15];
+	sub.version = argv[16] ? atoi(argv[16]) : 0;
+	sub.orig_proto = argv[17];
+	sub.full_to = argv[18];
+
+	if (!zstr(sub.call_id)) {
+		sofia_presence_sub_store_add(profile, &sub);
+	}
+
+	return 0;
+}
+
+void sofia_presence_sub_store_create(sofia_profile_t *profile)
+{
+	sofia_sub_store_t *store;
+	char *sql;
+	int i;
+
+	store = switch_core_alloc(profile->pool, sizeof(*store));
+	switch_mutex_init(&store->mutex, SWITCH_MUTEX_NESTED, profile->pool);
+	for (i = 0; i < SOFIA_SUB_IDX_MAX; i++) {
+		switch_core_hash_init(&store->index[i]);
+	}
+	profile->sub_store = store;
+
+	sql = switch_mprintf("select proto,sip_user,sip_host,sub_to_user,sub_to_host,presence_hosts,event,contact,call_id,full_from,"
+						 "full_via,expires,user_agent,accept,network_port,network_ip,version,orig_proto,full_to from sip_subscriptions "
+						 "where profile_name='%q' and hostname='%q'", profile->name, mod_sofia_globals.hostname);
+	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_sub_load_callback, profile);
+	switch_safe_free(sql);
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Loaded %u subscriptions for profile %s\n", store->count, profile->name);
+}
+
+void sofia_presence_sub_store_destroy(sofia_profile_t *profile)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	int i;
+
+	if (!store) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+	profile->sub_store = NULL;
+	sofia_sub_prune(store, 0);
+	for (i = 0; i < SOFIA_SUB_IDX_MAX; i++) {
+		switch_core_hash_destroy(&store->index[i]);
+	}
+	switch_mutex_unlock(store->mutex);
+}
+
+void sofia_presence_sub_store_add(sofia_profile_t *profile, const sofia_sub_t *sub)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_t *dup, *old;
+
+	if (!store) {
+		return;
+	}
+
+	dup = sofia_sub_dup(sub);
+
+	switch_mutex_lock(store->mutex);
+	if ((old = sofia_sub_find(store, dup->call_id))) {
+		sofia_sub_unlink(store, old);
+		free(old);
+	}
+	sofia_sub_link(store, dup);
+	switch_mutex_unlock(store->mutex);
+}
+
+/* a NULL call_id empties the store */
+void sofia_presence_sub_store_del(sofia_profile_t *profile, const char *call_id)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_t *sub;
+
+	if (!store) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+	if (!call_id) {
+		sofia_sub_prune(store, 0);
+	} else {
+		while ((sub = sofia_sub_find(store, call_id))) {
+			sofia_sub_unlink(store, sub);
+			free(sub);
+		}
+	}
+	switch_mutex_unlock(store->mutex);
+}
+
+/* a re-SUBSCRIBE, the columns set in changes replace the old ones */
+static void sofia_presence_sub_store_refresh(sofia_profile_t *profile, const sofia_sub_t *changes)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_t *sub, merged;
+	const char *val;
+	uint32_t i;
+
+	if (!store) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+	if ((sub = sofia_sub_find(store, changes->call_id))) {
+		merged = *sub;
+		for (i = 0; i < SOFIA_SUB_FIELD_COUNT; i++) {
+			if ((val = sofia_sub_field(changes, i))) {
+				sofia_sub_field(&merged, i) = (char *) val;
+			}
+		}
+		merged.expires = changes->expires;
+		/* the subscriber gets the full state again after it subscribes */
+		merged.last_hash = 0;
+
+		sofia_sub_unlink(store, sub);
+		sofia_sub_link(store, sofia_sub_dup(&merged));
+		free(sub);
+	}
+	switch_mutex_unlock(store->mutex);
+}
+
+/*
+ * The conference and line-seize updates of sip_subscriptions, by call_id or by watched user and host: expires is set,
+ * and the version bumped with bump set, or the subscriptions go away with del set.  Unset conditions match anything.
+ */
+static void sofia_presence_sub_store_mark(sofia_profile_t *profile, const char *call_id, const char *user, const char *host,
+										  const char *event, long expires, switch_bool_t bump, switch_bool_t del)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_idx_t idx = call_id ? SOFIA_SUB_IDX_CALL_ID : SOFIA_SUB_IDX_SUB_TO_USER;
+	sofia_sub_t *sub, *next;
+
+	if (!store || !(call_id || user)) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+	for (sub = switch_core_hash_find(store->index[idx], call_id ? call_id : user); sub; sub = next) {
+		next = sub->next[idx];
+
+		if ((user && strcmp(sub->sub_to_user, user)) || (host && strcmp(sub->sub_to_host, host)) || (event && strcmp(sub->event, event))) {
+			continue;
+		}
+
+		if (del) {
+			sofia_sub_unlink(store, sub);
+			free(sub);
+			continue;
+		}
+
+		sub->expires = expires;
+		if (bump) {
+			sub->version++;
+			sub->last_hash = 0;
+		}
+	}
+	switch_mutex_unlock(store->mutex);
+}
+
+static switch_bool_t sofia_presence_sub_store_contact(sofia_profile_t *profile, const char *call_id, char *buf, switch_size_t len)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_t *sub;
+
+	switch_mutex_lock(store->mutex);
+	if ((sub = sofia_sub_find(store, call_id))) {
+		switch_copy_string(buf, sub->contact, len);
+	}
+	switch_mutex_unlock(store->mutex);
+
+	return sub ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+/* the version the next NOTIFY outside the fan-out carries, -1 when the store does not know the subscription */
+static int sofia_presence_sub_store_bump(sofia_profile_t *profile, const char *call_id)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_t *sub;
+	int version = -1;
+
+	if (!store || zstr(call_id)) {
+		return -1;
+	}
+
+	switch_mutex_lock(store->mutex);
+	if ((sub = sofia_sub_find(store, call_id))) {
+		version = ++sub->version;
+		sub->last_hash = 0;
+	}
+	switch_mutex_unlock(store->mutex);
+
+	return version;
+}
+
+/*
+ * Whether a NOTIFY with this body should go out.  With unchanged set the subscription already has this state, so a
+ * flap that ends where it started does not reach the phone; otherwise the body and its version are remembered.
+ */
+static switch_bool_t sofia_presence_sub_store_notified(sofia_profile_t *profile, const char *call_id, const char *pl, const char *version,
+													   switch_bool_t unchanged)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_t *sub;
+	const char *p;
+	uint32_t hash;
+	int v;
+
+	if (!store || zstr(call_id) || zstr(pl)) {
+		return SWITCH_TRUE;
+	}
+
+	/* dialog-info counts its versions, they are not part of the state */
+	if ((p = strstr(pl, "\" state=\""))) {
+		pl = p;
+	}
+
+	if (!(hash = switch_hashfunc_default(pl, NULL))) {
+		hash = 1;
+	}
+
+	switch_mutex_lock(store->mutex);
+	if ((sub = sofia_sub_find(store, call_id))) {
+		if (unchanged && sub->last_hash == hash) {
+			profile->notify_suppressed++;
+			switch_mutex_unlock(store->mutex);
+			return SWITCH_FALSE;
+		}
+		sub->last_hash = hash;
+		if (version && (v = atoi(version)) > sub->version) {
+			sub->version = v;
+		}
+	}
+	switch_mutex_unlock(store->mutex);
+
+	return SWITCH_TRUE;
+}
+
+struct sofia_sub_presence {
+	char key[512];
+	char status[512];
+	char rpid[512];
+	char open_closed[512];
+	int hits;
+};
+
+static int sofia_sub_presence_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	struct sofia_sub_presence *sp = (struct sofia_sub_presence *) pArg;
+
+	if (!sp->hits++) {
+		switch_copy_string(sp->status, switch_str_nil(argv[0]), sizeof(sp->status));
+		switch_copy_string(sp->rpid, switch_str_nil(argv[1]), sizeof(sp->rpid));
+		switch_copy_string(sp->open_closed, switch_str_nil(argv[2]), sizeof(sp->open_closed));
+	}
+
+	return 0;
+}
+
+/*
+ * Hand the watchers of euser@host, or the subscription call_id names, to sofia_presence_sub_callback() the way the
+ * sip_subscriptions select did.  Only PUBLISHed presence still comes from the table, one lookup per watched address.
+ */
+static void sofia_presence_sub_store_fanout(sofia_profile_t *profile, struct presence_helper *helper, struct dialog_helper *dh,
+											const char *call_id, const char *proto, const char *event_type, const char *alt_event_type,
+											const char *euser, const char *host, const char *status, const char *rpid)
+{
+	sofia_sub_store_t *store = profile->sub_store;
+	sofia_sub_t *sub, **subs = NULL;
+	struct sofia_sub_presence sp = { { 0 } };
+	const char *extsipip = profile->extsipip ? profile->extsipip : "N/A";
+	char *argv[SOFIA_SUB_COLUMN_COUNT];
+	char expires[32], version[32], key[512];
+	char *sql;
+	sofia_sub_idx_t idx = zstr(call_id) ? SOFIA_SUB_IDX_SUB_TO_USER : SOFIA_SUB_IDX_CALL_ID;
+	uint32_t i, n = 0, size = 0;
+
+	switch_mutex_lock(store->mutex);
+	for (sub = switch_core_hash_find(store->index[idx], idx == SOFIA_SUB_IDX_CALL_ID ? call_id : euser); sub; sub = sub->next[idx]) {
+		if (!strcmp(sub->event, "line-seize")) {
+			continue;
+		}
+
+		if (idx == SOFIA_SUB_IDX_SUB_TO_USER &&
+			(strcmp(sub->proto, proto) || (strcmp(sub->event, event_type) && strcmp(sub->event, alt_event_type)) ||
+			 (strcmp(sub->sub_to_host, host) && strcmp(sub->sub_to_host, switch_str_nil(profile->sipip)) &&
+			  strcmp(sub->sub_to_host, extsipip) && !strstr(sub->presence_hosts, host)))) {
+			continue;
+		}
+
+		if (n == size) {
+			size = size ? size * 2 : 16;
+			switch_assert((subs = realloc(subs, size * sizeof(*subs))));
+		}
+		subs[n++] = sofia_sub_dup(sub);
+	}
+	switch_mutex_unlock(store->mutex);
+
+	for (i = 0; i < n; i++) {
+		sub = subs[i];
+
+		switch_snprintf(key, sizeof(key), "%s@%s", sub->sub_to_user, sub->sub_to_host);
+		if (strcmp(sp.key, key)) {
+			memset(&sp, 0, sizeof(sp));
+			switch_copy_string(sp.key, key, sizeof(sp.key));
+			sql = switch_mprintf("select status,rpid,open_closed from sip_presence where hostname='%q' and profile_name='%q' and "
+								 "sip_user='%q' and sip_host='%q'", mod_sofia_globals.hostname, profile->name, sub->sub_to_user, sub->sub_to_host);
+			sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_sub_presence_callback, &sp);
+			switch_safe_free(sql);
+		}
+
+		switch_snprintf(expires, sizeof(expires), "%ld", sub->expires);
+		switch_snprintf(version, sizeof(version), "%d", sub->version + 1);
+
+		argv[0] = sub->proto;
+		argv[1] = sub->sip_user;
+		argv[2] = sub->sip_host;
+		argv[3] = sub->sub_to_user;
+		argv[4] = sub->sub_to_host;
+		argv[5] = sub->event;
+		argv[6] = sub->contact;
+		argv[7] = sub->call_id;
+		argv[8] = sub->full_from;
+		argv[9] = sub->full_via;
+		argv[10] = expires;
+		argv[11] = sub->user_agent;
+		argv[12] = sub->accept;
+		argv[13] = profile->name;
+		argv[14] = (char *) switch_str_nil(status);
+		argv[15] = (char *) switch_str_nil(rpid);
+		argv[16] = (char *) host;
+		argv[17] = sp.hits ? sp.status : NULL;
+		argv[18] = sp.hits ? sp.rpid : NULL;
+		argv[19] = sp.hits ? sp.open_closed : NULL;
+		argv[20] = dh->status;
+		argv[21] = dh->rpid;
+		argv[22] = version;
+		argv[23] = dh->presence_id;
+		argv[24] = sub->orig_proto;
+		argv[25] = sub->full_to;
+		argv[26] = sub->network_ip;
+		argv[27] = sub->network_port;
+
+		sofia_presence_sub_callback(helper, SOFIA_SUB_COLUMN_COUNT, argv, sofia_sub_columns);
+		free(sub);
+	}
+
+	switch_safe_free(subs);
+}
+
 static void do_normal_probe(switch_event_t *event)
 {
 	char *sql;
@@ -851,6 +1369,8 @@ static void do_dialog_probe(switch_event_t *event)
 		sofia_profile_t *profile = sofia_glue_find_profile(probe_host);
 		struct rfc4235_helper *h4235 = {0};
 		switch_memory_pool_t *pool;
+		char version_col[32] = "version";
+		int version;
 
 		if (!profile && profile_name) {
 			profile = sofia_glue_find_profile(profile_name);
@@ -911,28 +1431,33 @@ static void do_dialog_probe(switch_event_t *event)
 		}
 
 
-		sql = switch_mprintf("update sip_subscriptions set version=version+1 where call_id='%q'", sub_call_id);
+		if ((version = sofia_presence_sub_store_bump(profile, sub_call_id)) > -1) {
+			/* the store keeps the versions, the table's column is not kept up */
+			switch_snprintf(version_col, sizeof(version_col), "%d", version);
+		} else {
+			sql = switch_mprintf("update sip_subscriptions set version=version+1 where call_id='%q'", sub_call_id);
 
-		if (mod_sofia_globals.debug_presence > 1) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s DUMP DIALOG_PROBE set version sql:\n%s\n", profile->name, sql);
+			if (mod_sofia_globals.debug_presence > 1) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s DUMP DIALOG_PROBE set version sql:\n%s\n", profile->name, sql);
+			}
+			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			switch_safe_free(sql);
 		}
-		sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
-		switch_safe_free(sql);
 
 
 		// The dialog_probe_callback has built up the dialogs to be included in the NOTIFY.
 		// Now send the "full" dialog event to the triggering subscription.
-		sql = switch_mprintf("select call_id,expires,sub_to_user,sub_to_host,event,version, "
+		sql = switch_mprintf("select call_id,expires,sub_to_user,sub_to_host,event,%s, "
 							 "'full',full_to,full_from,contact,network_ip,network_port "
 							 "from sip_subscriptions "
 							 "where hostname='%q' and profile_name='%q' and sub_to_user='%q' and sub_to_host='%q' and call_id='%q'",
-							 mod_sofia_globals.hostname, profile->name, probe_euser, probe_host, sub_call_id);
+							 version_col, mod_sofia_globals.hostname, profile->name, probe_euser, probe_host, sub_call_id);
 
 		if (mod_sofia_globals.debug_presence > 1) {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s DUMP DIALOG_PROBE subscription sql:\n%s\n", profile->name, sql);
 		}
 
-		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_dialog_probe_notify_callback, h4235);
+		sofia_presence_execute_sql_notify(profile, sql, sofia_dialog_probe_notify_callback, h4235);
 		switch_safe_free(sql);
 
 		sofia_glue_release_profile(profile);
@@ -981,6 +1506,7 @@ static void send_conference_data(sofia_profile_t *profile, switch_event_t *event
 							 from_user, from_host, event_str);
 
 		sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+		sofia_presence_sub_store_mark(profile, NULL, from_user, from_host, event_str, (long) switch_epoch_time_now(NULL), SWITCH_FALSE, SWITCH_FALSE);
 	}
 
 	if (call_id) {
@@ -993,6 +1519,7 @@ static void send_conference_data(sofia_profile_t *profile, switch_event_t *event
 							   from_user, from_host, event_str, call_id);
 
 		  sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+		  sofia_presence_sub_store_mark(profile, call_id, from_user, from_host, event_str, 0, SWITCH_FALSE, SWITCH_FALSE);
 	   }
 
 		sql = switch_mprintf("select full_to, full_from, contact %q ';_;isfocus', expires, call_id, event, network_ip, network_port, "
@@ -1014,6 +1541,7 @@ static void send_conference_data(sofia_profile_t *profile, switch_event_t *event
 							  from_user, from_host, event_str);
 
 		 sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+		 sofia_presence_sub_store_mark(profile, NULL, from_user, from_host, event_str, 0, SWITCH_FALSE, SWITCH_FALSE);
 	  }
 
 		sql = switch_mprintf("select full_to, full_from, contact %q ';_;isfocus', expires, call_id, event, network_ip, network_port, "
@@ -1027,7 +1555,7 @@ static void send_conference_data(sofia_profile_t *profile, switch_event_t *event
 							 from_user, from_host, event_str);
 	}
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_send_sql, &cb);
+	sofia_presence_execute_sql_notify(profile, sql, sofia_presence_send_sql, &cb);
 	switch_safe_free(sql);
 
 	if (switch_true(final)) {
@@ -1046,6 +1574,7 @@ static void send_conference_data(sofia_profile_t *profile, switch_event_t *event
 		}
 
 		sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+		sofia_presence_sub_store_mark(profile, call_id, from_user, from_host, event_str, 0, SWITCH_FALSE, SWITCH_TRUE);
 	}
 
 
@@ -1232,7 +1761,7 @@ static switch_event_t *actual_sofia_presence_event_handler(switch_event_t *event
 					memset(&helper, 0, sizeof(helper));
 					helper.profile = profile;
 					helper.event = NULL;
-					sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_sub_callback, &helper);
+					sofia_presence_execute_sql_notify(profile, sql, sofia_presence_sub_callback, &helper);
 					switch_safe_free(sql);
 					sofia_glue_release_profile(profile);
 				}
@@ -1417,7 +1946,9 @@ static switch_event_t *actual_sofia_presence_event_handler(switch_event_t *event
 					goto done;
 				}
 
-				if (zstr(call_id)) {
+				if (profile->sub_store) {
+					/* the store finds the watchers and keeps their versions, see sofia_presence_sub_store_fanout() */
+				} else if (zstr(call_id)) {
 
 					sql = switch_mprintf("update sip_subscriptions set version=version+1 where hostname='%q' and profile_name='%q' and "
 										 "sip_subscriptions.event != 'line-seize' "
@@ -1502,6 +2033,7 @@ static switch_event_t *actual_sofia_presence_event_handler(switch_event_t *event
 				helper.calls_up = dh.hits;
 				helper.profile = profile;
 				helper.event = event;
+				helper.fanout = zstr(call_id);
 				SWITCH_STANDARD_STREAM(helper.stream);
 				switch_assert(helper.stream.data);
 
@@ -1515,14 +2047,18 @@ static switch_event_t *actual_sofia_presence_event_handler(switch_event_t *event
 					switch_event_serialize(event, &buf, SWITCH_FALSE);
 					switch_assert(buf);
 					if (mod_sofia_globals.debug_presence > 1) {
-						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "DUMP PRESENCE SQL:\n%s\nEVENT DUMP:\n%s\n", sql, buf);
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "DUMP PRESENCE SQL:\n%s\nEVENT DUMP:\n%s\n", switch_str_nil(sql), buf);
 					} else {
 						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "EVENT DUMP:\n%s\n", buf);
 					}
 					free(buf);
 				}
 
-				sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_sub_callback, &helper);
+				if (profile->sub_store) {
+					sofia_presence_sub_store_fanout(profile, &helper, &dh, call_id, proto, event_type, alt_event_type, euser, host, status, rpid);
+				} else {
+					sofia_presence_execute_sql_notify(profile, sql, sofia_presence_sub_callback, &helper);
+				}
 				switch_safe_free(sql);
 
 				if (mod_sofia_globals.debug_presence > 0) {
@@ -1585,6 +2121,133 @@ static switch_event_t *actual_sofia_presence_event_handler(switch_event_t *event
 
 static int EVENT_THREAD_RUNNING = 0;
 static int EVENT_THREAD_STARTED = 0;
+static switch_thread_id_t EVENT_THREAD_ID;
+
+/*
+ * Presence events held back for presence-coalesce-ms.  A newer event about the same thing takes the place of the one
+ * waiting, so a phone that rings, answers and hangs up within the window only causes the fan-out for the hangup.
+ */
+typedef struct sofia_pres_held_s {
+	char *key;
+	switch_event_t *event;
+	switch_time_t due;
+	struct sofia_pres_held_s *next;
+} sofia_pres_held_t;
+
+static struct {
+	switch_hash_t *hash;
+	sofia_pres_held_t *head;
+	sofia_pres_held_t *tail;
+} HELD;
+
+/* what a later event can replace this one by, NULL for the ones that have to go out as they are */
+static char *sofia_presence_coalesce_key(switch_event_t *event)
+{
+	const char *from, *uuid;
+
+	switch (event->event_id) {
+	case SWITCH_EVENT_MESSAGE_WAITING:
+		/* counts are absolute, but an answer to one subscription is not for the others */
+		if (!(from = switch_event_get_header(event, "mwi-message-account")) ||
+			switch_event_get_header(event, "call-id") || switch_event_get_header(event, "sub-call-id")) {
+			return NULL;
+		}
+		return switch_mprintf("mwi/%s/%s", switch_str_nil(switch_event_get_header(event, "sofia-profile")), from);
+	case SWITCH_EVENT_PRESENCE_IN:
+	case SWITCH_EVENT_PRESENCE_OUT:
+		/* each NOTIFY only describes its own call, so calls are not folded into each other */
+		if (!(from = switch_event_get_header(event, "from")) || switch_event_get_header(event, "call-id")) {
+			return NULL;
+		}
+		uuid = switch_event_get_header(event, "unique-id");
+		return switch_mprintf("pres/%s/%s/%s/%s", switch_str_nil(switch_event_get_header(event, "proto")), from,
+							  switch_str_nil(switch_event_get_header(event, "event_type")), switch_str_nil(uuid));
+	default:
+		return NULL;
+	}
+}
+
+/* SWITCH_TRUE when the event is held, it is the held list's to destroy then */
+static switch_bool_t sofia_presence_coalesce(switch_event_t *event)
+{
+	sofia_pres_held_t *held;
+	char *key;
+
+	if (!mod_sofia_globals.presence_coalesce_ms || !(key = sofia_presence_coalesce_key(event))) {
+		return SWITCH_FALSE;
+	}
+
+	if (!HELD.hash) {
+		switch_core_hash_init(&HELD.hash);
+	}
+
+	if ((held = switch_core_hash_find(HELD.hash, key))) {
+		/* keeps its place and its deadline, a busy key still goes out once per window */
+		switch_event_destroy(&held->event);
+		held->event = event;
+		mod_sofia_globals.presence_coalesced++;
+		free(key);
+		return SWITCH_TRUE;
+	}
+
+	switch_zmalloc(held, sizeof(*held));
+	held->key = key;
+	held->event = event;
+	held->due = switch_micro_time_now() + (switch_time_t) mod_sofia_globals.presence_coalesce_ms * 1000;
+
+	if (HELD.tail) {
+		HELD.tail->next = held;
+	} else {
+		HELD.head = held;
+	}
+	HELD.tail = held;
+	switch_core_hash_insert(HELD.hash, key, held);
+
+	return SWITCH_TRUE;
+}
+
+static void sofia_presence_dispatch(switch_event_t *event)
+{
+	switch(event->event_id) {
+	case SWITCH_EVENT_MESSAGE_WAITING:
+		actual_sofia_presence_mwi_event_handler(event);
+		break;
+	case SWITCH_EVENT_CONFERENCE_DATA:
+		conference_data_event_handler(event);
+		break;
+	default:
+		do {
+			switch_event_t *ievent = event;
+			event = actual_sofia_presence_event_handler(ievent);
+			switch_event_destroy(&ievent);
+		} while (event);
+		break;
+	}
+
+	switch_event_destroy(&event);
+}
+
+/* hand the held events that are due to the handlers, all of them with run set, or just drop them */
+static void sofia_presence_release(switch_time_t now, switch_bool_t run)
+{
+	sofia_pres_held_t *held;
+
+	while ((held = HELD.head) && (!now || held->due <= now)) {
+		if (!(HELD.head = held->next)) {
+			HELD.tail = NULL;
+		}
+		switch_core_hash_delete(HELD.hash, held->key);
+
+		if (run) {
+			sofia_presence_dispatch(held->event);
+		} else {
+			switch_event_destroy(&held->event);
+		}
+
+		free(held->key);
+		free(held);
+	}
+}
 
 static void do_flush(void)
 {
@@ -1595,12 +2258,15 @@ static void do_flush(void)
 		switch_event_destroy(&event);
 	}
 
+	sofia_presence_release(0, SWITCH_FALSE);
 }
 
 void *SWITCH_THREAD_FUNC sofia_presence_event_thread_run(switch_thread_t *thread, void *obj)
 {
 	void *pop;
 	int done = 0;
+	switch_status_t status;
+	switch_time_t now;
 
 	switch_mutex_lock(mod_sofia_globals.mutex);
 	if (!EVENT_THREAD_RUNNING) {
@@ -1615,12 +2281,20 @@ void *SWITCH_THREAD_FUNC sofia_presence_event_thread_run(switch_thread_t *thread
 		return NULL;
 	}
 
+	EVENT_THREAD_ID = switch_thread_self();
+
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Event Thread Started\n");
 
 	while (mod_sofia_globals.running == 1) {
-		int count = 0;
+		if (HELD.head && (now = switch_micro_time_now()) < HELD.head->due) {
+			status = switch_queue_pop_timeout(mod_sofia_globals.presence_queue, &pop, HELD.head->due - now);
+		} else if (HELD.head) {
+			status = switch_queue_trypop(mod_sofia_globals.presence_queue, &pop);
+		} else {
+			status = switch_queue_pop(mod_sofia_globals.presence_queue, &pop);
+		}
 
-		if (switch_queue_pop(mod_sofia_globals.presence_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+		if (status == SWITCH_STATUS_SUCCESS) {
 			switch_event_t *event = (switch_event_t *) pop;
 
 			if (!pop) {
@@ -1636,29 +2310,21 @@ void *SWITCH_THREAD_FUNC sofia_presence_event_thread_run(switch_thread_t *thread
 				switch_mutex_unlock(mod_sofia_globals.mutex);
 			}
 
-			switch(event->event_id) {
-			case SWITCH_EVENT_MESSAGE_WAITING:
-				actual_sofia_presence_mwi_event_handler(event);
-				break;
-			case SWITCH_EVENT_CONFERENCE_DATA:
-				conference_data_event_handler(event);
-				break;
-			default:
-				do {
-					switch_event_t *ievent = event;
-					event = actual_sofia_presence_event_handler(ievent);
-					switch_event_destroy(&ievent);
-				} while (event);
-				break;
+			if (!sofia_presence_coalesce(event)) {
+				sofia_presence_dispatch(event);
 			}
-
-			switch_event_destroy(&event);
-			count++;
 		}
+
+		/* with coalescing turned off since, whatever is still held goes out now */
+		sofia_presence_release(mod_sofia_globals.presence_coalesce_ms ? switch_micro_time_now() : 0, SWITCH_TRUE);
 	}
 
 	do_flush();
 
+	if (HELD.hash) {
+		switch_core_hash_destroy(&HELD.hash);
+	}
+
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Event Thread Ended\n");
 
 	switch_mutex_lock(mod_sofia_globals.mutex);
@@ -2154,6 +2820,142 @@ uint32_t sofia_presence_get_cseq(sofia_profile_t *profile)
 }
 
 
+/*
+ * Count a NOTIFY against the profile's notify-rate.  The bucket holds a second's worth; the presence thread waits for
+ * a token so a fan-out spreads out instead of bursting, the threads answering SIP never wait and only use tokens up.
+ */
+static void sofia_presence_notify_pace(sofia_profile_t *profile)
+{
+	switch_time_t now, wait = 0, interval;
+	uint32_t add;
+
+	switch_mutex_lock(profile->flag_mutex);
+	profile->notify_sent++;
+
+	if (profile->notify_rate) {
+		interval = 1000000 / profile->notify_rate;
+		now = switch_micro_time_now();
+
+		if (!profile->notify_refill || now - profile->notify_refill >= 1000000) {
+			profile->notify_tokens = profile->notify_rate;
+			profile->notify_refill = now;
+		} else if ((add = (uint32_t) ((now - profile->notify_refill) / interval))) {
+			profile->notify_tokens += add;
+			profile->notify_refill += add * interval;
+			if (profile->notify_tokens > profile->notify_rate) {
+				profile->notify_tokens = profile->notify_rate;
+			}
+		}
+
+		if (profile->notify_tokens) {
+			profile->notify_tokens--;
+		} else if (switch_thread_equal(switch_thread_self(), EVENT_THREAD_ID)) {
+			/* the next token is this NOTIFY's */
+			profile->notify_refill += interval;
+			wait = profile->notify_refill - now;
+		}
+	}
+	switch_mutex_unlock(profile->flag_mutex);
+
+	if (wait > 0) {
+		switch_yield(wait);
+	}
+}
+
+/* the rows of a query, copied so they outlive it */
+typedef struct sofia_presence_row_s {
+	int argc;
+	char **argv;
+	char **columnNames;
+	struct sofia_presence_row_s *next;
+} sofia_presence_row_t;
+
+struct sofia_presence_rows {
+	sofia_presence_row_t *head;
+	sofia_presence_row_t *tail;
+};
+
+static char **sofia_presence_row_dup(int argc, char **v)
+{
+	char **dup;
+	int i;
+
+	if (!v) {
+		return NULL;
+	}
+
+	switch_zmalloc(dup, (argc + 1) * sizeof(*dup));
+	for (i = 0; i < argc; i++) {
+		dup[i] = v[i] ? strdup(v[i]) : NULL;
+	}
+
+	return dup;
+}
+
+static void sofia_presence_row_free(char **v, int argc)
+{
+	int i;
+
+	if (v) {
+		for (i = 0; i < argc; i++) {
+			switch_safe_free(v[i]);
+		}
+		free(v);
+	}
+}
+
+static int sofia_presence_rows_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	struct sofia_presence_rows *rows = (struct sofia_presence_rows *) pArg;
+	sofia_presence_row_t *row;
+
+	switch_zmalloc(row, sizeof(*row));
+	row->argc = argc;
+	row->argv = sofia_presence_row_dup(argc, argv);
+	row->columnNames = sofia_presence_row_dup(argc, columnNames);
+
+	if (rows->tail) {
+		rows->tail->next = row;
+	} else {
+		rows->head = row;
+	}
+	rows->tail = row;
+
+	return 0;
+}
+
+/*
+ * sofia_glue_execute_sql_callback() for the callbacks that send NOTIFYs.  On the presence thread with a notify-rate set
+ * the rows are collected first, so sofia_presence_notify_pace() waits without the database handle and its cursor held.
+ */
+static switch_bool_t sofia_presence_execute_sql_notify(sofia_profile_t *profile, char *sql, switch_core_db_callback_func_t callback, void *pArg)
+{
+	struct sofia_presence_rows rows = { 0 };
+	sofia_presence_row_t *row;
+	switch_bool_t ret;
+	int stop = 0;
+
+	if (!profile->notify_rate || !switch_thread_equal(switch_thread_self(), EVENT_THREAD_ID)) {
+		return sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, callback, pArg);
+	}
+
+	ret = sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_rows_callback, &rows);
+
+	while ((row = rows.head)) {
+		rows.head = row->next;
+
+		if (!stop && callback(pArg, row->argc, row->argv, row->columnNames)) {
+			stop = 1;
+		}
+
+		sofia_presence_row_free(row->argv, row->argc);
+		sofia_presence_row_free(row->columnNames, row->argc);
+		free(row);
+	}
+
+	return ret;
+}
+
 #define send_presence_notify(_a,_b,_c,_d,_e,_f,_g,_h,_i,_j,_k,_l) \
 _send_presence_notify(_a,_b,_c,_d,_e,_f,_g,_h,_i,_j,_k,_l,__FILE__, __SWITCH_FUNC__, __LINE__)
 
@@ -2193,6 +2995,8 @@ static void _send_presence_notify(sofia_profile_t *profile,
 		return;
 	}
 
+	sofia_presence_notify_pace(profile);
+
 	if ((cparams = strstr(o_contact, ";_;"))) {
 		cparams += 3;
 	}
@@ -3223,6 +4027,13 @@ static int sofia_presence_sub_callback(void *pArg, int argc, char **argv, char *
 		}
 	}
 
+	if (!sofia_presence_sub_store_notified(profile, call_id, pl, is_dialog ? version : NULL, helper->fanout)) {
+		if (mod_sofia_globals.debug_presence > 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s state unchanged for %s, not notifying\n", profile->name, call_id);
+		}
+		goto end;
+	}
+
 	send_presence_notify(profile, full_to, full_from, contact, expires, call_id, event, ip, port, ct, pl, NULL);
 
 
@@ -3323,6 +4134,8 @@ static int sofia_presence_mwi_callback2(void *pArg, int argc, char **argv, char
 		call_id = NULL;
 	}
 
+	/* unsolicited MWI counts against the notify-rate like the subscribed kind */
+	sofia_presence_notify_pace(profile);
 	sofia_glue_send_notify(profile, user, host, event, contenttype, body, o_contact, network_ip, call_id);
 
 	if (ext_profile) {
@@ -3505,6 +4318,7 @@ static int sync_sla(sofia_profile_t *profile, const char *to_user, const char *t
 								 call_id);
 
 			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			sofia_presence_sub_store_mark(profile, call_id, NULL, NULL, "line-seize", (long) switch_epoch_time_now(NULL), SWITCH_TRUE, SWITCH_FALSE);
 
 			if (mod_sofia_globals.debug_sla > 1) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "CLEAR SQL %s\n", sql);
@@ -3517,7 +4331,7 @@ static int sync_sla(sofia_profile_t *profile, const char *to_user, const char *t
 
 								 "and event='line-seize'", call_id);
 
-			sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_send_sql, &cb);
+			sofia_presence_execute_sql_notify(profile, sql, sofia_presence_send_sql, &cb);
 			if (mod_sofia_globals.debug_sla > 1) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "CLEAR SQL %s\n", sql);
 			}
@@ -3537,6 +4351,7 @@ static int sync_sla(sofia_profile_t *profile, const char *to_user, const char *t
 			}
 
 			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			sofia_presence_sub_store_mark(profile, NULL, to_user, to_host, "line-seize", (long) switch_epoch_time_now(NULL), SWITCH_TRUE, SWITCH_FALSE);
 
 
 			sql = switch_mprintf("select full_to, full_from, contact, -1, call_id, event, network_ip, network_port, "
@@ -3548,7 +4363,7 @@ static int sync_sla(sofia_profile_t *profile, const char *to_user, const char *t
 								 mod_sofia_globals.hostname, profile->name, to_user, to_host
 								 );
 
-			sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_send_sql, &cb);
+			sofia_presence_execute_sql_notify(profile, sql, sofia_presence_send_sql, &cb);
 
 			if (mod_sofia_globals.debug_sla > 1) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "CLEAR SQL %s\n", sql);
@@ -3628,7 +4443,7 @@ static int sync_sla(sofia_profile_t *profile, const char *to_user, const char *t
 	}
 
 	sh->profile = profile;
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, broadsoft_sla_notify_callback, sh);
+	sofia_presence_execute_sql_notify(profile, sql, broadsoft_sla_notify_callback, sh);
 	switch_safe_free(sql);
 	total = sh->total;
 	sh = NULL;
@@ -3682,6 +4497,7 @@ void sofia_presence_handle_sip_i_subscribe(int status,
 	const char *use_to_tag;
 	char to_tag[13] = "";
 	char buf[1025] = "";
+	char port[16] = "";
 	char *orig_to_user = NULL;
 	char *p;
 
@@ -3882,7 +4698,9 @@ void sofia_presence_handle_sip_i_subscribe(int status,
 		proto = alt_proto;
 	}
 
-	if ((sub_state != nua_substate_terminated)) {
+	if (profile->sub_store && sub_state != nua_substate_terminated) {
+		sofia_presence_sub_store_contact(profile, call_id, buf, sizeof(buf));
+	} else if ((sub_state != nua_substate_terminated)) {
 		sql = switch_mprintf("select contact from sip_subscriptions where call_id='%q' and profile_name='%q' and hostname='%q'",
 							 call_id, profile->name, mod_sofia_globals.hostname);
 		sofia_glue_execute_sql2str(profile, profile->dbh_mutex, sql, buf, sizeof(buf));
@@ -3928,6 +4746,23 @@ void sofia_presence_handle_sip_i_subscribe(int status,
 		}
 
 		sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+
+		if (profile->sub_store) {
+			sofia_sub_t sub = { 0 };
+
+			switch_snprintf(port, sizeof(port), "%d", np.network_port);
+			sub.call_id = (char *) call_id;
+			sub.expires = (long) switch_epoch_time_now(NULL) + exp_delta;
+			sub.network_ip = np.network_ip;
+			sub.network_port = port;
+			sub.sip_user = (char *) from_user;
+			sub.sip_host = (char *) from_host;
+			sub.full_via = full_via;
+			sub.full_to = full_to;
+			sub.full_from = full_from;
+			sub.contact = contact;
+			sofia_presence_sub_store_refresh(profile, &sub);
+		}
 	} else {
 
 		if (sub_state == nua_substate_terminated) {
@@ -3941,6 +4776,7 @@ void sofia_presence_handle_sip_i_subscribe(int status,
 
 			switch_assert(sql != NULL);
 			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			sofia_presence_sub_store_del(profile, call_id);
 			sstr = switch_mprintf("terminated;reason=noresource");
 
 		} else {
@@ -3975,6 +4811,34 @@ void sofia_presence_handle_sip_i_subscribe(int status,
 
 
 			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+
+			if (profile->sub_store) {
+				sofia_sub_t sub = { 0 };
+
+				switch_snprintf(port, sizeof(port), "%d", np.network_port);
+				sub.proto = proto;
+				sub.sip_user = (char *) from_user;
+				sub.sip_host = (char *) from_host;
+				sub.sub_to_user = (char *) to_user;
+				sub.sub_to_host = (char *) to_host;
+				sub.presence_hosts = profile->presence_hosts;
+				sub.event = event;
+				sub.contact = contact_str;
+				sub.call_id = (char *) call_id;
+				sub.full_from = full_from;
+				sub.full_via = full_via;
+				sub.expires = (long) switch_epoch_time_now(NULL) + exp_delta;
+				sub.user_agent = full_agent;
+				sub.accept = accept_header;
+				sub.network_port = port;
+				sub.network_ip = np.network_ip;
+				sub.version = -1;
+				sub.orig_proto = orig_proto;
+				sub.full_to = switch_mprintf("%s;tag=%s", full_to, use_to_tag);
+				sofia_presence_sub_store_add(profile, &sub);
+				free(sub.full_to);
+			}
+
 			sstr = switch_mprintf("active;expires=%ld", exp_delta);
 		}
 
@@ -4682,7 +5546,7 @@ void sofia_presence_handle_sip_i_publish(nua_t *nua, sofia_profile_t *profile, n
 									 mod_sofia_globals.hostname, profile->name,
 									 from_user, from_host, event_type, contact_str);
 
-				sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_send_sql, &cb);
+				sofia_presence_execute_sql_notify(profile, sql, sofia_presence_send_sql, &cb);
 				switch_safe_free(sql);
 			}
 
@@ -5063,6 +5927,13 @@ void sofia_presence_check_subscriptions(sofia_profile_t *profile, time_t now)
 	if (now) {
 		struct pres_sql_cb cb = {profile, 0};
 
+		if (profile->sub_store) {
+			/* the table still says who gets the terminating NOTIFY, the store just forgets them */
+			switch_mutex_lock(profile->sub_store->mutex);
+			sofia_sub_prune(profile->sub_store, now);
+			switch_mutex_unlock(profile->sub_store->mutex);
+		}
+
 		if (profile->pres_type != PRES_TYPE_FULL) {
 			if (mod_sofia_globals.debug_presence > 0) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "check_subs: %s is passive, skipping\n", (char *) profile->name);
@@ -5082,7 +5953,7 @@ void sofia_presence_check_subscriptions(sofia_profile_t *profile, time_t now)
 							 " from sip_subscriptions where ((expires > 0 and expires <= %ld)) and profile_name='%q' and hostname='%q'",
 							 (long) now, profile->name, mod_sofia_globals.hostname);
 
-		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_send_sql, &cb);
+		sofia_presence_execute_sql_notify(profile, sql, sofia_presence_send_sql, &cb);
 		switch_safe_free(sql);
 
 		if (cb.ttl) {
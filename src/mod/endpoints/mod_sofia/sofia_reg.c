@@ -742,12 +742,271 @@ int sofia_reg_del_callback(void *pArg, int argc, char **argv, char **columnNames
 	return 0;
 }
 
+/*
+ * The registration store keeps a profile's registrations in memory when registration-store is set to memory, so
+ * REGISTER handling, contact lookups and the expire sweep do not have to ask the database.  The sip_registrations
+ * table is still written (behind the store, through the sql queue, unless registration-write-behind is off) for
+ * persistence, the api commands and the presence queries that join on it.  The store itself is in sofia_reg_store.c.
+ */
+
+/*
+ * Writing behind is only safe while the store answers every read that could see the row.  With a shared odbc
+ * database the counts and lookups go to the table and would miss what is still queued.
+ */
+static switch_bool_t sofia_reg_write_behind(sofia_profile_t *profile)
+{
+	return profile->reg_store && zstr(profile->odbc_dsn) && sofia_test_pflag(profile, PFLAG_REG_WRITE_BEHIND);
+}
+
+/*
+ * The writes REGISTER handling used to wait for.  Writing behind, they are queued as prepared statements on queue 0,
+ * so only the values travel and the queue thread rebinds one compiled statement per row.  With a store the expire
+ * deletes take the same queue, so they stay in order with the writes still waiting in it.
+ */
+static const struct {
+	const char *name;
+	const char *sql;
+} sofia_reg_stmts[] = {
+	{ "reg_insert",
+	  "insert into sip_registrations "
+	  "(call_id,sip_user,sip_host,presence_hosts,contact,status,rpid,expires,"
+	  "user_agent,server_user,server_host,profile_name,hostname,network_ip,network_port,sip_username,sip_realm,"
+	  "mwi_user,mwi_host, orig_server_host, orig_hostname, sub_host, ping_status, ping_count, force_ping) "
+	  "values (?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,'Reachable',0,?)" },
+	{ "reg_refresh",
+	  "update sip_registrations set call_id=?,"
+	  "sub_host=?, network_ip=?,network_port=?,"
+	  "presence_hosts=?, server_host=?, orig_server_host=?,"
+	  "hostname=?, orig_hostname=?,"
+	  "expires = ?, force_ping=? where sip_user=? and sip_username=? and sip_host=? and contact=?" },
+	{ "reg_del_call_id", "delete from sip_registrations where call_id=?" },
+	{ "reg_del_user", "delete from sip_registrations where sip_user=? and sip_host=?" },
+	{ "reg_del_contact", "delete from sip_registrations where sip_user=? and sip_host=? and contact=?" },
+	{ "reg_del_stale_call_id", "delete from sip_registrations where call_id=? and expires!=?" },
+	{ "reg_del_stale_contact", "delete from sip_registrations where contact=? and expires!=?" },
+	{ "reg_del_call_id_or_user", "delete from sip_registrations where call_id=? or (sip_user=? and sip_host=?)" },
+	{ "reg_del_call_id_or_host", "delete from sip_registrations where call_id=? or (sip_host=?)" },
+	{ "reg_del_expired", "delete from sip_registrations where expires > 0 and expires <= ? and hostname=?" },
+	{ "reg_del_expiring", "delete from sip_registrations where expires > 0 and hostname=?" }
+};
+
+void sofia_reg_prepare_sql(sofia_profile_t *profile)
+{
+	int i;
+
+	/* not only while the flag is set, a reload can turn registration-write-behind on and the expire deletes use them */
+	if (!profile->reg_store) {
+		return;
+	}
+
+	for (i = 0; i < (int) (sizeof(sofia_reg_stmts) / sizeof(sofia_reg_stmts[0])); i++) {
+		switch_sql_queue_manager_prepare(profile->qm, sofia_reg_stmts[i].name, sofia_reg_stmts[i].sql);
+	}
+}
+
+#define sofia_reg_push_stmt(_profile_, _name_, _argv_) \
+	switch_sql_queue_manager_push_stmt((_profile_)->qm, _name_, 0, (int) (sizeof(_argv_) / sizeof((_argv_)[0])), _argv_)
+
+/* drops registrations from the store and the table, by call_id or else by user and host and, if set, contact */
+static void sofia_reg_delete(sofia_profile_t *profile, const char *call_id, const char *user, const char *host, const char *contact)
+{
+	sofia_reg_match_t match = { 0 };
+	char *sql;
+
+	if (call_id) {
+		match.call_id = call_id;
+	} else {
+		match.sip_user = user;
+		match.sip_host = host;
+		match.contact = contact;
+	}
+
+	sofia_reg_store_del(profile, &match, 0, SWITCH_FALSE);
+
+	if (sofia_reg_write_behind(profile)) {
+		if (call_id) {
+			const char *argv[] = { call_id };
+			sofia_reg_push_stmt(profile, "reg_del_call_id", argv);
+		} else if (contact) {
+			const char *argv[] = { user, host, contact };
+			sofia_reg_push_stmt(profile, "reg_del_contact", argv);
+		} else {
+			const char *argv[] = { user, host };
+			sofia_reg_push_stmt(profile, "reg_del_user", argv);
+		}
+		return;
+	}
+
+	if (call_id) {
+		sql = switch_mprintf("delete from sip_registrations where call_id='%q'", call_id);
+	} else if (contact) {
+		sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q' and contact='%q'", user, host, contact);
+	} else {
+		sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q'", user, host);
+	}
+
+	sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+}
+
+static void sofia_reg_free_list(sofia_profile_t *profile, sofia_reg_t *list, int reboot, switch_bool_t fire)
+{
+	sofia_reg_t *reg;
+	char expires[32], rb[16];
+	char *argv[15];
+
+	switch_snprintf(rb, sizeof(rb), "%d", reboot);
+
+	while ((reg = list)) {
+		list = reg->wheel_next;
+
+		if (fire) {
+			/* the columns sofia_reg_check_expire() selects */
+			switch_snprintf(expires, sizeof(expires), "%ld", reg->expires);
+			argv[0] = reg->call_id;
+			argv[1] = reg->sip_user;
+			argv[2] = reg->sip_host;
+			argv[3] = reg->contact;
+			argv[4] = reg->status;
+			argv[5] = reg->rpid;
+			argv[6] = expires;
+			argv[7] = reg->user_agent;
+			argv[8] = reg->server_user;
+			argv[9] = reg->server_host;
+			argv[10] = profile->name;
+			argv[11] = reg->network_ip;
+			argv[12] = reg->network_port;
+			argv[13] = rb;
+			argv[14] = reg->sip_realm;
+			sofia_reg_del_callback(profile, 15, argv, NULL);
+		}
+
+		free(reg);
+	}
+}
+
+static int sofia_reg_load_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	sofia_profile_t *profile = (sofia_profile_t *) pArg;
+	sofia_reg_t reg = { 0 };
+
+	reg.call_id = argv[0];
+	reg.sip_user = argv[1];
+	reg.sip_host = argv[2];
+	reg.presence_hosts = argv[3];
+	reg.contact = argv[4];
+	reg.status = argv[5];
+	reg.rpid = argv[6];
+	reg.expires = argv[7] ? atol(argv[7]) : 0;
+	reg.user_agent = argv[8];
+	reg.server_user = argv[9];
+	reg.server_host = argv[10];
+	reg.network_ip = argv[11];
+	reg.network_port = argv[12];
+	reg.sip_username = argv[13];
+	reg.sip_realm = argv[14];
+
+	sofia_reg_store_add(profile, &reg);
+
+	return 0;
+}
+
+void sofia_reg_store_create(sofia_profile_t *profile)
+{
+	char *sql;
+
+	profile->reg_store = sofia_reg_mem_create(profile->pool);
+
+	/* pick up where the table left off */
+	sql = switch_mprintf("select call_id,sip_user,sip_host,presence_hosts,contact,status,rpid,expires,user_agent,server_user,"
+						 "server_host,network_ip,network_port,sip_username,sip_realm from sip_registrations "
+						 "where profile_name='%q' and hostname='%q'", profile->name, mod_sofia_globals.hostname);
+	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_load_callback, profile);
+	switch_safe_free(sql);
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Loaded %u registrations for profile %s\n", profile->reg_store->count, profile->name);
+}
+
+void sofia_reg_store_destroy(sofia_profile_t *profile)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	sofia_reg_t *list;
+
+	if (!store) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+	profile->reg_store = NULL;
+	list = sofia_reg_mem_destroy(store);
+	switch_mutex_unlock(store->mutex);
+
+	sofia_reg_free_list(profile, list, 0, SWITCH_FALSE);
+}
+
+void sofia_reg_store_add(sofia_profile_t *profile, const sofia_reg_t *reg)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+
+	if (store) {
+		sofia_reg_mem_add(store, reg);
+	}
+}
+
+uint32_t sofia_reg_store_update(sofia_profile_t *profile, const sofia_reg_match_t *match, const sofia_reg_t *changes)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+
+	return store ? sofia_reg_mem_update(store, match, changes) : 0;
+}
+
+uint32_t sofia_reg_store_del(sofia_profile_t *profile, const sofia_reg_match_t *match, int reboot, switch_bool_t fire)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	sofia_reg_t *list = NULL;
+	uint32_t n;
+
+	if (!store) {
+		return 0;
+	}
+
+	n = sofia_reg_mem_take(store, match, &list);
+
+	/* the events and reboot NOTIFYs go out without the store locked */
+	sofia_reg_free_list(profile, list, reboot, fire);
+
+	return n;
+}
+
+uint32_t sofia_reg_store_count(sofia_profile_t *profile, const sofia_reg_match_t *match)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+
+	return store ? sofia_reg_mem_count(store, match) : 0;
+}
+
+uint32_t sofia_reg_store_find(sofia_profile_t *profile, const sofia_reg_match_t *match, switch_core_db_callback_func_t callback, void *pArg)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+
+	return store ? sofia_reg_mem_find(store, match, callback, pArg) : 0;
+}
+
+void sofia_reg_store_expire(sofia_profile_t *profile, time_t now, int reboot)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+
+	if (store) {
+		sofia_reg_free_list(profile, sofia_reg_mem_take_expired(store, now), reboot, SWITCH_TRUE);
+	}
+}
+
 void sofia_reg_expire_call_id(sofia_profile_t *profile, const char *call_id, int reboot)
 {
 	char *sql = NULL;
 	char *sqlextra = NULL;
 	char *dup = strdup(call_id);
 	char *host = NULL, *user = NULL;
+	sofia_reg_match_t match = { 0 };
 
 	switch_assert(dup);
 
@@ -768,16 +1027,36 @@ void sofia_reg_expire_call_id(sofia_profile_t *profile, const char *call_id, int
 		sqlextra = switch_mprintf(" or (sip_user='%q' and sip_host='%q')", user, host);
 	}
 
-	sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-						 ",user_agent,server_user,server_host,profile_name,network_ip,network_port"
-						 ",%d,sip_realm from sip_registrations where call_id='%q' %s", reboot, call_id, sqlextra);
+	if (profile->reg_store) {
+		match.call_id = call_id;
+		sofia_reg_store_del(profile, &match, reboot, SWITCH_TRUE);
 
+		memset(&match, 0, sizeof(match));
+		match.sip_user = zstr(user) ? NULL : user;
+		match.sip_host = host;
+		sofia_reg_store_del(profile, &match, reboot, SWITCH_TRUE);
+	} else {
+		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+							 ",user_agent,server_user,server_host,profile_name,network_ip,network_port"
+							 ",%d,sip_realm from sip_registrations where call_id='%q' %s", reboot, call_id, sqlextra);
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
-	switch_safe_free(sql);
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
+		switch_safe_free(sql);
+	}
 
-	sql = switch_mprintf("delete from sip_registrations where call_id='%q' %s", call_id, sqlextra);
-	sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+	if (profile->reg_store) {
+		/* behind any insert or update still queued for it */
+		if (zstr(user)) {
+			const char *argv[] = { call_id, host };
+			sofia_reg_push_stmt(profile, "reg_del_call_id_or_host", argv);
+		} else {
+			const char *argv[] = { call_id, user, host };
+			sofia_reg_push_stmt(profile, "reg_del_call_id_or_user", argv);
+		}
+	} else {
+		sql = switch_mprintf("delete from sip_registrations where call_id='%q' %s", call_id, sqlextra);
+		sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+	}
 
 	switch_safe_free(sqlextra);
 	switch_safe_free(sql);
@@ -789,25 +1068,43 @@ void sofia_reg_check_expire(sofia_profile_t *profile, time_t now, int reboot)
 {
 	char *sql;
 
-	if (now) {
-		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-						",user_agent,server_user,server_host,profile_name,network_ip, network_port"
-						",%d,sip_realm from sip_registrations where expires > 0 and expires <= %ld", reboot, (long) now);
+	if (profile->reg_store) {
+		sofia_reg_store_expire(profile, now, reboot);
 	} else {
-		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-						",user_agent,server_user,server_host,profile_name,network_ip, network_port" ",%d,sip_realm from sip_registrations where expires > 0", reboot);
+		if (now) {
+			sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+							",user_agent,server_user,server_host,profile_name,network_ip, network_port"
+							",%d,sip_realm from sip_registrations where expires > 0 and expires <= %ld", reboot, (long) now);
+		} else {
+			sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+							",user_agent,server_user,server_host,profile_name,network_ip, network_port" ",%d,sip_realm from sip_registrations where expires > 0", reboot);
+		}
+
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
+		free(sql);
 	}
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
-	free(sql);
+	if (profile->reg_store) {
+		char now_c[32];
 
-	if (now) {
-		sql = switch_mprintf("delete from sip_registrations where expires > 0 and expires <= %ld and hostname='%q'",
-						(long) now, mod_sofia_globals.hostname);
+		if (now) {
+			const char *argv[] = { now_c, mod_sofia_globals.hostname };
+
+			switch_snprintf(now_c, sizeof(now_c), "%ld", (long) now);
+			sofia_reg_push_stmt(profile, "reg_del_expired", argv);
+		} else {
+			const char *argv[] = { mod_sofia_globals.hostname };
+			sofia_reg_push_stmt(profile, "reg_del_expiring", argv);
+		}
 	} else {
-		sql = switch_mprintf("delete from sip_registrations where expires > 0 and hostname='%q'", mod_sofia_globals.hostname);
+		if (now) {
+			sql = switch_mprintf("delete from sip_registrations where expires > 0 and expires <= %ld and hostname='%q'",
+							(long) now, mod_sofia_globals.hostname);
+		} else {
+			sql = switch_mprintf("delete from sip_registrations where expires > 0 and hostname='%q'", mod_sofia_globals.hostname);
+		}
+		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 	}
-	sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 	
 
 
@@ -998,13 +1295,16 @@ void sofia_reg_check_sync(sofia_profile_t *profile)
 {
 	char *sql;
 
-	sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-					",user_agent,server_user,server_host,profile_name,network_ip,network_port,0,sip_realm"
-					" from sip_registrations where expires > 0");
-
+	if (profile->reg_store) {
+		sofia_reg_store_expire(profile, 0, 0);
+	} else {
+		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+						",user_agent,server_user,server_host,profile_name,network_ip,network_port,0,sip_realm"
+						" from sip_registrations where expires > 0");
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
-	switch_safe_free(sql);
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
+		switch_safe_free(sql);
+	}
 
 	sql = switch_mprintf("delete from sip_registrations where expires > 0 and hostname='%q'", mod_sofia_globals.hostname);
 	sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
@@ -1017,12 +1317,30 @@ void sofia_reg_check_sync(sofia_profile_t *profile)
 	
 	sql = switch_mprintf("delete from sip_subscriptions where expires >= -1 and hostname='%q'", mod_sofia_globals.hostname);
 	sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+	sofia_presence_sub_store_del(profile, NULL);
 
 	sql = switch_mprintf("delete from sip_dialogs where expires >= -1 and hostname='%q'", mod_sofia_globals.hostname);
 	sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
 
 }
 
+/* the store only knows this node's registrations, a shared database may have the ones it is missing */
+static switch_bool_t sofia_reg_store_missing(sofia_profile_t *profile, const char *user, const char *host,
+											 switch_core_db_callback_func_t callback, void *pArg)
+{
+	sofia_reg_match_t match = { 0 };
+
+	if (!profile->reg_store) {
+		return SWITCH_TRUE;
+	}
+
+	match.sip_user = user;
+	match.sip_host = host;
+	match.presence_hosts = SWITCH_TRUE;
+
+	return !sofia_reg_store_find(profile, &match, callback, pArg) && !zstr(profile->odbc_dsn);
+}
+
 char *sofia_reg_find_reg_url(sofia_profile_t *profile, const char *user, const char *host, char *val, switch_size_t len)
 {
 	struct callback_t cbt = { 0 };
@@ -1036,6 +1354,10 @@ char *sofia_reg_find_reg_url(sofia_profile_t *profile, const char *user, const c
 	cbt.val = val;
 	cbt.len = len;
 
+	if (!sofia_reg_store_missing(profile, user, host, sofia_reg_find_callback, &cbt)) {
+		goto end;
+	}
+
 	if (host) {
 		sql = switch_mprintf("select contact from sip_registrations where sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')",
 						user, host, host);
@@ -1048,6 +1370,8 @@ char *sofia_reg_find_reg_url(sofia_profile_t *profile, const char *user, const c
 
 	switch_safe_free(sql);
 
+  end:
+
 	if (cbt.list) {
 		switch_console_free_matches(&cbt.list);
 	}
@@ -1070,6 +1394,10 @@ switch_console_callback_match_t *sofia_reg_find_reg_url_multi(sofia_profile_t *p
 		return NULL;
 	}
 
+	if (!sofia_reg_store_missing(profile, user, host, sofia_reg_find_callback, &cbt)) {
+		return cbt.list;
+	}
+
 	if (host) {
 		sql = switch_mprintf("select contact from sip_registrations where sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')",
 						user, host, host);
@@ -1096,6 +1424,14 @@ switch_console_callback_match_t *sofia_reg_find_reg_url_with_positive_expires_mu
 		return NULL;
 	}
 
+	cbt.time = reg_time;
+	cbt.contact_str = contact_str;
+	cbt.exptime = exptime;
+
+	if (!sofia_reg_store_missing(profile, user, host, sofia_reg_find_reg_with_positive_expires_callback, &cbt)) {
+		return cbt.list;
+	}
+
 	if (host) {
 		sql = switch_mprintf("select contact,expires from sip_registrations where sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')",
 						user, host, host);
@@ -1103,10 +1439,6 @@ switch_console_callback_match_t *sofia_reg_find_reg_url_with_positive_expires_mu
 		sql = switch_mprintf("select contact,expires from sip_registrations where sip_user='%q'", user);
 	}
 
-	cbt.time = reg_time;
-	cbt.contact_str = contact_str;
-	cbt.exptime = exptime;
-
 	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_find_reg_with_positive_expires_callback, &cbt);
 	free(sql);
 
@@ -1154,6 +1486,15 @@ uint32_t sofia_reg_reg_count(sofia_profile_t *profile, const char *user, const c
 {
 	char buf[32] = "";
 	char *sql;
+	sofia_reg_match_t match = { 0 };
+
+	/* with a shared database the count includes the other nodes */
+	if (profile->reg_store && zstr(profile->odbc_dsn)) {
+		match.sip_user = user;
+		match.sip_host = host;
+		match.presence_hosts = SWITCH_TRUE;
+		return sofia_reg_store_count(profile, &match);
+	}
 	
 	sql = switch_mprintf("select count(*) from sip_registrations where profile_name='%q' and "
 						 "sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')", profile->name, user, host, host);
@@ -1847,6 +2188,8 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 		char *url = NULL;
 		char *contact = NULL;
 		switch_bool_t update_registration = SWITCH_FALSE;
+		sofia_reg_match_t match = { 0 };
+		sofia_reg_t reg = { 0 };
 
 		if (auth_params) {
 			username = switch_event_get_header(auth_params, "sip_auth_username");
@@ -1856,16 +2199,22 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 		if (auth_res != AUTH_RENEWED || !multi_reg) {
 			if (multi_reg) {
 				if (multi_reg_contact) {
-					sql =
-						switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q' and contact='%q'", to_user, reg_host, contact_str);
+					sofia_reg_delete(profile, NULL, to_user, reg_host, contact_str);
 				} else {
-					sql = switch_mprintf("delete from sip_registrations where call_id='%q'", call_id);
+					sofia_reg_delete(profile, call_id, NULL, NULL, NULL);
 				}
 			} else {
-				sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q'", to_user, reg_host);
+				sofia_reg_delete(profile, NULL, to_user, reg_host, NULL);
 			}
+		} else if (profile->reg_store) {
+			match.sip_user = to_user;
+			match.sip_username = username;
+			match.sip_host = reg_host;
+			match.contact = contact_str;
 
-			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			if (sofia_reg_store_count(profile, &match) > 0) {
+				update_registration = SWITCH_TRUE;
+			}
 		} else {
 			char buf[32] = "";
 
@@ -1924,7 +2273,28 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 		}
 		
 
-		if (!update_registration) {
+		if (sofia_reg_write_behind(profile)) {
+			char expires_c[32], force_ping_c[16];
+
+			switch_snprintf(expires_c, sizeof(expires_c), "%ld", (long) reg_time + (long) exptime + profile->sip_expires_late_margin);
+			switch_snprintf(force_ping_c, sizeof(force_ping_c), "%d", force_ping);
+
+			if (!update_registration) {
+				const char *argv[] = { call_id, to_user, reg_host, profile->presence_hosts ? profile->presence_hosts : "",
+									   contact_str, reg_desc, rpid, expires_c,
+									   switch_str_nil(agent), switch_str_nil(from_user), guess_ip4, profile->name, mod_sofia_globals.hostname,
+									   network_ip, network_port_c, switch_str_nil(username), switch_str_nil(realm),
+									   switch_str_nil(mwi_user), switch_str_nil(mwi_host), guess_ip4, mod_sofia_globals.hostname,
+									   switch_str_nil(sub_host), force_ping_c };
+				sofia_reg_push_stmt(profile, "reg_insert", argv);
+			} else {
+				const char *argv[] = { call_id, switch_str_nil(sub_host), network_ip, network_port_c,
+									   profile->presence_hosts ? profile->presence_hosts : "", guess_ip4, guess_ip4,
+									   mod_sofia_globals.hostname, mod_sofia_globals.hostname, expires_c, force_ping_c,
+									   to_user, switch_str_nil(username), reg_host, contact_str };
+				sofia_reg_push_stmt(profile, "reg_refresh", argv);
+			}
+		} else if (!update_registration) {
 			sql = switch_mprintf("insert into sip_registrations "
 					"(call_id,sip_user,sip_host,presence_hosts,contact,status,rpid,expires,"
 					"user_agent,server_user,server_host,profile_name,hostname,network_ip,network_port,sip_username,sip_realm,"
@@ -1945,6 +2315,34 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
                                                                  mod_sofia_globals.hostname, mod_sofia_globals.hostname,
 								 (long) reg_time + (long) exptime + profile->sip_expires_late_margin, force_ping,
 								 to_user, username, reg_host, contact_str);
+		}
+
+		if (!update_registration) {
+			reg.call_id = (char *) call_id;
+			reg.sip_user = (char *) to_user;
+			reg.sip_host = (char *) reg_host;
+			reg.presence_hosts = profile->presence_hosts ? profile->presence_hosts : "";
+			reg.contact = contact_str;
+			reg.status = (char *) reg_desc;
+			reg.rpid = (char *) rpid;
+			reg.expires = (long) reg_time + (long) exptime + profile->sip_expires_late_margin;
+			reg.user_agent = (char *) agent;
+			reg.server_user = (char *) from_user;
+			reg.server_host = guess_ip4;
+			reg.network_ip = network_ip;
+			reg.network_port = network_port_c;
+			reg.sip_username = (char *) username;
+			reg.sip_realm = (char *) realm;
+			sofia_reg_store_add(profile, &reg);
+		} else {
+			/* match still holds user, username, host and contact */
+			reg.call_id = (char *) call_id;
+			reg.presence_hosts = profile->presence_hosts ? profile->presence_hosts : "";
+			reg.server_host = guess_ip4;
+			reg.network_ip = network_ip;
+			reg.network_port = network_port_c;
+			reg.expires = (long) reg_time + (long) exptime + profile->sip_expires_late_margin;
+			sofia_reg_store_update(profile, &match, &reg);
 		}				 
 
 		if (sql) {
@@ -1961,13 +2359,32 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 		}
 
 		if (multi_reg) {
+			memset(&match, 0, sizeof(match));
+			match.not_expires = (long) reg_time + (long) exptime + profile->sip_expires_late_margin;
+
 			if (multi_reg_contact) {
-				sql = switch_mprintf("delete from sip_registrations where contact='%q' and expires!=%ld", contact_str, (long) reg_time + (long) exptime + profile->sip_expires_late_margin);
+				match.contact = contact_str;
 			} else {
-				sql = switch_mprintf("delete from sip_registrations where call_id='%q' and expires!=%ld", call_id, (long) reg_time + (long) exptime + profile->sip_expires_late_margin);
+				match.call_id = call_id;
 			}
 			
-			sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+			sofia_reg_store_del(profile, &match, 0, SWITCH_FALSE);
+
+			if (sofia_reg_write_behind(profile)) {
+				/* behind the queued insert or update it cleans up after, not ahead of it */
+				char expires_c[32];
+				const char *argv[] = { multi_reg_contact ? contact_str : call_id, expires_c };
+
+				switch_snprintf(expires_c, sizeof(expires_c), "%ld", match.not_expires);
+				sofia_reg_push_stmt(profile, multi_reg_contact ? "reg_del_stale_contact" : "reg_del_stale_call_id", argv);
+			} else {
+				if (multi_reg_contact) {
+					sql = switch_mprintf("delete from sip_registrations where contact='%q' and expires!=%ld", contact_str, match.not_expires);
+				} else {
+					sql = switch_mprintf("delete from sip_registrations where call_id='%q' and expires!=%ld", call_id, match.not_expires);
+				}
+				sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+			}
 		}
 
 
@@ -2004,6 +2421,7 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 
 	} else {
 		int send = 1;
+		sofia_reg_match_t match = { 0 };
 
 		if (multi_reg) {
 			if (sofia_reg_reg_count(profile, to_user, sub_host) > 0) {
@@ -2038,20 +2456,14 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 			}
 
 			if (multi_reg_contact) {
-				sql =
-					switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q' and contact='%q'", to_user, reg_host, contact_str);
+				sofia_reg_delete(profile, NULL, to_user, reg_host, contact_str);
 			} else {
-				sql = switch_mprintf("delete from sip_registrations where call_id='%q'", call_id);
+				sofia_reg_delete(profile, call_id, NULL, NULL, NULL);
 			}
-	
-			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
 
 			switch_safe_free(icontact);
 		} else {
-
-			if ((sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q'", to_user, reg_host))) {
-				sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
-			}
+			sofia_reg_delete(profile, NULL, to_user, reg_host, NULL);
 		}
 	}
 
@@ -0,0 +1,460 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * sofia_reg_store.c -- SOFIA SIP Endpoint (in-memory registration store)
+ *
+ */
+#include "sofia_reg_store.h"
+
+static const size_t sofia_reg_fields[] = {
+	offsetof(sofia_reg_t, call_id),
+	offsetof(sofia_reg_t, sip_user),
+	offsetof(sofia_reg_t, sip_host),
+	offsetof(sofia_reg_t, presence_hosts),
+	offsetof(sofia_reg_t, contact),
+	offsetof(sofia_reg_t, status),
+	offsetof(sofia_reg_t, rpid),
+	offsetof(sofia_reg_t, user_agent),
+	offsetof(sofia_reg_t, server_user),
+	offsetof(sofia_reg_t, server_host),
+	offsetof(sofia_reg_t, network_ip),
+	offsetof(sofia_reg_t, network_port),
+	offsetof(sofia_reg_t, sip_username),
+	offsetof(sofia_reg_t, sip_realm)
+};
+
+#define sofia_reg_field(_reg, _i) (*(char **) ((char *) (_reg) + sofia_reg_fields[_i]))
+
+/* one allocation for the registration and its strings, missing columns become empty strings like in the table */
+static sofia_reg_t *sofia_reg_dup(const sofia_reg_t *src)
+{
+	sofia_reg_t *reg;
+	switch_size_t len = sizeof(*reg), flen[sizeof(sofia_reg_fields) / sizeof(sofia_reg_fields[0])];
+	const char *val;
+	char *p;
+	int i, n = sizeof(sofia_reg_fields) / sizeof(sofia_reg_fields[0]);
+
+	for (i = 0; i < n; i++) {
+		val = sofia_reg_field(src, i);
+		flen[i] = val ? strlen(val) + 1 : 1;
+		len += flen[i];
+	}
+
+	len += flen[1] + flen[2];
+
+	switch_zmalloc(reg, len);
+	p = (char *) (reg + 1);
+
+	for (i = 0; i < n; i++) {
+		val = sofia_reg_field(src, i);
+		sofia_reg_field(reg, i) = p;
+		if (val) {
+			memcpy(p, val, flen[i]);
+		}
+		p += flen[i];
+	}
+
+	reg->user_host = p;
+	switch_snprintf(p, flen[1] + flen[2], "%s@%s", reg->sip_user, reg->sip_host);
+	reg->expires = src->expires;
+
+	return reg;
+}
+
+static const char *sofia_reg_key(sofia_reg_t *reg, sofia_reg_idx_t idx)
+{
+	switch (idx) {
+	case SOFIA_REG_IDX_USER:
+		return reg->sip_user;
+	case SOFIA_REG_IDX_USER_HOST:
+		return reg->user_host;
+	case SOFIA_REG_IDX_CALL_ID:
+		return reg->call_id;
+	default:
+		return reg->contact;
+	}
+}
+
+static void sofia_reg_link(sofia_reg_store_t *store, sofia_reg_t *reg)
+{
+	sofia_reg_t *head;
+	const char *key;
+	uint32_t slot;
+	int i;
+
+	for (i = 0; i < SOFIA_REG_IDX_MAX; i++) {
+		key = sofia_reg_key(reg, i);
+		if ((head = switch_core_hash_find(store->index[i], key))) {
+			head->prev[i] = reg;
+		}
+		reg->next[i] = head;
+		reg->prev[i] = NULL;
+		switch_core_hash_insert(store->index[i], key, reg);
+	}
+
+	if (reg->expires > 0) {
+		/* already due, make sure the next sweep sees it instead of the one a lap later */
+		slot = (uint32_t) ((reg->expires > store->swept ? reg->expires : store->swept + 1) % SOFIA_REG_WHEEL_SLOTS);
+		reg->slot = slot;
+		reg->wheel_prev = NULL;
+		if ((reg->wheel_next = store->wheel[slot])) {
+			reg->wheel_next->wheel_prev = reg;
+		}
+		store->wheel[slot] = reg;
+	}
+
+	if (*reg->presence_hosts) {
+		store->presence_hosts++;
+	}
+
+	store->count++;
+}
+
+static void sofia_reg_unlink(sofia_reg_store_t *store, sofia_reg_t *reg)
+{
+	int i;
+
+	for (i = 0; i < SOFIA_REG_IDX_MAX; i++) {
+		if (reg->next[i]) {
+			reg->next[i]->prev[i] = reg->prev[i];
+		}
+		if (reg->prev[i]) {
+			reg->prev[i]->next[i] = reg->next[i];
+		} else if (reg->next[i]) {
+			switch_core_hash_insert(store->index[i], sofia_reg_key(reg, i), reg->next[i]);
+		} else {
+			switch_core_hash_delete(store->index[i], sofia_reg_key(reg, i));
+		}
+	}
+
+	if (reg->expires > 0) {
+		if (reg->wheel_next) {
+			reg->wheel_next->wheel_prev = reg->wheel_prev;
+		}
+		if (reg->wheel_prev) {
+			reg->wheel_prev->wheel_next = reg->wheel_next;
+		} else {
+			store->wheel[reg->slot] = reg->wheel_next;
+		}
+	}
+
+	if (*reg->presence_hosts) {
+		store->presence_hosts--;
+	}
+
+	store->count--;
+}
+
+static switch_bool_t sofia_reg_matches(sofia_reg_t *reg, const sofia_reg_match_t *match)
+{
+	if ((match->call_id && strcmp(reg->call_id, match->call_id)) ||
+		(match->sip_user && strcmp(reg->sip_user, match->sip_user)) ||
+		(match->contact && strcmp(reg->contact, match->contact)) ||
+		(match->sip_username && strcmp(reg->sip_username, match->sip_username)) ||
+		(match->network_ip && strcmp(reg->network_ip, match->network_ip)) ||
+		(match->network_port && strcmp(reg->network_port, match->network_port)) ||
+		(match->not_expires && reg->expires == match->not_expires)) {
+		return SWITCH_FALSE;
+	}
+
+	if (match->sip_host && strcmp(reg->sip_host, match->sip_host)) {
+		/* presence_hosts like '%host%' */
+		return match->presence_hosts && strstr(reg->presence_hosts, match->sip_host) ? SWITCH_TRUE : SWITCH_FALSE;
+	}
+
+	return SWITCH_TRUE;
+}
+
+/* the shortest list that holds every registration the match can find, with the index it is linked through */
+static sofia_reg_t *sofia_reg_candidates(sofia_reg_store_t *store, const sofia_reg_match_t *match, sofia_reg_idx_t *idx)
+{
+	char key[1024];
+
+	if (match->call_id) {
+		*idx = SOFIA_REG_IDX_CALL_ID;
+		return switch_core_hash_find(store->index[*idx], match->call_id);
+	}
+
+	if (match->contact) {
+		*idx = SOFIA_REG_IDX_CONTACT;
+		return switch_core_hash_find(store->index[*idx], match->contact);
+	}
+
+	if (match->sip_user && match->sip_host && (!match->presence_hosts || !store->presence_hosts)) {
+		*idx = SOFIA_REG_IDX_USER_HOST;
+		switch_snprintf(key, sizeof(key), "%s@%s", match->sip_user, match->sip_host);
+		return switch_core_hash_find(store->index[*idx], key);
+	}
+
+	if (match->sip_user) {
+		*idx = SOFIA_REG_IDX_USER;
+		return switch_core_hash_find(store->index[*idx], match->sip_user);
+	}
+
+	return NULL;
+}
+
+/* hand the matching registrations to fn, stopping when it returns non-zero; call with the store locked */
+static uint32_t sofia_reg_mem_walk(sofia_reg_store_t *store, const sofia_reg_match_t *match,
+								   int (*fn)(sofia_reg_store_t *store, sofia_reg_t *reg, void *pArg), void *pArg)
+{
+	switch_hash_index_t *hi;
+	sofia_reg_idx_t idx = SOFIA_REG_IDX_USER;
+	sofia_reg_t *reg, *next;
+	uint32_t n = 0;
+	void *val;
+
+	if (match->call_id || match->contact || match->sip_user) {
+		for (reg = sofia_reg_candidates(store, match, &idx); reg; reg = next) {
+			next = reg->next[idx];
+			if (sofia_reg_matches(reg, match)) {
+				n++;
+				if (fn && fn(store, reg, pArg)) {
+					break;
+				}
+			}
+		}
+		return n;
+	}
+
+	/* no key to go by, every user's list */
+	for (hi = switch_core_hash_first(store->index[SOFIA_REG_IDX_USER]); hi; ) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		/* fn may take the current entry out of the hash */
+		hi = switch_core_hash_next(&hi);
+		for (reg = (sofia_reg_t *) val; reg; reg = next) {
+			next = reg->next[SOFIA_REG_IDX_USER];
+			if (sofia_reg_matches(reg, match)) {
+				n++;
+				if (fn && fn(store, reg, pArg)) {
+					switch_safe_free(hi);
+					return n;
+				}
+			}
+		}
+	}
+
+	return n;
+}
+
+static int sofia_reg_take(sofia_reg_store_t *store, sofia_reg_t *reg, void *pArg)
+{
+	sofia_reg_t **list = (sofia_reg_t **) pArg;
+
+	sofia_reg_unlink(store, reg);
+	reg->wheel_next = *list;
+	*list = reg;
+
+	return 0;
+}
+
+struct sofia_reg_find_helper {
+	switch_core_db_callback_func_t callback;
+	void *pArg;
+	uint32_t rows;
+};
+
+static int sofia_reg_find_row(sofia_reg_store_t *store, sofia_reg_t *reg, void *pArg)
+{
+	struct sofia_reg_find_helper *h = (struct sofia_reg_find_helper *) pArg;
+	char expires[32];
+	char *argv[2];
+
+	/* select contact,expires */
+	switch_snprintf(expires, sizeof(expires), "%ld", reg->expires);
+	argv[0] = reg->contact;
+	argv[1] = expires;
+	h->rows++;
+
+	return h->callback(h->pArg, 2, argv, NULL);
+}
+
+sofia_reg_store_t *sofia_reg_mem_create(switch_memory_pool_t *pool)
+{
+	sofia_reg_store_t *store;
+	int i;
+
+	store = switch_core_alloc(pool, sizeof(*store));
+	switch_mutex_init(&store->mutex, SWITCH_MUTEX_NESTED, pool);
+	for (i = 0; i < SOFIA_REG_IDX_MAX; i++) {
+		switch_core_hash_init(&store->index[i]);
+	}
+
+	return store;
+}
+
+sofia_reg_t *sofia_reg_mem_destroy(sofia_reg_store_t *store)
+{
+	sofia_reg_match_t match = { 0 };
+	sofia_reg_t *list = NULL;
+	int i;
+
+	switch_mutex_lock(store->mutex);
+	sofia_reg_mem_walk(store, &match, sofia_reg_take, &list);
+	for (i = 0; i < SOFIA_REG_IDX_MAX; i++) {
+		switch_core_hash_destroy(&store->index[i]);
+	}
+	switch_mutex_unlock(store->mutex);
+
+	return list;
+}
+
+void sofia_reg_mem_add(sofia_reg_store_t *store, const sofia_reg_t *reg)
+{
+	sofia_reg_t *dup = sofia_reg_dup(reg);
+
+	switch_mutex_lock(store->mutex);
+	sofia_reg_link(store, dup);
+	switch_mutex_unlock(store->mutex);
+}
+
+uint32_t sofia_reg_mem_update(sofia_reg_store_t *store, const sofia_reg_match_t *match, const sofia_reg_t *changes)
+{
+	sofia_reg_t *list = NULL, *reg, merged;
+	const char *val;
+	uint32_t n = 0;
+	int i, nf = sizeof(sofia_reg_fields) / sizeof(sofia_reg_fields[0]);
+
+	switch_mutex_lock(store->mutex);
+	sofia_reg_mem_walk(store, match, sofia_reg_take, &list);
+
+	while ((reg = list)) {
+		list = reg->wheel_next;
+
+		/* the columns the update sets replace the old ones, the rest stay */
+		merged = *reg;
+		for (i = 0; i < nf; i++) {
+			if ((val = sofia_reg_field(changes, i))) {
+				sofia_reg_field(&merged, i) = (char *) val;
+			}
+		}
+		if (changes->expires) {
+			merged.expires = changes->expires;
+		}
+
+		sofia_reg_link(store, sofia_reg_dup(&merged));
+		free(reg);
+		n++;
+	}
+	switch_mutex_unlock(store->mutex);
+
+	return n;
+}
+
+uint32_t sofia_reg_mem_take(sofia_reg_store_t *store, const sofia_reg_match_t *match, sofia_reg_t **list)
+{
+	uint32_t n;
+
+	switch_mutex_lock(store->mutex);
+	n = sofia_reg_mem_walk(store, match, sofia_reg_take, list);
+	switch_mutex_unlock(store->mutex);
+
+	return n;
+}
+
+uint32_t sofia_reg_mem_count(sofia_reg_store_t *store, const sofia_reg_match_t *match)
+{
+	uint32_t n;
+
+	switch_mutex_lock(store->mutex);
+	n = sofia_reg_mem_walk(store, match, NULL, NULL);
+	switch_mutex_unlock(store->mutex);
+
+	return n;
+}
+
+uint32_t sofia_reg_mem_find(sofia_reg_store_t *store, const sofia_reg_match_t *match, switch_core_db_callback_func_t callback, void *pArg)
+{
+	struct sofia_reg_find_helper h = { 0 };
+
+	h.callback = callback;
+	h.pArg = pArg;
+
+	switch_mutex_lock(store->mutex);
+	sofia_reg_mem_walk(store, match, sofia_reg_find_row, &h);
+	switch_mutex_unlock(store->mutex);
+
+	return h.rows;
+}
+
+sofia_reg_t *sofia_reg_mem_take_expired(sofia_reg_store_t *store, time_t now)
+{
+	sofia_reg_t *list = NULL, *reg, *next;
+	time_t t, first, last;
+	uint32_t slot;
+
+	switch_mutex_lock(store->mutex);
+
+	/* the seconds since the last sweep, one lap at most since a slot holds every registration that lands on it whatever the lap */
+	if (!now) {
+		first = 0;
+		last = SOFIA_REG_WHEEL_SLOTS - 1;
+	} else {
+		first = now - store->swept < SOFIA_REG_WHEEL_SLOTS ? store->swept + 1 : now - SOFIA_REG_WHEEL_SLOTS + 1;
+		last = now;
+	}
+
+	for (t = first; t <= last; t++) {
+		slot = (uint32_t) (t % SOFIA_REG_WHEEL_SLOTS);
+		for (reg = store->wheel[slot]; reg; reg = next) {
+			next = reg->wheel_next;
+			if (!now || reg->expires <= now) {
+				sofia_reg_take(store, reg, &list);
+			}
+		}
+	}
+
+	if (now > store->swept) {
+		store->swept = now;
+	}
+
+	switch_mutex_unlock(store->mutex);
+
+	return list;
+}
+
+void sofia_reg_mem_free(sofia_reg_t *list)
+{
+	sofia_reg_t *reg;
+
+	while ((reg = list)) {
+		list = reg->wheel_next;
+		free(reg);
+	}
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
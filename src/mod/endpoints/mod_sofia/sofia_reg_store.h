@@ -0,0 +1,131 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * sofia_reg_store.h -- SOFIA SIP Endpoint (in-memory registration store)
+ *
+ */
+
+#ifndef SOFIA_REG_STORE_H
+#define SOFIA_REG_STORE_H
+
+#include <switch.h>
+
+/* registrations held in memory, see sofia_reg_store_create() in sofia_reg.c */
+typedef enum {
+	SOFIA_REG_IDX_USER,
+	SOFIA_REG_IDX_USER_HOST,
+	SOFIA_REG_IDX_CALL_ID,
+	SOFIA_REG_IDX_CONTACT,
+	SOFIA_REG_IDX_MAX
+} sofia_reg_idx_t;
+
+/* one second per slot, registrations further out than this wait for the next lap */
+#define SOFIA_REG_WHEEL_SLOTS 4096
+
+typedef struct sofia_reg_s sofia_reg_t;
+struct sofia_reg_s {
+	/* the sip_registrations columns the lookups and the expire events need */
+	char *call_id;
+	char *sip_user;
+	char *sip_host;
+	char *presence_hosts;
+	char *contact;
+	char *status;
+	char *rpid;
+	char *user_agent;
+	char *server_user;
+	char *server_host;
+	char *network_ip;
+	char *network_port;
+	char *sip_username;
+	char *sip_realm;
+	long expires;
+	char *user_host;
+	sofia_reg_t *next[SOFIA_REG_IDX_MAX];
+	sofia_reg_t *prev[SOFIA_REG_IDX_MAX];
+	sofia_reg_t *wheel_next;
+	sofia_reg_t *wheel_prev;
+	uint32_t slot;
+};
+
+typedef struct {
+	switch_mutex_t *mutex;
+	/* each key maps to the first of a list of registrations linked through next[] */
+	switch_hash_t *index[SOFIA_REG_IDX_MAX];
+	sofia_reg_t *wheel[SOFIA_REG_WHEEL_SLOTS];
+	time_t swept;
+	uint32_t count;
+	/* registrations with presence hosts, a lookup by host has to look at all of a user's then */
+	uint32_t presence_hosts;
+} sofia_reg_store_t;
+
+/* conditions for sofia_reg_mem_find() and friends, unset members match anything */
+typedef struct {
+	const char *call_id;
+	const char *sip_user;
+	const char *sip_host;
+	/* sip_host also matches a presence host, like the contact lookups */
+	switch_bool_t presence_hosts;
+	const char *contact;
+	const char *sip_username;
+	const char *network_ip;
+	const char *network_port;
+	/* skip registrations that expire at exactly this time */
+	long not_expires;
+} sofia_reg_match_t;
+
+/*
+ * The store itself, without the profile it belongs to so it can be tested on its own.  Every call takes the store
+ * mutex, registrations handed back are linked through wheel_next and belong to the caller.
+ */
+sofia_reg_store_t *sofia_reg_mem_create(switch_memory_pool_t *pool);
+/* every registration left, the store can not be used afterwards */
+sofia_reg_t *sofia_reg_mem_destroy(sofia_reg_store_t *store);
+void sofia_reg_mem_add(sofia_reg_store_t *store, const sofia_reg_t *reg);
+/* the members of changes that are set replace those of the matching registrations */
+uint32_t sofia_reg_mem_update(sofia_reg_store_t *store, const sofia_reg_match_t *match, const sofia_reg_t *changes);
+uint32_t sofia_reg_mem_take(sofia_reg_store_t *store, const sofia_reg_match_t *match, sofia_reg_t **list);
+uint32_t sofia_reg_mem_count(sofia_reg_store_t *store, const sofia_reg_match_t *match);
+/* the callback gets the contact,expires row sofia_reg_find_callback() expects */
+uint32_t sofia_reg_mem_find(sofia_reg_store_t *store, const sofia_reg_match_t *match, switch_core_db_callback_func_t callback, void *pArg);
+/* the registrations due at now, all of them when now is 0 */
+sofia_reg_t *sofia_reg_mem_take_expired(sofia_reg_store_t *store, time_t now);
+void sofia_reg_mem_free(sofia_reg_t *list);
+
+#endif
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
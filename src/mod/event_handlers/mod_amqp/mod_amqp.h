@@ -61,6 +61,7 @@
 typedef struct {
     char routing_key[MAX_AMQP_ROUTING_KEY_LENGTH];
     char *pjson;
+    switch_size_t pjson_len;
 } mod_amqp_message_t;
 
 typedef struct mod_amqp_connection_s {
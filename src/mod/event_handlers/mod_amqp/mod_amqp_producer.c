@@ -81,6 +81,7 @@ void mod_amqp_producer_event_handler(switch_event_t* evt)
 	mod_amqp_producer_profile_t *profile = (mod_amqp_producer_profile_t *)evt->bind_user_data;
 	switch_time_t now = switch_time_now();
 	switch_time_t reset_time;
+	switch_stream_handle_t stream = { 0 };
 
 	if (!profile) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Event without a profile %p %p\n", (void *)evt, (void *)evt->event_user_data);
@@ -102,7 +103,11 @@ void mod_amqp_producer_event_handler(switch_event_t* evt)
 
 	switch_malloc(amqp_message, sizeof(mod_amqp_message_t));
 
-	switch_event_serialize_json(evt, &amqp_message->pjson);
+	/* render straight into the message buffer, the worker sends it with the length we already know */
+	SWITCH_STANDARD_STREAM(stream);
+	switch_event_serialize_json_stream(evt, &stream);
+	amqp_message->pjson = stream.data;
+	amqp_message->pjson_len = stream.data_len;
 	mod_amqp_producer_routing_key(profile, amqp_message->routing_key, evt, profile->format_fields);
 
 	/* Queue the message to be sent by the worker thread, errors are reported only once per circuit breaker interval */
@@ -393,6 +398,7 @@ switch_status_t mod_amqp_producer_send(mod_amqp_producer_profile_t *profile, mod
 {
 	amqp_table_entry_t messageTableEntries[1];
 	amqp_basic_properties_t props;
+	amqp_bytes_t body;
 	int status;
 
 	if (! profile->conn_active) {
@@ -420,6 +426,9 @@ switch_status_t mod_amqp_producer_send(mod_amqp_producer_profile_t *profile, mod
 		messageTableEntries[0].value.value.u64 = (uint64_t)switch_micro_time_now();
 	}
 
+	body.len = msg->pjson_len;
+	body.bytes = msg->pjson;
+
 	status = amqp_basic_publish(
 								profile->conn_active->state,
 								1,
@@ -428,7 +437,7 @@ switch_status_t mod_amqp_producer_send(mod_amqp_producer_profile_t *profile, mod
 								0,
 								0,
 								&props,
-								amqp_cstring_bytes(msg->pjson));
+								body);
 
 	if (status < 0) {
 		const char *errstr = amqp_error_string2(-status);
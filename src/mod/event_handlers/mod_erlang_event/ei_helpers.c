@@ -108,10 +108,21 @@ void ei_encode_switch_event_headers(ei_x_buff * ebuf, switch_event_t *event)
 	}
 
 	for (hp = event->headers; hp; hp = hp->next) {
+		char *value = hp->value;
+
+		/* the headers may be shared with other copies of a fired event, decode a copy of our own */
+		if (strchr(value, '%')) {
+			value = strdup(hp->value);
+			switch_url_decode(value);
+		}
+
 		ei_x_encode_tuple_header(ebuf, 2);
 		_ei_x_encode_string(ebuf, hp->name);
-		switch_url_decode(hp->value);
-		_ei_x_encode_string(ebuf, hp->value);
+		_ei_x_encode_string(ebuf, value);
+
+		if (value != hp->value) {
+			free(value);
+		}
 	}
 
 	if (event->body) {
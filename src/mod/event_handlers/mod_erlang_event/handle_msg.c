@@ -386,6 +386,10 @@ static switch_status_t handle_msg_filter(listener_t *listener, int arity, ei_x_b
 			}
 		}
 
+		/* compiled once here rather than on every event */
+		switch_event_filter_destroy(&listener->filter);
+		switch_event_filter_create_from_event(&listener->filter, listener->filters, SWITCH_TRUE);
+
 		switch_mutex_unlock(listener->filter_mutex);
 		switch_thread_rwlock_unlock(listener->event_rwlock);
 
@@ -215,67 +215,11 @@ static void event_handler(switch_event_t *event)
 			}
 		}
 
-		if (send) {
+		if (send && l->filter) {
 			switch_mutex_lock(l->filter_mutex);
-
-			if (l->filters && l->filters->headers) {
-				switch_event_header_t *hp;
-				const char *hval;
-
-				for (hp = l->filters->headers; hp; hp = hp->next) {
-					if ((hval = switch_event_get_header(event, hp->name))) {
-						const char *comp_to = hp->value;
-						int pos = 1, cmp = 0;
-
-						while (comp_to && *comp_to) {
-							if (*comp_to == '+') {
-								pos = 1;
-							} else if (*comp_to == '-') {
-								pos = 0;
-							} else if (*comp_to != ' ') {
-								break;
-							}
-							comp_to++;
-						}
-
-						if (!(comp_to && *comp_to)) {
-							if (pos) {
-								send = 1;
-								continue;
-							} else {
-								send = 0;
-								break;
-							}
-						}
-
-						if (*hp->value == '/') {
-							switch_regex_t *re = NULL;
-							int ovector[30];
-							cmp = !!switch_regex_perform(hval, comp_to, &re, ovector, sizeof(ovector) / sizeof(ovector[0]));
-							switch_regex_safe_free(re);
-						} else {
-							cmp = !strcasecmp(hval, comp_to);
-						}
-
-						if (cmp) {
-							if (pos) {
-								send = 1;
-							} else {
-								send = 0;
-								break;
-							}
-						} else {
-							if (pos) {
-								send = 0;
-								break;
-							} else {
-								send = 1;
-							}
-						}
-					}
-				}
+			if (l->filter) {
+				send = switch_event_filter_match(l->filter, event);
 			}
-
 			switch_mutex_unlock(l->filter_mutex);
 		}
 
@@ -1392,6 +1336,13 @@ void destroy_listener(listener_t * listener)
 
 	switch_core_hash_destroy(&listener->event_hash);
 
+	switch_mutex_lock(listener->filter_mutex);
+	if (listener->filters) {
+		switch_event_destroy(&listener->filters);
+	}
+	switch_event_filter_destroy(&listener->filter);
+	switch_mutex_unlock(listener->filter_mutex);
+
 	/* remove any bindings for this connection */
 	remove_binding(listener, NULL);
 
@@ -124,6 +124,7 @@ struct listener {
 	switch_mutex_t *sock_mutex;
 	switch_mutex_t *filter_mutex;
 	switch_event_t *filters;
+	switch_event_filter_t *filter;
 	char *ebuf;
 	uint32_t flags;
 	switch_log_level_t level;
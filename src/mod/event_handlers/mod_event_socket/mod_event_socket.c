@@ -77,7 +77,6 @@ struct listener {
 	switch_mutex_t *filter_mutex;
 	uint32_t flags;
 	switch_log_level_t level;
-	char *ebuf;
 	uint8_t event_list[SWITCH_EVENT_ALL + 1];
 	uint8_t allowed_event_list[SWITCH_EVENT_ALL + 1];
 	switch_hash_t *event_hash;
@@ -95,6 +94,7 @@ struct listener {
 	char remote_ip[50];
 	switch_port_t remote_port;
 	switch_event_t *filters;
+	switch_event_filter_t *filter;
 	time_t linger_timeout;
 	struct listener *next;
 	switch_pollfd_t *pollfd;
@@ -129,6 +129,9 @@ static struct {
 	uint32_t id;
 	int nat_map;
 	int stop_on_bind_error;
+	uint32_t event_queue_len;
+	uint32_t event_queue_workers;
+	switch_event_overflow_t event_queue_overflow;
 } prefs;
 
 
@@ -250,6 +253,7 @@ static switch_status_t expire_listener(listener_t ** listener)
 	if (l->filters) {
 		switch_event_destroy(&l->filters);
 	}
+	switch_event_filter_destroy(&l->filter);
 
 	switch_mutex_unlock(l->filter_mutex);
 	switch_thread_rwlock_unlock(l->rwlock);
@@ -259,6 +263,13 @@ static switch_status_t expire_listener(listener_t ** listener)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+/* filter_mutex held, the filter headers are compiled once here instead of on every event */
+static void compile_filters(listener_t *listener)
+{
+	switch_event_filter_destroy(&listener->filter);
+	switch_event_filter_create_from_event(&listener->filter, listener->filters, SWITCH_FALSE);
+}
+
 static void event_handler(switch_event_t *event)
 {
 	switch_event_t *clone = NULL;
@@ -305,60 +316,11 @@ static void event_handler(switch_event_t *event)
 			}
 		}
 
-		if (send) {
+		if (send && l->filter) {
 			switch_mutex_lock(l->filter_mutex);
-
-			if (l->filters && l->filters->headers) {
-				switch_event_header_t *hp;
-				const char *hval;
-
-				send = 0;
-				
-				for (hp = l->filters->headers; hp; hp = hp->next) {
-					if ((hval = switch_event_get_header(event, hp->name))) {
-						const char *comp_to = hp->value;
-						int pos = 1, cmp = 0;
-
-						while (comp_to && *comp_to) {
-							if (*comp_to == '+') {
-								pos = 1;
-							} else if (*comp_to == '-') {
-								pos = 0;
-							} else if (*comp_to != ' ') {
-								break;
-							}
-							comp_to++;
-						}
-
-						if (send && pos) {
-							continue;
-						}
-
-						if (!comp_to) {
-							continue;
-						}
-
-						if (*hp->value == '/') {
-							switch_regex_t *re = NULL;
-							int ovector[30];
-							cmp = !!switch_regex_perform(hval, comp_to, &re, ovector, sizeof(ovector) / sizeof(ovector[0]));
-							switch_regex_safe_free(re);
-						} else {
-							cmp = !strcasecmp(hval, comp_to);
-						}
-
-						if (cmp) {
-							if (pos) {
-								send = 1;
-							} else {
-								send = 0;
-								break;
-							}
-						}
-					}
-				}
+			if (l->filter) {
+				send = switch_event_filter_match(l->filter, event);
 			}
-
 			switch_mutex_unlock(l->filter_mutex);
 		}
 
@@ -778,6 +740,7 @@ SWITCH_STANDARD_API(event_sink_function)
 
 	  filter_end:
 
+		compile_filters(listener);
 		switch_mutex_unlock(listener->filter_mutex);
 
 	} else if (!strcasecmp(wcmd, "stop-logging")) {
@@ -1060,8 +1023,9 @@ SWITCH_STANDARD_API(event_sink_function)
 
 			if (listener->format == EVENT_FORMAT_PLAIN) {
 				//etype = "plain";
-				switch_event_serialize(pevent, &listener->ebuf, SWITCH_TRUE);
-				stream->write_function(stream, "<event type=\"plain\">\n%s</event>", listener->ebuf);
+				stream->write_function(stream, "<event type=\"plain\">\n");
+				switch_event_serialize_stream(pevent, stream, SWITCH_TRUE);
+				stream->write_function(stream, "</event>");
 			} else if (listener->format == EVENT_FORMAT_JSON) {
 				//etype = "json";
 				cJSON *cjevent = NULL;
@@ -1069,21 +1033,11 @@ SWITCH_STANDARD_API(event_sink_function)
 				switch_event_serialize_json_obj(pevent, &cjevent);
 				cJSON_AddItemToArray(cjevents, cjevent);
 			} else {
-				switch_xml_t xml;
 				//etype = "xml";
-
-				if ((xml = switch_event_xmlize(pevent, SWITCH_VA_NONE))) {
-					listener->ebuf = switch_xml_toxml(xml, SWITCH_FALSE);
-					switch_xml_free(xml);
-				} else {
-					stream->write_function(stream, "<data><reply type=\"error\">XML Render Error</reply></data>\n");
-					break;
-				}
-
-				stream->write_function(stream, "%s\n", listener->ebuf);
+				switch_event_xmlize_stream(pevent, stream);
+				stream->write_function(stream, "\n");
 			}
 
-			switch_safe_free(listener->ebuf);
 			switch_event_destroy(&pevent);
 		}
 
@@ -1378,49 +1332,45 @@ static switch_status_t read_packet(listener_t *listener, switch_event_t **event,
 			}
 
 			if (switch_test_flag(listener, LFLAG_EVENTS)) {
+				switch_stream_handle_t estream = { 0 };
+
+				/* every event is rendered into the same buffer, it only grows to fit the biggest one */
+				SWITCH_STANDARD_STREAM(estream);
+
 				while (switch_queue_trypop(listener->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
 					char hbuf[512];
 					switch_event_t *pevent = (switch_event_t *) pop;
 					char *etype;
 
 					do_sleep = 0;
+					estream.data_len = 0;
+					estream.end = estream.data;
+
 					if (listener->format == EVENT_FORMAT_PLAIN) {
 						etype = "plain";
-						switch_event_serialize(pevent, &listener->ebuf, SWITCH_TRUE);
+						switch_event_serialize_stream(pevent, &estream, SWITCH_TRUE);
 					} else if (listener->format == EVENT_FORMAT_JSON) {
 						etype = "json";
-						switch_event_serialize_json(pevent, &listener->ebuf);
+						switch_event_serialize_json_stream(pevent, &estream);
 					} else {
-						switch_xml_t xml;
 						etype = "xml";
-
-						if ((xml = switch_event_xmlize(pevent, SWITCH_VA_NONE))) {
-							listener->ebuf = switch_xml_toxml(xml, SWITCH_FALSE);
-							switch_xml_free(xml);
-						} else {
-							switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(listener->session), SWITCH_LOG_ERROR, "XML ERROR!\n");
-							goto endloop;
-						}
+						switch_event_xmlize_stream(pevent, &estream);
 					}
 
-					switch_assert(listener->ebuf);
-
-					len = strlen(listener->ebuf);
+					len = estream.data_len;
 
 					switch_snprintf(hbuf, sizeof(hbuf), "Content-Length: %" SWITCH_SSIZE_T_FMT "\n" "Content-Type: text/event-%s\n" "\n", len, etype);
 
 					len = strlen(hbuf);
 					switch_socket_send(listener->sock, hbuf, &len);
 
-					len = strlen(listener->ebuf);
-					switch_socket_send(listener->sock, listener->ebuf, &len);
-
-					switch_safe_free(listener->ebuf);
-
-				  endloop:
+					len = estream.data_len;
+					switch_socket_send(listener->sock, estream.data, &len);
 
 					switch_event_destroy(&pevent);
 				}
+
+				switch_safe_free(estream.data);
 			}
 		}
 
@@ -1966,6 +1916,7 @@ static switch_status_t parse_command(listener_t *listener, switch_event_t **even
 		} else {
 			switch_snprintf(reply, reply_len, "-ERR invalid syntax");
 		}
+		compile_filters(listener);
 		switch_mutex_unlock(listener->filter_mutex);
 
 		goto done;
@@ -2765,6 +2716,7 @@ static void *SWITCH_THREAD_FUNC listener_run(switch_thread_t *thread, void *obj)
 	if (listener->filters) {
 		switch_event_destroy(&listener->filters);
 	}
+	switch_event_filter_destroy(&listener->filter);
 	switch_mutex_unlock(listener->filter_mutex);
 
 	if (listener->session) {
@@ -2862,6 +2814,14 @@ static int config(void)
 					}
 				} else if (!strcasecmp(var, "stop-on-bind-error")) {
 					prefs.stop_on_bind_error = switch_true(val) ? 1 : 0;
+				} else if (!strcasecmp(var, "event-queue-size")) {
+					int tmp = atoi(val);
+					prefs.event_queue_len = tmp > 0 ? tmp : 0;
+				} else if (!strcasecmp(var, "event-queue-workers")) {
+					int tmp = atoi(val);
+					prefs.event_queue_workers = tmp > 0 ? tmp : 1;
+				} else if (!strcasecmp(var, "event-queue-overflow")) {
+					prefs.event_queue_overflow = switch_event_overflow_from_str(val);
 				}
 			}
 		}
@@ -2913,6 +2873,18 @@ SWITCH_MODULE_RUNTIME_FUNCTION(mod_event_socket_runtime)
 
 	config();
 
+	if (prefs.event_queue_len) {
+		/* nobody is connected yet so nothing is missed while the binding is swapped */
+		switch_event_unbind(&globals.node);
+
+		if (switch_event_bind_queued(modname, SWITCH_EVENT_ALL, SWITCH_EVENT_SUBCLASS_ANY, event_handler, NULL,
+									 prefs.event_queue_len, prefs.event_queue_workers, prefs.event_queue_overflow, &globals.node) != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Couldn't bind!\n");
+			switch_core_destroy_memory_pool(&pool);
+			return SWITCH_STATUS_TERM;
+		}
+	}
+
 	while (!prefs.done) {
 		rv = switch_sockaddr_info_get(&sa, prefs.ip, SWITCH_UNSPEC, prefs.port, 0, pool);
 		if (rv)
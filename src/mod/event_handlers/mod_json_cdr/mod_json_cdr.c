@@ -470,15 +470,23 @@ static switch_status_t my_on_reporting(switch_core_session_t *session)
 	json_text = cJSON_PrintUnformatted(json_cdr);
 
 	if (globals.url_count && globals.encode) {
-		switch_size_t need_bytes = strlen(json_text) * 3;
-		
-		json_text_escaped = malloc(need_bytes);
-		switch_assert(json_text_escaped);
-		memset(json_text_escaped, 0, need_bytes);
+		switch_size_t json_len = strlen(json_text);
+
 		if (globals.encode == ENCODING_DEFAULT) {
-			switch_url_encode(json_text, json_text_escaped, need_bytes);
+			switch_stream_handle_t stream = { 0 };
+
+			/* most of a cdr is safe text, size for a third of it escaped instead of all of it */
+			SWITCH_STANDARD_STREAM(stream);
+			stream.alloc_chunk = json_len + json_len / 2 + 1;
+			switch_url_encode_stream(&stream, json_text);
+			json_text_escaped = stream.data;
 		} else {
-			switch_b64_encode((unsigned char *) json_text, need_bytes / 3, (unsigned char *) json_text_escaped, need_bytes);
+			switch_size_t need_bytes = json_len * 3;
+
+			json_text_escaped = malloc(need_bytes);
+			switch_assert(json_text_escaped);
+			memset(json_text_escaped, 0, need_bytes);
+			switch_b64_encode((unsigned char *) json_text, json_len, (unsigned char *) json_text_escaped, need_bytes);
 		}
 	}
 
@@ -109,10 +109,21 @@ void ei_encode_switch_event_headers(ei_x_buff *ebuf, switch_event_t *event) {
     }
 
     for (hp = event->headers; hp; hp = hp->next) {
+        char *value = hp->value;
+
+        /* the headers may be shared with other copies of a fired event, decode a copy of our own */
+        if (strchr(value, '%')) {
+            value = strdup(hp->value);
+            switch_url_decode(value);
+        }
+
         ei_x_encode_tuple_header(ebuf, 2);
         ei_x_encode_binary(ebuf, hp->name, strlen(hp->name));
-        switch_url_decode(hp->value);
-        ei_x_encode_binary(ebuf, hp->value, strlen(hp->value));
+        ei_x_encode_binary(ebuf, value, strlen(value));
+
+        if (value != hp->value) {
+            free(value);
+        }
     }
 
     if (event->body) {
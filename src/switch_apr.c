@@ -918,6 +918,52 @@ SWITCH_DECLARE(int32_t) switch_sockaddr_get_family(switch_sockaddr_t *sa)
 	return sa->family;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_sockaddr_set_os(switch_sockaddr_t *sa, const void *os_sa, uint32_t os_salen)
+{
+	const struct sockaddr *in = (const struct sockaddr *) os_sa;
+
+	if (!sa || !os_sa || os_salen > sizeof(sa->sa)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	memcpy(&sa->sa, os_sa, os_salen);
+	sa->family = in->sa_family;
+	sa->port = ntohs(sa->sa.sin.sin_port);
+
+	if (sa->family == APR_INET) {
+		sa->salen = sizeof(struct sockaddr_in);
+		sa->addr_str_len = 16;
+		sa->ipaddr_ptr = &(sa->sa.sin.sin_addr);
+		sa->ipaddr_len = sizeof(struct in_addr);
+	}
+#if APR_HAVE_IPV6
+	else if (sa->family == APR_INET6) {
+		sa->salen = sizeof(struct sockaddr_in6);
+		sa->addr_str_len = 46;
+		sa->ipaddr_ptr = &(sa->sa.sin6.sin6_addr);
+		sa->ipaddr_len = sizeof(struct in6_addr);
+	}
+#endif
+	else {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(const void *) switch_sockaddr_get_os(switch_sockaddr_t *sa, uint32_t *os_salen)
+{
+	if (!sa) {
+		return NULL;
+	}
+
+	if (os_salen) {
+		*os_salen = sa->salen;
+	}
+
+	return &sa->sa;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_getnameinfo(char **hostname, switch_sockaddr_t *sa, int32_t flags)
 {
 	return apr_getnameinfo(hostname, sa, flags);
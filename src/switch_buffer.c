@@ -36,9 +36,24 @@ static uint32_t buffer_id = 0;
 
 typedef enum {
 	SWITCH_BUFFER_FLAG_DYNAMIC = (1 << 0),
-	SWITCH_BUFFER_FLAG_PARTITION = (1 << 1)
+	SWITCH_BUFFER_FLAG_PARTITION = (1 << 1),
+	SWITCH_BUFFER_FLAG_SPSC = (1 << 2)
 } switch_buffer_flag_t;
 
+/* The single producer / single consumer ring only needs the position it reads from the other side
+   to be ordered with the data it guards; the writer publishes wpos after the copy and the reader
+   publishes rpos after it is done with the bytes. */
+#if defined(__GNUC__)
+#define spsc_load(_p) __atomic_load_n(_p, __ATOMIC_ACQUIRE)
+#define spsc_store(_p, _v) __atomic_store_n(_p, _v, __ATOMIC_RELEASE)
+#else
+/* msvc gives volatile accesses acquire/release semantics */
+#define spsc_load(_p) (*(volatile switch_size_t *)(_p))
+#define spsc_store(_p, _v) (*(volatile switch_size_t *)(_p) = (_v))
+#endif
+
+#define SPSC_PAD 64
+
 struct switch_buffer {
 	switch_byte_t *data;
 	switch_byte_t *head;
@@ -51,8 +66,66 @@ struct switch_buffer {
 	uint32_t flags;
 	uint32_t id;
 	int32_t loops;
+	/* ring positions of a spsc buffer, they only ever grow and are kept on their own cache lines */
+	char pad0[SPSC_PAD];
+	switch_size_t wpos;
+	char pad1[SPSC_PAD];
+	switch_size_t rpos;
+	char pad2[SPSC_PAD];
 };
 
+static switch_size_t spsc_inuse(switch_buffer_t *buffer)
+{
+	return spsc_load(&buffer->wpos) - spsc_load(&buffer->rpos);
+}
+
+static switch_size_t spsc_copy_out(switch_buffer_t *buffer, void *data, switch_size_t datalen, switch_size_t *rposp)
+{
+	switch_size_t r = buffer->rpos, used = spsc_load(&buffer->wpos) - r, off, first;
+
+	if (datalen > used) {
+		datalen = used;
+	}
+
+	if (data && datalen) {
+		off = r & (buffer->datalen - 1);
+		first = buffer->datalen - off;
+
+		if (first > datalen) {
+			first = datalen;
+		}
+
+		memcpy(data, buffer->data + off, first);
+		memcpy((switch_byte_t *) data + first, buffer->data, datalen - first);
+	}
+
+	*rposp = r + datalen;
+
+	return datalen;
+}
+
+static switch_size_t spsc_write(switch_buffer_t *buffer, const void *data, switch_size_t datalen)
+{
+	switch_size_t w = buffer->wpos, r = spsc_load(&buffer->rpos), off, first;
+
+	if (buffer->datalen - (w - r) < datalen) {
+		return 0;
+	}
+
+	off = w & (buffer->datalen - 1);
+	first = buffer->datalen - off;
+
+	if (first > datalen) {
+		first = datalen;
+	}
+
+	memcpy(buffer->data + off, data, first);
+	memcpy(buffer->data, (const switch_byte_t *) data + first, datalen - first);
+	spsc_store(&buffer->wpos, w + datalen);
+
+	return w + datalen - r;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_buffer_reset_partition_data(switch_buffer_t *buffer)
 {
 	if (!switch_test_flag(buffer, SWITCH_BUFFER_FLAG_PARTITION)) {
@@ -135,6 +208,37 @@ SWITCH_DECLARE(switch_status_t) switch_buffer_create_dynamic(switch_buffer_t **b
 	return SWITCH_STATUS_MEMERR;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_buffer_create_spsc(switch_buffer_t **buffer, switch_size_t len)
+{
+	switch_buffer_t *new_buffer;
+	switch_size_t size = 64;
+
+	while (size < len) {
+		size <<= 1;
+	}
+
+	if ((new_buffer = malloc(sizeof(*new_buffer)))) {
+		memset(new_buffer, 0, sizeof(*new_buffer));
+
+		if (!(new_buffer->data = malloc(size))) {
+			free(new_buffer);
+			*buffer = NULL;
+			return SWITCH_STATUS_MEMERR;
+		}
+
+		new_buffer->datalen = new_buffer->max_len = size;
+		new_buffer->id = buffer_id++;
+		new_buffer->head = new_buffer->data;
+		switch_set_flag(new_buffer, SWITCH_BUFFER_FLAG_DYNAMIC);
+		switch_set_flag(new_buffer, SWITCH_BUFFER_FLAG_SPSC);
+
+		*buffer = new_buffer;
+		return SWITCH_STATUS_SUCCESS;
+	}
+	*buffer = NULL;
+	return SWITCH_STATUS_MEMERR;
+}
+
 SWITCH_DECLARE(void) switch_buffer_add_mutex(switch_buffer_t *buffer, switch_mutex_t *mutex)
 {
 	buffer->mutex = mutex;
@@ -169,6 +273,10 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_len(switch_buffer_t *buffer)
 
 SWITCH_DECLARE(switch_size_t) switch_buffer_freespace(switch_buffer_t *buffer)
 {
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		return buffer->datalen - spsc_inuse(buffer);
+	}
+
 	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_DYNAMIC)) {
 		if (buffer->max_len) {
 			return (switch_size_t) (buffer->max_len - buffer->used);
@@ -181,6 +289,10 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_freespace(switch_buffer_t *buffer)
 
 SWITCH_DECLARE(switch_size_t) switch_buffer_inuse(switch_buffer_t *buffer)
 {
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		return spsc_inuse(buffer);
+	}
+
 	return buffer->used;
 }
 
@@ -188,6 +300,14 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_toss(switch_buffer_t *buffer, switch
 {
 	switch_size_t reading = 0;
 
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		switch_size_t r;
+
+		spsc_copy_out(buffer, NULL, datalen, &r);
+		spsc_store(&buffer->rpos, r);
+		return spsc_load(&buffer->wpos) - r;
+	}
+
 	if (buffer->used < 1) {
 		buffer->used = 0;
 		return 0;
@@ -211,7 +331,7 @@ SWITCH_DECLARE(void) switch_buffer_set_loops(switch_buffer_t *buffer, int32_t lo
 SWITCH_DECLARE(switch_size_t) switch_buffer_read_loop(switch_buffer_t *buffer, void *data, switch_size_t datalen)
 {
 	switch_size_t len;
-	if ((len = switch_buffer_read(buffer, data, datalen)) == 0) {
+	if ((len = switch_buffer_read(buffer, data, datalen)) == 0 && !switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
 		if (buffer->loops > 0) {
 			buffer->loops--;
 		}
@@ -229,6 +349,14 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_read(switch_buffer_t *buffer, void *
 {
 	switch_size_t reading = 0;
 
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		switch_size_t r;
+
+		reading = spsc_copy_out(buffer, data, datalen, &r);
+		spsc_store(&buffer->rpos, r);
+		return reading;
+	}
+
 	if (buffer->used < 1) {
 		buffer->used = 0;
 		return 0;
@@ -249,6 +377,12 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_peek(switch_buffer_t *buffer, void *
 {
 	switch_size_t reading = 0;
 
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		switch_size_t r;
+
+		return spsc_copy_out(buffer, data, datalen, &r);
+	}
+
 	if (buffer->used < 1) {
 		buffer->used = 0;
 		return 0;
@@ -267,6 +401,18 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_peek_zerocopy(switch_buffer_t *buffe
 {
 	switch_size_t reading = 0;
 
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		switch_size_t off = buffer->rpos & (buffer->datalen - 1);
+
+		/* only the part up to the end of the ring is contiguous */
+		if ((reading = spsc_inuse(buffer)) > buffer->datalen - off) {
+			reading = buffer->datalen - off;
+		}
+
+		*ptr = reading ? buffer->data + off : NULL;
+		return reading;
+	}
+
 	if (buffer->used < 1) {
 		buffer->used = 0;
 		*ptr = NULL;
@@ -290,6 +436,10 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_write(switch_buffer_t *buffer, const
 
 	switch_assert(buffer->data != NULL);
 
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		return datalen ? spsc_write(buffer, data, datalen) : spsc_inuse(buffer);
+	}
+
 	if (!datalen) {
 		return buffer->used;
 	}
@@ -341,6 +491,12 @@ SWITCH_DECLARE(void) switch_buffer_zero(switch_buffer_t *buffer)
 {
 	switch_assert(buffer->data != NULL);
 
+	if (switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
+		/* consumer side only, drops whatever has been published so far */
+		spsc_store(&buffer->rpos, spsc_load(&buffer->wpos));
+		return;
+	}
+
 	buffer->used = 0;
 	buffer->actually_used = 0;
 	buffer->head = buffer->data;
@@ -354,7 +510,7 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_zwrite(switch_buffer_t *buffer, cons
 		return 0;
 	}
 
-	if (!(w = switch_buffer_write(buffer, data, datalen))) {
+	if (!(w = switch_buffer_write(buffer, data, datalen)) && !switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
 		switch_buffer_zero(buffer);
 		return switch_buffer_write(buffer, data, datalen);
 	}
@@ -370,7 +526,7 @@ SWITCH_DECLARE(switch_size_t) switch_buffer_slide_write(switch_buffer_t *buffer,
 		return 0;
 	}
 
-	if (!(w = switch_buffer_write(buffer, data, datalen))) {
+	if (!(w = switch_buffer_write(buffer, data, datalen)) && !switch_test_flag(buffer, SWITCH_BUFFER_FLAG_SPSC)) {
 		switch_buffer_toss(buffer, datalen);
 		return switch_buffer_write(buffer, data, datalen);
 	}
@@ -0,0 +1,976 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_call_registry.c -- In memory registry of channels and calls
+ *
+ */
+
+#include <switch.h>
+#include <switch_call_registry.h>
+
+/* every channel sits on the ALL list, on one list per indexed column and on DIRTY while it waits for the export */
+typedef enum {
+	SCR_LINK_ALL,
+	SCR_LINK_PRESENCE_ID,
+	SCR_LINK_CALL_UUID,
+	SCR_LINK_HOSTNAME,
+	SCR_LINK_DIRTY,
+	SCR_LINK_MAX
+} scr_link_t;
+
+struct scr_call;
+
+typedef struct scr_channel {
+	char *cols[SCR_COL_MAX];
+	struct scr_call *caller_of;
+	struct scr_call *callee_of;
+	struct scr_channel *next[SCR_LINK_MAX];
+	struct scr_channel *prev[SCR_LINK_MAX];
+} scr_channel_t;
+
+typedef struct scr_call {
+	char *call_uuid;
+	char *created;
+	char *created_epoch;
+	scr_channel_t *caller;
+	scr_channel_t *callee;
+} scr_call_t;
+
+typedef struct scr_list {
+	scr_channel_t *head;
+	scr_channel_t *tail;
+} scr_list_t;
+
+/* export sql built under the write lock, queued once it is dropped */
+typedef struct scr_sql {
+	char *sql;
+	struct scr_sql *next;
+} scr_sql_t;
+
+static struct {
+	switch_thread_rwlock_t *rwlock;
+	switch_hash_t *uuid_hash;
+	switch_hash_t *index_hash[SCR_LINK_MAX];
+	scr_list_t all;
+	scr_list_t dirty;
+	uint32_t count;
+	char *insert_sql;
+	scr_sql_t *sql_head;
+	scr_sql_t *sql_tail;
+	switch_mutex_t *export_mutex;
+	int running;
+} REGISTRY;
+
+static const char *scr_col_names[SCR_COL_MAX] = {
+	"uuid", "direction", "created", "created_epoch", "name", "state", "cid_name", "cid_num", "ip_addr", "dest",
+	"application", "application_data", "dialplan", "context", "read_codec", "read_rate", "read_bit_rate",
+	"write_codec", "write_rate", "write_bit_rate", "secure", "hostname", "presence_id", "presence_data", "callstate",
+	"callee_name", "callee_num", "callee_direction", "call_uuid", "sent_callee_name", "sent_callee_num",
+	"initial_cid_name", "initial_cid_num", "initial_ip_addr", "initial_dest", "initial_dialplan", "initial_context"
+};
+
+static const char *scr_b_col_names[SCR_COL_MAX] = {
+	"b_uuid", "b_direction", "b_created", "b_created_epoch", "b_name", "b_state", "b_cid_name", "b_cid_num", "b_ip_addr", "b_dest",
+	"b_application", "b_application_data", "b_dialplan", "b_context", "b_read_codec", "b_read_rate", "b_read_bit_rate",
+	"b_write_codec", "b_write_rate", "b_write_bit_rate", "b_secure", "b_hostname", "b_presence_id", "b_presence_data", "b_callstate",
+	"b_callee_name", "b_callee_num", "b_callee_direction", "b_call_uuid", "b_sent_callee_name", "b_sent_callee_num",
+	"b_initial_cid_name", "b_initial_cid_num", "b_initial_ip_addr", "b_initial_dest", "b_initial_dialplan", "b_initial_context"
+};
+
+/* the a and b leg columns of the basic_calls view, detailed_calls has every column up to sent_callee_num on both legs */
+static const switch_call_registry_col_t scr_basic_a_cols[] = {
+	SCR_COL_UUID, SCR_COL_DIRECTION, SCR_COL_CREATED, SCR_COL_CREATED_EPOCH, SCR_COL_NAME, SCR_COL_STATE, SCR_COL_CID_NAME,
+	SCR_COL_CID_NUM, SCR_COL_IP_ADDR, SCR_COL_DEST, SCR_COL_PRESENCE_ID, SCR_COL_PRESENCE_DATA, SCR_COL_CALLSTATE,
+	SCR_COL_CALLEE_NAME, SCR_COL_CALLEE_NUM, SCR_COL_CALLEE_DIRECTION, SCR_COL_CALL_UUID, SCR_COL_HOSTNAME,
+	SCR_COL_SENT_CALLEE_NAME, SCR_COL_SENT_CALLEE_NUM
+};
+
+static const switch_call_registry_col_t scr_basic_b_cols[] = {
+	SCR_COL_UUID, SCR_COL_DIRECTION, SCR_COL_CREATED, SCR_COL_CREATED_EPOCH, SCR_COL_NAME, SCR_COL_STATE, SCR_COL_CID_NAME,
+	SCR_COL_CID_NUM, SCR_COL_IP_ADDR, SCR_COL_DEST, SCR_COL_PRESENCE_ID, SCR_COL_PRESENCE_DATA, SCR_COL_CALLSTATE,
+	SCR_COL_CALLEE_NAME, SCR_COL_CALLEE_NUM, SCR_COL_CALLEE_DIRECTION, SCR_COL_SENT_CALLEE_NAME, SCR_COL_SENT_CALLEE_NUM
+};
+
+#define SCR_DETAILED_COLS (SCR_COL_SENT_CALLEE_NUM + 1)
+#define SCR_ROW_MAX (SCR_DETAILED_COLS * 2 + 1)
+
+SWITCH_DECLARE(const char *) switch_call_registry_col_name(switch_call_registry_col_t col)
+{
+	return col < SCR_COL_MAX ? scr_col_names[col] : NULL;
+}
+
+static switch_call_registry_col_t scr_col_lookup(const char *name)
+{
+	int i;
+
+	for (i = 0; i < SCR_COL_MAX; i++) {
+		if (!strcasecmp(scr_col_names[i], name)) {
+			return (switch_call_registry_col_t) i;
+		}
+	}
+
+	return SCR_COL_MAX;
+}
+
+static scr_link_t scr_col_link(switch_call_registry_col_t col)
+{
+	switch (col) {
+	case SCR_COL_PRESENCE_ID:
+		return SCR_LINK_PRESENCE_ID;
+	case SCR_COL_CALL_UUID:
+		return SCR_LINK_CALL_UUID;
+	case SCR_COL_HOSTNAME:
+		return SCR_LINK_HOSTNAME;
+	default:
+		return SCR_LINK_MAX;
+	}
+}
+
+static switch_bool_t scr_exporting(void)
+{
+	switch_core_flag_t flags = switch_core_flags();
+
+	return ((flags & SCF_USE_SQL) && (flags & SCF_CHANNEL_SQL_EXPORT)) ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+static void scr_list_add(scr_list_t *list, scr_channel_t *ch, scr_link_t link)
+{
+	ch->next[link] = NULL;
+	ch->prev[link] = list->tail;
+
+	if (list->tail) {
+		list->tail->next[link] = ch;
+	} else {
+		list->head = ch;
+	}
+
+	list->tail = ch;
+}
+
+static void scr_list_del(scr_list_t *list, scr_channel_t *ch, scr_link_t link)
+{
+	if (ch->prev[link]) {
+		ch->prev[link]->next[link] = ch->next[link];
+	} else {
+		list->head = ch->next[link];
+	}
+
+	if (ch->next[link]) {
+		ch->next[link]->prev[link] = ch->prev[link];
+	} else {
+		list->tail = ch->prev[link];
+	}
+
+	ch->next[link] = ch->prev[link] = NULL;
+}
+
+static void scr_index_add(scr_channel_t *ch, scr_link_t link, const char *key)
+{
+	scr_list_t *list;
+
+	if (zstr(key)) {
+		return;
+	}
+
+	if (!(list = switch_core_hash_find(REGISTRY.index_hash[link], key))) {
+		switch_zmalloc(list, sizeof(*list));
+		switch_core_hash_insert(REGISTRY.index_hash[link], key, list);
+	}
+
+	scr_list_add(list, ch, link);
+}
+
+static void scr_index_del(scr_channel_t *ch, scr_link_t link, const char *key)
+{
+	scr_list_t *list;
+
+	if (zstr(key) || !(list = switch_core_hash_find(REGISTRY.index_hash[link], key))) {
+		return;
+	}
+
+	scr_list_del(list, ch, link);
+
+	if (!list->head) {
+		switch_core_hash_delete(REGISTRY.index_hash[link], key);
+		free(list);
+	}
+}
+
+static scr_channel_t *scr_find(const char *uuid)
+{
+	return zstr(uuid) ? NULL : (scr_channel_t *) switch_core_hash_find(REGISTRY.uuid_hash, uuid);
+}
+
+static void scr_touch(scr_channel_t *ch)
+{
+	if (!ch->next[SCR_LINK_DIRTY] && REGISTRY.dirty.tail != ch && scr_exporting()) {
+		scr_list_add(&REGISTRY.dirty, ch, SCR_LINK_DIRTY);
+	}
+}
+
+static void scr_set(scr_channel_t *ch, switch_call_registry_col_t col, const char *val)
+{
+	char *old = ch->cols[col];
+	scr_link_t link = scr_col_link(col);
+
+	if (old == val || (old && val && !strcmp(old, val))) {
+		return;
+	}
+
+	if (col == SCR_COL_UUID) {
+		if (old && scr_find(old) == ch) {
+			switch_core_hash_delete(REGISTRY.uuid_hash, old);
+		}
+	} else if (link != SCR_LINK_MAX) {
+		scr_index_del(ch, link, old);
+	}
+
+	ch->cols[col] = val ? strdup(val) : NULL;
+	switch_safe_free(old);
+
+	if (col == SCR_COL_UUID) {
+		if (!zstr(ch->cols[col])) {
+			switch_core_hash_insert(REGISTRY.uuid_hash, ch->cols[col], ch);
+		}
+	} else if (link != SCR_LINK_MAX) {
+		scr_index_add(ch, link, ch->cols[col]);
+	}
+
+	scr_touch(ch);
+}
+
+static void scr_set_header(scr_channel_t *ch, switch_call_registry_col_t col, switch_event_t *event, const char *header)
+{
+	scr_set(ch, col, switch_event_get_header_nil(event, header));
+}
+
+/* the columns a module asked for with presence-data-cols, columns the channels table does not have are ignored */
+static void scr_set_presence_data_cols(scr_channel_t *ch, switch_event_t *event)
+{
+	const char *data = switch_event_get_header(event, "presence-data-cols");
+	char *cols[128] = { 0 };
+	char *data_copy;
+	char header[128];
+	const char *val;
+	switch_call_registry_col_t col;
+	int i, col_count;
+
+	if (zstr(data)) {
+		return;
+	}
+
+	data_copy = strdup(data);
+	col_count = switch_split(data_copy, ':', cols);
+
+	for (i = 0; i < col_count; i++) {
+		if ((col = scr_col_lookup(cols[i])) == SCR_COL_MAX) {
+			continue;
+		}
+
+		switch_snprintf(header, sizeof(header), "PD-%s", cols[i]);
+		val = switch_event_get_header(event, header);
+		scr_set(ch, col, zstr(val) ? NULL : val);
+	}
+
+	free(data_copy);
+}
+
+/* only collects the statement, the sql queue can make its caller wait and the write lock is held here */
+static void scr_export_sql(char *sql)
+{
+	scr_sql_t *node;
+
+	switch_zmalloc(node, sizeof(*node));
+	node->sql = sql;
+
+	if (REGISTRY.sql_tail) {
+		REGISTRY.sql_tail->next = node;
+	} else {
+		REGISTRY.sql_head = node;
+	}
+	REGISTRY.sql_tail = node;
+}
+
+/* drops the write lock and queues what was collected under it, the export mutex keeps it in order with other writers */
+static void scr_unlock_export(void)
+{
+	scr_sql_t *node = REGISTRY.sql_head, *next;
+
+	if (!node) {
+		switch_thread_rwlock_unlock(REGISTRY.rwlock);
+		return;
+	}
+
+	REGISTRY.sql_head = REGISTRY.sql_tail = NULL;
+
+	switch_mutex_lock(REGISTRY.export_mutex);
+	switch_thread_rwlock_unlock(REGISTRY.rwlock);
+
+	for (; node; node = next) {
+		next = node->next;
+		switch_core_sql_exec(node->sql);
+		free(node->sql);
+		free(node);
+	}
+
+	switch_mutex_unlock(REGISTRY.export_mutex);
+}
+
+static void scr_call_del(scr_call_t *call)
+{
+	if (!call) {
+		return;
+	}
+
+	if (call->caller && call->caller->caller_of == call) {
+		call->caller->caller_of = NULL;
+	}
+
+	if (call->callee && call->callee->callee_of == call) {
+		call->callee->callee_of = NULL;
+	}
+
+	switch_safe_free(call->call_uuid);
+	switch_safe_free(call->created);
+	switch_safe_free(call->created_epoch);
+	free(call);
+}
+
+/* the calls rows a channel takes part in, "delete from calls where caller_uuid=... or callee_uuid=..." */
+static void scr_channel_del_calls(scr_channel_t *ch)
+{
+	scr_call_del(ch->caller_of);
+	scr_call_del(ch->callee_of);
+}
+
+static scr_channel_t *scr_channel_add(const char *uuid)
+{
+	scr_channel_t *ch;
+
+	switch_zmalloc(ch, sizeof(*ch));
+	scr_list_add(&REGISTRY.all, ch, SCR_LINK_ALL);
+	REGISTRY.count++;
+	scr_set(ch, SCR_COL_UUID, uuid);
+
+	return ch;
+}
+
+static void scr_channel_del(scr_channel_t *ch)
+{
+	int i;
+
+	scr_channel_del_calls(ch);
+
+	for (i = 0; i < SCR_COL_MAX; i++) {
+		scr_link_t link = scr_col_link((switch_call_registry_col_t) i);
+
+		if (i == SCR_COL_UUID) {
+			if (ch->cols[i] && scr_find(ch->cols[i]) == ch) {
+				switch_core_hash_delete(REGISTRY.uuid_hash, ch->cols[i]);
+			}
+		} else if (link != SCR_LINK_MAX) {
+			scr_index_del(ch, link, ch->cols[i]);
+		}
+
+		switch_safe_free(ch->cols[i]);
+	}
+
+	if (ch->next[SCR_LINK_DIRTY] || REGISTRY.dirty.tail == ch) {
+		scr_list_del(&REGISTRY.dirty, ch, SCR_LINK_DIRTY);
+	}
+
+	scr_list_del(&REGISTRY.all, ch, SCR_LINK_ALL);
+	REGISTRY.count--;
+	free(ch);
+}
+
+static void scr_clear(void)
+{
+	while (REGISTRY.all.head) {
+		scr_channel_del(REGISTRY.all.head);
+	}
+}
+
+static void scr_set_call_uuid_where(const char *call_uuid, const char *new_call_uuid)
+{
+	scr_list_t *list;
+	scr_channel_t *ch, *next;
+
+	if (zstr(call_uuid) || !(list = switch_core_hash_find(REGISTRY.index_hash[SCR_LINK_CALL_UUID], call_uuid))) {
+		return;
+	}
+
+	/* the list goes away under us once the last channel moves off it, so hold on to the next one first */
+	for (ch = list->head; ch; ch = next) {
+		next = ch->next[SCR_LINK_CALL_UUID];
+		scr_set(ch, SCR_COL_CALL_UUID, new_call_uuid ? new_call_uuid : ch->cols[SCR_COL_UUID]);
+	}
+}
+
+static void scr_channel_state(scr_channel_t *ch, switch_event_t *event)
+{
+	const char *state = switch_event_get_header_nil(event, "channel-state-number");
+	switch_channel_state_t state_i = CS_DESTROY;
+
+	if (!zstr(state)) {
+		state_i = atoi(state);
+	}
+
+	switch (state_i) {
+	case CS_NEW:
+	case CS_DESTROY:
+	case CS_REPORTING:
+#ifndef SWITCH_DEPRECATED_CORE_DB
+	case CS_HANGUP: /* marked for deprication */
+#endif
+	case CS_INIT:
+		break;
+	case CS_ROUTING:
+		scr_set_header(ch, SCR_COL_STATE, event, "channel-state");
+		scr_set_header(ch, SCR_COL_CID_NAME, event, "caller-caller-id-name");
+		scr_set_header(ch, SCR_COL_CID_NUM, event, "caller-caller-id-number");
+		scr_set_header(ch, SCR_COL_CALLEE_NAME, event, "caller-callee-id-name");
+		scr_set_header(ch, SCR_COL_CALLEE_NUM, event, "caller-callee-id-number");
+		scr_set_header(ch, SCR_COL_SENT_CALLEE_NAME, event, "sent-callee-id-name");
+		scr_set_header(ch, SCR_COL_SENT_CALLEE_NUM, event, "sent-callee-id-number");
+		scr_set_header(ch, SCR_COL_IP_ADDR, event, "caller-network-addr");
+		scr_set_header(ch, SCR_COL_DEST, event, "caller-destination-number");
+		scr_set_header(ch, SCR_COL_DIALPLAN, event, "caller-dialplan");
+		scr_set_header(ch, SCR_COL_CONTEXT, event, "caller-context");
+		scr_set_header(ch, SCR_COL_PRESENCE_ID, event, "channel-presence-id");
+		scr_set_header(ch, SCR_COL_PRESENCE_DATA, event, "channel-presence-data");
+		scr_set_presence_data_cols(ch, event);
+		break;
+	case CS_EXECUTE:
+		scr_set_header(ch, SCR_COL_STATE, event, "channel-state");
+		scr_set_presence_data_cols(ch, event);
+		break;
+	default:
+		scr_set_header(ch, SCR_COL_STATE, event, "channel-state");
+		break;
+	}
+}
+
+static void scr_bridge(switch_event_t *event)
+{
+	const char *a_uuid, *b_uuid, *call_uuid = switch_event_get_header_nil(event, "channel-call-uuid");
+	scr_channel_t *ch, *a, *b;
+	scr_call_t *call;
+	char epoch[32];
+
+	a_uuid = switch_event_get_header(event, "Bridge-A-Unique-ID");
+	b_uuid = switch_event_get_header(event, "Bridge-B-Unique-ID");
+
+	if (zstr(a_uuid) || zstr(b_uuid)) {
+		a_uuid = switch_event_get_header_nil(event, "caller-unique-id");
+		b_uuid = switch_event_get_header_nil(event, "other-leg-unique-id");
+	}
+
+	if ((ch = scr_find(switch_event_get_header(event, "unique-id")))) {
+		scr_set_presence_data_cols(ch, event);
+	}
+
+	a = scr_find(a_uuid);
+	b = scr_find(b_uuid);
+
+	if (a) {
+		scr_set(a, SCR_COL_CALL_UUID, call_uuid);
+	}
+
+	if (b) {
+		scr_set(b, SCR_COL_CALL_UUID, call_uuid);
+	}
+
+	if (!a && !b) {
+		return;
+	}
+
+	switch_snprintf(epoch, sizeof(epoch), "%ld", (long) switch_epoch_time_now(NULL));
+
+	switch_zmalloc(call, sizeof(*call));
+	call->call_uuid = strdup(call_uuid);
+	call->created = strdup(switch_event_get_header_nil(event, "event-date-local"));
+	call->created_epoch = strdup(epoch);
+
+	if (a) {
+		scr_call_del(a->caller_of);
+		a->caller_of = call;
+		call->caller = a;
+	}
+
+	if (b) {
+		scr_call_del(b->callee_of);
+		b->callee_of = call;
+		call->callee = b;
+	}
+
+	if (scr_exporting()) {
+		scr_export_sql(switch_mprintf("insert into calls (call_uuid,call_created,call_created_epoch,caller_uuid,callee_uuid,hostname) "
+									  "values ('%q','%q','%q','%q','%q','%q')",
+									  call->call_uuid, call->created, call->created_epoch, a_uuid, b_uuid, switch_core_get_switchname()));
+	}
+}
+
+static void scr_unbridge(switch_event_t *event)
+{
+	const char *cuuid = switch_event_get_header_nil(event, "caller-unique-id");
+	scr_channel_t *ch;
+
+	if ((ch = scr_find(switch_event_get_header(event, "unique-id")))) {
+		scr_set_presence_data_cols(ch, event);
+	}
+
+	scr_set_call_uuid_where(switch_event_get_header_nil(event, "channel-call-uuid"), NULL);
+
+	if ((ch = scr_find(cuuid))) {
+		scr_channel_del_calls(ch);
+	}
+
+	if (scr_exporting()) {
+		scr_export_sql(switch_mprintf("delete from calls where (caller_uuid='%q' or callee_uuid='%q')", cuuid, cuuid));
+	}
+}
+
+SWITCH_DECLARE(void) switch_call_registry_apply_event(switch_event_t *event)
+{
+	const char *uuid = switch_event_get_header(event, "unique-id");
+	scr_channel_t *ch = NULL;
+	char epoch[32];
+
+	if (!REGISTRY.rwlock) {
+		return;
+	}
+
+	switch_thread_rwlock_wrlock(REGISTRY.rwlock);
+
+	switch (REGISTRY.running ? event->event_id : SWITCH_EVENT_ALL) {
+	case SWITCH_EVENT_CHANNEL_CREATE:
+		if (zstr(uuid)) {
+			break;
+		}
+
+		if ((ch = scr_find(uuid))) {
+			scr_channel_del(ch);
+		}
+
+		switch_snprintf(epoch, sizeof(epoch), "%ld", (long) switch_epoch_time_now(NULL));
+
+		ch = scr_channel_add(uuid);
+		scr_set_header(ch, SCR_COL_DIRECTION, event, "call-direction");
+		scr_set_header(ch, SCR_COL_CREATED, event, "event-date-local");
+		scr_set(ch, SCR_COL_CREATED_EPOCH, epoch);
+		scr_set_header(ch, SCR_COL_NAME, event, "channel-name");
+		scr_set_header(ch, SCR_COL_STATE, event, "channel-state");
+		scr_set_header(ch, SCR_COL_CALLSTATE, event, "channel-call-state");
+		scr_set_header(ch, SCR_COL_DIALPLAN, event, "caller-dialplan");
+		scr_set_header(ch, SCR_COL_CONTEXT, event, "caller-context");
+		scr_set(ch, SCR_COL_HOSTNAME, switch_core_get_switchname());
+		scr_set_header(ch, SCR_COL_INITIAL_CID_NAME, event, "caller-caller-id-name");
+		scr_set_header(ch, SCR_COL_INITIAL_CID_NUM, event, "caller-caller-id-number");
+		scr_set_header(ch, SCR_COL_INITIAL_IP_ADDR, event, "caller-network-addr");
+		scr_set_header(ch, SCR_COL_INITIAL_DEST, event, "caller-destination-number");
+		scr_set_header(ch, SCR_COL_INITIAL_DIALPLAN, event, "caller-dialplan");
+		scr_set_header(ch, SCR_COL_INITIAL_CONTEXT, event, "caller-context");
+		break;
+	case SWITCH_EVENT_CHANNEL_DESTROY:
+		if ((ch = scr_find(uuid))) {
+			scr_channel_del(ch);
+		}
+
+		if (uuid && scr_exporting()) {
+			scr_export_sql(switch_mprintf("delete from channels where uuid='%q'", uuid));
+			scr_export_sql(switch_mprintf("delete from calls where (caller_uuid='%q' or callee_uuid='%q')", uuid, uuid));
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_UUID:
+		{
+			const char *old_uuid = switch_event_get_header(event, "old-unique-id");
+
+			if ((ch = scr_find(old_uuid))) {
+				scr_set(ch, SCR_COL_UUID, uuid);
+
+				if (scr_exporting()) {
+					scr_export_sql(switch_mprintf("delete from channels where uuid='%q'", old_uuid));
+				}
+			}
+
+			scr_set_call_uuid_where(old_uuid, switch_event_get_header_nil(event, "unique-id"));
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_ANSWER:
+	case SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA:
+	case SWITCH_EVENT_CODEC:
+		if ((ch = scr_find(uuid))) {
+			scr_set_header(ch, SCR_COL_READ_CODEC, event, "channel-read-codec-name");
+			scr_set_header(ch, SCR_COL_READ_RATE, event, "channel-read-codec-rate");
+			scr_set_header(ch, SCR_COL_READ_BIT_RATE, event, "channel-read-codec-bit-rate");
+			scr_set_header(ch, SCR_COL_WRITE_CODEC, event, "channel-write-codec-name");
+			scr_set_header(ch, SCR_COL_WRITE_RATE, event, "channel-write-codec-rate");
+			scr_set_header(ch, SCR_COL_WRITE_BIT_RATE, event, "channel-write-codec-bit-rate");
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_HOLD:
+	case SWITCH_EVENT_CHANNEL_UNHOLD:
+	case SWITCH_EVENT_CHANNEL_EXECUTE:
+		if ((ch = scr_find(uuid))) {
+			scr_set_header(ch, SCR_COL_APPLICATION, event, "application");
+			scr_set_header(ch, SCR_COL_APPLICATION_DATA, event, "application-data");
+			scr_set_header(ch, SCR_COL_PRESENCE_ID, event, "channel-presence-id");
+			scr_set_header(ch, SCR_COL_PRESENCE_DATA, event, "channel-presence-data");
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_ORIGINATE:
+		if ((ch = scr_find(uuid))) {
+			scr_set_header(ch, SCR_COL_PRESENCE_ID, event, "channel-presence-id");
+			scr_set_header(ch, SCR_COL_PRESENCE_DATA, event, "channel-presence-data");
+			scr_set_header(ch, SCR_COL_CALL_UUID, event, "channel-call-uuid");
+			scr_set_presence_data_cols(ch, event);
+		}
+		break;
+	case SWITCH_EVENT_CALL_UPDATE:
+		if ((ch = scr_find(uuid))) {
+			scr_set_header(ch, SCR_COL_CALLEE_NAME, event, "caller-callee-id-name");
+			scr_set_header(ch, SCR_COL_CALLEE_NUM, event, "caller-callee-id-number");
+			scr_set_header(ch, SCR_COL_SENT_CALLEE_NAME, event, "sent-callee-id-name");
+			scr_set_header(ch, SCR_COL_SENT_CALLEE_NUM, event, "sent-callee-id-number");
+			scr_set_header(ch, SCR_COL_CALLEE_DIRECTION, event, "direction");
+			scr_set_header(ch, SCR_COL_CID_NAME, event, "caller-caller-id-name");
+			scr_set_header(ch, SCR_COL_CID_NUM, event, "caller-caller-id-number");
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_CALLSTATE:
+		{
+			const char *num = switch_event_get_header(event, "channel-call-state-number");
+			switch_channel_callstate_t callstate = num ? atoi(num) : CCS_DOWN;
+
+			if (callstate != CCS_DOWN && callstate != CCS_HANGUP && (ch = scr_find(uuid))) {
+				scr_set_header(ch, SCR_COL_CALLSTATE, event, "channel-call-state");
+				scr_set_presence_data_cols(ch, event);
+			}
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_STATE:
+		if ((ch = scr_find(uuid))) {
+			scr_channel_state(ch, event);
+		}
+		break;
+	case SWITCH_EVENT_CHANNEL_BRIDGE:
+		scr_bridge(event);
+		break;
+	case SWITCH_EVENT_CHANNEL_UNBRIDGE:
+		scr_unbridge(event);
+		break;
+	case SWITCH_EVENT_CALL_SECURE:
+		{
+			const char *type = switch_event_get_header(event, "secure_type");
+
+			if (!zstr(type) && (ch = scr_find(switch_event_get_header(event, "caller-unique-id")))) {
+				scr_set(ch, SCR_COL_SECURE, type);
+			}
+		}
+		break;
+	case SWITCH_EVENT_SHUTDOWN:
+		scr_clear();
+		break;
+	default:
+		break;
+	}
+
+	scr_unlock_export();
+}
+
+/* hand one channel to the callback in the shape of the view, returns -1 when the callback wants to stop */
+static int scr_row(switch_call_registry_view_t view, scr_channel_t *a, switch_core_db_callback_func_t callback, void *pdata)
+{
+	char *argv[SCR_ROW_MAX];
+	char *names[SCR_ROW_MAX];
+	const switch_call_registry_col_t *a_cols = NULL, *b_cols = NULL;
+	int a_count = 0, b_count = 0, argc = 0, i;
+	scr_channel_t *b;
+
+	if (view == SCR_VIEW_CHANNELS) {
+		if (callback && callback(pdata, SCR_COL_MAX, a->cols, (char **) scr_col_names)) {
+			return -1;
+		}
+		return 1;
+	}
+
+	/* the views show a call on its a leg and drop the b leg's own row */
+	if (!a->caller_of && a->callee_of) {
+		return 0;
+	}
+
+	b = a->caller_of ? a->caller_of->callee : NULL;
+
+	if (!b && (view == SCR_VIEW_BRIDGED_CALLS || view == SCR_VIEW_DETAILED_BRIDGED_CALLS)) {
+		return 0;
+	}
+
+	if (!callback) {
+		return 1;
+	}
+
+	if (view == SCR_VIEW_CALLS || view == SCR_VIEW_BRIDGED_CALLS) {
+		a_cols = scr_basic_a_cols;
+		a_count = sizeof(scr_basic_a_cols) / sizeof(scr_basic_a_cols[0]);
+		b_cols = scr_basic_b_cols;
+		b_count = sizeof(scr_basic_b_cols) / sizeof(scr_basic_b_cols[0]);
+	} else {
+		a_count = b_count = SCR_DETAILED_COLS;
+	}
+
+	for (i = 0; i < a_count; i++, argc++) {
+		switch_call_registry_col_t col = a_cols ? a_cols[i] : (switch_call_registry_col_t) i;
+
+		argv[argc] = a->cols[col];
+		names[argc] = (char *) scr_col_names[col];
+	}
+
+	for (i = 0; i < b_count; i++, argc++) {
+		switch_call_registry_col_t col = b_cols ? b_cols[i] : (switch_call_registry_col_t) i;
+
+		argv[argc] = b ? b->cols[col] : NULL;
+		names[argc] = (char *) scr_b_col_names[col];
+	}
+
+	argv[argc] = a->caller_of ? a->caller_of->created_epoch : NULL;
+	names[argc++] = "call_created_epoch";
+
+	return callback(pdata, argc, argv, names) ? -1 : 1;
+}
+
+SWITCH_DECLARE(uint32_t) switch_call_registry_query(switch_call_registry_view_t view, switch_call_registry_index_t index, const char *key,
+													 switch_core_db_callback_func_t callback, void *pdata)
+{
+	scr_channel_t *ch, *next;
+	scr_list_t *list = NULL;
+	scr_link_t link = SCR_LINK_ALL;
+	uint32_t rows = 0;
+	int r;
+
+	if (!REGISTRY.rwlock) {
+		return 0;
+	}
+
+	switch_thread_rwlock_rdlock(REGISTRY.rwlock);
+
+	if (!REGISTRY.running) {
+		goto end;
+	}
+
+	switch (index) {
+	case SCR_INDEX_UUID:
+		if ((ch = scr_find(key)) && (r = scr_row(view, ch, callback, pdata)) > 0) {
+			rows++;
+		}
+		goto end;
+	case SCR_INDEX_PRESENCE_ID:
+		link = SCR_LINK_PRESENCE_ID;
+		break;
+	case SCR_INDEX_CALL_UUID:
+		link = SCR_LINK_CALL_UUID;
+		break;
+	case SCR_INDEX_HOSTNAME:
+		link = SCR_LINK_HOSTNAME;
+		break;
+	default:
+		list = &REGISTRY.all;
+		break;
+	}
+
+	if (!list && (zstr(key) || !(list = switch_core_hash_find(REGISTRY.index_hash[link], key)))) {
+		goto end;
+	}
+
+	for (ch = list->head; ch; ch = next) {
+		next = ch->next[link];
+
+		if ((r = scr_row(view, ch, callback, pdata)) < 0) {
+			rows++;
+			break;
+		}
+
+		rows += r;
+	}
+
+ end:
+
+	switch_thread_rwlock_unlock(REGISTRY.rwlock);
+
+	return rows;
+}
+
+SWITCH_DECLARE(char *) switch_call_registry_get(const char *uuid, switch_call_registry_col_t col)
+{
+	scr_channel_t *ch;
+	char *val = NULL;
+
+	if (!REGISTRY.rwlock || col >= SCR_COL_MAX) {
+		return NULL;
+	}
+
+	switch_thread_rwlock_rdlock(REGISTRY.rwlock);
+	if (REGISTRY.running && (ch = scr_find(uuid)) && ch->cols[col]) {
+		val = strdup(ch->cols[col]);
+	}
+	switch_thread_rwlock_unlock(REGISTRY.rwlock);
+
+	return val;
+}
+
+static void scr_export_channel(scr_channel_t *ch)
+{
+	switch_stream_handle_t stream = { 0 };
+	char *val;
+	int i;
+
+	scr_export_sql(switch_mprintf("delete from channels where uuid='%q' and hostname='%q'",
+								  switch_str_nil(ch->cols[SCR_COL_UUID]), switch_str_nil(ch->cols[SCR_COL_HOSTNAME])));
+
+	SWITCH_STANDARD_STREAM(stream);
+	stream.write_function(&stream, "%s", REGISTRY.insert_sql);
+
+	for (i = 0; i < SCR_COL_MAX; i++) {
+		if (ch->cols[i]) {
+			val = switch_mprintf("'%q'", ch->cols[i]);
+			stream.write_function(&stream, "%s%s", val, i == SCR_COL_MAX - 1 ? ")" : ",");
+			free(val);
+		} else {
+			stream.write_function(&stream, "NULL%s", i == SCR_COL_MAX - 1 ? ")" : ",");
+		}
+	}
+
+	scr_export_sql((char *) stream.data);
+}
+
+SWITCH_DECLARE(void) switch_call_registry_export(void)
+{
+	scr_channel_t *ch;
+
+	if (!REGISTRY.rwlock || !scr_exporting()) {
+		return;
+	}
+
+	switch_thread_rwlock_wrlock(REGISTRY.rwlock);
+	while (REGISTRY.running && (ch = REGISTRY.dirty.head)) {
+		scr_list_del(&REGISTRY.dirty, ch, SCR_LINK_DIRTY);
+		scr_export_channel(ch);
+	}
+	scr_unlock_export();
+}
+
+static void scr_event_handler(switch_event_t *event)
+{
+	const char *uuid;
+
+	/* events are delivered late, skip the ones for channels that are already gone so a create can not outlive its destroy */
+	switch (event->event_id) {
+	case SWITCH_EVENT_CHANNEL_DESTROY:
+	case SWITCH_EVENT_CODEC:
+	case SWITCH_EVENT_SHUTDOWN:
+		break;
+	default:
+		if ((uuid = switch_event_get_header(event, "unique-id")) && !switch_ivr_uuid_exists(uuid)) {
+			return;
+		}
+		break;
+	}
+
+	switch_call_registry_apply_event(event);
+}
+
+SWITCH_DECLARE(void) switch_call_registry_init(switch_memory_pool_t *pool)
+{
+	switch_stream_handle_t stream = { 0 };
+	switch_event_types_t events[] = {
+		SWITCH_EVENT_CHANNEL_CREATE, SWITCH_EVENT_CHANNEL_DESTROY, SWITCH_EVENT_CHANNEL_UUID, SWITCH_EVENT_CHANNEL_ANSWER,
+		SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA, SWITCH_EVENT_CODEC, SWITCH_EVENT_CHANNEL_HOLD, SWITCH_EVENT_CHANNEL_UNHOLD,
+		SWITCH_EVENT_CHANNEL_EXECUTE, SWITCH_EVENT_CHANNEL_ORIGINATE, SWITCH_EVENT_CALL_UPDATE, SWITCH_EVENT_CHANNEL_CALLSTATE,
+		SWITCH_EVENT_CHANNEL_STATE, SWITCH_EVENT_CHANNEL_BRIDGE, SWITCH_EVENT_CHANNEL_UNBRIDGE, SWITCH_EVENT_CALL_SECURE,
+		SWITCH_EVENT_SHUTDOWN
+	};
+	int i;
+
+	memset(&REGISTRY, 0, sizeof(REGISTRY));
+	switch_thread_rwlock_create(&REGISTRY.rwlock, pool);
+	switch_mutex_init(&REGISTRY.export_mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_core_hash_init(&REGISTRY.uuid_hash);
+
+	for (i = SCR_LINK_PRESENCE_ID; i <= SCR_LINK_HOSTNAME; i++) {
+		switch_core_hash_init(&REGISTRY.index_hash[i]);
+	}
+
+	SWITCH_STANDARD_STREAM(stream);
+	stream.write_function(&stream, "insert into channels (");
+	for (i = 0; i < SCR_COL_MAX; i++) {
+		stream.write_function(&stream, "%s%s", scr_col_names[i], i == SCR_COL_MAX - 1 ? ") values (" : ",");
+	}
+	REGISTRY.insert_sql = switch_core_strdup(pool, (char *) stream.data);
+	free(stream.data);
+
+	REGISTRY.running = 1;
+
+	for (i = 0; i < (int) (sizeof(events) / sizeof(events[0])); i++) {
+		switch_event_bind("core_call_registry", events[i], SWITCH_EVENT_SUBCLASS_ANY, scr_event_handler, NULL);
+	}
+}
+
+SWITCH_DECLARE(void) switch_call_registry_shutdown(void)
+{
+	int i;
+
+	if (!REGISTRY.rwlock) {
+		return;
+	}
+
+	switch_event_unbind_callback(scr_event_handler);
+
+	switch_thread_rwlock_wrlock(REGISTRY.rwlock);
+	if (!REGISTRY.running) {
+		switch_thread_rwlock_unlock(REGISTRY.rwlock);
+		return;
+	}
+	scr_clear();
+	REGISTRY.running = 0;
+	switch_core_hash_destroy(&REGISTRY.uuid_hash);
+	for (i = SCR_LINK_PRESENCE_ID; i <= SCR_LINK_HOSTNAME; i++) {
+		switch_core_hash_destroy(&REGISTRY.index_hash[i]);
+	}
+	switch_thread_rwlock_unlock(REGISTRY.rwlock);
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
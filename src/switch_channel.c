@@ -430,6 +430,8 @@ SWITCH_DECLARE(switch_status_t) switch_channel_alloc(switch_channel_t **channel,
 	}
 
 	switch_event_create_plain(&(*channel)->variables, SWITCH_EVENT_CHANNEL_DATA);
+	/* every variable lookup and set goes through here, long calls carry hundreds of them */
+	switch_event_index_headers((*channel)->variables);
 
 	switch_core_hash_init(&(*channel)->private_hash);
 	switch_queue_create(&(*channel)->dtmf_queue, SWITCH_DTMF_LOG_LEN, pool);
@@ -3829,6 +3831,126 @@ SWITCH_DECLARE(switch_status_t) switch_channel_perform_answer(switch_channel_t *
 	memset(c, 0, olen - cpos);\
 	}}                           \
 
+/* what the parser below does for each ${...} it finds, over the ops of a compiled template */
+static char *channel_expand_template(switch_channel_t *channel, switch_expand_template_t *tpl, switch_event_t *var_list, switch_event_t *api_list, uint32_t recur)
+{
+	switch_stream_handle_t out = { 0 }, api_stream = { 0 };
+	uint32_t i;
+
+	switch_expand_stream_init(&out, tpl);
+
+	for (i = 0; i < tpl->op_count; i++) {
+		switch_expand_op_t *op = &tpl->ops[i], dyn;
+		char *vname = op->str, *vval = op->arg, *expanded = NULL, *expanded_vname = NULL, *copy = NULL;
+		const char *sub_val = NULL;
+		switch_size_t len;
+
+		if (op->type == SWITCH_EXPAND_LITERAL) {
+			out.raw_write_function(&out, (uint8_t *) op->str, op->len);
+			continue;
+		}
+
+		if (op->type == SWITCH_EXPAND_API) {
+			if (op->expand_str && (expanded_vname = switch_channel_expand_variables_check(channel, vname, var_list, api_list, recur+1)) != vname) {
+				vname = expanded_vname;
+			} else {
+				expanded_vname = NULL;
+			}
+
+			if (op->expand_arg && (expanded = switch_channel_expand_variables_check(channel, vval, var_list, api_list, recur+1)) != vval) {
+				vval = expanded;
+			} else {
+				expanded = NULL;
+			}
+
+			if (!switch_core_test_flag(SCF_API_EXPANSION) || (api_list && !switch_event_check_permission_list(api_list, vname))) {
+				sub_val = "<API Execute Permission Denied>";
+			} else {
+				/* one scratch stream for all the api calls of this expansion */
+				if (!api_stream.data) {
+					SWITCH_STANDARD_STREAM(api_stream);
+				} else {
+					api_stream.data_len = 0;
+					api_stream.end = api_stream.data;
+					*(char *) api_stream.data = '\0';
+				}
+
+				if (switch_api_execute(vname, vval, channel->session, &api_stream) == SWITCH_STATUS_SUCCESS) {
+					sub_val = api_stream.data;
+				}
+			}
+
+			if (sub_val) {
+				out.raw_write_function(&out, (uint8_t *) sub_val, strlen(sub_val));
+			}
+
+			switch_safe_free(expanded);
+			switch_safe_free(expanded_vname);
+			continue;
+		}
+
+		/* ${var} and $${var} are the same thing here, the channel lookup falls back to the globals */
+		if (op->expand_str) {
+			int offset = 0, ooffset = 0, idx = -1;
+
+			if ((expanded = switch_channel_expand_variables_check(channel, vname, var_list, api_list, recur+1)) == vname) {
+				expanded = strdup(vname);
+				switch_assert(expanded);
+			}
+			vname = expanded;
+			switch_expand_parse_name(vname, &offset, &ooffset, &idx);
+
+			dyn = *op;
+			dyn.offset = offset;
+			dyn.ooffset = ooffset;
+			dyn.idx = idx;
+			op = &dyn;
+		}
+
+		switch_mutex_lock(channel->profile_mutex);
+
+		if ((sub_val = switch_channel_get_variable_dup(channel, vname, SWITCH_FALSE, op->idx))) {
+			if (var_list && !switch_event_check_permission_list(var_list, vname)) {
+				sub_val = "<Variable Expansion Permission Denied>";
+			}
+
+			if (switch_string_var_check_const(sub_val) || switch_string_has_escaped_data(sub_val)) {
+				/* expanding the value can run apis, that is not done holding the lock */
+				copy = strdup(sub_val);
+				switch_assert(copy);
+			} else {
+				len = strlen(sub_val);
+				switch_expand_substr(op->offset, op->ooffset, &sub_val, &len);
+				out.raw_write_function(&out, (uint8_t *) sub_val, len);
+			}
+		}
+
+		switch_mutex_unlock(channel->profile_mutex);
+
+		if (copy) {
+			char *expanded_sub_val;
+
+			if ((expanded_sub_val = switch_channel_expand_variables_check(channel, copy, var_list, api_list, recur+1)) == copy) {
+				expanded_sub_val = NULL;
+			}
+
+			sub_val = expanded_sub_val ? expanded_sub_val : copy;
+			len = strlen(sub_val);
+			switch_expand_substr(op->offset, op->ooffset, &sub_val, &len);
+			out.raw_write_function(&out, (uint8_t *) sub_val, len);
+
+			switch_safe_free(expanded_sub_val);
+			free(copy);
+		}
+
+		switch_safe_free(expanded);
+	}
+
+	switch_safe_free(api_stream.data);
+
+	return out.data;
+}
+
 SWITCH_DECLARE(char *) switch_channel_expand_variables_check(switch_channel_t *channel, const char *in, switch_event_t *var_list, switch_event_t *api_list, uint32_t recur)
 {
 	char *p, *c = NULL;
@@ -3836,6 +3958,7 @@ SWITCH_DECLARE(char *) switch_channel_expand_variables_check(switch_channel_t *c
 	size_t sp = 0, len = 0, olen = 0, vtype = 0, br = 0, cpos, block = 128;
 	char *cloned_sub_val = NULL, *sub_val = NULL, *expanded_sub_val = NULL;
 	char *func_val = NULL, *sb = NULL;
+	switch_expand_template_t *tpl;
 	int nv = 0;
 
 	if (recur > 100) {
@@ -3852,6 +3975,11 @@ SWITCH_DECLARE(char *) switch_channel_expand_variables_check(switch_channel_t *c
 		return (char *) in;
 	}
 
+	if ((tpl = switch_expand_template_get(in))) {
+		data = channel_expand_template(channel, tpl, var_list, api_list, recur);
+		switch_expand_template_release(&tpl);
+		return data;
+	}
 
 	nv = 0;
 	olen = strlen(in) + 1;
@@ -1945,6 +1945,9 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 #endif
 	switch_console_init(runtime.memory_pool);
 	switch_event_init(runtime.memory_pool);
+	switch_expand_init(runtime.memory_pool);
+	switch_call_registry_init(runtime.memory_pool);
+	switch_regex_init(runtime.memory_pool);
 	switch_channel_global_init(runtime.memory_pool);
 
 	if (switch_xml_init(runtime.memory_pool, err) != SWITCH_STATUS_SUCCESS) {
@@ -1957,6 +1960,8 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 	}
 
 	switch_log_init(runtime.memory_pool, runtime.colorize_console);
+
+	switch_simd_init();
 			
 	runtime.tipping_point = 0;
 	runtime.timer_affinity = -1;
@@ -2167,6 +2172,12 @@ static void switch_load_core_config(const char *file)
 					runtime.core_db_inner_pre_trans_execute = switch_core_strdup(runtime.memory_pool, val);
 				} else if (!strcasecmp(var, "core-db-inner-post-trans-execute") && !zstr(val)) {
 					runtime.core_db_inner_post_trans_execute = switch_core_strdup(runtime.memory_pool, val);
+				} else if (!strcasecmp(var, "core-channel-sql-export")) {
+					if (switch_true(val)) {
+						switch_set_flag((&runtime), SCF_CHANNEL_SQL_EXPORT);
+					} else {
+						switch_clear_flag((&runtime), SCF_CHANNEL_SQL_EXPORT);
+					}
 				} else if (!strcasecmp(var, "dialplan-timestamps")) {
 					if (switch_true(val)) {
 						switch_set_flag((&runtime), SCF_DIALPLAN_TIMESTAMPS);
@@ -2282,6 +2293,29 @@ static void switch_load_core_config(const char *file)
 					switch_rtp_set_start_port((switch_port_t) atoi(val));
 				} else if (!strcasecmp(var, "rtp-end-port") && !zstr(val)) {
 					switch_rtp_set_end_port((switch_port_t) atoi(val));
+				} else if (!strcasecmp(var, "rtp-batch-recv-threads") && !zstr(val)) {
+					if (!strcasecmp(val, "auto")) {
+						switch_rtp_set_batch_recv_threads(runtime.cpu_count);
+					} else {
+						int tmp = atoi(val);
+						switch_rtp_set_batch_recv_threads(tmp > 0 ? (uint32_t) tmp : 0);
+					}
+				} else if (!strcasecmp(var, "rtp-batch-send-threads") && !zstr(val)) {
+					if (!strcasecmp(val, "auto")) {
+						switch_rtp_set_batch_send_threads(runtime.cpu_count);
+					} else {
+						int tmp = atoi(val);
+						switch_rtp_set_batch_send_threads(tmp > 0 ? (uint32_t) tmp : 0);
+					}
+				} else if (!strcasecmp(var, "simd-level") && !zstr(val)) {
+					switch_simd_level_t level = switch_simd_level_from_name(val);
+
+					if (switch_simd_set_level(level) != SWITCH_STATUS_SUCCESS) {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "SIMD level %s is not supported by this cpu, using %s\n",
+										  val, switch_simd_level_name(switch_simd_level()));
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Using %s PCM kernels\n", switch_simd_level_name(level));
+					}
 				} else if (!strcasecmp(var, "rtp-port-usage-robustness") && switch_true(val)) {
 					runtime.port_alloc_flags |= SPF_ROBUST_UDP;
 				} else if (!strcasecmp(var, "core-db-name") && !zstr(val)) {
@@ -2902,8 +2936,12 @@ SWITCH_DECLARE(switch_status_t) switch_core_destroy(void)
 	switch_console_shutdown();
 	switch_channel_global_uninit();
 
+	switch_call_registry_shutdown();
+
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Closing Event Engine.\n");
 	switch_event_shutdown();
+	switch_expand_shutdown();
+	switch_regex_shutdown();
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Finalizing Shutdown.\n");
 	switch_log_shutdown();
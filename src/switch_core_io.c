@@ -723,8 +723,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 													 bp->read_demux_frame->channels) * 2 * bp->read_demux_frame->channels;
 
 						switch_buffer_write(bp->raw_read_buffer, data, datalen);
+						session->copy_stats.bugs += read_frame->datalen + datalen;
 					} else {
 						switch_buffer_write(bp->raw_read_buffer, read_frame->data, read_frame->datalen);
+						session->copy_stats.bugs += read_frame->datalen;
 					}
 
 					if (bp->callback) {
@@ -754,6 +756,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 				switch_mutex_lock(session->resample_mutex);
 				switch_resample_process(session->read_resampler, data, (int) read_frame->datalen / 2 / session->read_resampler->channels);
 				memcpy(data, session->read_resampler->to, session->read_resampler->to_len * 2 * session->read_resampler->channels);
+				session->copy_stats.resample += session->read_resampler->to_len * 2 * session->read_resampler->channels;
 				read_frame->samples = session->read_resampler->to_len;
 				read_frame->channels = session->read_resampler->channels;
 				read_frame->datalen = session->read_resampler->to_len * 2 * session->read_resampler->channels;
@@ -775,6 +778,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 					status = SWITCH_STATUS_MEMERR;
 					goto done;
 				}
+				session->copy_stats.reframe += read_frame->datalen;
 			}
 			
 			if (perfect || switch_buffer_inuse(session->raw_read_buffer) >= session->read_impl.decoded_bytes_per_packet) {
@@ -787,6 +791,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_frame(switch_core_sessi
 																					session->read_impl.decoded_bytes_per_packet);
 
 					session->raw_read_frame.rate = session->read_impl.actual_samples_per_second;
+					session->copy_stats.reframe += session->raw_read_frame.datalen;
 					enc_frame = &session->raw_read_frame;
 				}
 				session->enc_read_frame.datalen = session->enc_read_frame.buflen;
@@ -1269,6 +1274,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 			switch_resample_process(session->write_resampler, data, write_frame->datalen / 2 / session->write_resampler->channels);
 
 			memcpy(data, session->write_resampler->to, session->write_resampler->to_len * 2 * session->write_resampler->channels);
+			session->copy_stats.resample += session->write_resampler->to_len * 2 * session->write_resampler->channels;
 
 			write_frame->samples = session->write_resampler->to_len;
 			write_frame->channels = session->write_resampler->channels;
@@ -1312,6 +1318,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 				switch_mutex_lock(bp->write_mutex);
 				switch_buffer_write(bp->raw_write_buffer, write_frame->data, write_frame->datalen);
 				switch_mutex_unlock(bp->write_mutex);
+				session->copy_stats.bugs += write_frame->datalen;
 				
 				if (bp->callback) {
 					ok = bp->callback(bp, bp->user_data, SWITCH_ABC_TYPE_WRITE);
@@ -1453,6 +1460,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 				status = SWITCH_STATUS_MEMERR;
 				goto error;
 			}
+			session->copy_stats.reframe += write_frame->datalen;
 
 			status = SWITCH_STATUS_SUCCESS;
 
@@ -1466,6 +1474,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 					 switch_buffer_read(session->raw_write_buffer, session->raw_write_frame.data, session->write_impl.decoded_bytes_per_packet)) == 0) {
 					goto error;
 				}
+				session->copy_stats.reframe += session->raw_write_frame.datalen;
 
 				enc_frame = &session->raw_write_frame;
 				session->raw_write_frame.rate = session->write_impl.actual_samples_per_second;
@@ -1586,6 +1595,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 					if (session->read_resampler) {
 						switch_resample_process(session->read_resampler, data, write_frame->datalen / 2 / session->read_resampler->channels);
 						memcpy(data, session->read_resampler->to, session->read_resampler->to_len * 2 * session->read_resampler->channels);
+						session->copy_stats.resample += session->read_resampler->to_len * 2 * session->read_resampler->channels;
 						write_frame->samples = session->read_resampler->to_len;
 						write_frame->channels = session->read_resampler->channels;
 						write_frame->datalen = session->read_resampler->to_len * 2 * session->read_resampler->channels;
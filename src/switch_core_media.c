@@ -1511,6 +1511,21 @@ static void set_stats(switch_core_session_t *session, switch_media_type_t type,
 	}
 }
 
+static void set_copy_stats(switch_core_session_t *session)
+{
+	switch_media_copy_stats_t *copy_stats = switch_core_session_get_copy_stats(session);
+	switch_channel_t *channel = switch_core_session_get_channel(session);
+	const char *prefix = "copy";
+	char var_name[256] = "", var_val[35] = "";
+
+	add_stat(copy_stats->rtp_read, "read_bytes");
+	add_stat(copy_stats->resample, "resample_bytes");
+	add_stat(copy_stats->reframe, "reframe_bytes");
+	add_stat(copy_stats->bugs, "media_bug_bytes");
+	add_stat(copy_stats->rtp_write, "write_bytes");
+	add_stat(copy_stats->rtp_write_zerocopy, "write_zerocopy_bytes");
+}
+
 SWITCH_DECLARE(void) switch_core_media_set_stats(switch_core_session_t *session)
 {
 	
@@ -1520,6 +1535,7 @@ SWITCH_DECLARE(void) switch_core_media_set_stats(switch_core_session_t *session)
 
 	set_stats(session, SWITCH_MEDIA_TYPE_AUDIO, "audio");
 	set_stats(session, SWITCH_MEDIA_TYPE_VIDEO, "video");
+	set_copy_stats(session);
 }
 
 
@@ -5974,6 +5990,22 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_activate_rtp(switch_core_sessi
 		flags[SWITCH_RTP_FLAG_AUTOFLUSH]++;
 	}
 
+	if ((val = switch_channel_get_variable(session->channel, "rtp_batch_recv"))) {
+		if (switch_true(val)) {
+			flags[SWITCH_RTP_FLAG_BATCH_RECV]++;
+		}
+	} else if (switch_media_handle_test_media_flag(smh, SCMF_RTP_BATCH_RECV)) {
+		flags[SWITCH_RTP_FLAG_BATCH_RECV]++;
+	}
+
+	if ((val = switch_channel_get_variable(session->channel, "rtp_batch_send"))) {
+		if (switch_true(val)) {
+			flags[SWITCH_RTP_FLAG_BATCH_SEND]++;
+		}
+	} else if (switch_media_handle_test_media_flag(smh, SCMF_RTP_BATCH_SEND)) {
+		flags[SWITCH_RTP_FLAG_BATCH_SEND]++;
+	}
+
 	if (!(switch_media_handle_test_media_flag(smh, SCMF_REWRITE_TIMESTAMPS) ||
 		  ((val = switch_channel_get_variable(session->channel, "rtp_rewrite_timestamps")) && switch_true(val)))) {
 		flags[SWITCH_RTP_FLAG_RAW_WRITE]++;
@@ -598,6 +598,11 @@ void switch_core_memory_stop(void)
 #ifndef INSTANTLY_DESTROY_POOLS
 	switch_status_t st;
 	void *pop = NULL;
+#endif
+
+	switch_slab_shutdown();
+
+#ifndef INSTANTLY_DESTROY_POOLS
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Stopping memory pool queue.\n");
 
@@ -651,6 +656,8 @@ switch_memory_pool_t *switch_core_memory_init(void)
 	switch_mutex_init(&memory_manager.mem_lock, SWITCH_MUTEX_NESTED, memory_manager.memory_pool);
 #endif
 
+	switch_slab_init(memory_manager.memory_pool);
+
 #ifdef INSTANTLY_DESTROY_POOLS
 	{
 		void *foo;
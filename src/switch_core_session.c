@@ -1358,6 +1358,11 @@ SWITCH_DECLARE(switch_channel_t *) switch_core_session_get_channel(switch_core_s
 	return session->channel;
 }
 
+SWITCH_DECLARE(switch_media_copy_stats_t *) switch_core_session_get_copy_stats(switch_core_session_t *session)
+{
+	return &session->copy_stats;
+}
+
 SWITCH_DECLARE(switch_mutex_t *) switch_core_session_get_mutex(switch_core_session_t *session)
 {
 	return session->mutex;
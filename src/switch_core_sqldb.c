@@ -38,6 +38,8 @@
 
 #define SWITCH_SQL_QUEUE_LEN 100000
 #define SWITCH_SQL_QUEUE_PAUSE_LEN 90000
+#define SWITCH_SQL_QUEUE_TRANS_MIN 16
+#define SWITCH_SQL_QUEUE_TRANS_TARGET 100000
 
 struct switch_cache_db_handle {
 	char name[CACHE_DB_LEN];
@@ -1392,6 +1394,8 @@ static void *SWITCH_THREAD_FUNC switch_core_sql_db_thread(switch_thread_t *threa
 			switch_core_expire_registration(0);
 			reg_sec = 0;
 		}
+
+		switch_call_registry_export();
 		switch_yield(1000000);
 	}
 
@@ -1402,6 +1406,24 @@ static void *SWITCH_THREAD_FUNC switch_core_sql_db_thread(switch_thread_t *threa
 
 static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread, void *obj);
 
+/* a statement registered with switch_sql_queue_manager_prepare(), split on its ? placeholders */
+typedef struct qm_stmt {
+	char *name;
+	char *sql;
+	char **segs;
+	switch_size_t seg_len;
+	int argc;
+	switch_core_db_stmt_t *core_stmt;
+	struct qm_stmt *next;
+} qm_stmt_t;
+
+/* one queued entry, either plain sql or a prepared statement and its parameters */
+typedef struct qm_job {
+	qm_stmt_t *stmt;
+	char *sql;
+	char **argv;
+} qm_job_t;
+
 struct switch_sql_queue_manager {
 	const char *name;
 	switch_cache_db_handle_t *event_db;
@@ -1422,8 +1444,13 @@ struct switch_sql_queue_manager {
 	char *inner_post_trans_execute;
 	switch_memory_pool_t *pool;
 	uint32_t max_trans;
+	uint32_t trans_size;
+	switch_time_t trans_target;
+	switch_time_t trans_time;
 	uint32_t confirm;
 	uint8_t paused;
+	switch_hash_t *stmt_hash;
+	qm_stmt_t *stmts;
 };
 
 static int qm_wake(switch_sql_queue_manager_t *qm)
@@ -1594,18 +1621,170 @@ SWITCH_DECLARE(void) switch_sql_queue_manager_execute_sql_event_callback_err(swi
 }
 
 
+static char *qm_stmt_render(qm_stmt_t *stmt, char **argv)
+{
+	switch_size_t len = stmt->seg_len + 1;
+	char *sql, *p;
+	const char *v;
+	int i;
+
+	for (i = 0; i < stmt->argc; i++) {
+		len += argv[i] ? strlen(argv[i]) * 2 + 2 : 4;
+	}
+
+	switch_zmalloc(sql, len);
+	p = sql;
+
+	for (i = 0; i <= stmt->argc; i++) {
+		len = strlen(stmt->segs[i]);
+		memcpy(p, stmt->segs[i], len);
+		p += len;
+
+		if (i == stmt->argc) {
+			break;
+		}
+
+		if (!argv[i]) {
+			memcpy(p, "NULL", 4);
+			p += 4;
+			continue;
+		}
+
+		*p++ = '\'';
+		for (v = argv[i]; *v; v++) {
+			if (*v == '\'') {
+				*p++ = '\'';
+			}
+			*p++ = *v;
+		}
+		*p++ = '\'';
+	}
+
+	return sql;
+}
+
+static switch_status_t qm_exec_stmt_native(switch_sql_queue_manager_t *qm, switch_cache_db_handle_t *dbh, qm_job_t *job)
+{
+	qm_stmt_t *stmt = job->stmt;
+	switch_core_db_t *db = dbh->native_handle.core_db_dbh;
+	int i, ret, sane = 300, reprepared = 0;
+
+	while (--sane > 0) {
+		if (!stmt->core_stmt && switch_core_db_prepare(db, stmt->sql, -1, &stmt->core_stmt, NULL) != SWITCH_CORE_DB_OK) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s NATIVE PREPARE ERR [%s]\n%s\n", qm->name, switch_core_db_errmsg(db), stmt->sql);
+			if (stmt->core_stmt) {
+				switch_core_db_finalize(stmt->core_stmt);
+				stmt->core_stmt = NULL;
+			}
+			return SWITCH_STATUS_FALSE;
+		}
+
+		for (i = 0; i < stmt->argc; i++) {
+			switch_core_db_bind_text(stmt->core_stmt, i + 1, job->argv[i], -1, SWITCH_CORE_DB_STATIC);
+		}
+
+		ret = switch_core_db_step(stmt->core_stmt);
+
+		if (ret == SWITCH_CORE_DB_DONE || ret == SWITCH_CORE_DB_ROW) {
+			switch_core_db_reset(stmt->core_stmt);
+			return SWITCH_STATUS_SUCCESS;
+		}
+
+		/* the legacy step only says ERROR, reset hands back the real reason */
+		if (ret == SWITCH_CORE_DB_ERROR) {
+			ret = switch_core_db_reset(stmt->core_stmt);
+		} else {
+			switch_core_db_reset(stmt->core_stmt);
+		}
+
+		/* somebody else has the database, wait for it the way switch_core_db_exec() does */
+		if (ret == SWITCH_CORE_DB_BUSY || ret == SWITCH_CORE_DB_LOCKED) {
+			if (sane > 1) {
+				switch_yield(100000);
+			}
+			continue;
+		}
+
+		/* a schema change leaves the statement stale, prepare it once more before giving up */
+		if ((ret == SWITCH_CORE_DB_SCHEMA || ret == SWITCH_CORE_DB_ERROR) && !reprepared++) {
+			switch_core_db_finalize(stmt->core_stmt);
+			stmt->core_stmt = NULL;
+			continue;
+		}
+
+		break;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s NATIVE SQL ERR [%s]\n%s\n", qm->name, switch_core_db_errmsg(db), stmt->sql);
+
+	return SWITCH_STATUS_FALSE;
+}
+
+static switch_status_t qm_exec_job(switch_sql_queue_manager_t *qm, switch_cache_db_handle_t *dbh, qm_job_t *job)
+{
+	switch_status_t status;
+	char *sql;
+
+	if (!job->stmt) {
+		return switch_cache_db_execute_sql(dbh, job->sql, NULL);
+	}
+
+	/* compiled statements belong to the queue thread's own handle, anything else gets the rendered text */
+	if (dbh == qm->event_db && dbh->type == SCDB_TYPE_CORE_DB) {
+		return qm_exec_stmt_native(qm, dbh, job);
+	}
+
+	sql = qm_stmt_render(job->stmt, job->argv);
+	status = switch_cache_db_execute_sql(dbh, sql, NULL);
+	free(sql);
+
+	return status;
+}
+
+static void qm_free_job(qm_job_t **jobp)
+{
+	qm_job_t *job = *jobp;
+
+	*jobp = NULL;
+
+	if (!job) {
+		return;
+	}
+
+	if (job->sql && job->sql != (char *) (job + 1)) {
+		free(job->sql);
+	}
+
+	free(job);
+}
+
+static void qm_finalize_stmts(switch_sql_queue_manager_t *qm)
+{
+	qm_stmt_t *stmt;
+
+	switch_mutex_lock(qm->mutex);
+	for (stmt = qm->stmts; stmt; stmt = stmt->next) {
+		if (stmt->core_stmt) {
+			switch_core_db_finalize(stmt->core_stmt);
+			stmt->core_stmt = NULL;
+		}
+	}
+	switch_mutex_unlock(qm->mutex);
+}
+
 static void do_flush(switch_sql_queue_manager_t *qm, int i, switch_cache_db_handle_t *dbh)
 {
 	void *pop = NULL;
 	switch_queue_t *q = qm->sql_queue[i];
+	qm_job_t *job;
 
 	switch_mutex_lock(qm->mutex);
 	while (switch_queue_trypop(q, &pop) == SWITCH_STATUS_SUCCESS) {
-		if (pop) {
+		if ((job = (qm_job_t *) pop)) {
 			if (dbh) {
-				switch_cache_db_execute_sql(dbh, (char *) pop, NULL);
+				qm_exec_job(qm, dbh, job);
 			}
-			switch_safe_free(pop);
+			qm_free_job(&job);
 		}
 	}
 	switch_mutex_unlock(qm->mutex);
@@ -1722,18 +1901,60 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_destroy(switch_sql_queu
 		do_flush(qm, i, NULL);
 	}
 
+	qm_finalize_stmts(qm);
+	switch_core_hash_destroy(&qm->stmt_hash);
+
 	pool = qm->pool;
 	switch_core_destroy_memory_pool(&pool);
 
 	return status;
 }
 
-SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup)
+static void qm_push_job(switch_sql_queue_manager_t *qm, qm_job_t *job, uint32_t pos)
 {
-	char *sqlptr = NULL;
 	switch_status_t status;
 	int x = 0;
 
+	if (pos > qm->numq - 1) {
+		pos = 0;
+	}
+
+	do {
+		switch_mutex_lock(qm->mutex);
+		status = switch_queue_trypush(qm->sql_queue[pos], job);
+		switch_mutex_unlock(qm->mutex);
+		if (status != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG1, "Delay %d sending sql\n", x);
+			if (x++) {
+				switch_yield(1000000 * x);
+			}
+		}
+	} while(status != SWITCH_STATUS_SUCCESS);
+	
+	qm_wake(qm);
+}
+
+static qm_job_t *qm_sql_job(const char *sql, switch_bool_t dup)
+{
+	qm_job_t *job;
+	switch_size_t len;
+
+	if (dup) {
+		len = strlen(sql) + 1;
+		switch_zmalloc(job, sizeof(*job) + len);
+		job->sql = (char *) (job + 1);
+		memcpy(job->sql, sql, len);
+	} else {
+		switch_zmalloc(job, sizeof(*job));
+		job->sql = (char *) sql;
+	}
+
+	return job;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push(switch_sql_queue_manager_t *qm, const char *sql, uint32_t pos, switch_bool_t dup)
+{
+
 	if (sql_manager.paused || qm->thread_running != 1) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG1, "DROP [%s]\n", sql);
 		if (!dup) free((char *)sql);
@@ -1746,25 +1967,115 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push(switch_sql_queue_m
 		return SWITCH_STATUS_FALSE;
 	}
 
-	if (pos > qm->numq - 1) {
-		pos = 0;
+	qm_push_job(qm, qm_sql_job(sql, dup), pos);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_prepare(switch_sql_queue_manager_t *qm, const char *name, const char *sql)
+{
+	qm_stmt_t *stmt;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	const char *p, *s;
+	int quoted = 0, i = 0;
+
+	switch_assert(name && sql);
+
+	switch_mutex_lock(qm->mutex);
+
+	if ((stmt = switch_core_hash_find(qm->stmt_hash, name))) {
+		if (strcmp(stmt->sql, sql)) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s statement [%s] is already prepared as [%s]\n", qm->name, name, stmt->sql);
+			status = SWITCH_STATUS_FALSE;
+		}
+		goto end;
 	}
 
-	sqlptr = dup ? strdup(sql) : (char *)sql;
+	stmt = switch_core_alloc(qm->pool, sizeof(*stmt));
+	stmt->name = switch_core_strdup(qm->pool, name);
+	stmt->sql = switch_core_strdup(qm->pool, sql);
 
-	do {
-		switch_mutex_lock(qm->mutex);
-		status = switch_queue_trypush(qm->sql_queue[pos], sqlptr);
-		switch_mutex_unlock(qm->mutex);
-		if (status != SWITCH_STATUS_SUCCESS) {
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG1, "Delay %d sending sql\n", x);
-			if (x++) {
-				switch_yield(1000000 * x);
+	for (p = sql; *p; p++) {
+		if (*p == '\'') {
+			quoted = !quoted;
+		} else if (*p == '?' && !quoted) {
+			stmt->argc++;
+		}
+	}
+
+	stmt->segs = switch_core_alloc(qm->pool, sizeof(char *) * (stmt->argc + 1));
+	quoted = 0;
+
+	for (s = p = sql; ; p++) {
+		if (*p == '\'') {
+			quoted = !quoted;
+		} else if (!*p || (*p == '?' && !quoted)) {
+			stmt->segs[i++] = switch_core_sprintf(qm->pool, "%.*s", (int) (p - s), s);
+			stmt->seg_len += p - s;
+			if (!*p) {
+				break;
 			}
+			s = p + 1;
 		}
-	} while(status != SWITCH_STATUS_SUCCESS);
-	
-	qm_wake(qm);
+	}
+
+	stmt->next = qm->stmts;
+	qm->stmts = stmt;
+	switch_core_hash_insert(qm->stmt_hash, stmt->name, stmt);
+
+ end:
+
+	switch_mutex_unlock(qm->mutex);
+
+	return status;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_stmt(switch_sql_queue_manager_t *qm, const char *name, uint32_t pos, int argc, const char **argv)
+{
+	qm_stmt_t *stmt;
+	qm_job_t *job;
+	switch_size_t len = 0;
+	char *p;
+	int i;
+
+	if (sql_manager.paused || qm->thread_running != 1) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG1, "DROP [%s]\n", name);
+		qm_wake(qm);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_lock(qm->mutex);
+	stmt = switch_core_hash_find(qm->stmt_hash, name);
+	switch_mutex_unlock(qm->mutex);
+
+	if (!stmt || stmt->argc != argc) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s statement [%s] %s\n", qm->name, name,
+						  stmt ? "called with the wrong number of parameters" : "is not prepared");
+		return SWITCH_STATUS_FALSE;
+	}
+
+	for (i = 0; i < argc; i++) {
+		if (argv[i]) {
+			len += strlen(argv[i]) + 1;
+		}
+	}
+
+	/* the parameters travel in the same allocation as the job */
+	switch_zmalloc(job, sizeof(*job) + sizeof(char *) * argc + len);
+	job->stmt = stmt;
+	job->argv = (char **) (job + 1);
+	p = (char *) (job->argv + argc);
+
+	for (i = 0; i < argc; i++) {
+		if (argv[i]) {
+			len = strlen(argv[i]) + 1;
+			memcpy(p, argv[i], len);
+			job->argv[i] = p;
+			p += len;
+		}
+	}
+
+	qm_push_job(qm, job, pos);
 
 	return SWITCH_STATUS_SUCCESS;
 }
@@ -1812,7 +2123,7 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_push_confirm(switch_sql
 
 	switch_mutex_lock(qm->mutex);
 	qm->confirm++;
-	switch_queue_push(qm->sql_queue[pos], dup ? strdup(sql) : (char *)sql);
+	switch_queue_push(qm->sql_queue[pos], qm_sql_job(sql, dup));
 	written = qm->pre_written[pos];
 	size = switch_sql_queue_manager_size(qm, pos);
 	want = written + size;
@@ -1866,7 +2177,10 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_init_name(const char *n
 	qm->dsn = switch_core_strdup(qm->pool, dsn);
 	qm->name = switch_core_strdup(qm->pool, name);
 	qm->max_trans = max_trans;
+	qm->trans_size = max_trans ? max_trans : SWITCH_SQL_QUEUE_LEN;
+	qm->trans_target = SWITCH_SQL_QUEUE_TRANS_TARGET;
 
+	switch_core_hash_init(&qm->stmt_hash);
 	switch_mutex_init(&qm->cond_mutex, SWITCH_MUTEX_NESTED, qm->pool);
 	switch_mutex_init(&qm->cond2_mutex, SWITCH_MUTEX_NESTED, qm->pool);
 	switch_mutex_init(&qm->mutex, SWITCH_MUTEX_NESTED, qm->pool);
@@ -1899,10 +2213,11 @@ SWITCH_DECLARE(switch_status_t) switch_sql_queue_manager_init_name(const char *n
 
 }
 
-static uint32_t do_trans(switch_sql_queue_manager_t *qm)
+static uint32_t do_trans(switch_sql_queue_manager_t *qm, uint32_t limit)
 {
 	char *errmsg = NULL;
 	void *pop;
+	qm_job_t *job;
 	switch_status_t status;
 	uint32_t ttl = 0;
 	switch_mutex_t *io_mutex = qm->event_db->io_mutex;
@@ -1964,24 +2279,24 @@ static uint32_t do_trans(switch_sql_queue_manager_t *qm)
 	}
 
 
-	while(qm->max_trans == 0 || ttl <= qm->max_trans) {
+	while(ttl < limit) {
 		pop = NULL;
 
-		for (i = 0; (qm->max_trans == 0 || ttl <= qm->max_trans) && (i < qm->numq); i++) {
+		for (i = 0; i < qm->numq; i++) {
 			switch_mutex_lock(qm->mutex);
 			switch_queue_trypop(qm->sql_queue[i], &pop);
 			switch_mutex_unlock(qm->mutex);
 			if (pop) break;
 		}
 
-		if (pop) {
-			if ((status = switch_cache_db_execute_sql(qm->event_db, (char *) pop, NULL)) == SWITCH_STATUS_SUCCESS) {
+		if ((job = (qm_job_t *) pop)) {
+			if ((status = qm_exec_job(qm, qm->event_db, job)) == SWITCH_STATUS_SUCCESS) {
 				switch_mutex_lock(qm->mutex);
 				qm->pre_written[i]++;
 				switch_mutex_unlock(qm->mutex);
 				ttl++;
 			}
-			switch_safe_free(pop);
+			qm_free_job(&job);
 			if (status != SWITCH_STATUS_SUCCESS) break;
 		} else {
 			break;
@@ -2042,6 +2357,21 @@ static uint32_t do_trans(switch_sql_queue_manager_t *qm)
 	return ttl;
 }
 
+/* halve the group commit when a transaction runs past the target and double it again while full ones commit quickly */
+static void qm_tune(switch_sql_queue_manager_t *qm, uint32_t written, uint32_t limit, switch_time_t elapsed)
+{
+	uint32_t cap = qm->max_trans ? qm->max_trans : SWITCH_SQL_QUEUE_LEN;
+	uint32_t floor = cap < SWITCH_SQL_QUEUE_TRANS_MIN ? cap : SWITCH_SQL_QUEUE_TRANS_MIN;
+
+	qm->trans_time = elapsed;
+
+	if (elapsed > qm->trans_target) {
+		qm->trans_size = qm->trans_size / 2 < floor ? floor : qm->trans_size / 2;
+	} else if (written == limit && elapsed < qm->trans_target / 2 && qm->trans_size < cap) {
+		qm->trans_size = qm->trans_size > cap / 2 ? cap : qm->trans_size * 2;
+	}
+}
+
 static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread, void *obj)
 {
 
@@ -2083,8 +2413,9 @@ static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread,
 
 
 	while (qm->thread_running == 1) {
-		uint32_t i, lc;
+		uint32_t i, lc, limit;
 		uint32_t written = 0, iterations = 0;
+		switch_time_t start;
 
 		if (qm->paused) {
 			goto check;
@@ -2101,9 +2432,12 @@ static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread,
 			if (!qm_ttl(qm)) {
 				goto check;
 			}
-			written = do_trans(qm);			
+			limit = qm->trans_size;
+			start = switch_time_now();
+			written = do_trans(qm, limit);
+			qm_tune(qm, written, limit, switch_time_now() - start);
 			iterations += written;
-		} while(written == qm->max_trans);
+		} while(written == limit);
 		
 		if (switch_test_flag((&runtime), SCF_DEBUG_SQL)) {
 			char line[128] = "";
@@ -2117,7 +2451,7 @@ static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread,
 			}
 			
 			l = strlen(line);
-			switch_snprintf(line + l, sizeof(line) - l, "]--[%d]\n", iterations);
+			switch_snprintf(line + l, sizeof(line) - l, "]--[%d] trans %u %ldus\n", iterations, qm->trans_size, (long) qm->trans_time);
 			
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "%s", line);
 			
@@ -2146,6 +2480,7 @@ static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread,
 		do_flush(qm, i, qm->event_db);
 	}
 
+	qm_finalize_stmts(qm);
 	switch_cache_db_release_db_handle(&qm->event_db);
 
 	qm->thread_running = 0;
@@ -2154,91 +2489,16 @@ static void *SWITCH_THREAD_FUNC switch_user_sql_thread(switch_thread_t *thread,
 }
 
 
-static char *parse_presence_data_cols(switch_event_t *event)
-{
-	char *cols[128] = { 0 };
-	int col_count = 0;
-	char *data_copy;
-	switch_stream_handle_t stream = { 0 };
-	int i;
-	char *r;
-	char col_name[128] = "";
-	const char *data = switch_event_get_header(event, "presence-data-cols");
-
-	if (zstr(data)) {
-		return NULL;
-	}
-
-	data_copy = strdup(data);
-	
-	col_count = switch_split(data_copy, ':', cols);
-
-	SWITCH_STANDARD_STREAM(stream);
-
-	for (i = 0; i < col_count; i++) {
-		const char *val = NULL;
-
-		switch_snprintfv(col_name, sizeof(col_name), "PD-%q", cols[i]);
-		val = switch_event_get_header_nil(event, col_name);
-		if (zstr(val)) {
-			stream.write_function(&stream, "%q=NULL,", cols[i]);
-		} else {
-			stream.write_function(&stream, "%q='%q',", cols[i], val);
-		}
-	}
-
-	r = (char *) stream.data;
-
-	if (end_of(r) == ',') {
-		end_of(r) = '\0';
-	}
-
-	switch_safe_free(data_copy);
-	
-	return r;
-	
-}
-
-
 #define MAX_SQL 5
-#define new_sql()   switch_assert(sql_idx+1 < MAX_SQL); if (exists) sql[sql_idx++]
-#define new_sql_a() switch_assert(sql_idx+1 < MAX_SQL); sql[sql_idx++]
+#define new_sql()   switch_assert(sql_idx+1 < MAX_SQL); sql[sql_idx++]
 
 static void core_event_handler(switch_event_t *event)
 {
 	char *sql[MAX_SQL] = { 0 };
 	int sql_idx = 0;
-	char *extra_cols;
-	int exists = 1;
-	char *uuid = NULL;
 
 	switch_assert(event);
 
-	switch (event->event_id) {
-	case SWITCH_EVENT_CHANNEL_UUID:
-	case SWITCH_EVENT_CHANNEL_CREATE:
-	case SWITCH_EVENT_CHANNEL_ANSWER:
-	case SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA:
-	case SWITCH_EVENT_CHANNEL_HOLD:
-	case SWITCH_EVENT_CHANNEL_UNHOLD:
-	case SWITCH_EVENT_CHANNEL_EXECUTE:
-	case SWITCH_EVENT_CHANNEL_ORIGINATE:
-	case SWITCH_EVENT_CALL_UPDATE:
-	case SWITCH_EVENT_CHANNEL_CALLSTATE:
-	case SWITCH_EVENT_CHANNEL_STATE:
-	case SWITCH_EVENT_CHANNEL_BRIDGE:
-	case SWITCH_EVENT_CHANNEL_UNBRIDGE:
-	case SWITCH_EVENT_CALL_SECURE:
-		{
-			if ((uuid = switch_event_get_header(event, "unique-id"))) {
-				exists = switch_ivr_uuid_exists(uuid);
-			}
-		}
-		break;
-	default:
-		break;
-	}
-
 	switch (event->event_id) {
 	case SWITCH_EVENT_ADD_SCHEDULE:
 		{
@@ -2280,290 +2540,6 @@ static void core_event_handler(switch_event_t *event)
 			}
 		}
 		break;
-	case SWITCH_EVENT_CHANNEL_DESTROY:
-		{
-			const char *uuid = switch_event_get_header(event, "unique-id");
-			
-			if (uuid) {
-				new_sql() = switch_mprintf("delete from channels where uuid='%q'",
-										   uuid);
-
-				new_sql() = switch_mprintf("delete from calls where (caller_uuid='%q' or callee_uuid='%q')",
-										   uuid, uuid);
-
-			}
-		}
-		break;
-	case SWITCH_EVENT_CHANNEL_UUID:
-		{
-			new_sql() = switch_mprintf("update channels set uuid='%q' where uuid='%q'",
-									   switch_event_get_header_nil(event, "unique-id"),
-									   switch_event_get_header_nil(event, "old-unique-id")
-									   );
-
-			new_sql() = switch_mprintf("update channels set call_uuid='%q' where call_uuid='%q'",
-									   switch_event_get_header_nil(event, "unique-id"),
-									   switch_event_get_header_nil(event, "old-unique-id")
-									   );
-			break;
-		}
-	case SWITCH_EVENT_CHANNEL_CREATE:
-		new_sql() = switch_mprintf("insert into channels (uuid,direction,created,created_epoch, name,state,callstate,dialplan,context,hostname,initial_cid_name,initial_cid_num,initial_ip_addr,initial_dest,initial_dialplan,initial_context) "
-								   "values('%q','%q','%q','%ld','%q','%q','%q','%q','%q','%q','%q','%q','%q','%q','%q','%q')",
-								   switch_event_get_header_nil(event, "unique-id"),
-								   switch_event_get_header_nil(event, "call-direction"),
-								   switch_event_get_header_nil(event, "event-date-local"),
-								   (long) switch_epoch_time_now(NULL),
-								   switch_event_get_header_nil(event, "channel-name"),
-								   switch_event_get_header_nil(event, "channel-state"),
-								   switch_event_get_header_nil(event, "channel-call-state"),
-								   switch_event_get_header_nil(event, "caller-dialplan"),
-								   switch_event_get_header_nil(event, "caller-context"), switch_core_get_switchname(),
-								   switch_event_get_header_nil(event, "caller-caller-id-name"),
-								   switch_event_get_header_nil(event, "caller-caller-id-number"),
-								   switch_event_get_header_nil(event, "caller-network-addr"),
-								   switch_event_get_header_nil(event, "caller-destination-number"),
-								   switch_event_get_header_nil(event, "caller-dialplan"),
-								   switch_event_get_header_nil(event, "caller-context")
-								   );
-		break;
-	case SWITCH_EVENT_CHANNEL_ANSWER:
-	case SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA:
-	case SWITCH_EVENT_CODEC:
-		new_sql() =
-			switch_mprintf
-			("update channels set read_codec='%q',read_rate='%q',read_bit_rate='%q',write_codec='%q',write_rate='%q',write_bit_rate='%q' where uuid='%q'",
-			 switch_event_get_header_nil(event, "channel-read-codec-name"),
-			 switch_event_get_header_nil(event, "channel-read-codec-rate"),
-			 switch_event_get_header_nil(event, "channel-read-codec-bit-rate"),
-			 switch_event_get_header_nil(event, "channel-write-codec-name"),
-			 switch_event_get_header_nil(event, "channel-write-codec-rate"),
-			 switch_event_get_header_nil(event, "channel-write-codec-bit-rate"),
-			 switch_event_get_header_nil(event, "unique-id"));
-		break;
-	case SWITCH_EVENT_CHANNEL_HOLD:
-	case SWITCH_EVENT_CHANNEL_UNHOLD:
-	case SWITCH_EVENT_CHANNEL_EXECUTE: {
-		
-		new_sql() = switch_mprintf("update channels set application='%q',application_data='%q',"
-								   "presence_id='%q',presence_data='%q' where uuid='%q'",
-								   switch_event_get_header_nil(event, "application"),
-								   switch_event_get_header_nil(event, "application-data"),
-								   switch_event_get_header_nil(event, "channel-presence-id"),
-								   switch_event_get_header_nil(event, "channel-presence-data"),
-								   switch_event_get_header_nil(event, "unique-id")
-								   );
-
-	}
-		break;
-
-	case SWITCH_EVENT_CHANNEL_ORIGINATE:
-		{
-			if ((extra_cols = parse_presence_data_cols(event))) {
-				new_sql() = switch_mprintf("update channels set "
-										   "presence_id='%q',presence_data='%q', call_uuid='%q',%s where uuid='%q'",
-										   switch_event_get_header_nil(event, "channel-presence-id"),
-										   switch_event_get_header_nil(event, "channel-presence-data"),
-										   switch_event_get_header_nil(event, "channel-call-uuid"),
-										   extra_cols,
-										   switch_event_get_header_nil(event, "unique-id"));
-				free(extra_cols);
-			} else {
-				new_sql() = switch_mprintf("update channels set "
-										   "presence_id='%q',presence_data='%q', call_uuid='%q' where uuid='%q'",
-										   switch_event_get_header_nil(event, "channel-presence-id"),
-										   switch_event_get_header_nil(event, "channel-presence-data"),
-										   switch_event_get_header_nil(event, "channel-call-uuid"),
-										   switch_event_get_header_nil(event, "unique-id"));
-			}
-
-		}
-
-		break;
-	case SWITCH_EVENT_CALL_UPDATE:
-		{
-			new_sql() = switch_mprintf("update channels set callee_name='%q',callee_num='%q',sent_callee_name='%q',sent_callee_num='%q',callee_direction='%q',"
-									   "cid_name='%q',cid_num='%q' where uuid='%s'",
-									   switch_event_get_header_nil(event, "caller-callee-id-name"),
-									   switch_event_get_header_nil(event, "caller-callee-id-number"),
-									   switch_event_get_header_nil(event, "sent-callee-id-name"),
-									   switch_event_get_header_nil(event, "sent-callee-id-number"),
-									   switch_event_get_header_nil(event, "direction"),
-									   switch_event_get_header_nil(event, "caller-caller-id-name"),
-									   switch_event_get_header_nil(event, "caller-caller-id-number"),
-									   switch_event_get_header_nil(event, "unique-id")
-									   );
-		}
-		break;
-	case SWITCH_EVENT_CHANNEL_CALLSTATE:
-		{
-			char *num = switch_event_get_header_nil(event, "channel-call-state-number");
-			switch_channel_callstate_t callstate = CCS_DOWN;
-
-			if (num) {
-				callstate = atoi(num);
-			}
-
-			if (callstate != CCS_DOWN && callstate != CCS_HANGUP) {
-				if ((extra_cols = parse_presence_data_cols(event))) {
-					new_sql() = switch_mprintf("update channels set callstate='%q',%s where uuid='%q'",
-											   switch_event_get_header_nil(event, "channel-call-state"),
-											   extra_cols,
-											   switch_event_get_header_nil(event, "unique-id"));
-					free(extra_cols);
-				} else {
-					new_sql() = switch_mprintf("update channels set callstate='%q' where uuid='%q'",
-											   switch_event_get_header_nil(event, "channel-call-state"),
-											   switch_event_get_header_nil(event, "unique-id"));
-				}
-			}
-
-		}
-		break;
-	case SWITCH_EVENT_CHANNEL_STATE:
-		{
-			char *state = switch_event_get_header_nil(event, "channel-state-number");
-			switch_channel_state_t state_i = CS_DESTROY;
-
-			if (!zstr(state)) {
-				state_i = atoi(state);
-			}
-
-			switch (state_i) {
-			case CS_NEW:
-			case CS_DESTROY:
-			case CS_REPORTING:
-#ifndef SWITCH_DEPRECATED_CORE_DB
-			case CS_HANGUP: /* marked for deprication */
-#endif
-			case CS_INIT:
-				break;
-#ifdef SWITCH_DEPRECATED_CORE_DB
-			case CS_HANGUP: /* marked for deprication */
-				new_sql_a() = switch_mprintf("update channels set state='%s' where uuid='%s'",
-											 switch_event_get_header_nil(event, "channel-state"),
-											 switch_event_get_header_nil(event, "unique-id"));
-				break;
-#endif
-			case CS_EXECUTE:
-				if ((extra_cols = parse_presence_data_cols(event))) {
-					new_sql() = switch_mprintf("update channels set state='%s',%s where uuid='%q'",
-											   switch_event_get_header_nil(event, "channel-state"),
-											   extra_cols,
-											   switch_event_get_header_nil(event, "unique-id"));
-					free(extra_cols);
-					
-				} else {
-					new_sql() = switch_mprintf("update channels set state='%s' where uuid='%s'",
-											   switch_event_get_header_nil(event, "channel-state"),
-											   switch_event_get_header_nil(event, "unique-id"));
-				}
-				break;
-			case CS_ROUTING:
-				if ((extra_cols = parse_presence_data_cols(event))) {
-					new_sql() = switch_mprintf("update channels set state='%s',cid_name='%q',cid_num='%q',callee_name='%q',callee_num='%q',"
-											   "sent_callee_name='%q',sent_callee_num='%q',"
-											   "ip_addr='%s',dest='%q',dialplan='%q',context='%q',presence_id='%q',presence_data='%q',%s "
-											   "where uuid='%s'",
-											   switch_event_get_header_nil(event, "channel-state"),
-											   switch_event_get_header_nil(event, "caller-caller-id-name"),
-											   switch_event_get_header_nil(event, "caller-caller-id-number"),
-											   switch_event_get_header_nil(event, "caller-callee-id-name"),
-											   switch_event_get_header_nil(event, "caller-callee-id-number"),
-											   switch_event_get_header_nil(event, "sent-callee-id-name"),
-											   switch_event_get_header_nil(event, "sent-callee-id-number"),
-											   switch_event_get_header_nil(event, "caller-network-addr"),
-											   switch_event_get_header_nil(event, "caller-destination-number"),
-											   switch_event_get_header_nil(event, "caller-dialplan"),
-											   switch_event_get_header_nil(event, "caller-context"),
-											   switch_event_get_header_nil(event, "channel-presence-id"),
-											   switch_event_get_header_nil(event, "channel-presence-data"),
-											   extra_cols,
-											   switch_event_get_header_nil(event, "unique-id"));
-					free(extra_cols);
-				} else {
-					new_sql() = switch_mprintf("update channels set state='%s',cid_name='%q',cid_num='%q',callee_name='%q',callee_num='%q',"
-											   "sent_callee_name='%q',sent_callee_num='%q',"
-											   "ip_addr='%s',dest='%q',dialplan='%q',context='%q',presence_id='%q',presence_data='%q' "
-											   "where uuid='%s'",
-											   switch_event_get_header_nil(event, "channel-state"),
-											   switch_event_get_header_nil(event, "caller-caller-id-name"),
-											   switch_event_get_header_nil(event, "caller-caller-id-number"),
-											   switch_event_get_header_nil(event, "caller-callee-id-name"),
-											   switch_event_get_header_nil(event, "caller-callee-id-number"),
-											   switch_event_get_header_nil(event, "sent-callee-id-name"),
-											   switch_event_get_header_nil(event, "sent-callee-id-number"),
-											   switch_event_get_header_nil(event, "caller-network-addr"),
-											   switch_event_get_header_nil(event, "caller-destination-number"),
-											   switch_event_get_header_nil(event, "caller-dialplan"),
-											   switch_event_get_header_nil(event, "caller-context"),
-											   switch_event_get_header_nil(event, "channel-presence-id"),
-											   switch_event_get_header_nil(event, "channel-presence-data"),
-											   switch_event_get_header_nil(event, "unique-id"));
-				}
-				break;
-			default:
-				new_sql() = switch_mprintf("update channels set state='%s' where uuid='%s'",
-										   switch_event_get_header_nil(event, "channel-state"),
-										   switch_event_get_header_nil(event, "unique-id"));
-				break;
-			}
-
-			break;
-
-
-		}
-	case SWITCH_EVENT_CHANNEL_BRIDGE:
-		{
-			const char *a_uuid, *b_uuid, *uuid;
-
-			a_uuid = switch_event_get_header(event, "Bridge-A-Unique-ID");
-			b_uuid = switch_event_get_header(event, "Bridge-B-Unique-ID");
-			uuid = switch_event_get_header(event, "unique-id");
-
-			if (zstr(a_uuid) || zstr(b_uuid)) {
-				a_uuid = switch_event_get_header_nil(event, "caller-unique-id");
-				b_uuid = switch_event_get_header_nil(event, "other-leg-unique-id");
-			}
-
-			if (uuid && (extra_cols = parse_presence_data_cols(event))) {
-				new_sql() = switch_mprintf("update channels set %s where uuid='%s'", extra_cols, uuid);
-				switch_safe_free(extra_cols);
-			} 
-
-			new_sql() = switch_mprintf("update channels set call_uuid='%q' where uuid='%s' or uuid='%s'",
-									   switch_event_get_header_nil(event, "channel-call-uuid"), a_uuid, b_uuid);
-			
-
-			new_sql() = switch_mprintf("insert into calls (call_uuid,call_created,call_created_epoch,"
-									   "caller_uuid,callee_uuid,hostname) "
-									   "values ('%s','%s','%ld','%q','%q','%q')",
-									   switch_event_get_header_nil(event, "channel-call-uuid"),
-									   switch_event_get_header_nil(event, "event-date-local"),
-									   (long) switch_epoch_time_now(NULL),
-									   a_uuid,
-									   b_uuid,
-									   switch_core_get_switchname()
-									   );
-		}
-		break;
-	case SWITCH_EVENT_CHANNEL_UNBRIDGE:
-		{
-			char *cuuid = switch_event_get_header_nil(event, "caller-unique-id");
-			char *uuid = switch_event_get_header(event, "unique-id");
-
-			if (uuid && (extra_cols = parse_presence_data_cols(event))) {
-				new_sql() = switch_mprintf("update channels set %s where uuid='%s'", extra_cols, uuid);
-				switch_safe_free(extra_cols);
-			} 
-
-			new_sql() = switch_mprintf("update channels set call_uuid=uuid where call_uuid='%s'",
-									   switch_event_get_header_nil(event, "channel-call-uuid"));
-			
-			new_sql() = switch_mprintf("delete from calls where (caller_uuid='%q' or callee_uuid='%q')",
-									   cuuid, cuuid);
-			break;
-		}
 	case SWITCH_EVENT_SHUTDOWN:
 		new_sql() = switch_mprintf("delete from channels where hostname='%q';"
 								   "delete from interfaces where hostname='%q';"
@@ -2601,18 +2577,6 @@ static void core_event_handler(switch_event_t *event)
 			}
 			break;
 		}
-	case SWITCH_EVENT_CALL_SECURE:
-		{
-			const char *type = switch_event_get_header_nil(event, "secure_type");
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Secure Type: %s\n", type);
-			if (zstr(type)) {
-				break;
-			}
-			new_sql() = switch_mprintf("update channels set secure='%s' where uuid='%s'",
-									   type, switch_event_get_header_nil(event, "caller-unique-id")
-									   );
-			break;
-		}
 	case SWITCH_EVENT_NAT:
 		{
 			const char *op = switch_event_get_header_nil(event, "op");
@@ -3596,27 +3560,11 @@ switch_status_t switch_core_sqldb_start(switch_memory_pool_t *pool, switch_bool_
 		switch_event_bind("core_db", SWITCH_EVENT_DEL_SCHEDULE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 		switch_event_bind("core_db", SWITCH_EVENT_EXE_SCHEDULE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 		switch_event_bind("core_db", SWITCH_EVENT_RE_SCHEDULE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_DESTROY, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_UUID, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_CREATE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_ANSWER, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_PROGRESS_MEDIA, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_HOLD, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_UNHOLD, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_EXECUTE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_ORIGINATE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CALL_UPDATE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_CALLSTATE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_STATE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_BRIDGE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CHANNEL_UNBRIDGE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 		switch_event_bind("core_db", SWITCH_EVENT_SHUTDOWN, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 		switch_event_bind("core_db", SWITCH_EVENT_LOG, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 		switch_event_bind("core_db", SWITCH_EVENT_MODULE_LOAD, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 		switch_event_bind("core_db", SWITCH_EVENT_MODULE_UNLOAD, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CALL_SECURE, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 		switch_event_bind("core_db", SWITCH_EVENT_NAT, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
-		switch_event_bind("core_db", SWITCH_EVENT_CODEC, SWITCH_EVENT_SUBCLASS_ANY, core_event_handler, NULL);
 #endif	
 
 		switch_threadattr_create(&thd_attr, sql_manager.memory_pool);
@@ -42,6 +42,8 @@
 #define DISPATCH_QUEUE_LEN 10000
 //#define DEBUG_DISPATCH_QUEUES
 
+typedef struct event_subscriber_s event_subscriber_t;
+
 /*! \brief A node to store binded events */
 struct switch_event_node {
 	/*! the id of the node */
@@ -54,9 +56,106 @@ struct switch_event_node {
 	switch_event_callback_t callback;
 	/*! private data */
 	void *user_data;
+	/*! the queues the callback runs from, NULL to run it on the dispatch thread */
+	event_subscriber_t *sub;
+	/*! a queued binding, its callback never runs on the dispatch thread even once the queues are gone */
+	switch_bool_t queued;
+	/*! header rules checked before the callback or queue sees the event */
+	switch_event_filter_t *filter;
 	struct switch_event_node *next;
 };
 
+typedef struct event_filter_rule_s {
+	char *name;
+	unsigned long hash;
+	switch_event_filter_op_t op;
+	char *value;
+	switch_size_t len;
+	switch_regex_t *re;
+	switch_bool_t exclude;
+	struct event_filter_rule_s *next;
+} event_filter_rule_t;
+
+/*! \brief Header rules compiled once, matched against every event */
+struct switch_event_filter {
+	event_filter_rule_t *rules;
+	event_filter_rule_t *last;
+	switch_bool_t match_all;
+};
+
+/* A queued binding is split into shards, each a bounded ring with its own worker.  Any dispatch
+   thread may push and only the worker normally pops (a producer also pops to drop the oldest
+   event), so every cell carries a sequence number to hand it over between threads without a lock. */
+#if defined(__GNUC__)
+#define eq_load(_p) __atomic_load_n(_p, __ATOMIC_ACQUIRE)
+#define eq_store(_p, _v) __atomic_store_n(_p, _v, __ATOMIC_RELEASE)
+#define eq_cas(_p, _e, _v) __atomic_compare_exchange_n(_p, _e, _v, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define eq_add(_p, _v) __atomic_fetch_add(_p, _v, __ATOMIC_RELAXED)
+#define eq_dec(_p) __atomic_sub_fetch(_p, 1, __ATOMIC_ACQ_REL)
+#define eq_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define eq_load(_p) (*(volatile switch_size_t *)(_p))
+#define eq_store(_p, _v) (*(volatile switch_size_t *)(_p) = (_v))
+#define eq_add(_p, _v) InterlockedExchangeAdd64((volatile LONG64 *)(_p), (_v))
+#define eq_dec(_p) InterlockedDecrement64((volatile LONG64 *)(_p))
+#define eq_fence() MemoryBarrier()
+static int eq_cas(volatile switch_size_t *p, switch_size_t *expected, switch_size_t v)
+{
+	switch_size_t old = (switch_size_t) InterlockedCompareExchangePointer((PVOID volatile *) p, (PVOID) v, (PVOID) *expected);
+
+	if (old == *expected) {
+		return 1;
+	}
+
+	*expected = old;
+	return 0;
+}
+#endif
+
+#define EQ_PAD 64
+#define EQ_MAX_WORKERS 64
+
+typedef struct {
+	switch_size_t seq;
+	switch_event_t *event;
+} event_cell_t;
+
+typedef struct {
+	event_cell_t *cells;
+	switch_size_t mask;
+	char pad0[EQ_PAD];
+	switch_size_t head;
+	char pad1[EQ_PAD];
+	switch_size_t tail;
+	char pad2[EQ_PAD];
+	switch_size_t sleeping;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_thread_t *thread;
+	event_subscriber_t *sub;
+	uint64_t queued;
+	uint64_t delivered;
+	uint64_t dropped;
+	uint64_t high;
+} event_shard_t;
+
+struct event_subscriber_s {
+	char *id;
+	switch_event_types_t event_id;
+	switch_event_callback_t callback;
+	void *user_data;
+	switch_event_overflow_t overflow;
+	uint32_t queue_len;
+	uint32_t shard_count;
+	event_shard_t *shards;
+	switch_size_t running;
+	/* dispatch threads waiting for room outside the node lock, destroy waits for them */
+	switch_size_t waiters;
+	switch_memory_pool_t *pool;
+	struct event_subscriber_s *reap_next;
+	struct event_subscriber_s *next;
+};
+
 /*! \brief A registered custom event subclass  */
 struct switch_event_subclass {
 	/*! the owner of the subclass */
@@ -94,6 +193,7 @@ static switch_queue_t *EVENT_DISPATCH_QUEUE = NULL;
 static switch_queue_t *EVENT_CHANNEL_DISPATCH_QUEUE = NULL;
 static switch_mutex_t *EVENT_QUEUE_MUTEX = NULL;
 static switch_hash_t *CUSTOM_HASH = NULL;
+static event_subscriber_t *EVENT_SUBSCRIBERS = NULL;
 static int THREAD_COUNT = 0;
 static int DISPATCH_THREAD_COUNT = 0;
 static int EVENT_CHANNEL_DISPATCH_THREAD_COUNT = 0;
@@ -126,6 +226,620 @@ static char *my_dup(const char *s)
 #define FREE(ptr) switch_safe_free(ptr)
 #endif
 
+/* event structs are freed one by one at a high rate, they come from the slab allocator along with the arena chunks below
+   and any header struct or name that does not fit in its event's arena.  bodies and subclass names stay on the heap */
+#define SLAB_ALLOC(size) switch_slab_alloc(size)
+#define SLAB_DUP(str) switch_slab_strdup(str)
+#define SLAB_FREE(ptr) if (ptr) { switch_slab_free(ptr); ptr = NULL; }
+
+/* Every event keeps its headers in an arena of slab chunks, so building one costs a few allocations instead of three
+   per header, and the names of the headers the core puts on nearly every event are interned once and never copied.
+   Values and names that do not fit (or come from the caller with SWITCH_STACK_NODUP) live on their own as before,
+   anything a pointer is not inside the arena or the intern block is freed one by one.
+
+   A fired event is sealed and a dup of a sealed event shares its arena instead of copying the headers.  The arena is
+   frozen from then on: an event that wants to change frozen headers it is not the last user of first copies them into a
+   fresh arena, which keeps the old one pinned until the event is destroyed so pointers it already handed out stay valid. */
+#define EVENT_ARENA_CHUNK 1024
+#define EVENT_ARENA_CHUNK_MAX 4096
+#define EVENT_ARENA_MAX 16384
+#define EVENT_ARENA_BIG 512
+#define EVENT_ARENA_ALIGN(_l) (((_l) + 7) & ~((switch_size_t) 7))
+#define EVENT_CHUNK_HDR 16
+#define EVENT_INTERN_SLOTS 512
+
+typedef struct event_chunk_s {
+	struct event_chunk_s *next;
+	uint32_t size;
+	uint32_t used;
+} event_chunk_t;
+
+typedef struct event_retired_s {
+	struct switch_event_arena *arena;
+	struct event_retired_s *next;
+} event_retired_t;
+
+struct switch_event_arena {
+	/* events (and pins) using it, only ever more than one while frozen */
+	switch_size_t refs;
+	switch_size_t size;
+	event_chunk_t *chunks;
+	/* the shared header list once frozen */
+	switch_event_header_t *headers;
+	event_retired_t *retired;
+	int frozen;
+};
+
+typedef struct switch_event_arena switch_event_arena_t;
+typedef struct switch_event_index switch_event_index_t;
+
+static void event_index_build(switch_event_t *event);
+
+static struct {
+	const char *name;
+	unsigned long hash;
+} EVENT_INTERN[EVENT_INTERN_SLOTS];
+
+static char *EVENT_INTERN_BLOCK = NULL;
+static switch_size_t EVENT_INTERN_LEN = 0;
+
+static const char *EVENT_INTERN_NAMES[] = {
+	"Event-Name", "Core-UUID", "FreeSWITCH-Hostname", "FreeSWITCH-Switchname", "FreeSWITCH-IPv4", "FreeSWITCH-IPv6",
+	"Event-Date-Local", "Event-Date-GMT", "Event-Date-Timestamp", "Event-Calling-File", "Event-Calling-Function",
+	"Event-Calling-Line-Number", "Event-Sequence", "Event-Subclass",
+	"Channel-State", "Channel-Call-State", "Channel-State-Number", "Channel-Name", "Unique-ID", "Call-Direction",
+	"Presence-Call-Direction", "Channel-HIT-Dialplan", "Channel-Presence-ID", "Channel-Presence-Data",
+	"Channel-Call-UUID", "Answer-State", "Hangup-Cause", "Channel-Read-Codec-Name", "Channel-Read-Codec-Rate",
+	"Channel-Read-Codec-Bit-Rate", "Channel-Write-Codec-Name", "Channel-Write-Codec-Rate",
+	"Channel-Write-Codec-Bit-Rate", "Original-Channel-Call-State", "Other-Type", "Presence-Data-Cols",
+	"Presence-Privacy", "Bridged-To", "Device-ID", "Device-State", "Device-Call-State",
+	NULL
+};
+
+/* switch_caller_profile_event_set_data() adds these behind "Caller-" and "Other-Leg-" */
+static const char *EVENT_INTERN_PROFILE[] = {
+	"Direction", "Logical-Direction", "Username", "Dialplan", "Caller-ID-Name", "Caller-ID-Number",
+	"Orig-Caller-ID-Name", "Orig-Caller-ID-Number", "Callee-ID-Name", "Callee-ID-Number", "Network-Addr", "ANI",
+	"ANI-II", "Destination-Number", "Unique-ID", "Source", "Transfer-Source", "Context", "RDNIS", "Channel-Name",
+	"Profile-Index", "Profile-Created-Time", "Channel-Created-Time", "Channel-Answered-Time",
+	"Channel-Progress-Time", "Channel-Progress-Media-Time", "Channel-Hangup-Time", "Channel-Transfer-Time",
+	"Channel-Resurrect-Time", "Channel-Bridged-Time", "Channel-Last-Hold", "Channel-Hold-Accum", "Screen-Bit",
+	"Privacy-Hide-Name", "Privacy-Hide-Number",
+	NULL
+};
+
+static void event_intern_add(char **pos, const char *prefix, const char *name)
+{
+	switch_ssize_t hlen = -1;
+	unsigned long hash;
+	uint32_t i;
+	switch_size_t plen = strlen(prefix), nlen = strlen(name);
+	char *str = *pos;
+
+	memcpy(str, prefix, plen);
+	memcpy(str + plen, name, nlen + 1);
+	*pos += plen + nlen + 1;
+	hash = switch_ci_hashfunc_default(str, &hlen);
+
+	for (i = hash & (EVENT_INTERN_SLOTS - 1); EVENT_INTERN[i].name; i = (i + 1) & (EVENT_INTERN_SLOTS - 1));
+
+	EVENT_INTERN[i].name = str;
+	EVENT_INTERN[i].hash = hash;
+}
+
+/* built once, the block lives as long as the process since header names keep pointing into it */
+static void event_intern_init(void)
+{
+	switch_size_t len = 0;
+	char *pos;
+	int x;
+
+	if (EVENT_INTERN_BLOCK) {
+		return;
+	}
+
+	for (x = 0; EVENT_INTERN_NAMES[x]; x++) {
+		len += strlen(EVENT_INTERN_NAMES[x]) + 1;
+	}
+	for (x = 0; EVENT_INTERN_PROFILE[x]; x++) {
+		len += (strlen(EVENT_INTERN_PROFILE[x]) + 11) * 2;
+	}
+
+	pos = ALLOC(len);
+	switch_assert(pos);
+
+	EVENT_INTERN_BLOCK = pos;
+	EVENT_INTERN_LEN = len;
+
+	for (x = 0; EVENT_INTERN_NAMES[x]; x++) {
+		event_intern_add(&pos, "", EVENT_INTERN_NAMES[x]);
+	}
+	for (x = 0; EVENT_INTERN_PROFILE[x]; x++) {
+		event_intern_add(&pos, "Caller-", EVENT_INTERN_PROFILE[x]);
+		event_intern_add(&pos, "Other-Leg-", EVENT_INTERN_PROFILE[x]);
+	}
+}
+
+static const char *event_intern_find(const char *name, unsigned long hash)
+{
+	uint32_t i;
+
+	if (!EVENT_INTERN_BLOCK) {
+		return NULL;
+	}
+
+	for (i = hash & (EVENT_INTERN_SLOTS - 1); EVENT_INTERN[i].name; i = (i + 1) & (EVENT_INTERN_SLOTS - 1)) {
+		if (EVENT_INTERN[i].hash == hash && !strcmp(EVENT_INTERN[i].name, name)) {
+			return EVENT_INTERN[i].name;
+		}
+	}
+
+	return NULL;
+}
+
+static inline int event_interned(const char *name)
+{
+	return EVENT_INTERN_BLOCK && name >= EVENT_INTERN_BLOCK && name < EVENT_INTERN_BLOCK + EVENT_INTERN_LEN;
+}
+
+static switch_event_arena_t *event_arena_create(void)
+{
+	event_chunk_t *chunk = SLAB_ALLOC(EVENT_ARENA_CHUNK);
+	switch_event_arena_t *arena;
+
+	switch_assert(chunk);
+
+	chunk->next = NULL;
+	chunk->size = EVENT_ARENA_CHUNK;
+	chunk->used = (uint32_t) (EVENT_CHUNK_HDR + EVENT_ARENA_ALIGN(sizeof(*arena)));
+
+	arena = (switch_event_arena_t *) ((uint8_t *) chunk + EVENT_CHUNK_HDR);
+	memset(arena, 0, sizeof(*arena));
+	arena->refs = 1;
+	arena->size = EVENT_ARENA_CHUNK;
+	arena->chunks = chunk;
+
+	return arena;
+}
+
+/* NULL when the caller should allocate the memory on its own */
+static void *event_arena_alloc(switch_event_t *event, switch_size_t len)
+{
+	switch_event_arena_t *arena;
+	event_chunk_t *chunk;
+	void *ptr;
+
+	if (!event->arena) {
+		event->arena = event_arena_create();
+	}
+
+	arena = event->arena;
+	chunk = arena->chunks;
+	len = EVENT_ARENA_ALIGN(len);
+
+	if (chunk->used + len > chunk->size) {
+		uint32_t size = chunk->size * 2;
+
+		if (len > EVENT_ARENA_BIG || arena->size >= EVENT_ARENA_MAX) {
+			return NULL;
+		}
+
+		if (size > EVENT_ARENA_CHUNK_MAX) {
+			size = EVENT_ARENA_CHUNK_MAX;
+		}
+
+		chunk = SLAB_ALLOC(size);
+		switch_assert(chunk);
+		chunk->next = arena->chunks;
+		chunk->size = size;
+		chunk->used = EVENT_CHUNK_HDR;
+		arena->chunks = chunk;
+		arena->size += size;
+	}
+
+	ptr = (uint8_t *) chunk + chunk->used;
+	chunk->used += (uint32_t) len;
+
+	return ptr;
+}
+
+static int event_arena_owns(switch_event_arena_t *arena, const void *ptr)
+{
+	event_chunk_t *chunk;
+
+	if (!arena || !ptr) {
+		return 0;
+	}
+
+	for (chunk = arena->chunks; chunk; chunk = chunk->next) {
+		if ((const uint8_t *) ptr >= (uint8_t *) chunk && (const uint8_t *) ptr < (uint8_t *) chunk + chunk->size) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static char *event_value_dup(switch_event_t *event, const char *str)
+{
+	switch_size_t len = strlen(str) + 1;
+	char *new;
+
+	if (!(new = event_arena_alloc(event, len))) {
+		return DUP(str);
+	}
+
+	return (char *) memcpy(new, str, len);
+}
+
+static void event_value_free(switch_event_arena_t *arena, char *str)
+{
+	if (str && !event_arena_owns(arena, str)) {
+		free(str);
+	}
+}
+
+static char *event_name_dup(switch_event_t *event, const char *name, unsigned long hash)
+{
+	switch_size_t len;
+	const char *interned;
+	char *new;
+
+	if ((interned = event_intern_find(name, hash))) {
+		return (char *) interned;
+	}
+
+	len = strlen(name) + 1;
+
+	if (!(new = event_arena_alloc(event, len))) {
+		return SLAB_DUP(name);
+	}
+
+	return (char *) memcpy(new, name, len);
+}
+
+static void event_name_free(switch_event_arena_t *arena, char *name)
+{
+	if (name && !event_interned(name) && !event_arena_owns(arena, name)) {
+		switch_slab_free(name);
+	}
+}
+
+static switch_event_header_t *event_header_alloc(switch_event_t *event)
+{
+	switch_event_header_t *header;
+
+	if (!(header = event_arena_alloc(event, sizeof(*header)))) {
+#ifdef SWITCH_EVENT_RECYCLE
+		void *pop;
+		if (EVENT_HEADER_RECYCLE_QUEUE && switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS) {
+			header = (switch_event_header_t *) pop;
+		} else {
+#endif
+			header = SLAB_ALLOC(sizeof(*header));
+			switch_assert(header);
+#ifdef SWITCH_EVENT_RECYCLE
+		}
+#endif
+	}
+
+	memset(header, 0, sizeof(*header));
+
+	return header;
+}
+
+/* frees everything the header owns and the header itself unless the arena holds it */
+static void event_header_free(switch_event_arena_t *arena, switch_event_header_t *hp)
+{
+	if (hp->idx) {
+		if (!hp->array) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "INDEX WITH NO ARRAY WTF?? [%s][%s]\n", hp->name, hp->value);
+		} else {
+			int i = 0;
+
+			for (i = 0; i < hp->idx; i++) {
+				event_value_free(arena, hp->array[i]);
+			}
+			FREE(hp->array);
+		}
+	}
+
+	event_name_free(arena, hp->name);
+	event_value_free(arena, hp->value);
+
+	if (event_arena_owns(arena, hp)) {
+		return;
+	}
+
+	memset(hp, 0, sizeof(*hp));
+#ifdef SWITCH_EVENT_RECYCLE
+	if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, hp) != SWITCH_STATUS_SUCCESS) {
+		SLAB_FREE(hp);
+	}
+#else
+	SLAB_FREE(hp);
+#endif
+}
+
+static void event_arena_release(switch_event_arena_t *arena, switch_event_header_t *headers)
+{
+	switch_event_header_t *hp, *this;
+	event_retired_t *rp;
+	event_chunk_t *chunk, *next;
+
+	if (arena->frozen && eq_dec(&arena->refs) > 0) {
+		return;
+	}
+
+	for (hp = arena->frozen ? arena->headers : headers; hp;) {
+		this = hp;
+		hp = hp->next;
+		event_header_free(arena, this);
+	}
+
+	for (rp = arena->retired; rp; rp = rp->next) {
+		event_arena_release(rp->arena, NULL);
+	}
+
+	/* the arena struct itself lives in the oldest chunk */
+	for (chunk = arena->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		switch_slab_free(chunk);
+	}
+}
+
+static void event_copy_header(switch_event_t *event, switch_event_header_t *hp)
+{
+	switch_event_header_t *header = event_header_alloc(event);
+
+	header->name = event_interned(hp->name) ? hp->name : event_name_dup(event, hp->name, hp->hash);
+	header->hash = hp->hash;
+
+	if (hp->idx) {
+		int i;
+
+		header->array = ALLOC(sizeof(char *) * hp->idx);
+		switch_assert(header->array);
+
+		for (i = 0; i < hp->idx; i++) {
+			header->array[i] = event_value_dup(event, hp->array[i]);
+		}
+		header->idx = hp->idx;
+	}
+
+	if (hp->value) {
+		header->value = event_value_dup(event, hp->value);
+	}
+
+	header->prev = event->last_header;
+
+	if (event->last_header) {
+		event->last_header->next = header;
+	} else {
+		event->headers = header;
+	}
+	event->last_header = header;
+}
+
+/* called before anything changes the header list, a frozen arena is handed back or copied */
+static void event_headers_private(switch_event_t *event)
+{
+	switch_event_arena_t *old = event->arena;
+	switch_event_header_t *hp;
+	event_retired_t *pin;
+
+	if (!old || !old->frozen) {
+		return;
+	}
+
+	if (eq_load(&old->refs) == 1) {
+		old->frozen = 0;
+		old->headers = NULL;
+		return;
+	}
+
+	hp = event->headers;
+	event->arena = event_arena_create();
+	event->headers = event->last_header = NULL;
+
+	pin = event_arena_alloc(event, sizeof(*pin));
+	pin->arena = old;
+	pin->next = NULL;
+	event->arena->retired = pin;
+
+	for (; hp; hp = hp->next) {
+		event_copy_header(event, hp);
+	}
+
+	if (event->index) {
+		event_index_build(event);
+	}
+}
+
+static void event_share_headers(switch_event_t *event, switch_event_t *todup)
+{
+	switch_event_arena_t *arena = todup->arena;
+
+	if (!arena->frozen) {
+		arena->headers = todup->headers;
+		arena->frozen = 1;
+	}
+
+	eq_add(&arena->refs, 1);
+
+	event->arena = arena;
+	event->headers = todup->headers;
+	event->last_header = todup->last_header;
+}
+
+/* An indexed event maps each header name to the first header carrying it in an open addressed table keyed on the
+   name hash the headers already carry.  The list stays the only record of order, the table is rebuilt whenever the
+   header structs move (a private copy of shared headers, a rename). */
+#define EVENT_INDEX_MIN 64
+
+struct switch_event_index {
+	switch_event_header_t **slots;
+	uint32_t size;
+	/* live entries */
+	uint32_t used;
+	/* live entries and tombstones, what the probe length depends on */
+	uint32_t filled;
+	/* some name is on the list more than once, only the first one is in the table */
+	int dups;
+};
+
+static switch_event_header_t EVENT_INDEX_TOMB;
+
+static switch_event_header_t **event_index_slot(switch_event_index_t *index, const char *name, unsigned long hash)
+{
+	uint32_t mask = index->size - 1, i = (uint32_t) hash & mask;
+	switch_event_header_t *hp;
+
+	while ((hp = index->slots[i])) {
+		if (hp != &EVENT_INDEX_TOMB && hp->hash == hash && !strcasecmp(hp->name, name)) {
+			return &index->slots[i];
+		}
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static void event_index_resize(switch_event_index_t *index, uint32_t size)
+{
+	switch_event_header_t **old = index->slots, *hp;
+	uint32_t old_size = index->size, i, j;
+
+	index->slots = calloc(size, sizeof(*index->slots));
+	switch_assert(index->slots);
+	index->size = size;
+	index->filled = index->used;
+
+	for (i = 0; i < old_size; i++) {
+		if ((hp = old[i]) && hp != &EVENT_INDEX_TOMB) {
+			for (j = (uint32_t) hp->hash & (size - 1); index->slots[j]; j = (j + 1) & (size - 1));
+			index->slots[j] = hp;
+		}
+	}
+
+	free(old);
+}
+
+/* top says the header went in ahead of any other of the same name, otherwise an existing entry stays first */
+static void event_index_add(switch_event_index_t *index, switch_event_header_t *header, int top)
+{
+	switch_event_header_t **slot, **tomb = NULL, *hp;
+	uint32_t mask, i;
+
+	if ((slot = event_index_slot(index, header->name, header->hash))) {
+		if (*slot != header) {
+			index->dups = 1;
+		}
+		if (top) {
+			*slot = header;
+		}
+		return;
+	}
+
+	if ((index->filled + 1) * 2 > index->size) {
+		uint32_t size = index->size;
+
+		while ((index->used + 1) * 4 > size) {
+			size <<= 1;
+		}
+		event_index_resize(index, size);
+	}
+
+	mask = index->size - 1;
+
+	for (i = (uint32_t) header->hash & mask; (hp = index->slots[i]); i = (i + 1) & mask) {
+		if (hp == &EVENT_INDEX_TOMB && !tomb) {
+			tomb = &index->slots[i];
+		}
+	}
+
+	if (tomb) {
+		*tomb = header;
+	} else {
+		index->slots[i] = header;
+		index->filled++;
+	}
+	index->used++;
+}
+
+static void event_index_clear(switch_event_index_t *index, switch_event_header_t **slot)
+{
+	uint32_t next = (uint32_t) (slot - index->slots + 1) & (index->size - 1);
+
+	/* nothing probes past an empty slot, a slot right before one needs no tombstone */
+	if (index->slots[next]) {
+		*slot = &EVENT_INDEX_TOMB;
+	} else {
+		*slot = NULL;
+		index->filled--;
+	}
+	index->used--;
+}
+
+static void event_index_del(switch_event_index_t *index, switch_event_header_t *header)
+{
+	switch_event_header_t **slot;
+
+	if ((slot = event_index_slot(index, header->name, header->hash)) && *slot == header) {
+		event_index_clear(index, slot);
+	}
+}
+
+static void event_index_build(switch_event_t *event)
+{
+	switch_event_index_t *index = event->index;
+	switch_event_header_t *hp;
+	uint32_t size = EVENT_INDEX_MIN, count = 0;
+
+	for (hp = event->headers; hp; hp = hp->next) {
+		count++;
+	}
+
+	while (count * 4 > size) {
+		size <<= 1;
+	}
+
+	if (index->size != size) {
+		free(index->slots);
+		index->slots = calloc(size, sizeof(*index->slots));
+		switch_assert(index->slots);
+		index->size = size;
+	} else {
+		memset(index->slots, 0, size * sizeof(*index->slots));
+	}
+
+	index->used = index->filled = 0;
+	index->dups = 0;
+
+	for (hp = event->headers; hp; hp = hp->next) {
+		event_index_add(index, hp, 0);
+	}
+}
+
+static void event_index_destroy(switch_event_t *event)
+{
+	if (event->index) {
+		free(event->index->slots);
+		free(event->index);
+		event->index = NULL;
+	}
+}
+
+SWITCH_DECLARE(void) switch_event_index_headers(switch_event_t *event)
+{
+	switch_assert(event);
+
+	if (!event->index) {
+		switch_zmalloc(event->index, sizeof(*event->index));
+		event_index_build(event);
+	}
+}
+
 /* make sure this is synced with the switch_event_types_t enum in switch_types.h
    also never put any new ones before EVENT_ALL
 */
@@ -229,38 +943,213 @@ static int switch_events_match(switch_event_t *event, switch_event_node_t *node)
 	if (node->event_id == SWITCH_EVENT_ALL) {
 		match++;
 
-		if (!node->subclass_name) {
-			return match;
+		if (!node->subclass_name) {
+			return match;
+		}
+	}
+
+	if (match || event->event_id == node->event_id) {
+
+		if (event->subclass_name && node->subclass_name) {
+			if (!strncasecmp(node->subclass_name, "file:", 5)) {
+				char *file_header;
+				if ((file_header = switch_event_get_header(event, "file")) != 0) {
+					match = !strcmp(node->subclass_name + 5, file_header) ? 1 : 0;
+				}
+			} else if (!strncasecmp(node->subclass_name, "func:", 5)) {
+				char *func_header;
+				if ((func_header = switch_event_get_header(event, "function")) != 0) {
+					match = !strcmp(node->subclass_name + 5, func_header) ? 1 : 0;
+				}
+			} else if (event->subclass_name && node->subclass_name) {
+				match = !strcmp(event->subclass_name, node->subclass_name) ? 1 : 0;
+			}
+		} else if ((event->subclass_name && !node->subclass_name) || (!event->subclass_name && !node->subclass_name)) {
+			match = 1;
+		} else {
+			match = 0;
+		}
+	}
+
+	return match;
+}
+
+
+SWITCH_DECLARE(switch_status_t) switch_event_filter_create(switch_event_filter_t **filter)
+{
+	switch_zmalloc(*filter, sizeof(**filter));
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_event_filter_destroy(switch_event_filter_t **filter)
+{
+	event_filter_rule_t *rule, *next;
+
+	if (!filter || !*filter) {
+		return;
+	}
+
+	for (rule = (*filter)->rules; rule; rule = next) {
+		next = rule->next;
+		switch_regex_safe_free(rule->re);
+		FREE(rule->name);
+		FREE(rule->value);
+		FREE(rule);
+	}
+
+	FREE(*filter);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_filter_add(switch_event_filter_t *filter, const char *header_name, switch_event_filter_op_t op,
+														const char *value, switch_bool_t exclude)
+{
+	event_filter_rule_t *rule;
+	switch_ssize_t hlen = -1;
+	switch_regex_t *re = NULL;
+
+	if (!filter || zstr(header_name) || !value) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (op == SWITCH_EVENT_FILTER_REGEX) {
+		/* keep the rule without its regex, it never matches, the same as the filters did before they were compiled */
+		re = switch_regex_compile_expression(value);
+	}
+
+	switch_zmalloc(rule, sizeof(*rule));
+	rule->name = DUP(header_name);
+	rule->hash = switch_ci_hashfunc_default(rule->name, &hlen);
+	rule->op = op;
+	rule->value = DUP(value);
+	rule->len = strlen(value);
+	rule->re = re;
+	rule->exclude = exclude;
+
+	if (filter->last) {
+		filter->last->next = rule;
+	} else {
+		filter->rules = rule;
+	}
+	filter->last = rule;
+
+	return (op == SWITCH_EVENT_FILTER_REGEX && !re) ? SWITCH_STATUS_FALSE : SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_filter_add_string(switch_event_filter_t *filter, const char *header_name, const char *value)
+{
+	const char *comp_to = value;
+	switch_bool_t exclude = SWITCH_FALSE;
+
+	while (comp_to && *comp_to) {
+		if (*comp_to == '+') {
+			exclude = SWITCH_FALSE;
+		} else if (*comp_to == '-') {
+			exclude = SWITCH_TRUE;
+		} else if (*comp_to != ' ') {
+			break;
+		}
+		comp_to++;
+	}
+
+	if (!comp_to) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	return switch_event_filter_add(filter, header_name, *value == '/' ? SWITCH_EVENT_FILTER_REGEX : SWITCH_EVENT_FILTER_EQUAL, comp_to, exclude);
+}
+
+SWITCH_DECLARE(void) switch_event_filter_set_match_all(switch_event_filter_t *filter, switch_bool_t match_all)
+{
+	filter->match_all = match_all;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_filter_create_from_event(switch_event_filter_t **filter, switch_event_t *filters, switch_bool_t match_all)
+{
+	switch_event_header_t *hp;
+
+	*filter = NULL;
+
+	if (!filters || !filters->headers) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_event_filter_create(filter);
+	(*filter)->match_all = match_all;
+
+	for (hp = filters->headers; hp; hp = hp->next) {
+		if (switch_event_filter_add_string(*filter, hp->name, hp->value) != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Filter %s [%s] does not compile and never matches\n", hp->name, hp->value);
+		}
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_bool_t) switch_event_filter_match(switch_event_filter_t *filter, switch_event_t *event)
+{
+	event_filter_rule_t *rule;
+	switch_event_header_t *hp;
+	switch_bool_t pass = SWITCH_FALSE;
+	int ovector[30];
+
+	if (!filter || !filter->rules) {
+		return SWITCH_TRUE;
+	}
+
+	for (rule = filter->rules; rule; rule = rule->next) {
+		int cmp = 0;
+
+		if (pass && !rule->exclude && !filter->match_all) {
+			continue;
+		}
+
+		/* the rule hash is computed the same way as the header hash so most headers are skipped on an integer compare */
+		for (hp = event->headers; hp; hp = hp->next) {
+			if ((!hp->hash || rule->hash == hp->hash) && !strcasecmp(hp->name, rule->name)) {
+				break;
+			}
+		}
+
+		if (!hp || !hp->value) {
+			continue;
+		}
+
+		if (filter->match_all && !rule->len && rule->op != SWITCH_EVENT_FILTER_REGEX) {
+			/* a bare + or - only asks whether the header is there */
+			if (rule->exclude) {
+				return SWITCH_FALSE;
+			}
+			continue;
 		}
-	}
 
-	if (match || event->event_id == node->event_id) {
+		switch (rule->op) {
+		case SWITCH_EVENT_FILTER_REGEX:
+			cmp = rule->re && switch_regex_exec(rule->re, hp->value, ovector, sizeof(ovector) / sizeof(ovector[0])) > 0;
+			break;
+		case SWITCH_EVENT_FILTER_PREFIX:
+			cmp = !strncasecmp(hp->value, rule->value, rule->len);
+			break;
+		default:
+			cmp = !strcasecmp(hp->value, rule->value);
+			break;
+		}
 
-		if (event->subclass_name && node->subclass_name) {
-			if (!strncasecmp(node->subclass_name, "file:", 5)) {
-				char *file_header;
-				if ((file_header = switch_event_get_header(event, "file")) != 0) {
-					match = !strcmp(node->subclass_name + 5, file_header) ? 1 : 0;
-				}
-			} else if (!strncasecmp(node->subclass_name, "func:", 5)) {
-				char *func_header;
-				if ((func_header = switch_event_get_header(event, "function")) != 0) {
-					match = !strcmp(node->subclass_name + 5, func_header) ? 1 : 0;
-				}
-			} else if (event->subclass_name && node->subclass_name) {
-				match = !strcmp(event->subclass_name, node->subclass_name) ? 1 : 0;
+		if (filter->match_all) {
+			if (cmp == rule->exclude) {
+				return SWITCH_FALSE;
 			}
-		} else if ((event->subclass_name && !node->subclass_name) || (!event->subclass_name && !node->subclass_name)) {
-			match = 1;
-		} else {
-			match = 0;
+		} else if (cmp) {
+			if (rule->exclude) {
+				return SWITCH_FALSE;
+			}
+			pass = SWITCH_TRUE;
 		}
 	}
 
-	return match;
+	return filter->match_all ? SWITCH_TRUE : pass;
 }
 
-
 static void *SWITCH_THREAD_FUNC switch_event_deliver_thread(switch_thread_t *thread, void *obj)
 {
 	switch_event_t *event = (switch_event_t *) obj;
@@ -389,16 +1278,400 @@ static switch_status_t switch_event_queue_dispatch_event(switch_event_t **eventp
 	return SWITCH_STATUS_SUCCESS;
 }
 
+static int event_shard_push(event_shard_t *shard, switch_event_t *event)
+{
+	switch_size_t pos = eq_load(&shard->head), seq;
+	event_cell_t *cell;
+	intptr_t dif;
+
+	for (;;) {
+		cell = &shard->cells[pos & shard->mask];
+		seq = eq_load(&cell->seq);
+		dif = (intptr_t) seq - (intptr_t) pos;
+
+		if (dif == 0) {
+			if (eq_cas(&shard->head, &pos, pos + 1)) {
+				break;
+			}
+		} else if (dif < 0) {
+			return 0;
+		} else {
+			pos = eq_load(&shard->head);
+		}
+	}
+
+	cell->event = event;
+	eq_store(&cell->seq, pos + 1);
+
+	return 1;
+}
+
+static switch_event_t *event_shard_pop(event_shard_t *shard)
+{
+	switch_size_t pos = eq_load(&shard->tail), seq;
+	switch_event_t *event;
+	event_cell_t *cell;
+	intptr_t dif;
+
+	for (;;) {
+		cell = &shard->cells[pos & shard->mask];
+		seq = eq_load(&cell->seq);
+		dif = (intptr_t) seq - (intptr_t) (pos + 1);
+
+		if (dif == 0) {
+			if (eq_cas(&shard->tail, &pos, pos + 1)) {
+				break;
+			}
+		} else if (dif < 0) {
+			return NULL;
+		} else {
+			pos = eq_load(&shard->tail);
+		}
+	}
+
+	event = cell->event;
+	eq_store(&cell->seq, pos + shard->mask + 1);
+
+	return event;
+}
+
+static switch_size_t event_shard_depth(event_shard_t *shard)
+{
+	switch_size_t head = eq_load(&shard->head), tail = eq_load(&shard->tail);
+
+	return head > tail ? head - tail : 0;
+}
+
+static void *SWITCH_THREAD_FUNC event_shard_thread(switch_thread_t *thread, void *obj)
+{
+	event_shard_t *shard = (event_shard_t *) obj;
+	event_subscriber_t *sub = shard->sub;
+	switch_event_t *event;
+
+	for (;;) {
+		if ((event = event_shard_pop(shard))) {
+			if (SYSTEM_RUNNING) {
+				event->bind_user_data = sub->user_data;
+				sub->callback(event);
+			}
+			switch_event_destroy(&event);
+			eq_add(&shard->delivered, 1);
+			continue;
+		}
+
+		/* only leave once the queue is drained so an unbind does not lose what was accepted */
+		if (!eq_load(&sub->running)) {
+			break;
+		}
+
+		switch_mutex_lock(shard->mutex);
+		eq_store(&shard->sleeping, 1);
+		eq_fence();
+		if (!event_shard_depth(shard) && eq_load(&sub->running)) {
+			switch_thread_cond_timedwait(shard->cond, shard->mutex, 100000);
+		}
+		eq_store(&shard->sleeping, 0);
+		switch_mutex_unlock(shard->mutex);
+	}
+
+	return NULL;
+}
+
+static void event_shard_wake(event_shard_t *shard)
+{
+	eq_fence();
+
+	if (eq_load(&shard->sleeping)) {
+		switch_mutex_lock(shard->mutex);
+		switch_thread_cond_signal(shard->cond);
+		switch_mutex_unlock(shard->mutex);
+	}
+}
+
+/* waiting entries switch_event_deliver() keeps on its stack, more are allocated so a blocking binding never loses one */
+#define EQ_MAX_WAITING 16
+
+/* an event a SWITCH_EVENT_OVERFLOW_BLOCK binding had no room for, pushed again once the node lock is released */
+typedef struct event_waiting_s {
+	event_subscriber_t *sub;
+	event_shard_t *shard;
+	switch_event_t *clone;
+} event_waiting_t;
+
+static void event_shard_queued(event_shard_t *shard)
+{
+	switch_size_t depth;
+
+	eq_add(&shard->queued, 1);
+
+	if ((depth = event_shard_depth(shard)) > shard->high) {
+		/* racy by design, it is a statistic */
+		shard->high = depth;
+	}
+
+	event_shard_wake(shard);
+}
+
+/*
+  called from switch_event_deliver() with the read lock held, the subscriber gets its own copy.
+  A worker may bind or unbind and so needs the write lock, blocking here would deadlock with it,
+  a full SWITCH_EVENT_OVERFLOW_BLOCK queue hands the copy back in waiting and returns SWITCH_TRUE instead.
+*/
+static switch_bool_t event_subscriber_push(event_subscriber_t *sub, switch_event_t *event, event_waiting_t *waiting)
+{
+	event_shard_t *shard = &sub->shards[0];
+	switch_event_t *clone = NULL, *old;
+	switch_ssize_t hlen = -1;
+	const char *uuid;
+
+	if (sub->shard_count > 1 && (uuid = switch_event_get_header(event, "unique-id"))) {
+		shard = &sub->shards[switch_ci_hashfunc_default(uuid, &hlen) % sub->shard_count];
+	}
+
+	if (switch_event_dup(&clone, event) != SWITCH_STATUS_SUCCESS) {
+		eq_add(&shard->dropped, 1);
+		return SWITCH_FALSE;
+	}
+
+	switch_set_flag(clone, EF_SEALED);
+
+	while (!event_shard_push(shard, clone)) {
+		if (sub->overflow == SWITCH_EVENT_OVERFLOW_DROP_OLD) {
+			if ((old = event_shard_pop(shard))) {
+				switch_event_destroy(&old);
+				eq_add(&shard->dropped, 1);
+			}
+		} else if (sub->overflow == SWITCH_EVENT_OVERFLOW_BLOCK && waiting && SYSTEM_RUNNING && eq_load(&sub->running)) {
+			eq_add(&sub->waiters, 1);
+			waiting->sub = sub;
+			waiting->shard = shard;
+			waiting->clone = clone;
+			event_shard_wake(shard);
+			return SWITCH_TRUE;
+		} else {
+			switch_event_destroy(&clone);
+			eq_add(&shard->dropped, 1);
+			return SWITCH_FALSE;
+		}
+	}
+
+	event_shard_queued(shard);
+
+	return SWITCH_FALSE;
+}
+
+/* called without the node lock, the waiters count keeps the subscriber alive until this returns */
+static void event_subscriber_push_wait(event_waiting_t *waiting)
+{
+	event_subscriber_t *sub = waiting->sub;
+	event_shard_t *shard = waiting->shard;
+
+	while (!event_shard_push(shard, waiting->clone)) {
+		if (!SYSTEM_RUNNING || !eq_load(&sub->running)) {
+			switch_event_destroy(&waiting->clone);
+			eq_add(&shard->dropped, 1);
+			eq_dec(&sub->waiters);
+			return;
+		}
+		event_shard_wake(shard);
+		switch_cond_next();
+	}
+
+	event_shard_queued(shard);
+	eq_dec(&sub->waiters);
+}
+
+static event_subscriber_t *event_subscriber_create(const char *id, switch_event_types_t event_id, switch_event_callback_t callback, void *user_data,
+												   uint32_t queue_len, uint32_t workers, switch_event_overflow_t overflow)
+{
+	switch_memory_pool_t *pool = NULL;
+	switch_threadattr_t *thd_attr = NULL;
+	event_subscriber_t *sub;
+	uint32_t x, len = 16;
+
+	if (!workers) {
+		workers = 1;
+	} else if (workers > EQ_MAX_WORKERS) {
+		workers = EQ_MAX_WORKERS;
+	}
+
+	while (len < queue_len && len < (1U << 24)) {
+		len <<= 1;
+	}
+
+	switch_core_new_memory_pool(&pool);
+	sub = switch_core_alloc(pool, sizeof(*sub));
+	sub->pool = pool;
+	sub->id = switch_core_strdup(pool, id);
+	sub->event_id = event_id;
+	sub->callback = callback;
+	sub->user_data = user_data;
+	sub->overflow = overflow;
+	sub->queue_len = len;
+	sub->shard_count = workers;
+	sub->running = 1;
+	sub->shards = switch_core_alloc(pool, sizeof(event_shard_t) * workers);
+
+	switch_threadattr_create(&thd_attr, pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	for (x = 0; x < workers; x++) {
+		event_shard_t *shard = &sub->shards[x];
+		uint32_t i;
+
+		shard->sub = sub;
+		shard->mask = len - 1;
+		shard->cells = switch_core_alloc(pool, sizeof(event_cell_t) * len);
+		for (i = 0; i < len; i++) {
+			shard->cells[i].seq = i;
+		}
+		switch_mutex_init(&shard->mutex, SWITCH_MUTEX_NESTED, pool);
+		switch_thread_cond_create(&shard->cond, pool);
+		switch_thread_create(&shard->thread, thd_attr, event_shard_thread, shard, pool);
+	}
+
+	switch_mutex_lock(BLOCK);
+	sub->next = EVENT_SUBSCRIBERS;
+	EVENT_SUBSCRIBERS = sub;
+	switch_mutex_unlock(BLOCK);
+
+	return sub;
+}
+
+/* the binding must already be out of EVENT_NODES so nothing can push any more */
+static void event_subscriber_destroy(event_subscriber_t **subp)
+{
+	event_subscriber_t *sub = *subp, *sp, *last = NULL;
+	switch_memory_pool_t *pool;
+	switch_status_t st;
+	uint32_t x;
+
+	*subp = NULL;
+
+	switch_mutex_lock(BLOCK);
+	for (sp = EVENT_SUBSCRIBERS; sp; sp = sp->next) {
+		if (sp == sub) {
+			if (last) {
+				last->next = sp->next;
+			} else {
+				EVENT_SUBSCRIBERS = sp->next;
+			}
+			break;
+		}
+		last = sp;
+	}
+	switch_mutex_unlock(BLOCK);
+
+	eq_store(&sub->running, 0);
+
+	while (eq_load(&sub->waiters)) {
+		switch_cond_next();
+	}
+
+	for (x = 0; x < sub->shard_count; x++) {
+		event_shard_t *shard = &sub->shards[x];
+
+		switch_mutex_lock(shard->mutex);
+		switch_thread_cond_signal(shard->cond);
+		switch_mutex_unlock(shard->mutex);
+		switch_thread_join(&st, shard->thread);
+	}
+
+	pool = sub->pool;
+	switch_core_destroy_memory_pool(&pool);
+}
+
+SWITCH_DECLARE(const char *) switch_event_overflow_str(switch_event_overflow_t overflow)
+{
+	switch (overflow) {
+	case SWITCH_EVENT_OVERFLOW_DROP_OLD:
+		return "drop-old";
+	case SWITCH_EVENT_OVERFLOW_BLOCK:
+		return "block";
+	default:
+		return "drop-new";
+	}
+}
+
+SWITCH_DECLARE(switch_event_overflow_t) switch_event_overflow_from_str(const char *str)
+{
+	if (!zstr(str)) {
+		if (!strcasecmp(str, "drop-old")) {
+			return SWITCH_EVENT_OVERFLOW_DROP_OLD;
+		} else if (!strcasecmp(str, "block")) {
+			return SWITCH_EVENT_OVERFLOW_BLOCK;
+		}
+	}
+
+	return SWITCH_EVENT_OVERFLOW_DROP_NEW;
+}
+
+SWITCH_DECLARE(void) switch_event_queue_stats(switch_stream_handle_t *stream, switch_bool_t reset)
+{
+	event_subscriber_t *sub;
+	uint32_t x;
+	int found = 0;
+
+	stream->write_function(stream, "%-24s %-20s %6s %8s %8s %8s %12s %12s %12s\n",
+						   "id", "event", "worker", "size", "depth", "high", "queued", "delivered", "dropped");
+
+	switch_mutex_lock(BLOCK);
+	for (sub = EVENT_SUBSCRIBERS; sub; sub = sub->next) {
+		for (x = 0; x < sub->shard_count; x++) {
+			event_shard_t *shard = &sub->shards[x];
+
+			stream->write_function(stream, "%-24s %-20s %6u %8u %8u %8" SWITCH_UINT64_T_FMT " %12" SWITCH_UINT64_T_FMT " %12" SWITCH_UINT64_T_FMT " %12" SWITCH_UINT64_T_FMT "\n",
+								   sub->id, switch_event_name(sub->event_id), x, sub->queue_len, (uint32_t) event_shard_depth(shard),
+								   shard->high, shard->queued, shard->delivered, shard->dropped);
+
+			if (reset) {
+				shard->high = 0;
+				shard->queued = 0;
+				shard->delivered = 0;
+				shard->dropped = 0;
+			}
+		}
+		stream->write_function(stream, "%-24s overflow policy %s\n", "", switch_event_overflow_str(sub->overflow));
+		found++;
+	}
+	switch_mutex_unlock(BLOCK);
+
+	stream->write_function(stream, "\n%d queued binding%s\n", found, found == 1 ? "" : "s");
+}
+
 SWITCH_DECLARE(void) switch_event_deliver(switch_event_t **event)
 {
 	switch_event_types_t e;
 	switch_event_node_t *node;
+	event_waiting_t stack_waiting[EQ_MAX_WAITING], *waiting = stack_waiting;
+	int x, nwaiting = 0, max_waiting = EQ_MAX_WAITING;
 
 	if (SYSTEM_RUNNING) {
 		switch_thread_rwlock_rdlock(RWLOCK);
 		for (e = (*event)->event_id;; e = SWITCH_EVENT_ALL) {
 			for (node = EVENT_NODES[e]; node; node = node->next) {
-				if (switch_events_match(*event, node)) {
+				if (switch_events_match(*event, node) && (!node->filter || switch_event_filter_match(node->filter, *event))) {
+					if (node->sub) {
+						if (nwaiting == max_waiting) {
+							max_waiting *= 2;
+							if (waiting == stack_waiting) {
+								waiting = malloc(max_waiting * sizeof(*waiting));
+								switch_assert(waiting);
+								memcpy(waiting, stack_waiting, sizeof(stack_waiting));
+							} else {
+								waiting = realloc(waiting, max_waiting * sizeof(*waiting));
+								switch_assert(waiting);
+							}
+						}
+						if (event_subscriber_push(node->sub, *event, &waiting[nwaiting])) {
+							nwaiting++;
+						}
+						continue;
+					}
+					if (node->queued) {
+						/* its queues are already gone at shutdown */
+						continue;
+					}
 					(*event)->bind_user_data = node->user_data;
 					node->callback(*event);
 				}
@@ -409,6 +1682,14 @@ SWITCH_DECLARE(void) switch_event_deliver(switch_event_t **event)
 			}
 		}
 		switch_thread_rwlock_unlock(RWLOCK);
+
+		for (x = 0; x < nwaiting; x++) {
+			event_subscriber_push_wait(&waiting[x]);
+		}
+
+		if (waiting != stack_waiting) {
+			free(waiting);
+		}
 	}
 
 	switch_event_destroy(event);
@@ -510,10 +1791,10 @@ SWITCH_DECLARE(void) switch_core_memory_reclaim_events(void)
 					  size, (int) sizeof(switch_event_header_t) * size);
 
 	while (switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		free(pop);
+		switch_slab_free(pop);
 	}
 	while (switch_queue_trypop(EVENT_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		free(pop);
+		switch_slab_free(pop);
 	}
 #else
 	return;
@@ -562,6 +1843,26 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 		}
 	}
 
+	if (EVENT_SUBSCRIBERS) {
+		switch_event_node_t *node;
+		event_subscriber_t *sub;
+		int e;
+
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Stopping queued event bindings\n");
+
+		switch_thread_rwlock_wrlock(RWLOCK);
+		for (e = 0; e <= SWITCH_EVENT_ALL; e++) {
+			for (node = EVENT_NODES[e]; node; node = node->next) {
+				node->sub = NULL;
+			}
+		}
+		switch_thread_rwlock_unlock(RWLOCK);
+
+		while ((sub = EVENT_SUBSCRIBERS)) {
+			event_subscriber_destroy(&sub);
+		}
+	}
+
 	x = 0;
 	while (x < 100 && THREAD_COUNT) {
 		switch_yield(100000);
@@ -677,6 +1978,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 	switch_mutex_init(&POOL_LOCK, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_mutex_init(&EVENT_QUEUE_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_core_hash_init(&CUSTOM_HASH);
+	event_intern_init();
 
 	if (switch_core_test_flag(SCF_MINIMAL)) {
 		return SWITCH_STATUS_SUCCESS;
@@ -732,7 +2034,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_create_subclass_detailed(const char
 		*event = (switch_event_t *) pop;
 	} else {
 #endif
-		*event = ALLOC(sizeof(switch_event_t));
+		*event = SLAB_ALLOC(sizeof(switch_event_t));
 		switch_assert(*event);
 #ifdef SWITCH_EVENT_RECYCLE
 	}
@@ -778,17 +2080,22 @@ SWITCH_DECLARE(switch_status_t) switch_event_rename_header(switch_event_t *event
 	}
 
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
+	event_headers_private(event);
 
 	for (hp = event->headers; hp; hp = hp->next) {
 		if ((!hp->hash || hash == hp->hash) && !strcasecmp(hp->name, header_name)) {
-			FREE(hp->name);
-			hp->name = DUP(new_header_name);
+			event_name_free(event->arena, hp->name);
 			hlen = -1;
-			hp->hash = switch_ci_hashfunc_default(hp->name, &hlen);
+			hp->hash = switch_ci_hashfunc_default(new_header_name, &hlen);
+			hp->name = event_name_dup(event, new_header_name, hp->hash);
 			x++;
 		}
 	}
 
+	if (x && event->index) {
+		event_index_build(event);
+	}
+
 	return x ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
 }
 
@@ -806,6 +2113,12 @@ SWITCH_DECLARE(switch_event_header_t *) switch_event_get_header_ptr(switch_event
 
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
 
+	if (event->index) {
+		switch_event_header_t **slot = event_index_slot(event->index, header_name, hash);
+
+		return slot ? *slot : NULL;
+	}
+
 	for (hp = event->headers; hp; hp = hp->next) {
 		if ((!hp->hash || hash == hp->hash) && !strcasecmp(hp->name, header_name)) {
 			return hp;
@@ -840,16 +2153,49 @@ SWITCH_DECLARE(char *) switch_event_get_body(switch_event_t *event)
 	return (event ? event->body : NULL);
 }
 
+static void event_unlink_header(switch_event_t *event, switch_event_header_t *hp)
+{
+	if (hp->prev) {
+		hp->prev->next = hp->next;
+	} else {
+		event->headers = hp->next;
+	}
+
+	if (hp->next) {
+		hp->next->prev = hp->prev;
+	} else {
+		event->last_header = hp->prev;
+	}
+}
+
 SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *event, const char *header_name, const char *val)
 {
-	switch_event_header_t *hp, *lp = NULL, *tp;
+	switch_event_header_t *hp, *tp, *first = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	int x = 0;
 	switch_ssize_t hlen = -1;
 	unsigned long hash = 0;
 
-	tp = event->headers;
+	event_headers_private(event);
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
+
+	/* a name is on an event with unique headers at most once (unless a rename doubled it up), the index takes us straight to it */
+	if (event->index && !event->index->dups && zstr(val) && switch_test_flag(event, EF_UNIQ_HEADERS)) {
+		switch_event_header_t **slot;
+
+		if (!(slot = event_index_slot(event->index, header_name, hash))) {
+			return SWITCH_STATUS_FALSE;
+		}
+
+		hp = *slot;
+		event_index_clear(event->index, slot);
+		event_unlink_header(event, hp);
+		event_header_free(event->arena, hp);
+
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	tp = event->headers;
 	while (tp) {
 		hp = tp;
 		tp = tp->next;
@@ -857,66 +2203,37 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 		x++;
 		switch_assert(x < 1000000);
 
-		if ((!hp->hash || hash == hp->hash) && !strcasecmp(header_name, hp->name) && (zstr(val) || !strcmp(hp->value, val))) {
-			if (lp) {
-				lp->next = hp->next;
-			} else {
-				event->headers = hp->next;
-			}
-			if (hp == event->last_header || !hp->next) {
-				event->last_header = lp;
-			}
-			FREE(hp->name);
-
-			if (hp->idx) {
-				int i = 0;
-
-				for (i = 0; i < hp->idx; i++) {
-					FREE(hp->array[i]);
+		if ((!hp->hash || hash == hp->hash) && !strcasecmp(header_name, hp->name)) {
+			if (zstr(val) || !strcmp(hp->value, val)) {
+				if (event->index) {
+					event_index_del(event->index, hp);
 				}
-				FREE(hp->array);
-			}
-
-			FREE(hp->value);
-
-			memset(hp, 0, sizeof(*hp));
-#ifdef SWITCH_EVENT_RECYCLE
-			if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, hp) != SWITCH_STATUS_SUCCESS) {
-				FREE(hp);
+				event_unlink_header(event, hp);
+				event_header_free(event->arena, hp);
+				status = SWITCH_STATUS_SUCCESS;
+			} else if (!first) {
+				first = hp;
 			}
-#else
-			FREE(hp);
-#endif
-			status = SWITCH_STATUS_SUCCESS;
-		} else {
-			lp = hp;
 		}
 	}
 
-	return status;
-}
-
-static switch_event_header_t *new_header(const char *header_name)
-{
-	switch_event_header_t *header;
-
-#ifdef SWITCH_EVENT_RECYCLE
-		void *pop;
-		if (EVENT_HEADER_RECYCLE_QUEUE && switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS) {
-			header = (switch_event_header_t *) pop;
-		} else {
-#endif
-			header = ALLOC(sizeof(*header));
-			switch_assert(header);
-#ifdef SWITCH_EVENT_RECYCLE
-		}
-#endif
+	/* whatever of that name survived takes over the index entry */
+	if (first && event->index && status == SWITCH_STATUS_SUCCESS) {
+		event_index_add(event->index, first, 1);
+	}
 
-		memset(header, 0, sizeof(*header));
-		header->name = DUP(header_name);
+	return status;
+}
+
+static switch_event_header_t *new_header(switch_event_t *event, const char *header_name)
+{
+	switch_event_header_t *header = event_header_alloc(event);
+	switch_ssize_t hlen = -1;
 
-		return header;
+	header->hash = switch_ci_hashfunc_default(header_name, &hlen);
+	header->name = event_name_dup(event, header_name, header->hash);
 
+	return header;
 }
 
 SWITCH_DECLARE(int) switch_event_add_array(switch_event_t *event, const char *var, const char *val)
@@ -965,10 +2282,10 @@ SWITCH_DECLARE(int) switch_event_add_array(switch_event_t *event, const char *va
 	return 0;
 }
 
+/* data is ours from here on, either in the event's arena or malloc'd */
 static switch_status_t switch_event_base_add_header(switch_event_t *event, switch_stack_t stack, const char *header_name, char *data)
 {
 	switch_event_header_t *header = NULL;
-	switch_ssize_t hlen = -1;
 	int exists = 0, fly = 0;
 	char *index_ptr;
 	int index = 0;
@@ -993,7 +2310,7 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (!(header = switch_event_get_header_ptr(event, header_name)) && index_ptr) {
 
-			header = new_header(header_name);
+			header = new_header(event, header_name);
 
 			if (switch_test_flag(event, EF_UNIQ_HEADERS)) {
 				switch_event_del_header(event, header_name);
@@ -1007,8 +2324,8 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 			if (index_ptr) {
 				if (index > -1 && index <= 4000) {
 					if (index < header->idx) {
-						FREE(header->array[index]);
-						header->array[index] = DUP(data);
+						event_value_free(event->arena, header->array[index]);
+						header->array[index] = data;
 					} else {
 						int i;
 						char **m;
@@ -1017,9 +2334,9 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 						switch_assert(m);
 						header->array = m;
 						for (i = header->idx; i < index; i++) {
-							m[i] = DUP("");
+							m[i] = event_value_dup(event, "");
 						}
-						m[index] = DUP(data);
+						m[index] = data;
 						header->idx = index + 1;
 						if (!fly) {
 							exists = 1;
@@ -1027,6 +2344,11 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 						goto redraw;
 					}
+				} else {
+					event_value_free(event->arena, data);
+					if (fly) {
+						event_header_free(event->arena, header);
+					}
 				}
 				goto end;
 			} else {
@@ -1045,7 +2367,7 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (zstr(data)) {
 			switch_event_del_header(event, header_name);
-			FREE(data);
+			event_value_free(event->arena, data);
 			goto end;
 		}
 
@@ -1055,12 +2377,12 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (!strncmp(data, "ARRAY::", 7)) {
 			switch_event_add_array(event, header_name, data);
-			FREE(data);
+			event_value_free(event->arena, data);
 			goto end;
 		}
 
 
-		header = new_header(header_name);
+		header = new_header(event, header_name);
 	}
 
 	if ((stack & SWITCH_STACK_PUSH) || (stack & SWITCH_STACK_UNSHIFT)) {
@@ -1103,6 +2425,10 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (len) {
 			len += 8;
+			/* the joined value is rewritten on every push, it lives on the heap */
+			if (event_arena_owns(event->arena, header->value)) {
+				header->value = NULL;
+			}
 			hv = realloc(header->value, len);
 			switch_assert(hv);
 			header->value = hv;
@@ -1126,20 +2452,23 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 		}
 
 	} else {
-		switch_safe_free(header->value);
+		event_value_free(event->arena, header->value);
 		header->value = data;
 	}
 
 	if (!exists) {
-		header->hash = switch_ci_hashfunc_default(header->name, &hlen);
-
 		if ((stack & SWITCH_STACK_TOP)) {
+			header->prev = NULL;
 			header->next = event->headers;
+			if (event->headers) {
+				event->headers->prev = header;
+			}
 			event->headers = header;
 			if (!event->last_header) {
 				event->last_header = header;
 			}
 		} else {
+			header->prev = event->last_header;
 			if (event->last_header) {
 				event->last_header->next = header;
 			} else {
@@ -1148,6 +2477,10 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 			}
 			event->last_header = header;
 		}
+
+		if (event->index) {
+			event_index_add(event->index, header, (stack & SWITCH_STACK_TOP));
+		}
 	}
 
  end:
@@ -1161,8 +2494,20 @@ SWITCH_DECLARE(switch_status_t) switch_event_add_header(switch_event_t *event, s
 {
 	int ret = 0;
 	char *data;
+	char buf[256];
 	va_list ap;
 
+	event_headers_private(event);
+
+	/* most values are short, format them on the stack and copy them into the arena */
+	va_start(ap, fmt);
+	ret = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	if (ret >= 0 && ret < (int) sizeof(buf)) {
+		return switch_event_base_add_header(event, stack, header_name, event_value_dup(event, buf));
+	}
+
 	va_start(ap, fmt);
 	ret = switch_vasprintf(&data, fmt, ap);
 	va_end(ap);
@@ -1189,7 +2534,8 @@ SWITCH_DECLARE(switch_status_t) switch_event_set_subclass_name(switch_event_t *e
 SWITCH_DECLARE(switch_status_t) switch_event_add_header_string(switch_event_t *event, switch_stack_t stack, const char *header_name, const char *data)
 {
 	if (data) {
-		return switch_event_base_add_header(event, stack, header_name, (stack & SWITCH_STACK_NODUP) ? (char *)data : DUP(data));
+		event_headers_private(event);
+		return switch_event_base_add_header(event, stack, header_name, (stack & SWITCH_STACK_NODUP) ? (char *)data : event_value_dup(event, data));
 	}
 	return SWITCH_STATUS_GENERR;
 }
@@ -1231,48 +2577,20 @@ SWITCH_DECLARE(switch_status_t) switch_event_add_body(switch_event_t *event, con
 SWITCH_DECLARE(void) switch_event_destroy(switch_event_t **event)
 {
 	switch_event_t *ep = *event;
-	switch_event_header_t *hp, *this;
 
 	if (ep) {
-		for (hp = ep->headers; hp;) {
-			this = hp;
-			hp = hp->next;
-
-			if (this->idx) {
-				if (!this->array) {
-					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "INDEX WITH NO ARRAY WTF?? [%s][%s]\n", this->name, this->value);
-				} else {
-					int i = 0;
-
-					for (i = 0; i < this->idx; i++) {
-						FREE(this->array[i]);
-					}
-					FREE(this->array);
-				}
-			}
-
-			FREE(this->name);
-			FREE(this->value);
-
-
-#ifdef SWITCH_EVENT_RECYCLE
-			if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, this) != SWITCH_STATUS_SUCCESS) {
-				FREE(this);
-			}
-#else
-			FREE(this);
-#endif
-
-
+		if (ep->arena) {
+			event_arena_release(ep->arena, ep->headers);
 		}
+		event_index_destroy(ep);
 		FREE(ep->body);
 		FREE(ep->subclass_name);
 #ifdef SWITCH_EVENT_RECYCLE
 		if (switch_queue_trypush(EVENT_RECYCLE_QUEUE, ep) != SWITCH_STATUS_SUCCESS) {
-			FREE(ep);
+			SLAB_FREE(ep);
 		}
 #else
-		FREE(ep);
+		SLAB_FREE(ep);
 #endif
 
 	}
@@ -1303,26 +2621,25 @@ SWITCH_DECLARE(switch_status_t) switch_event_dup(switch_event_t **event, switch_
 {
 	switch_event_header_t *hp;
 
-	if (switch_event_create_subclass(event, SWITCH_EVENT_CLONE, todup->subclass_name) != SWITCH_STATUS_SUCCESS) {
+	if (switch_event_create_subclass(event, SWITCH_EVENT_CLONE, NULL) != SWITCH_STATUS_SUCCESS) {
 		return SWITCH_STATUS_GENERR;
 	}
 
 	(*event)->event_id = todup->event_id;
 	(*event)->event_user_data = todup->event_user_data;
 	(*event)->bind_user_data = todup->bind_user_data;
-	(*event)->flags = todup->flags;
-	for (hp = todup->headers; hp; hp = hp->next) {
-		if (todup->subclass_name && !strcmp(hp->name, "Event-Subclass")) {
-			continue;
-		}
+	(*event)->flags = todup->flags & ~EF_SEALED;
 
-		if (hp->idx) {
-			int i;
-			for (i = 0; i < hp->idx; i++) {
-				switch_event_add_header_string(*event, SWITCH_STACK_PUSH, hp->name, hp->array[i]);
-			}
-		} else {
-			switch_event_add_header_string(*event, SWITCH_STACK_BOTTOM, hp->name, hp->value);
+	if (todup->subclass_name) {
+		(*event)->subclass_name = DUP(todup->subclass_name);
+	}
+
+	/* the headers of a sealed event no longer change under us, share them, anything else gets a copy of its own */
+	if (todup->arena && switch_test_flag(todup, EF_SEALED)) {
+		event_share_headers(*event, todup);
+	} else {
+		for (hp = todup->headers; hp; hp = hp->next) {
+			event_copy_header(*event, hp);
 		}
 	}
 
@@ -1484,117 +2801,248 @@ SWITCH_DECLARE(switch_status_t) switch_event_binary_serialize(switch_event_t *ev
 }
 
 
-SWITCH_DECLARE(switch_status_t) switch_event_serialize(switch_event_t *event, char **str, switch_bool_t encode)
+/* The serializers append straight to the caller's stream.  The stream is told up front roughly how much is coming so it
+   grows once, and values with nothing to escape, nearly all of them, are copied in one piece. */
+#define EVENT_PUT(_s, _d, _l) (_s)->raw_write_function((_s), (uint8_t *) (_d), (_l))
+#define EVENT_PUTS(_s, _str) EVENT_PUT(_s, _str, strlen(_str))
+
+static switch_size_t event_stream_hint(switch_stream_handle_t *stream, switch_event_t *event)
 {
-	switch_size_t len = 0;
 	switch_event_header_t *hp;
-	switch_size_t llen = 0, dlen = 0, blocksize = 512, encode_len = 1536, new_len = 0;
-	char *buf;
-	char *encode_buf = NULL;	/* used for url encoding of variables to make sure unsafe things stay out of the serialized copy */
+	switch_size_t chunk = stream->alloc_chunk, len = 64;
+
+	for (hp = event->headers; hp; hp = hp->next) {
+		len += strlen(hp->name) + strlen(hp->value) + 8;
+	}
+
+	if (event->body) {
+		len += strlen(event->body) + 64;
+	}
+
+	if (len > chunk) {
+		stream->alloc_chunk = len;
+	}
+
+	return chunk;
+}
+
+static void event_json_string(switch_stream_handle_t *stream, const char *str)
+{
+	const char *p, *run;
+	char esc[8];
+
+	EVENT_PUT(stream, "\"", 1);
+
+	/* same escaping as cJSON */
+	for (run = p = str; *p; p++) {
+		unsigned char c = (unsigned char) *p;
+
+		if (c > 31 && c != '"' && c != '\\') {
+			continue;
+		}
 
-	*str = NULL;
+		if (p > run) {
+			EVENT_PUT(stream, run, p - run);
+		}
 
-	dlen = blocksize * 2;
+		switch (c) {
+		case '"':
+		case '\\':
+			esc[0] = '\\';
+			esc[1] = c;
+			esc[2] = '\0';
+			break;
+		case '\b':
+			strcpy(esc, "\\b");
+			break;
+		case '\f':
+			strcpy(esc, "\\f");
+			break;
+		case '\n':
+			strcpy(esc, "\\n");
+			break;
+		case '\r':
+			strcpy(esc, "\\r");
+			break;
+		case '\t':
+			strcpy(esc, "\\t");
+			break;
+		default:
+			switch_snprintf(esc, sizeof(esc), "\\u%04x", c);
+			break;
+		}
 
-	if (!(buf = malloc(dlen))) {
-		abort();
+		EVENT_PUTS(stream, esc);
+		run = p + 1;
 	}
 
-	/* go ahead and give ourselves some space to work with, should save a few reallocs */
-	if (!(encode_buf = malloc(encode_len))) {
-		abort();
+	if (p > run) {
+		EVENT_PUT(stream, run, p - run);
 	}
 
-	/* switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "hit serialized!.\n"); */
+	EVENT_PUT(stream, "\"", 1);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_serialize_stream(switch_event_t *event, switch_stream_handle_t *stream, switch_bool_t encode)
+{
+	switch_event_header_t *hp;
+	switch_size_t chunk;
+
+	switch_assert(stream->raw_write_function);
+
+	chunk = event_stream_hint(stream, event);
+
 	for (hp = event->headers; hp; hp = hp->next) {
-		/*
-		 * grab enough memory to store 3x the string (url encode takes one char and turns it into %XX)
-		 * so we could end up with a string that is 3 times the originals length, unlikely but rather
-		 * be safe than destroy the string, also add one for the null.  And try to be smart about using
-		 * the memory, allocate and only reallocate if we need more.  This avoids an alloc, free CPU
-		 * destroying loop.
-		 */
+		EVENT_PUTS(stream, hp->name);
+		EVENT_PUT(stream, ": ", 2);
 
-		if (hp->idx) {
-			int i;
-			new_len = 0;
-			for(i = 0; i < hp->idx; i++) {
-				new_len += (strlen(hp->array[i]) * 3) + 1;
+		/* handle any bad things in the string like newlines : etc that screw up the serialized format */
+		if (encode) {
+			if (zstr(hp->value)) {
+				EVENT_PUT(stream, "_undef_", 7);
+			} else {
+				switch_url_encode_stream(stream, hp->value);
 			}
 		} else {
-			new_len = (strlen(hp->value) * 3) + 1;
+			EVENT_PUT(stream, "[", 1);
+			EVENT_PUTS(stream, hp->value);
+			EVENT_PUT(stream, "]", 1);
 		}
 
-		if (encode_len < new_len) {
-			char *tmp;
+		EVENT_PUT(stream, "\n", 1);
+	}
 
-			/* keep track of the size of our allocation */
-			encode_len = new_len;
+	if (!zstr(event->body)) {
+		char tmp[64];
 
-			if (!(tmp = realloc(encode_buf, encode_len))) {
-				abort();
-			}
+		switch_snprintf(tmp, sizeof(tmp), "Content-Length: %d\n\n", (int) strlen(event->body));
+		EVENT_PUTS(stream, tmp);
+		EVENT_PUTS(stream, event->body);
+	} else {
+		EVENT_PUT(stream, "\n", 1);
+	}
 
-			encode_buf = tmp;
-		}
+	stream->alloc_chunk = chunk;
 
-		/* handle any bad things in the string like newlines : etc that screw up the serialized format */
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_serialize_json_stream(switch_event_t *event, switch_stream_handle_t *stream)
+{
+	switch_event_header_t *hp;
+	switch_size_t chunk;
 
+	switch_assert(stream->raw_write_function);
 
-		if (encode) {
-			switch_url_encode(hp->value, encode_buf, encode_len);
-		} else {
-			switch_snprintf(encode_buf, encode_len, "[%s]", hp->value);
+	chunk = event_stream_hint(stream, event);
+
+	EVENT_PUT(stream, "{", 1);
+
+	for (hp = event->headers; hp; hp = hp->next) {
+		if (hp != event->headers) {
+			EVENT_PUT(stream, ",", 1);
 		}
 
+		event_json_string(stream, hp->name);
+		EVENT_PUT(stream, ":", 1);
 
-		llen = strlen(hp->name) + strlen(encode_buf) + 8;
+		if (hp->idx) {
+			int i;
 
-		if ((len + llen) > dlen) {
-			char *m = buf;
-			dlen += (blocksize + (len + llen));
-			if (!(buf = realloc(buf, dlen))) {
-				buf = m;
-				abort();
+			EVENT_PUT(stream, "[", 1);
+			for (i = 0; i < hp->idx; i++) {
+				if (i) {
+					EVENT_PUT(stream, ",", 1);
+				}
+				event_json_string(stream, hp->array[i]);
 			}
+			EVENT_PUT(stream, "]", 1);
+		} else {
+			event_json_string(stream, hp->value);
 		}
+	}
+
+	if (event->body) {
+		char tmp[64];
 
-		switch_snprintf(buf + len, dlen - len, "%s: %s\n", hp->name, *encode_buf == '\0' ? "_undef_" : encode_buf);
-		len = strlen(buf);
+		switch_snprintf(tmp, sizeof(tmp), "%s\"Content-Length\":\"%d\",\"_body\":", event->headers ? "," : "", (int) strlen(event->body));
+		EVENT_PUTS(stream, tmp);
+		event_json_string(stream, event->body);
 	}
 
-	/* we are done with the memory we used for encoding, give it back */
-	switch_safe_free(encode_buf);
+	EVENT_PUT(stream, "}", 1);
 
-	if (event->body) {
-		int blen = (int) strlen(event->body);
-		llen = blen;
+	stream->alloc_chunk = chunk;
 
-		if (blen) {
-			llen += 25;
-		} else {
-			llen += 5;
-		}
+	return SWITCH_STATUS_SUCCESS;
+}
 
-		if ((len + llen) > dlen) {
-			char *m = buf;
-			dlen += (blocksize + (len + llen));
-			if (!(buf = realloc(buf, dlen))) {
-				buf = m;
-				abort();
-			}
+static void event_xml_header(switch_stream_handle_t *stream, const char *indent, const char *name, const char *value)
+{
+	EVENT_PUTS(stream, indent);
+	EVENT_PUT(stream, "<", 1);
+	EVENT_PUTS(stream, name);
+	EVENT_PUT(stream, ">", 1);
+	switch_url_encode_stream(stream, value);
+	EVENT_PUT(stream, "</", 2);
+	EVENT_PUTS(stream, name);
+	EVENT_PUT(stream, ">\n", 2);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_xmlize_stream(switch_event_t *event, switch_stream_handle_t *stream)
+{
+	switch_event_header_t *hp;
+	switch_size_t chunk;
+
+	switch_assert(stream->raw_write_function);
+
+	chunk = event_stream_hint(stream, event);
+
+	/* the same text switch_xml_toxml() renders from switch_event_xmlize() */
+	EVENT_PUTS(stream, "<event>\n  <headers>");
+
+	for (hp = event->headers; hp; hp = hp->next) {
+		if (hp == event->headers) {
+			EVENT_PUT(stream, "\n", 1);
 		}
 
-		if (blen) {
-			switch_snprintf(buf + len, dlen - len, "Content-Length: %d\n\n%s", blen, event->body);
+		if (hp->idx) {
+			int i;
+
+			for (i = 0; i < hp->idx; i++) {
+				event_xml_header(stream, "    ", hp->name, hp->array[i]);
+			}
 		} else {
-			switch_snprintf(buf + len, dlen - len, "\n");
+			event_xml_header(stream, "    ", hp->name, hp->value);
 		}
-	} else {
-		switch_snprintf(buf + len, dlen - len, "\n");
 	}
 
-	*str = buf;
+	EVENT_PUTS(stream, event->headers ? "  </headers>\n" : "</headers>\n");
+
+	if (!zstr(event->body)) {
+		char tmp[25];
+
+		switch_snprintf(tmp, sizeof(tmp), "%d", (int) strlen(event->body));
+		event_xml_header(stream, "  ", "Content-Length", tmp);
+		EVENT_PUTS(stream, "  <body>");
+		switch_xml_ampencode_stream(stream, event->body);
+		EVENT_PUTS(stream, "</body>\n");
+	}
+
+	EVENT_PUTS(stream, "</event>\n");
+
+	stream->alloc_chunk = chunk;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_serialize(switch_event_t *event, char **str, switch_bool_t encode)
+{
+	switch_stream_handle_t stream = { 0 };
+
+	SWITCH_STANDARD_STREAM(stream);
+	switch_event_serialize_stream(event, &stream, encode);
+	*str = (char *) stream.data;
 
 	return SWITCH_STATUS_SUCCESS;
 }
@@ -1817,17 +3265,13 @@ SWITCH_DECLARE(switch_status_t) switch_event_serialize_json_obj(switch_event_t *
 SWITCH_DECLARE(switch_status_t) switch_event_serialize_json(switch_event_t *event, char **str)
 {
 
-	cJSON *cj;
-	*str = NULL;
+	switch_stream_handle_t stream = { 0 };
 
-	if (switch_event_serialize_json_obj(event, &cj) == SWITCH_STATUS_SUCCESS) {
-		*str = cJSON_PrintUnformatted(cj);
-		cJSON_Delete(cj);
-		
-		return SWITCH_STATUS_SUCCESS;
-	}
+	SWITCH_STANDARD_STREAM(stream);
+	switch_event_serialize_json_stream(event, &stream);
+	*str = (char *) stream.data;
 
-	return SWITCH_STATUS_FALSE;
+	return SWITCH_STATUS_SUCCESS;
 }
 
 static switch_xml_t add_xml_header(switch_xml_t xml, char *name, char *value, int offset)
@@ -1978,6 +3422,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_fire_detailed(const char *file, con
 		(*event)->event_user_data = user_data;
 	}
 
+	switch_set_flag((*event), EF_SEALED);
 
 
 	if (runtime.events_use_dispatch) {
@@ -2010,8 +3455,8 @@ SWITCH_DECLARE(switch_status_t) switch_event_get_custom_events(switch_console_ca
 	return x ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
 }
 
-SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, switch_event_types_t event, const char *subclass_name,
-															switch_event_callback_t callback, void *user_data, switch_event_node_t **node)
+static switch_status_t event_bind(const char *id, switch_event_types_t event, const char *subclass_name,
+								   switch_event_callback_t callback, void *user_data, event_subscriber_t *sub, switch_event_node_t **node)
 {
 	switch_event_node_t *event_node;
 	switch_event_subclass_t *subclass = NULL;
@@ -2047,6 +3492,8 @@ SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, swit
 		}
 		event_node->callback = callback;
 		event_node->user_data = user_data;
+		event_node->sub = sub;
+		event_node->queued = sub ? SWITCH_TRUE : SWITCH_FALSE;
 
 		if (EVENT_NODES[event]) {
 			event_node->next = EVENT_NODES[event];
@@ -2067,6 +3514,54 @@ SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, swit
 	return SWITCH_STATUS_MEMERR;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, switch_event_types_t event, const char *subclass_name,
+															switch_event_callback_t callback, void *user_data, switch_event_node_t **node)
+{
+	return event_bind(id, event, subclass_name, callback, user_data, NULL, node);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_event_bind_queued(const char *id, switch_event_types_t event, const char *subclass_name,
+														 switch_event_callback_t callback, void *user_data,
+														 uint32_t queue_len, uint32_t workers, switch_event_overflow_t overflow,
+														 switch_event_node_t **node)
+{
+	event_subscriber_t *sub;
+	switch_status_t status;
+
+	switch_assert(BLOCK != NULL);
+
+	if (event > SWITCH_EVENT_ALL) {
+		return SWITCH_STATUS_MEMERR;
+	}
+
+	sub = event_subscriber_create(id, event, callback, user_data, queue_len, workers, overflow);
+
+	if ((status = event_bind(id, event, subclass_name, callback, user_data, sub, node)) != SWITCH_STATUS_SUCCESS) {
+		event_subscriber_destroy(&sub);
+	} else {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Event Binding for %s:%s queued on %u worker(s), %u deep, %s on overflow\n",
+						  id, switch_event_name(event), sub->shard_count, sub->queue_len, switch_event_overflow_str(overflow));
+	}
+
+	return status;
+}
+
+
+SWITCH_DECLARE(switch_status_t) switch_event_bind_filter(switch_event_node_t *node, switch_event_filter_t *filter)
+{
+	switch_event_filter_t *old;
+
+	switch_assert(node);
+
+	switch_thread_rwlock_wrlock(RWLOCK);
+	old = node->filter;
+	node->filter = filter;
+	switch_thread_rwlock_unlock(RWLOCK);
+
+	switch_event_filter_destroy(&old);
+
+	return SWITCH_STATUS_SUCCESS;
+}
 
 SWITCH_DECLARE(switch_status_t) switch_event_bind(const char *id, switch_event_types_t event, const char *subclass_name,
 												  switch_event_callback_t callback, void *user_data)
@@ -2079,6 +3574,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind_callback(switch_event_callba
 {
 	switch_event_node_t *n, *np, *lnp = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
+	event_subscriber_t *reap = NULL, *sub;
 	int id;
 
 	switch_thread_rwlock_wrlock(RWLOCK);
@@ -2098,6 +3594,11 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind_callback(switch_event_callba
 				}
 
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Event Binding deleted for %s:%s\n", n->id, switch_event_name(n->event_id));
+				if (n->sub) {
+					n->sub->reap_next = reap;
+					reap = n->sub;
+				}
+				switch_event_filter_destroy(&n->filter);
 				FREE(n->subclass_name);
 				FREE(n->id);
 				FREE(n);
@@ -2111,6 +3612,12 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind_callback(switch_event_callba
 	switch_thread_rwlock_unlock(RWLOCK);
 	/* </LOCKED> ----------------------------------------------- */
 
+	/* the workers may fire events or bind themselves, join them without the locks */
+	while ((sub = reap)) {
+		reap = sub->reap_next;
+		event_subscriber_destroy(&sub);
+	}
+
 	return status;
 }
 
@@ -2120,6 +3627,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind(switch_event_node_t **node)
 {
 	switch_event_node_t *n, *np, *lnp = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
+	event_subscriber_t *sub = NULL;
 
 	n = *node;
 
@@ -2138,6 +3646,8 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind(switch_event_node_t **node)
 				EVENT_NODES[n->event_id] = n->next;
 			}
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Event Binding deleted for %s:%s\n", n->id, switch_event_name(n->event_id));
+			sub = n->sub;
+			switch_event_filter_destroy(&n->filter);
 			FREE(n->subclass_name);
 			FREE(n->id);
 			FREE(n);
@@ -2151,6 +3661,10 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind(switch_event_node_t **node)
 	switch_thread_rwlock_unlock(RWLOCK);
 	/* </LOCKED> ----------------------------------------------- */
 
+	if (sub) {
+		event_subscriber_destroy(&sub);
+	}
+
 	return status;
 }
 
@@ -2192,6 +3706,114 @@ if ((dp = realloc(data, olen))) {\
 	memset(c, 0, olen - cpos);\
  }}                           \
 
+/* what the parser below does for each ${...} it finds, over the ops of a compiled template */
+static char *event_expand_template(switch_event_t *event, switch_expand_template_t *tpl, switch_event_t *var_list, switch_event_t *api_list, uint32_t recur)
+{
+	switch_stream_handle_t out = { 0 }, api_stream = { 0 };
+	uint32_t i;
+
+	switch_expand_stream_init(&out, tpl);
+
+	for (i = 0; i < tpl->op_count; i++) {
+		switch_expand_op_t *op = &tpl->ops[i], dyn;
+		char *vname = op->str, *vval = op->arg, *expanded = NULL, *expanded_vname = NULL, *expanded_sub_val = NULL, *gvar = NULL;
+		const char *sub_val = NULL;
+		switch_size_t len;
+
+		if (op->type == SWITCH_EXPAND_LITERAL) {
+			out.raw_write_function(&out, (uint8_t *) op->str, op->len);
+			continue;
+		}
+
+		if (op->type == SWITCH_EXPAND_API) {
+			if (op->expand_str && (expanded_vname = switch_event_expand_headers_check(event, vname, var_list, api_list, recur+1)) != vname) {
+				vname = expanded_vname;
+			} else {
+				expanded_vname = NULL;
+			}
+
+			if (op->expand_arg && (expanded = switch_event_expand_headers_check(event, vval, var_list, api_list, recur+1)) != vval) {
+				vval = expanded;
+			} else {
+				expanded = NULL;
+			}
+
+			if (!switch_core_test_flag(SCF_API_EXPANSION) || (api_list && !switch_event_check_permission_list(api_list, vname))) {
+				sub_val = "<API execute Permission Denied>";
+			} else {
+				/* one scratch stream for all the api calls of this expansion */
+				if (!api_stream.data) {
+					SWITCH_STANDARD_STREAM(api_stream);
+				} else {
+					api_stream.data_len = 0;
+					api_stream.end = api_stream.data;
+					*(char *) api_stream.data = '\0';
+				}
+
+				if (switch_api_execute(vname, vval, NULL, &api_stream) == SWITCH_STATUS_SUCCESS) {
+					sub_val = api_stream.data;
+				}
+			}
+
+			if (sub_val) {
+				out.raw_write_function(&out, (uint8_t *) sub_val, strlen(sub_val));
+			}
+
+			switch_safe_free(expanded);
+			switch_safe_free(expanded_vname);
+			continue;
+		}
+
+		if (op->expand_str) {
+			int offset = 0, ooffset = 0, idx = -1;
+
+			if ((expanded = switch_event_expand_headers_check(event, vname, var_list, api_list, recur+1)) == vname) {
+				expanded = strdup(vname);
+				switch_assert(expanded);
+			}
+			vname = expanded;
+			switch_expand_parse_name(vname, &offset, &ooffset, &idx);
+
+			dyn = *op;
+			dyn.offset = offset;
+			dyn.ooffset = ooffset;
+			dyn.idx = idx;
+			op = &dyn;
+		}
+
+		/* $${var} always means the global, ${var} only falls back to it */
+		if (op->type == SWITCH_EXPAND_GLOBAL || !(sub_val = switch_event_get_header_idx(event, vname, op->idx))) {
+			if ((gvar = switch_core_get_variable_dup(vname))) {
+				sub_val = gvar;
+			}
+
+			if (var_list && !switch_event_check_permission_list(var_list, vname)) {
+				sub_val = "<Variable Expansion Permission Denied>";
+			}
+
+			if ((expanded_sub_val = switch_event_expand_headers_check(event, sub_val, var_list, api_list, recur+1)) == sub_val) {
+				expanded_sub_val = NULL;
+			} else {
+				sub_val = expanded_sub_val;
+			}
+		}
+
+		if (sub_val) {
+			len = strlen(sub_val);
+			switch_expand_substr(op->offset, op->ooffset, &sub_val, &len);
+			out.raw_write_function(&out, (uint8_t *) sub_val, len);
+		}
+
+		switch_safe_free(expanded_sub_val);
+		switch_safe_free(gvar);
+		switch_safe_free(expanded);
+	}
+
+	switch_safe_free(api_stream.data);
+
+	return out.data;
+}
+
 SWITCH_DECLARE(char *) switch_event_expand_headers_check(switch_event_t *event, const char *in, switch_event_t *var_list, switch_event_t *api_list, uint32_t recur)
 {
 	char *p, *c = NULL;
@@ -2202,6 +3824,7 @@ SWITCH_DECLARE(char *) switch_event_expand_headers_check(switch_event_t *event,
 	char *func_val = NULL;
 	int nv = 0;
 	char *gvar = NULL, *sb = NULL;
+	switch_expand_template_t *tpl;
 
 	if (recur > 100) {
 		return (char *) in;
@@ -2217,6 +3840,12 @@ SWITCH_DECLARE(char *) switch_event_expand_headers_check(switch_event_t *event,
 		return (char *) in;
 	}
 
+	if ((tpl = switch_expand_template_get(in))) {
+		data = event_expand_template(event, tpl, var_list, api_list, recur);
+		switch_expand_template_release(&tpl);
+		return data;
+	}
+
 	nv = 0;
 	olen = strlen(in) + 1;
 	indup = strdup(in);
@@ -0,0 +1,479 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_expand.c -- Compiled variable expansion templates
+ *
+ */
+
+#include <switch.h>
+#include <switch_expand.h>
+
+/* strings longer than this are rare and mostly one offs (bodies, json blobs), they are parsed every time */
+#define EXPAND_KEY_MAX 2048
+/* once full the least recently used template is evicted, if it is still in use it goes away with its last user */
+#define EXPAND_CACHE_MAX 4096
+
+/* a cached template on the lru list, most recently used first */
+typedef struct expand_cache_node_s {
+	switch_expand_template_t *tpl;
+	struct expand_cache_node_s *prev;
+	struct expand_cache_node_s *next;
+	char key[1];
+} expand_cache_node_t;
+
+static struct {
+	switch_mutex_t *mutex;
+	switch_hash_t *hash;
+	expand_cache_node_t *head;
+	expand_cache_node_t *tail;
+	uint32_t count;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t flushes;
+	int running;
+} EXPAND;
+
+static switch_bool_t expand_needed(const char *str)
+{
+	return (!zstr(str) && (switch_string_var_check_const(str) || switch_string_has_escaped_data(str))) ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+SWITCH_DECLARE(void) switch_expand_parse_name(char *name, int *offset, int *ooffset, int *idx)
+{
+	char *ptr;
+
+	if ((ptr = strchr(name, ':'))) {
+		*ptr++ = '\0';
+		*offset = atoi(ptr);
+		if ((ptr = strchr(ptr, ':'))) {
+			ptr++;
+			*ooffset = atoi(ptr);
+		}
+	}
+
+	if ((ptr = strchr(name, '[')) && strchr(ptr, ']')) {
+		*ptr++ = '\0';
+		*idx = atoi(ptr);
+	}
+}
+
+SWITCH_DECLARE(void) switch_expand_substr(int offset, int ooffset, const char **val, switch_size_t *len)
+{
+	if (offset >= 0) {
+		if ((switch_size_t) offset > *len) {
+			*len = 0;
+		} else {
+			*val += offset;
+			*len -= offset;
+		}
+	} else if ((switch_size_t) abs(offset) <= *len) {
+		*val += *len + offset;
+		*len = -offset;
+	}
+
+	if (ooffset > 0 && (switch_size_t) ooffset < *len) {
+		*len = ooffset;
+	}
+}
+
+#define EXPAND_LIT(_ch) do {											\
+		if (!lit) {														\
+			lit = &tpl->ops[tpl->op_count++];							\
+			lit->type = SWITCH_EXPAND_LITERAL;							\
+			lit->str = lp;												\
+		}																\
+		*lp++ = (_ch);													\
+		lit->len++;														\
+		tpl->literal_len++;												\
+	} while (0)
+
+/* the scan is the one switch_channel_expand_variables_check() does, it records what it finds instead of looking it up */
+SWITCH_DECLARE(switch_expand_template_t *) switch_expand_template_compile(const char *in)
+{
+	switch_expand_template_t *tpl;
+	switch_expand_op_t *lit = NULL, *op;
+	switch_size_t ilen, max_ops = 1, size;
+	char *p, *indup, *endof_indup, *lp, *sb;
+	const char *q;
+	size_t vtype = 0, br = 0;
+	int nv = 0;
+
+	switch_assert(in);
+
+	ilen = strlen(in);
+
+	for (q = in; *q; q++) {
+		if (*q == '$') {
+			max_ops += 2;
+		}
+	}
+
+	/* the template, its ops, the scanned copy names and args point into and the literals, each one terminated */
+	size = sizeof(*tpl) + (max_ops * sizeof(switch_expand_op_t)) + (ilen + 1) + (ilen + max_ops);
+	tpl = malloc(size);
+	switch_assert(tpl);
+	memset(tpl, 0, sizeof(*tpl) + (max_ops * sizeof(switch_expand_op_t)));
+
+	tpl->ops = (switch_expand_op_t *) (tpl + 1);
+	indup = (char *) (tpl->ops + max_ops);
+	lp = indup + ilen + 1;
+	memcpy(indup, in, ilen + 1);
+	endof_indup = end_of_p(indup) + 1;
+	tpl->refs = 1;
+
+	for (p = indup; p && p < endof_indup && *p; p++) {
+		int global = 0;
+		vtype = 0;
+
+		if (*p == '\\') {
+			if (*(p + 1) == '$') {
+				nv = 1;
+				p++;
+				if (*(p + 1) == '$') {
+					p++;
+				}
+			} else if (*(p + 1) == '\'') {
+				p++;
+				continue;
+			} else if (*(p + 1) == '\\') {
+				EXPAND_LIT(*p);
+				p++;
+				continue;
+			}
+		}
+
+		if (*p == '$' && !nv) {
+			if (*(p + 1) == '$') {
+				p++;
+				global++;
+			}
+
+			if (*(p + 1)) {
+				if (*(p + 1) == '{') {
+					vtype = global ? 3 : 1;
+				} else {
+					nv = 1;
+				}
+			} else {
+				nv = 1;
+			}
+		}
+
+		if (nv) {
+			EXPAND_LIT(*p);
+			nv = 0;
+			continue;
+		}
+
+		if (vtype) {
+			char *s = p, *e, *vname, *vval = NULL;
+
+			s++;
+
+			if ((vtype == 1 || vtype == 3) && *s == '{') {
+				br = 1;
+				s++;
+			}
+
+			e = s;
+			vname = s;
+			while (*e) {
+				if (br == 1 && *e == '}') {
+					br = 0;
+					*e++ = '\0';
+					break;
+				}
+
+				if (br > 0) {
+					if (e != s && *e == '{') {
+						br++;
+					} else if (br > 1 && *e == '}') {
+						br--;
+					}
+				}
+
+				e++;
+			}
+			p = e > endof_indup ? endof_indup : e;
+
+			vval = NULL;
+			for (sb = vname; sb && *sb; sb++) {
+				if (*sb == ' ') {
+					vval = sb;
+					break;
+				} else if (*sb == '(') {
+					vval = sb;
+					br = 1;
+					break;
+				}
+			}
+
+			if (vval) {
+				e = vval - 1;
+				*vval++ = '\0';
+				while (*e == ' ') {
+					*e-- = '\0';
+				}
+				e = vval;
+
+				while (e && *e) {
+					if (*e == '(') {
+						br++;
+					} else if (br > 1 && *e == ')') {
+						br--;
+					} else if (br == 1 && *e == ')') {
+						*e = '\0';
+						break;
+					}
+					e++;
+				}
+
+				vtype = 2;
+			}
+
+			if (lit) {
+				*lp++ = '\0';
+				lit = NULL;
+			}
+
+			op = &tpl->ops[tpl->op_count++];
+			op->str = vname;
+			op->idx = -1;
+
+			if (vtype == 2) {
+				op->type = SWITCH_EXPAND_API;
+				op->arg = vval;
+				op->expand_str = expand_needed(vname);
+				op->expand_arg = expand_needed(vval);
+			} else {
+				op->type = vtype == 3 ? SWITCH_EXPAND_GLOBAL : SWITCH_EXPAND_VAR;
+				if (!(op->expand_str = expand_needed(vname))) {
+					switch_expand_parse_name(vname, &op->offset, &op->ooffset, &op->idx);
+				}
+			}
+
+			br = 0;
+		}
+
+		if (*p == '$') {
+			p--;
+		} else if (*p) {
+			EXPAND_LIT(*p);
+		}
+	}
+
+	if (lit) {
+		*lp = '\0';
+	}
+
+	return tpl;
+}
+
+static void expand_template_free(switch_expand_template_t *tpl)
+{
+	if (!switch_atomic_dec(&tpl->refs)) {
+		free(tpl);
+	}
+}
+
+SWITCH_DECLARE(void) switch_expand_template_release(switch_expand_template_t **tpl)
+{
+	if (tpl && *tpl) {
+		expand_template_free(*tpl);
+		*tpl = NULL;
+	}
+}
+
+/* the lru helpers are called with the mutex held */
+static void expand_cache_unlink(expand_cache_node_t *node)
+{
+	if (node->prev) {
+		node->prev->next = node->next;
+	} else {
+		EXPAND.head = node->next;
+	}
+
+	if (node->next) {
+		node->next->prev = node->prev;
+	} else {
+		EXPAND.tail = node->prev;
+	}
+
+	node->prev = node->next = NULL;
+}
+
+static void expand_cache_link(expand_cache_node_t *node)
+{
+	node->next = EXPAND.head;
+
+	if (EXPAND.head) {
+		EXPAND.head->prev = node;
+	} else {
+		EXPAND.tail = node;
+	}
+
+	EXPAND.head = node;
+}
+
+static void expand_cache_del(expand_cache_node_t *node)
+{
+	expand_cache_unlink(node);
+	switch_core_hash_delete(EXPAND.hash, node->key);
+	expand_template_free(node->tpl);
+	free(node);
+	EXPAND.count--;
+}
+
+static void expand_cache_flush(void)
+{
+	while (EXPAND.head) {
+		expand_cache_del(EXPAND.head);
+	}
+
+	EXPAND.flushes++;
+}
+
+SWITCH_DECLARE(switch_expand_template_t *) switch_expand_template_get(const char *in)
+{
+	switch_expand_template_t *tpl;
+	expand_cache_node_t *node;
+	switch_size_t len = strlen(in);
+
+	if (!EXPAND.running || len > EXPAND_KEY_MAX) {
+		return NULL;
+	}
+
+	switch_mutex_lock(EXPAND.mutex);
+	if (EXPAND.running && (node = switch_core_hash_find(EXPAND.hash, in))) {
+		if (node != EXPAND.head) {
+			expand_cache_unlink(node);
+			expand_cache_link(node);
+		}
+		tpl = node->tpl;
+		switch_atomic_inc(&tpl->refs);
+		EXPAND.hits++;
+		switch_mutex_unlock(EXPAND.mutex);
+		return tpl;
+	}
+	switch_mutex_unlock(EXPAND.mutex);
+
+	/* compiled outside the lock, if another thread got there first ours is thrown away */
+	tpl = switch_expand_template_compile(in);
+
+	switch_mutex_lock(EXPAND.mutex);
+	if (!EXPAND.running) {
+		switch_mutex_unlock(EXPAND.mutex);
+		free(tpl);
+		return NULL;
+	}
+
+	if ((node = switch_core_hash_find(EXPAND.hash, in))) {
+		free(tpl);
+		tpl = node->tpl;
+	} else {
+		if (EXPAND.count >= EXPAND_CACHE_MAX) {
+			expand_cache_del(EXPAND.tail);
+			EXPAND.evictions++;
+		}
+		node = malloc(sizeof(*node) + len);
+		switch_assert(node);
+		memcpy(node->key, in, len + 1);
+		node->tpl = tpl;
+		node->prev = node->next = NULL;
+		expand_cache_link(node);
+		switch_core_hash_insert(EXPAND.hash, node->key, node);
+		EXPAND.count++;
+		EXPAND.misses++;
+	}
+	switch_atomic_inc(&tpl->refs);
+	switch_mutex_unlock(EXPAND.mutex);
+
+	return tpl;
+}
+
+SWITCH_DECLARE(void) switch_expand_stream_init(switch_stream_handle_t *stream, switch_expand_template_t *tpl)
+{
+	switch_size_t size = tpl->literal_len + 128 * (tpl->op_count + 1);
+
+	memset(stream, 0, sizeof(*stream));
+	stream->data = malloc(size);
+	switch_assert(stream->data);
+	*(char *) stream->data = '\0';
+	stream->end = stream->data;
+	stream->data_size = size;
+	stream->write_function = switch_console_stream_write;
+	stream->raw_write_function = switch_console_stream_raw_write;
+	stream->alloc_len = size;
+	stream->alloc_chunk = size;
+}
+
+SWITCH_DECLARE(void) switch_expand_stats(switch_stream_handle_t *stream, switch_bool_t reset)
+{
+	switch_mutex_lock(EXPAND.mutex);
+	stream->write_function(stream, "templates: %u/%u\nhits: %" SWITCH_UINT64_T_FMT "\nmisses: %" SWITCH_UINT64_T_FMT
+						   "\nevictions: %" SWITCH_UINT64_T_FMT "\nflushes: %" SWITCH_UINT64_T_FMT "\n",
+						   EXPAND.count, EXPAND_CACHE_MAX, EXPAND.hits, EXPAND.misses, EXPAND.evictions, EXPAND.flushes);
+	if (reset && EXPAND.running) {
+		expand_cache_flush();
+		EXPAND.hits = EXPAND.misses = EXPAND.evictions = EXPAND.flushes = 0;
+	}
+	switch_mutex_unlock(EXPAND.mutex);
+}
+
+SWITCH_DECLARE(void) switch_expand_init(switch_memory_pool_t *pool)
+{
+	memset(&EXPAND, 0, sizeof(EXPAND));
+	switch_mutex_init(&EXPAND.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_core_hash_init(&EXPAND.hash);
+	EXPAND.running = 1;
+}
+
+SWITCH_DECLARE(void) switch_expand_shutdown(void)
+{
+	if (!EXPAND.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(EXPAND.mutex);
+	EXPAND.running = 0;
+	expand_cache_flush();
+	switch_core_hash_destroy(&EXPAND.hash);
+	switch_mutex_unlock(EXPAND.mutex);
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -154,9 +154,8 @@ static switch_status_t switch_g711u_encode(switch_codec_t *codec,
 	dbuf = decoded_data;
 	ebuf = encoded_data;
 
-	for (i = 0; i < decoded_data_len / sizeof(short); i++) {
-		ebuf[i] = linear_to_ulaw(dbuf[i]);
-	}
+	i = decoded_data_len / sizeof(short);
+	switch_g711u_encode_block(ebuf, dbuf, i);
 
 	*encoded_data_len = i;
 
@@ -181,9 +180,8 @@ static switch_status_t switch_g711u_decode(switch_codec_t *codec,
 		memset(dbuf, 0, codec->implementation->decoded_bytes_per_packet);
 		*decoded_data_len = codec->implementation->decoded_bytes_per_packet;
 	} else {
-		for (i = 0; i < encoded_data_len; i++) {
-			dbuf[i] = ulaw_to_linear(ebuf[i]);
-		}
+		i = encoded_data_len;
+		switch_g711u_decode_block(dbuf, ebuf, i);
 
 		*decoded_data_len = i * 2;
 	}
@@ -225,9 +223,8 @@ static switch_status_t switch_g711a_encode(switch_codec_t *codec,
 	dbuf = decoded_data;
 	ebuf = encoded_data;
 
-	for (i = 0; i < decoded_data_len / sizeof(short); i++) {
-		ebuf[i] = linear_to_alaw(dbuf[i]);
-	}
+	i = decoded_data_len / sizeof(short);
+	switch_g711a_encode_block(ebuf, dbuf, i);
 
 	*encoded_data_len = i;
 
@@ -252,9 +249,8 @@ static switch_status_t switch_g711a_decode(switch_codec_t *codec,
 		memset(dbuf, 0, codec->implementation->decoded_bytes_per_packet);
 		*decoded_data_len = codec->implementation->decoded_bytes_per_packet;
 	} else {
-		for (i = 0; i < encoded_data_len; i++) {
-			dbuf[i] = alaw_to_linear(ebuf[i]);
-		}
+		i = encoded_data_len;
+		switch_g711a_decode_block(dbuf, ebuf, i);
 
 		*decoded_data_len = i * 2;
 	}
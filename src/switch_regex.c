@@ -33,98 +33,355 @@
 #include <switch.h>
 #include <pcre.h>
 
-SWITCH_DECLARE(switch_regex_t *) switch_regex_compile(const char *pattern,
-													  int options, const char **errorptr, int *erroroffset, const unsigned char *tables)
+/*
+ * A switch_regex_t points to one of these.  The patterns given to switch_regex_perform(), switch_regex_match()
+ * and switch_regex_compile_expression() are compiled and studied once and kept in a bounded cache, least recently
+ * used first out.  Every handle given out holds a reference, the cache another one while the pattern is in it.
+ */
+typedef struct regex_entry_s {
+	pcre *re;
+	pcre_extra *extra;
+	/* the cache key, NULL when the pattern is not cached */
+	char *expression;
+	int refs;
+	struct regex_entry_s *prev;
+	struct regex_entry_s *next;
+} regex_entry_t;
+
+/* longer patterns are not worth a cache slot */
+#define REGEX_KEY_MAX 1024
+#define REGEX_CACHE_MAX 1024
+
+static struct {
+	switch_mutex_t *mutex;
+	switch_hash_t *hash;
+	/* most recently used first */
+	regex_entry_t *head;
+	regex_entry_t *tail;
+	uint32_t count;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	int running;
+} REGEX;
+
+static regex_entry_t *regex_entry_create(pcre *re)
 {
+	regex_entry_t *entry;
+	const char *error = NULL;
+	int options = 0;
+
+	switch_zmalloc(entry, sizeof(*entry));
+	entry->re = re;
+	entry->refs = 1;
+
+#ifdef PCRE_STUDY_JIT_COMPILE
+	options |= PCRE_STUDY_JIT_COMPILE;
+#endif
 
-	return pcre_compile(pattern, options, errorptr, erroroffset, tables);
+	entry->extra = pcre_study(re, options, &error);
 
+	return entry;
 }
 
-SWITCH_DECLARE(int) switch_regex_copy_substring(const char *subject, int *ovector, int stringcount, int stringnumber, char *buffer, int size)
+static void regex_entry_destroy(regex_entry_t *entry)
 {
-	return pcre_copy_substring(subject, ovector, stringcount, stringnumber, buffer, size);
+	if (entry->extra) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+		pcre_free_study(entry->extra);
+#else
+		pcre_free(entry->extra);
+#endif
+	}
+
+	pcre_free(entry->re);
+	switch_safe_free(entry->expression);
+	free(entry);
 }
 
-SWITCH_DECLARE(void) switch_regex_free(void *data)
+static void regex_entry_release(regex_entry_t *entry)
 {
-	pcre_free(data);
+	int refs;
 
+	if (entry->expression && REGEX.mutex) {
+		switch_mutex_lock(REGEX.mutex);
+		refs = --entry->refs;
+		switch_mutex_unlock(REGEX.mutex);
+	} else {
+		refs = --entry->refs;
+	}
+
+	if (!refs) {
+		regex_entry_destroy(entry);
+	}
 }
 
-SWITCH_DECLARE(int) switch_regex_perform(const char *field, const char *expression, switch_regex_t **new_re, int *ovector, uint32_t olen)
+static void regex_lru_unlink(regex_entry_t *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		REGEX.head = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else {
+		REGEX.tail = entry->prev;
+	}
+
+	entry->prev = entry->next = NULL;
+}
+
+static void regex_lru_push(regex_entry_t *entry)
+{
+	entry->prev = NULL;
+	entry->next = REGEX.head;
+
+	if (REGEX.head) {
+		REGEX.head->prev = entry;
+	} else {
+		REGEX.tail = entry;
+	}
+
+	REGEX.head = entry;
+}
+
+/* call with the mutex held, the entry goes once its last handle is freed */
+static void regex_cache_remove(regex_entry_t *entry)
+{
+	switch_core_hash_delete(REGEX.hash, entry->expression);
+	regex_lru_unlink(entry);
+	REGEX.count--;
+
+	if (!--entry->refs) {
+		regex_entry_destroy(entry);
+	}
+}
+
+static void regex_cache_flush(void)
+{
+	while (REGEX.head) {
+		regex_cache_remove(REGEX.head);
+	}
+}
+
+/* the /re/flags options, tmp holds the pattern without the delimiters when there are some */
+static const char *regex_parse_flags(const char *expression, char **tmp, int *flags)
+{
+	char *opts = NULL;
+
+	*flags = 0;
+
+	if (*expression != '/') {
+		return expression;
+	}
+
+	*tmp = strdup(expression + 1);
+	assert(*tmp);
+
+	if (!(opts = strrchr(*tmp, '/'))) {
+		/* Note our error */
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR,
+						  "Regular Expression Error expression[%s] missing ending '/' delimeter\n", expression);
+		return NULL;
+	}
+
+	*opts++ = '\0';
+
+	if (strchr(opts, 'i')) {
+		*flags |= PCRE_CASELESS;
+	}
+	if (strchr(opts, 's')) {
+		*flags |= PCRE_DOTALL;
+	}
+
+	return *tmp;
+}
+
+static regex_entry_t *regex_compile_entry(const char *expression)
 {
 	const char *error = NULL;
 	int erroffset = 0;
 	pcre *re = NULL;
-	int match_count = 0;
 	char *tmp = NULL;
-	uint32_t flags = 0;
+	int flags = 0;
 	char abuf[256] = "";
+	const char *pattern = expression;
+	regex_entry_t *entry = NULL;
 
-	if (!(field && expression)) {
-		return 0;
-	}
-
-	if (*expression == '_') {
-		if (switch_ast2regex(expression + 1, abuf, sizeof(abuf))) {
-			expression = abuf;
+	if (*pattern == '_') {
+		if (switch_ast2regex(pattern + 1, abuf, sizeof(abuf))) {
+			pattern = abuf;
 		}
 	}
 
-	if (*expression == '/') {
-		char *opts = NULL;
-		tmp = strdup(expression + 1);
-		assert(tmp);
-		if ((opts = strrchr(tmp, '/'))) {
-			*opts++ = '\0';
-		} else {
-			/* Note our error */
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR,
-							  "Regular Expression Error expression[%s] missing ending '/' delimeter\n", expression);
-			goto end;
-		}
-		expression = tmp;
-		if (opts) {
-			if (strchr(opts, 'i')) {
-				flags |= PCRE_CASELESS;
-			}
-			if (strchr(opts, 's')) {
-				flags |= PCRE_DOTALL;
-			}
-		}
+	if (!(pattern = regex_parse_flags(pattern, &tmp, &flags))) {
+		goto end;
 	}
 
-	re = pcre_compile(expression,	/* the pattern */
+	re = pcre_compile(pattern,	/* the pattern */
 					  flags,	/* default options */
 					  &error,	/* for error message */
 					  &erroffset,	/* for error offset */
 					  NULL);	/* use default character tables */
 	if (error) {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "COMPILE ERROR: %d [%s][%s]\n", erroffset, error, expression);
-		switch_regex_safe_free(re);
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "COMPILE ERROR: %d [%s][%s]\n", erroffset, error, pattern);
+		if (re) {
+			pcre_free(re);
+		}
 		goto end;
 	}
 
-	match_count = pcre_exec(re,	/* result of pcre_compile() */
-							NULL,	/* we didn't study the pattern */
-							field,	/* the subject string */
-							(int) strlen(field),	/* the length of the subject string */
+	entry = regex_entry_create(re);
+
+  end:
+	switch_safe_free(tmp);
+	return entry;
+}
+
+/* a referenced entry for expression, from the cache when possible */
+static regex_entry_t *regex_cache_get(const char *expression)
+{
+	regex_entry_t *entry, *old;
+
+	if (!REGEX.running || strlen(expression) > REGEX_KEY_MAX) {
+		return regex_compile_entry(expression);
+	}
+
+	switch_mutex_lock(REGEX.mutex);
+	if ((entry = switch_core_hash_find(REGEX.hash, expression))) {
+		entry->refs++;
+		REGEX.hits++;
+
+		if (entry != REGEX.head) {
+			regex_lru_unlink(entry);
+			regex_lru_push(entry);
+		}
+		switch_mutex_unlock(REGEX.mutex);
+		return entry;
+	}
+	REGEX.misses++;
+	switch_mutex_unlock(REGEX.mutex);
+
+	/* compile outside of the lock, if another thread beat us to it the first one in wins */
+	if (!(entry = regex_compile_entry(expression))) {
+		return NULL;
+	}
+
+	switch_mutex_lock(REGEX.mutex);
+	if (!REGEX.running) {
+		switch_mutex_unlock(REGEX.mutex);
+		return entry;
+	}
+
+	if ((old = switch_core_hash_find(REGEX.hash, expression))) {
+		old->refs++;
+		switch_mutex_unlock(REGEX.mutex);
+		regex_entry_destroy(entry);
+		return old;
+	}
+
+	entry->expression = strdup(expression);
+	entry->refs++;
+	switch_core_hash_insert(REGEX.hash, entry->expression, entry);
+	regex_lru_push(entry);
+
+	if (++REGEX.count > REGEX_CACHE_MAX) {
+		REGEX.evictions++;
+		regex_cache_remove(REGEX.tail);
+	}
+	switch_mutex_unlock(REGEX.mutex);
+
+	return entry;
+}
+
+static int regex_entry_exec(regex_entry_t *entry, const char *subject, int options, int *ovector, int olen)
+{
+	int match_count;
+
+	match_count = pcre_exec(entry->re,	/* result of pcre_compile() */
+							entry->extra,	/* result of pcre_study(), the jit code when there is some */
+							subject,	/* the subject string */
+							(int) strlen(subject),	/* the length of the subject string */
 							0,	/* start at offset 0 in the subject */
-							0,	/* default options */
+							options,	/* default options */
 							ovector,	/* vector of integers for substring information */
 							olen);	/* number of elements (NOT size in bytes) */
 
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+	if (match_count == PCRE_ERROR_JIT_STACKLIMIT) {
+		/* the interpreter is slower but not limited by the jit stack */
+		match_count = pcre_exec(entry->re, NULL, subject, (int) strlen(subject), 0, options, ovector, olen);
+	}
+#endif
 
-	if (match_count <= 0) {
+	return match_count;
+}
+
+SWITCH_DECLARE(switch_regex_t *) switch_regex_compile(const char *pattern,
+													  int options, const char **errorptr, int *erroroffset, const unsigned char *tables)
+{
+	pcre *re;
+
+	if (!(re = pcre_compile(pattern, options, errorptr, erroroffset, tables))) {
+		return NULL;
+	}
+
+	return (switch_regex_t *) regex_entry_create(re);
+}
+
+SWITCH_DECLARE(int) switch_regex_copy_substring(const char *subject, int *ovector, int stringcount, int stringnumber, char *buffer, int size)
+{
+	return pcre_copy_substring(subject, ovector, stringcount, stringnumber, buffer, size);
+}
+
+SWITCH_DECLARE(void) switch_regex_free(void *data)
+{
+	regex_entry_release((regex_entry_t *) data);
+}
+
+SWITCH_DECLARE(switch_regex_t *) switch_regex_compile_expression(const char *expression)
+{
+	if (!expression) {
+		return NULL;
+	}
+
+	return (switch_regex_t *) regex_cache_get(expression);
+}
+
+SWITCH_DECLARE(int) switch_regex_exec(switch_regex_t *re, const char *field, int *ovector, uint32_t olen)
+{
+	int match_count;
+
+	if (!(re && field)) {
+		return 0;
+	}
+
+	match_count = regex_entry_exec((regex_entry_t *) re, field, 0, ovector, olen);
+
+	return match_count > 0 ? match_count : 0;
+}
+
+SWITCH_DECLARE(int) switch_regex_perform(const char *field, const char *expression, switch_regex_t **new_re, int *ovector, uint32_t olen)
+{
+	switch_regex_t *re = NULL;
+	int match_count = 0;
+
+	if (!(field && expression)) {
+		return 0;
+	}
+
+	if (!(re = switch_regex_compile_expression(expression))) {
+		return 0;
+	}
+
+	if (!(match_count = switch_regex_exec(re, field, ovector, olen))) {
 		switch_regex_safe_free(re);
-		match_count = 0;
 	}
 
-	*new_re = (switch_regex_t *) re;
+	*new_re = re;
 
-  end:
-	switch_safe_free(tmp);
 	return match_count;
 }
 
@@ -211,53 +468,45 @@ SWITCH_DECLARE(switch_status_t) switch_regex_match_partial(const char *target, c
 {
 	const char *error = NULL;	/* Used to hold any errors                                           */
 	int error_offset = 0;		/* Holds the offset of an error                                      */
-	pcre *pcre_prepared = NULL;	/* Holds the compiled regex                                          */
+	regex_entry_t *entry = NULL;	/* Holds the compiled regex                                          */
 	int match_count = 0;		/* Number of times the regex was matched                             */
 	int offset_vectors[255];	/* not used, but has to exist or pcre won't even try to find a match */
 	int pcre_flags = 0;
-	uint32_t flags = 0;
+	int flags = 0;
 	char *tmp = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	if (*expression == '/') {
-		char *opts = NULL;
-		tmp = strdup(expression + 1);
-		assert(tmp);
-		if ((opts = strrchr(tmp, '/'))) {
-			*opts++ = '\0';
-		} else {
-			/* Note our error */
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR,
-							  "Regular Expression Error expression[%s] missing ending '/' delimeter\n", expression);
+	if (*expression != '_') {
+		/* the same pattern switch_regex_compile_expression() would make, so it can come from the cache */
+		if (!(entry = regex_cache_get(expression))) {
 			goto end;
 		}
-		expression = tmp;
-		if (opts) {
-			if (strchr(opts, 'i')) {
-				flags |= PCRE_CASELESS;
-			}
-			if (strchr(opts, 's')) {
-				flags |= PCRE_DOTALL;
-			}
+	} else {
+		pcre *pcre_prepared = NULL;
+
+		if (!(expression = regex_parse_flags(expression, &tmp, &flags))) {
+			goto end;
 		}
-	}
 
-	/* Compile the expression */
-	pcre_prepared = pcre_compile(expression, flags, &error, &error_offset, NULL);
+		/* Compile the expression */
+		pcre_prepared = pcre_compile(expression, flags, &error, &error_offset, NULL);
+
+		/* See if there was an error in the expression */
+		if (error != NULL) {
+			/* Clean up after ourselves */
+			if (pcre_prepared) {
+				pcre_free(pcre_prepared);
+				pcre_prepared = NULL;
+			}
+			/* Note our error */
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR,
+							  "Regular Expression Error expression[%s] error[%s] location[%d]\n", expression, error, error_offset);
 
-	/* See if there was an error in the expression */
-	if (error != NULL) {
-		/* Clean up after ourselves */
-		if (pcre_prepared) {
-			pcre_free(pcre_prepared);
-			pcre_prepared = NULL;
+			/* We definitely didn't match anything */
+			goto end;
 		}
-		/* Note our error */
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR,
-						  "Regular Expression Error expression[%s] error[%s] location[%d]\n", expression, error, error_offset);
 
-		/* We definitely didn't match anything */
-		goto end;
+		entry = regex_entry_create(pcre_prepared);
 	}
 
 	if (*partial) {
@@ -265,14 +514,10 @@ SWITCH_DECLARE(switch_status_t) switch_regex_match_partial(const char *target, c
 	}
 
 	/* So far so good, run the regex */
-	match_count =
-		pcre_exec(pcre_prepared, NULL, target, (int) strlen(target), 0, pcre_flags, offset_vectors, sizeof(offset_vectors) / sizeof(offset_vectors[0]));
+	match_count = regex_entry_exec(entry, target, pcre_flags, offset_vectors, sizeof(offset_vectors) / sizeof(offset_vectors[0]));
 
 	/* Clean up */
-	if (pcre_prepared) {
-		pcre_free(pcre_prepared);
-		pcre_prepared = NULL;
-	}
+	regex_entry_release(entry);
 
 	/* switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "number of matches: %d\n", match_count); */
 
@@ -298,6 +543,49 @@ SWITCH_DECLARE(switch_status_t) switch_regex_match(const char *target, const cha
 	return switch_regex_match_partial(target, expression, &partial);
 }
 
+SWITCH_DECLARE(void) switch_regex_cache_stats(switch_stream_handle_t *stream, switch_bool_t reset)
+{
+	if (!REGEX.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(REGEX.mutex);
+	stream->write_function(stream, "patterns: %u/%u\nhits: %" SWITCH_UINT64_T_FMT "\nmisses: %" SWITCH_UINT64_T_FMT "\nevictions: %" SWITCH_UINT64_T_FMT "\njit: %s\n",
+						   REGEX.count, REGEX_CACHE_MAX, REGEX.hits, REGEX.misses, REGEX.evictions,
+#ifdef PCRE_STUDY_JIT_COMPILE
+						   "yes"
+#else
+						   "no"
+#endif
+						   );
+	if (reset && REGEX.running) {
+		regex_cache_flush();
+		REGEX.hits = REGEX.misses = REGEX.evictions = 0;
+	}
+	switch_mutex_unlock(REGEX.mutex);
+}
+
+SWITCH_DECLARE(void) switch_regex_init(switch_memory_pool_t *pool)
+{
+	memset(&REGEX, 0, sizeof(REGEX));
+	switch_mutex_init(&REGEX.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_core_hash_init(&REGEX.hash);
+	REGEX.running = 1;
+}
+
+SWITCH_DECLARE(void) switch_regex_shutdown(void)
+{
+	if (!REGEX.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(REGEX.mutex);
+	REGEX.running = 0;
+	regex_cache_flush();
+	switch_core_hash_destroy(&REGEX.hash);
+	switch_mutex_unlock(REGEX.mutex);
+}
+
 SWITCH_DECLARE_NONSTD(void) switch_regex_set_var_callback(const char *var, const char *val, void *user_data)
 {
 	switch_core_session_t *session = (switch_core_session_t *) user_data;
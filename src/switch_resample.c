@@ -32,6 +32,7 @@
 
 #include <switch.h>
 #include <switch_resample.h>
+#include <switch_simd.h>
 #ifndef WIN32
 #include <switch_private.h>
 #endif
@@ -230,8 +231,7 @@ SWITCH_DECLARE(void) switch_generate_sln_silence(int16_t *data, uint32_t samples
 
 SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16_t *other_data, uint32_t other_samples, int channels)
 {
-	int i;
-	int32_t x, z;
+	int32_t x;
 
 	if (channels == 0) channels = 1;
 
@@ -241,11 +241,7 @@ SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16
 		x = samples;
 	}
 
-	for (i = 0; i < x * channels; i++) {
-		z = data[i] + other_data[i];
-		switch_normalize_to_16bit(z);
-		data[i] = (int16_t) z;
-	}
+	switch_sln_add_saturate(data, other_data, x * channels);
 
 	return x;
 }
@@ -253,7 +249,6 @@ SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16
 
 SWITCH_DECLARE(uint32_t) switch_unmerge_sln(int16_t *data, uint32_t samples, int16_t *other_data, uint32_t other_samples, int channels)
 {
-	int i;
 	int32_t x;
 
 	if (channels == 0) channels = 1;
@@ -264,9 +259,7 @@ SWITCH_DECLARE(uint32_t) switch_unmerge_sln(int16_t *data, uint32_t samples, int
 		x = samples;
 	}
 
-	for (i = 0; i < x * channels; i++) {
-		data[i] -= other_data[i];
-	}
+	switch_sln_subtract(data, other_data, x * channels);
 
 	return x;
 }
@@ -278,7 +271,11 @@ SWITCH_DECLARE(void) switch_mux_channels(int16_t *data, switch_size_t samples, u
 
 	switch_assert(channels < 11);
 
-	if (orig_channels > channels) {
+	if (orig_channels == 2 && channels == 1) {
+		switch_sln_downmix_stereo(data, (uint32_t) samples);
+	} else if (orig_channels == 1 && channels == 2) {
+		switch_sln_upmix_mono(data, (uint32_t) samples);
+	} else if (orig_channels > channels) {
 		for (i = 0; i < samples; i++) {
 			int32_t z = 0;
 			for (j = 0; j < orig_channels; j++) {
@@ -348,15 +345,7 @@ SWITCH_DECLARE(void) switch_change_sln_volume_granular(int16_t *data, uint32_t s
 	newrate = chart[i];
 
 	if (newrate) {
-		int32_t tmp;
-		uint32_t x;
-		int16_t *fp = data;
-
-		for (x = 0; x < samples; x++) {
-			tmp = (int32_t) (fp[x] * newrate);
-			switch_normalize_to_16bit(tmp);
-			fp[x] = (int16_t) tmp;
-		}
+		switch_sln_scale(data, samples, newrate);
 	} else {
 		memset(data, 0, samples * 2);
 	}
@@ -387,15 +376,7 @@ SWITCH_DECLARE(void) switch_change_sln_volume(int16_t *data, uint32_t samples, i
 	newrate = chart[i];
 
 	if (newrate) {
-		int32_t tmp;
-		uint32_t x;
-		int16_t *fp = data;
-
-		for (x = 0; x < samples; x++) {
-			tmp = (int32_t) (fp[x] * newrate);
-			switch_normalize_to_16bit(tmp);
-			fp[x] = (int16_t) tmp;
-		}
+		switch_sln_scale(data, samples, newrate);
 	}
 }
 
@@ -42,6 +42,17 @@
 #endif
 #include <switch_stun.h>
 #include <apr_network_io.h>
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SYS_EPOLL_H)
+#define RTP_BATCH_RECV
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_SENDMMSG
+#define RTP_BATCH_SEND
+#include <netinet/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#endif
 #undef PACKAGE_NAME
 #undef PACKAGE_STRING
 #undef PACKAGE_TARNAME
@@ -116,6 +127,7 @@ typedef struct {
 } rtp_msg_t;
 
 #define RTP_BODY(_s) (char *) (_s->recv_msg.ebody ? _s->recv_msg.ebody : _s->recv_msg.body)
+#define rtp_count_copy(_s, _stage, _bytes) do { if (_s->session) switch_core_session_get_copy_stats(_s->session)->_stage += (_bytes); } while(0)
 
 typedef struct {
 	uint32_t ssrc;
@@ -445,6 +457,9 @@ struct switch_rtp {
 	uint8_t has_ice;
 	uint8_t punts;
 	uint8_t clean;
+	struct rtp_batch_rx_s *batch_rx;
+	struct rtp_batch_sender_s *batch_tx;
+	uint64_t batch_tx_last;
 #ifdef ENABLE_ZRTP
 	zrtp_session_t *zrtp_session;
 	zrtp_profile_t *zrtp_profile;
@@ -745,8 +760,8 @@ static handle_rfc2833_result_t handle_rfc2833(switch_rtp_t *rtp_session, switch_
 
 static int rtp_write_ready(switch_rtp_t *rtp_session, uint32_t bytes, int line);
 static int global_init = 0;
-static int rtp_common_write(switch_rtp_t *rtp_session,
-							rtp_msg_t *send_msg, void *data, uint32_t datalen, switch_payload_t payload, uint32_t timestamp, switch_frame_flag_t *flags);
+static int rtp_common_write(switch_rtp_t *rtp_session, rtp_msg_t *send_msg, rtp_msg_t *recv_msg,
+							void *data, uint32_t datalen, switch_payload_t payload, uint32_t timestamp, switch_frame_flag_t *flags);
 
 
 static switch_status_t ice_out(switch_rtp_t *rtp_session, switch_rtp_ice_t *ice)
@@ -1281,13 +1296,15 @@ SWITCH_STANDARD_SCHED_FUNC(zrtp_cache_save_callback)
 	task->runtime = switch_epoch_time_now(NULL) + 900;
 }
 
+static switch_status_t rtp_sendto(switch_rtp_t *rtp_session, void *data, switch_size_t *bytes);
+
 static int zrtp_send_rtp_callback(const zrtp_stream_t *stream, char *rtp_packet, unsigned int rtp_packet_length)
 {
 	switch_rtp_t *rtp_session = zrtp_stream_get_userdata(stream);
 	switch_size_t len = rtp_packet_length;
 	zrtp_status_t status = zrtp_status_ok;
 
-	switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, rtp_packet, &len);
+	rtp_sendto(rtp_session, rtp_packet, &len);
 	return status;
 }
 
@@ -1420,6 +1437,951 @@ static void zrtp_logger(int level, const char *data, int len, int offset)
 }
 #endif
 
+/* 
+ * Batched receive: a small pool of poller threads (one per core by default) wait on many RTP sockets
+ * with epoll and drain them with recvmmsg() into a per-session ring, the media thread then reads
+ * from the ring instead of doing its own poll()/recvfrom() per packet.
+ *
+ * Batched send: the media thread queues its packets on a per-core send ring and a sender thread
+ * flushes whatever accumulated with one sendmmsg() per socket, or one UDP_SEGMENT (GSO) sendmsg()
+ * when a run of equal sized packets goes to the same destination (video frames).
+ */
+
+static struct {
+	uint32_t threads;
+	uint32_t running;
+	uint32_t gen;
+	struct rtp_batch_poller_s **pollers;
+	uint32_t poller_count;
+	uint32_t send_threads;
+	uint32_t send_running;
+	struct rtp_batch_sender_s **senders;
+	uint32_t sender_count;
+	switch_mutex_t *mutex;
+	switch_memory_pool_t *pool;
+} rtp_batch_globals;
+
+SWITCH_DECLARE(void) switch_rtp_set_batch_recv_threads(uint32_t threads)
+{
+	if (rtp_batch_globals.running) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Batched RTP receive is already running with %u threads\n",
+						  rtp_batch_globals.poller_count);
+		return;
+	}
+
+	rtp_batch_globals.threads = threads;
+}
+
+SWITCH_DECLARE(void) switch_rtp_set_batch_send_threads(uint32_t threads)
+{
+	if (rtp_batch_globals.send_running) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Batched RTP send is already running with %u threads\n",
+						  rtp_batch_globals.sender_count);
+		return;
+	}
+
+	rtp_batch_globals.send_threads = threads;
+}
+
+#ifdef RTP_BATCH_RECV
+
+#define RTP_BATCH_RING_LEN 16
+#define RTP_BATCH_SLOT_LEN 1536
+#define RTP_BATCH_VLEN 16
+#define RTP_BATCH_MAX_EVENTS 256
+
+typedef struct rtp_batch_slot_s {
+	uint32_t len;
+	socklen_t addrlen;
+	struct sockaddr_storage addr;
+	char data[RTP_BATCH_SLOT_LEN];
+} rtp_batch_slot_t;
+
+typedef struct rtp_batch_poller_s {
+	int epfd;
+	int cpu;
+	uint32_t count;
+	struct rtp_batch_rx_s **table;
+	uint32_t table_size;
+	uint64_t packets;
+	uint64_t syscalls;
+	uint64_t truncated;
+	uint64_t stalls;
+	switch_mutex_t *mutex;
+	switch_thread_t *thread;
+} rtp_batch_poller_t;
+
+typedef struct rtp_batch_rx_s {
+	rtp_batch_poller_t *poller;
+	int fd;
+	uint32_t idx;
+	uint32_t gen;
+	uint8_t registered;
+	uint8_t stalled;
+	uint32_t head;
+	uint32_t tail;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	rtp_batch_slot_t slots[RTP_BATCH_RING_LEN];
+} rtp_batch_rx_t;
+
+static void rtp_batch_drain(rtp_batch_poller_t *poller, rtp_batch_rx_t *rx, struct mmsghdr *msgs, struct iovec *iov)
+{
+	for (;;) {
+		uint32_t head, space, i;
+		int got;
+
+		switch_mutex_lock(rx->mutex);
+		head = rx->head;
+		space = RTP_BATCH_RING_LEN - (rx->head - rx->tail);
+		if (!space) {
+			/* leave the rest in the kernel, the reader rearms the socket once it catches up */
+			rx->stalled = 1;
+		}
+		switch_mutex_unlock(rx->mutex);
+
+		if (!space) {
+			poller->stalls++;
+			break;
+		}
+
+		if (space > RTP_BATCH_VLEN) {
+			space = RTP_BATCH_VLEN;
+		}
+
+		for (i = 0; i < space; i++) {
+			rtp_batch_slot_t *slot = &rx->slots[(head + i) % RTP_BATCH_RING_LEN];
+
+			iov[i].iov_base = slot->data;
+			iov[i].iov_len = sizeof(slot->data);
+			memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_name = &slot->addr;
+			msgs[i].msg_hdr.msg_namelen = sizeof(slot->addr);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		got = recvmmsg(rx->fd, msgs, space, MSG_DONTWAIT, NULL);
+		poller->syscalls++;
+
+		if (got <= 0) {
+			break;
+		}
+
+		for (i = 0; i < (uint32_t) got; i++) {
+			rtp_batch_slot_t *slot = &rx->slots[(head + i) % RTP_BATCH_RING_LEN];
+
+			if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+				/* too big for a slot, the reader skips empty slots */
+				poller->truncated++;
+				slot->len = 0;
+				continue;
+			}
+
+			slot->len = msgs[i].msg_len;
+			slot->addrlen = msgs[i].msg_hdr.msg_namelen;
+		}
+
+		poller->packets += got;
+
+		switch_mutex_lock(rx->mutex);
+		rx->head += got;
+		switch_thread_cond_signal(rx->cond);
+		switch_mutex_unlock(rx->mutex);
+
+		if ((uint32_t) got < space) {
+			break;
+		}
+	}
+}
+
+static void *SWITCH_THREAD_FUNC rtp_batch_poller_thread(switch_thread_t *thread, void *obj)
+{
+	rtp_batch_poller_t *poller = (rtp_batch_poller_t *) obj;
+	struct epoll_event events[RTP_BATCH_MAX_EVENTS];
+	struct mmsghdr msgs[RTP_BATCH_VLEN];
+	struct iovec iov[RTP_BATCH_VLEN];
+
+	if (poller->cpu > -1) {
+		switch_core_thread_set_cpu_affinity(poller->cpu);
+	}
+
+	while (rtp_batch_globals.running) {
+		int i, n = epoll_wait(poller->epfd, events, RTP_BATCH_MAX_EVENTS, 100);
+
+		if (n <= 0) {
+			continue;
+		}
+
+		switch_mutex_lock(poller->mutex);
+		for (i = 0; i < n; i++) {
+			uint32_t idx = (uint32_t) (events[i].data.u64 & 0xffffffff);
+			uint32_t gen = (uint32_t) (events[i].data.u64 >> 32);
+			rtp_batch_rx_t *rx;
+
+			/* the socket may have been unregistered since epoll_wait returned */
+			if (idx < poller->table_size && (rx = poller->table[idx]) && rx->gen == gen) {
+				rtp_batch_drain(poller, rx, msgs, iov);
+			}
+		}
+		switch_mutex_unlock(poller->mutex);
+	}
+
+	return NULL;
+}
+
+static switch_status_t rtp_batch_start(void)
+{
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	uint32_t i;
+
+	switch_mutex_lock(rtp_batch_globals.mutex);
+
+	if (rtp_batch_globals.running) {
+		goto end;
+	}
+
+	if (!rtp_batch_globals.threads) {
+		status = SWITCH_STATUS_FALSE;
+		goto end;
+	}
+
+	rtp_batch_globals.pollers = switch_core_alloc(rtp_batch_globals.pool, sizeof(rtp_batch_poller_t *) * rtp_batch_globals.threads);
+	rtp_batch_globals.running = 1;
+
+	for (i = 0; i < rtp_batch_globals.threads; i++) {
+		rtp_batch_poller_t *poller = switch_core_alloc(rtp_batch_globals.pool, sizeof(*poller));
+		switch_threadattr_t *thd_attr = NULL;
+
+		if ((poller->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error creating epoll set for RTP poller %u: %s\n", i, strerror(errno));
+			break;
+		}
+
+		poller->cpu = switch_core_cpu_count() > 1 ? (int) (i % switch_core_cpu_count()) : -1;
+		switch_mutex_init(&poller->mutex, SWITCH_MUTEX_NESTED, rtp_batch_globals.pool);
+
+		switch_threadattr_create(&thd_attr, rtp_batch_globals.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+		switch_thread_create(&poller->thread, thd_attr, rtp_batch_poller_thread, poller, rtp_batch_globals.pool);
+
+		rtp_batch_globals.pollers[rtp_batch_globals.poller_count++] = poller;
+	}
+
+	if (!rtp_batch_globals.poller_count) {
+		rtp_batch_globals.running = 0;
+		status = SWITCH_STATUS_FALSE;
+	} else {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Started %u batched RTP receive threads\n", rtp_batch_globals.poller_count);
+	}
+
+ end:
+
+	switch_mutex_unlock(rtp_batch_globals.mutex);
+
+	return status;
+}
+
+static void rtp_batch_stop(void)
+{
+	uint32_t i;
+	switch_status_t st;
+
+	switch_mutex_lock(rtp_batch_globals.mutex);
+
+	if (!rtp_batch_globals.running) {
+		switch_mutex_unlock(rtp_batch_globals.mutex);
+		return;
+	}
+
+	rtp_batch_globals.running = 0;
+	switch_mutex_unlock(rtp_batch_globals.mutex);
+
+	for (i = 0; i < rtp_batch_globals.poller_count; i++) {
+		rtp_batch_poller_t *poller = rtp_batch_globals.pollers[i];
+
+		switch_thread_join(&st, poller->thread);
+		close(poller->epfd);
+		switch_safe_free(poller->table);
+	}
+
+	rtp_batch_globals.poller_count = 0;
+}
+
+static switch_status_t rtp_batch_register(switch_rtp_t *rtp_session)
+{
+	rtp_batch_rx_t *rx = rtp_session->batch_rx;
+	rtp_batch_poller_t *poller = NULL;
+	switch_os_socket_t fd;
+	struct epoll_event ev = { 0 };
+	uint32_t i, idx;
+
+	if (rtp_batch_start() != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (switch_os_sock_get(&fd, rtp_session->sock_input) != SWITCH_STATUS_SUCCESS || fd < 0) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!rx) {
+		rx = switch_core_alloc(rtp_session->pool, sizeof(*rx));
+		switch_mutex_init(&rx->mutex, SWITCH_MUTEX_NESTED, rtp_session->pool);
+		switch_thread_cond_create(&rx->cond, rtp_session->pool);
+		rtp_session->batch_rx = rx;
+	}
+
+	switch_mutex_lock(rtp_batch_globals.mutex);
+	for (i = 0; i < rtp_batch_globals.poller_count; i++) {
+		if (!poller || rtp_batch_globals.pollers[i]->count < poller->count) {
+			poller = rtp_batch_globals.pollers[i];
+		}
+	}
+	rx->gen = ++rtp_batch_globals.gen;
+	switch_mutex_unlock(rtp_batch_globals.mutex);
+
+	switch_mutex_lock(poller->mutex);
+
+	for (idx = 0; idx < poller->table_size; idx++) {
+		if (!poller->table[idx]) {
+			break;
+		}
+	}
+
+	if (idx == poller->table_size) {
+		uint32_t new_size = poller->table_size ? poller->table_size * 2 : 128;
+		rtp_batch_rx_t **table = realloc(poller->table, sizeof(*table) * new_size);
+
+		switch_assert(table);
+		memset(table + poller->table_size, 0, sizeof(*table) * (new_size - poller->table_size));
+		poller->table = table;
+		poller->table_size = new_size;
+	}
+
+	switch_mutex_lock(rx->mutex);
+	rx->poller = poller;
+	rx->fd = fd;
+	rx->idx = idx;
+	rx->head = rx->tail = 0;
+	rx->stalled = 0;
+	rx->registered = 1;
+	switch_mutex_unlock(rx->mutex);
+
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.u64 = ((uint64_t) rx->gen << 32) | idx;
+
+	if (epoll_ctl(poller->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		switch_mutex_lock(rx->mutex);
+		rx->registered = 0;
+		rx->poller = NULL;
+		switch_mutex_unlock(rx->mutex);
+		switch_mutex_unlock(poller->mutex);
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR, "%s cannot add socket to RTP poller: %s\n",
+						  rtp_session_name(rtp_session), strerror(errno));
+		return SWITCH_STATUS_FALSE;
+	}
+
+	poller->table[idx] = rx;
+	poller->count++;
+
+	switch_mutex_unlock(poller->mutex);
+
+	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG, "%s using batched RTP receive\n",
+					  rtp_session_name(rtp_session));
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void rtp_batch_unregister(switch_rtp_t *rtp_session)
+{
+	rtp_batch_rx_t *rx = rtp_session->batch_rx;
+	rtp_batch_poller_t *poller;
+
+	if (!rx || !(poller = rx->poller)) {
+		return;
+	}
+
+	switch_mutex_lock(poller->mutex);
+	if (rx->registered && poller->table[rx->idx] == rx) {
+		epoll_ctl(poller->epfd, EPOLL_CTL_DEL, rx->fd, NULL);
+		poller->table[rx->idx] = NULL;
+		poller->count--;
+	}
+	switch_mutex_unlock(poller->mutex);
+
+	/* wake up a reader waiting on the ring */
+	switch_mutex_lock(rx->mutex);
+	rx->registered = 0;
+	rx->poller = NULL;
+	rx->head = rx->tail = 0;
+	switch_thread_cond_broadcast(rx->cond);
+	switch_mutex_unlock(rx->mutex);
+}
+
+static void rtp_batch_rearm(rtp_batch_rx_t *rx)
+{
+	rtp_batch_poller_t *poller = rx->poller;
+	struct epoll_event ev = { 0 };
+
+	if (!poller) {
+		return;
+	}
+
+	/* EPOLL_CTL_MOD on an edge triggered fd reports it again if data is still pending */
+	switch_mutex_lock(poller->mutex);
+	if (rx->registered && poller->table[rx->idx] == rx) {
+		ev.events = EPOLLIN | EPOLLET;
+		ev.data.u64 = ((uint64_t) rx->gen << 32) | rx->idx;
+		epoll_ctl(poller->epfd, EPOLL_CTL_MOD, rx->fd, &ev);
+	}
+	switch_mutex_unlock(poller->mutex);
+}
+
+static int rtp_batch_eligible(switch_rtp_t *rtp_session)
+{
+	return rtp_session->flags[SWITCH_RTP_FLAG_BATCH_RECV] &&
+		!rtp_session->flags[SWITCH_RTP_FLAG_VIDEO] &&
+		!rtp_session->flags[SWITCH_RTP_FLAG_UDPTL] &&
+		rtp_session->sock_input &&
+		rtp_session->rtcp_sock_input != rtp_session->sock_input;
+}
+
+static void rtp_batch_check(switch_rtp_t *rtp_session)
+{
+	int active = rtp_session->batch_rx && rtp_session->batch_rx->registered;
+
+	if (rtp_batch_eligible(rtp_session)) {
+		if (!active && rtp_batch_register(rtp_session) != SWITCH_STATUS_SUCCESS) {
+			/* fall back to reading the socket directly for the rest of the call */
+			rtp_session->flags[SWITCH_RTP_FLAG_BATCH_RECV] = 0;
+		}
+	} else if (active) {
+		rtp_batch_unregister(rtp_session);
+	}
+}
+
+static switch_status_t rtp_batch_poll(rtp_batch_rx_t *rx, int32_t timeout)
+{
+	switch_status_t status = SWITCH_STATUS_TIMEOUT;
+
+	switch_mutex_lock(rx->mutex);
+	if (rx->head == rx->tail && timeout > 0 && rx->registered) {
+		switch_thread_cond_timedwait(rx->cond, rx->mutex, timeout);
+	}
+	if (rx->head != rx->tail) {
+		status = SWITCH_STATUS_SUCCESS;
+	}
+	switch_mutex_unlock(rx->mutex);
+
+	return status;
+}
+
+static switch_status_t rtp_batch_recvfrom(switch_rtp_t *rtp_session, void *buf, switch_size_t *bytes)
+{
+	rtp_batch_rx_t *rx = rtp_session->batch_rx;
+	switch_status_t status = SWITCH_STATUS_BREAK;
+	switch_size_t want = *bytes;
+	int rearm = 0;
+
+	*bytes = 0;
+
+	switch_mutex_lock(rx->mutex);
+	while (rx->tail != rx->head) {
+		rtp_batch_slot_t *slot = &rx->slots[rx->tail % RTP_BATCH_RING_LEN];
+
+		if (slot->len) {
+			*bytes = slot->len > want ? want : slot->len;
+			memcpy(buf, slot->data, *bytes);
+			rtp_count_copy(rtp_session, rtp_read, *bytes);
+			switch_sockaddr_set_os(rtp_session->from_addr, &slot->addr, slot->addrlen);
+			status = SWITCH_STATUS_SUCCESS;
+		}
+
+		rx->tail++;
+
+		if (status == SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+	}
+
+	if (rx->stalled && rx->head == rx->tail) {
+		rx->stalled = 0;
+		rearm = 1;
+	}
+	switch_mutex_unlock(rx->mutex);
+
+	if (rearm) {
+		rtp_batch_rearm(rx);
+	}
+
+	return status;
+}
+
+#define rtp_batch_active(_rtp_session) (_rtp_session->batch_rx && _rtp_session->batch_rx->registered)
+
+#endif
+
+static switch_status_t rtp_poll_input(switch_rtp_t *rtp_session, int *fdr, int32_t timeout)
+{
+#ifdef RTP_BATCH_RECV
+	if (rtp_batch_active(rtp_session)) {
+		return rtp_batch_poll(rtp_session->batch_rx, timeout);
+	}
+#endif
+
+	return switch_poll(rtp_session->read_pollfd, 1, fdr, timeout);
+}
+
+static switch_status_t rtp_recvfrom(switch_rtp_t *rtp_session, switch_size_t *bytes)
+{
+#ifdef RTP_BATCH_RECV
+	if (rtp_batch_active(rtp_session)) {
+		return rtp_batch_recvfrom(rtp_session, (void *) &rtp_session->recv_msg, bytes);
+	}
+#endif
+
+	return switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, bytes);
+}
+
+#ifdef RTP_BATCH_SEND
+
+#define RTP_BATCH_TX_RING_LEN 1024
+#define RTP_BATCH_TX_SLOT_LEN 1536
+#define RTP_BATCH_TX_VLEN 64
+/* the kernel's UDP_MAX_SEGMENTS, and a GSO send is still one datagram so it has to fit the largest udp payload */
+#define RTP_BATCH_GSO_MAX 64
+#define RTP_BATCH_GSO_MAX_BYTES 65507
+
+typedef struct rtp_batch_tx_pkt_s {
+	int fd;
+	uint32_t len;
+	socklen_t addrlen;
+	struct sockaddr_storage addr;
+	char data[RTP_BATCH_TX_SLOT_LEN];
+} rtp_batch_tx_pkt_t;
+
+typedef struct rtp_batch_sender_s {
+	rtp_batch_tx_pkt_t ring[RTP_BATCH_TX_RING_LEN];
+	uint64_t head;
+	uint64_t tail;
+	uint32_t count;
+	int cpu;
+	int gso;
+	uint32_t gso_max;
+	uint64_t packets;
+	uint64_t syscalls;
+	uint64_t gso_sends;
+	uint64_t overflows;
+	uint64_t errors;
+	char gso_buf[RTP_BATCH_GSO_MAX * RTP_BATCH_TX_SLOT_LEN];
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_thread_cond_t *done_cond;
+	switch_thread_t *thread;
+} rtp_batch_sender_t;
+
+static int rtp_batch_gso_run(rtp_batch_sender_t *sender, uint64_t start, uint32_t n)
+{
+	rtp_batch_tx_pkt_t *first = &sender->ring[start % RTP_BATCH_TX_RING_LEN];
+	size_t len = first->len;
+	uint32_t i;
+
+	if (!sender->gso || n < 2) {
+		return 0;
+	}
+
+	if (n > sender->gso_max) {
+		n = sender->gso_max;
+	}
+
+	/* every segment but the last has to be the same size, all to the same destination */
+	for (i = 1; i < n; i++) {
+		rtp_batch_tx_pkt_t *pkt = &sender->ring[(start + i) % RTP_BATCH_TX_RING_LEN];
+
+		if (pkt->addrlen != first->addrlen || memcmp(&pkt->addr, &first->addr, first->addrlen) ||
+			pkt->len > first->len || (pkt->len != first->len && i != n - 1) || len + pkt->len > RTP_BATCH_GSO_MAX_BYTES) {
+			break;
+		}
+
+		len += pkt->len;
+	}
+
+	return i > 1 ? (int) i : 0;
+}
+
+static int rtp_batch_gso_send(rtp_batch_sender_t *sender, uint64_t start, uint32_t n)
+{
+	rtp_batch_tx_pkt_t *first = &sender->ring[start % RTP_BATCH_TX_RING_LEN];
+	char control[CMSG_SPACE(sizeof(uint16_t))] = { 0 };
+	struct msghdr msg = { 0 };
+	struct cmsghdr *cm;
+	struct iovec iov;
+	size_t len = 0;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		rtp_batch_tx_pkt_t *pkt = &sender->ring[(start + i) % RTP_BATCH_TX_RING_LEN];
+
+		memcpy(sender->gso_buf + len, pkt->data, pkt->len);
+		len += pkt->len;
+	}
+
+	iov.iov_base = sender->gso_buf;
+	iov.iov_len = len;
+	msg.msg_name = &first->addr;
+	msg.msg_namelen = first->addrlen;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	cm = CMSG_FIRSTHDR(&msg);
+	cm->cmsg_level = IPPROTO_UDP;
+	cm->cmsg_type = UDP_SEGMENT;
+	cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+	*((uint16_t *) CMSG_DATA(cm)) = (uint16_t) first->len;
+
+	sender->syscalls++;
+
+	if (sendmsg(first->fd, &msg, 0) < 0) {
+		if (errno == EMSGSIZE && n > 2) {
+			/* the route or the kernel takes fewer segments than that, shorten the runs from now on */
+			sender->gso_max = n / 2;
+			return 1;
+		}
+		if (errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP || errno == EIO || errno == EMSGSIZE) {
+			/* no GSO in this kernel or on this route, stick to sendmmsg() */
+			sender->gso = 0;
+		}
+		return -1;
+	}
+
+	sender->gso_sends++;
+
+	return 0;
+}
+
+static void rtp_batch_flush(rtp_batch_sender_t *sender, uint64_t start, uint32_t n)
+{
+	struct mmsghdr msgs[RTP_BATCH_TX_VLEN];
+	struct iovec iov[RTP_BATCH_TX_VLEN];
+	uint32_t i = 0;
+
+	while (i < n) {
+		rtp_batch_tx_pkt_t *pkt = &sender->ring[(start + i) % RTP_BATCH_TX_RING_LEN];
+		uint32_t run = 1, x;
+		int gso, sent, r = -1;
+
+		while (i + run < n && run < RTP_BATCH_TX_VLEN && sender->ring[(start + i + run) % RTP_BATCH_TX_RING_LEN].fd == pkt->fd) {
+			run++;
+		}
+
+		while ((gso = rtp_batch_gso_run(sender, start + i, run)) && (r = rtp_batch_gso_send(sender, start + i, gso)) > 0) {
+			/* the kernel found the run too big and gso_max went down, try it shorter */
+		}
+
+		if (gso && !r) {
+			sender->packets += gso;
+			i += gso;
+			continue;
+		}
+
+		for (x = 0; x < run; x++) {
+			rtp_batch_tx_pkt_t *p = &sender->ring[(start + i + x) % RTP_BATCH_TX_RING_LEN];
+
+			iov[x].iov_base = p->data;
+			iov[x].iov_len = p->len;
+			memset(&msgs[x], 0, sizeof(msgs[x]));
+			msgs[x].msg_hdr.msg_name = &p->addr;
+			msgs[x].msg_hdr.msg_namelen = p->addrlen;
+			msgs[x].msg_hdr.msg_iov = &iov[x];
+			msgs[x].msg_hdr.msg_iovlen = 1;
+		}
+
+		x = 0;
+		while (x < run) {
+			sender->syscalls++;
+
+			if ((sent = sendmmsg(pkt->fd, msgs + x, run - x, 0)) <= 0) {
+				/* skip the packet the kernel refused, same as a failed sendto() */
+				sender->errors++;
+				x++;
+				continue;
+			}
+
+			sender->packets += sent;
+			x += sent;
+		}
+
+		i += run;
+	}
+}
+
+static void *SWITCH_THREAD_FUNC rtp_batch_sender_thread(switch_thread_t *thread, void *obj)
+{
+	rtp_batch_sender_t *sender = (rtp_batch_sender_t *) obj;
+
+	if (sender->cpu > -1) {
+		switch_core_thread_set_cpu_affinity(sender->cpu);
+	}
+
+	switch_mutex_lock(sender->mutex);
+
+	while (rtp_batch_globals.send_running || sender->head != sender->tail) {
+		uint64_t start;
+		uint32_t n;
+
+		if (sender->head == sender->tail) {
+			switch_thread_cond_timedwait(sender->cond, sender->mutex, 100000);
+			continue;
+		}
+
+		/* packets are sent as soon as they are queued so each session keeps its own timer pacing,
+		   whatever the other media threads queue while we are in the kernel goes out in the next batch */
+		start = sender->tail;
+		n = (uint32_t) (sender->head - sender->tail);
+		switch_mutex_unlock(sender->mutex);
+
+		rtp_batch_flush(sender, start, n);
+
+		switch_mutex_lock(sender->mutex);
+		sender->tail += n;
+		switch_thread_cond_broadcast(sender->done_cond);
+	}
+
+	switch_mutex_unlock(sender->mutex);
+
+	return NULL;
+}
+
+static switch_status_t rtp_batch_send_start(void)
+{
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	uint32_t i;
+
+	switch_mutex_lock(rtp_batch_globals.mutex);
+
+	if (rtp_batch_globals.send_running) {
+		goto end;
+	}
+
+	if (!rtp_batch_globals.send_threads) {
+		status = SWITCH_STATUS_FALSE;
+		goto end;
+	}
+
+	rtp_batch_globals.senders = switch_core_alloc(rtp_batch_globals.pool, sizeof(rtp_batch_sender_t *) * rtp_batch_globals.send_threads);
+	rtp_batch_globals.send_running = 1;
+
+	for (i = 0; i < rtp_batch_globals.send_threads; i++) {
+		rtp_batch_sender_t *sender = switch_core_alloc(rtp_batch_globals.pool, sizeof(*sender));
+		switch_threadattr_t *thd_attr = NULL;
+
+		sender->cpu = switch_core_cpu_count() > 1 ? (int) (i % switch_core_cpu_count()) : -1;
+		sender->gso = 1;
+		sender->gso_max = RTP_BATCH_GSO_MAX;
+		switch_mutex_init(&sender->mutex, SWITCH_MUTEX_NESTED, rtp_batch_globals.pool);
+		switch_thread_cond_create(&sender->cond, rtp_batch_globals.pool);
+		switch_thread_cond_create(&sender->done_cond, rtp_batch_globals.pool);
+
+		switch_threadattr_create(&thd_attr, rtp_batch_globals.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+		switch_thread_create(&sender->thread, thd_attr, rtp_batch_sender_thread, sender, rtp_batch_globals.pool);
+
+		rtp_batch_globals.senders[rtp_batch_globals.sender_count++] = sender;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Started %u batched RTP send threads\n", rtp_batch_globals.sender_count);
+
+ end:
+
+	switch_mutex_unlock(rtp_batch_globals.mutex);
+
+	return status;
+}
+
+static void rtp_batch_send_stop(void)
+{
+	uint32_t i;
+	switch_status_t st;
+
+	switch_mutex_lock(rtp_batch_globals.mutex);
+
+	if (!rtp_batch_globals.send_running) {
+		switch_mutex_unlock(rtp_batch_globals.mutex);
+		return;
+	}
+
+	rtp_batch_globals.send_running = 0;
+	switch_mutex_unlock(rtp_batch_globals.mutex);
+
+	for (i = 0; i < rtp_batch_globals.sender_count; i++) {
+		rtp_batch_sender_t *sender = rtp_batch_globals.senders[i];
+
+		switch_mutex_lock(sender->mutex);
+		switch_thread_cond_signal(sender->cond);
+		switch_mutex_unlock(sender->mutex);
+		switch_thread_join(&st, sender->thread);
+	}
+
+	rtp_batch_globals.sender_count = 0;
+}
+
+static rtp_batch_sender_t *rtp_batch_send_attach(switch_rtp_t *rtp_session)
+{
+	rtp_batch_sender_t *sender = NULL;
+	uint32_t i;
+
+	if (rtp_session->batch_tx) {
+		return rtp_session->batch_tx;
+	}
+
+	if (rtp_batch_send_start() != SWITCH_STATUS_SUCCESS) {
+		rtp_session->flags[SWITCH_RTP_FLAG_BATCH_SEND] = 0;
+		return NULL;
+	}
+
+	switch_mutex_lock(rtp_batch_globals.mutex);
+	for (i = 0; i < rtp_batch_globals.sender_count; i++) {
+		if (!sender || rtp_batch_globals.senders[i]->count < sender->count) {
+			sender = rtp_batch_globals.senders[i];
+		}
+	}
+	sender->count++;
+	switch_mutex_unlock(rtp_batch_globals.mutex);
+
+	rtp_session->batch_tx = sender;
+
+	return sender;
+}
+
+/* wait until everything this session queued has left, before its socket is shut down or replaced */
+static void rtp_batch_send_drain(switch_rtp_t *rtp_session)
+{
+	rtp_batch_sender_t *sender = rtp_session->batch_tx;
+
+	if (!sender) {
+		return;
+	}
+
+	switch_mutex_lock(sender->mutex);
+	while (sender->tail < rtp_session->batch_tx_last && rtp_batch_globals.send_running) {
+		switch_thread_cond_timedwait(sender->done_cond, sender->mutex, 20000);
+	}
+	switch_mutex_unlock(sender->mutex);
+}
+
+static void rtp_batch_send_detach(switch_rtp_t *rtp_session)
+{
+	if (!rtp_session->batch_tx) {
+		return;
+	}
+
+	rtp_batch_send_drain(rtp_session);
+
+	switch_mutex_lock(rtp_batch_globals.mutex);
+	rtp_session->batch_tx->count--;
+	switch_mutex_unlock(rtp_batch_globals.mutex);
+
+	rtp_session->batch_tx = NULL;
+}
+
+static switch_status_t rtp_batch_sendto(switch_rtp_t *rtp_session, const void *data, switch_size_t bytes)
+{
+	rtp_batch_sender_t *sender;
+	rtp_batch_tx_pkt_t *pkt;
+	switch_os_socket_t fd;
+	const void *os_addr;
+	uint32_t os_addrlen = 0;
+
+	if (!(sender = rtp_batch_send_attach(rtp_session)) || bytes > RTP_BATCH_TX_SLOT_LEN ||
+		switch_os_sock_get(&fd, rtp_session->sock_output) != SWITCH_STATUS_SUCCESS ||
+		!(os_addr = switch_sockaddr_get_os(rtp_session->remote_addr, &os_addrlen)) || os_addrlen > sizeof(pkt->addr)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_mutex_lock(sender->mutex);
+
+	if (sender->head - sender->tail >= RTP_BATCH_TX_RING_LEN) {
+		sender->overflows++;
+		switch_mutex_unlock(sender->mutex);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	pkt = &sender->ring[sender->head % RTP_BATCH_TX_RING_LEN];
+	pkt->fd = fd;
+	pkt->len = (uint32_t) bytes;
+	pkt->addrlen = os_addrlen;
+	memcpy(&pkt->addr, os_addr, os_addrlen);
+	memcpy(pkt->data, data, bytes);
+
+	rtp_session->batch_tx_last = ++sender->head;
+	switch_thread_cond_signal(sender->cond);
+
+	switch_mutex_unlock(sender->mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+#endif
+
+static switch_status_t rtp_sendto(switch_rtp_t *rtp_session, void *data, switch_size_t *bytes)
+{
+#ifdef RTP_BATCH_SEND
+	if (rtp_session->flags[SWITCH_RTP_FLAG_BATCH_SEND]) {
+		if (rtp_batch_sendto(rtp_session, data, *bytes) == SWITCH_STATUS_SUCCESS) {
+			return SWITCH_STATUS_SUCCESS;
+		}
+
+		/* anything still queued has to go first */
+		rtp_batch_send_drain(rtp_session);
+	}
+#endif
+
+	return switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, data, bytes);
+}
+
+SWITCH_DECLARE(void) switch_rtp_batch_stats(switch_stream_handle_t *stream)
+{
+#if defined(RTP_BATCH_RECV) || defined(RTP_BATCH_SEND)
+	uint32_t i;
+#endif
+
+#ifdef RTP_BATCH_RECV
+	stream->write_function(stream, "Receive: %s, %u thread(s)\n", rtp_batch_globals.running ? "running" : "idle", rtp_batch_globals.poller_count);
+
+	for (i = 0; i < rtp_batch_globals.poller_count; i++) {
+		rtp_batch_poller_t *poller = rtp_batch_globals.pollers[i];
+
+		stream->write_function(stream, "  rx[%u] sockets=%u packets=%" SWITCH_UINT64_T_FMT " syscalls=%" SWITCH_UINT64_T_FMT
+							   " pkts/syscall=%.2f truncated=%" SWITCH_UINT64_T_FMT " stalls=%" SWITCH_UINT64_T_FMT "\n",
+							   i, poller->count, poller->packets, poller->syscalls,
+							   poller->syscalls ? (double) poller->packets / poller->syscalls : 0.0, poller->truncated, poller->stalls);
+	}
+#else
+	stream->write_function(stream, "Receive: not supported on this platform\n");
+#endif
+
+#ifdef RTP_BATCH_SEND
+	stream->write_function(stream, "Send: %s, %u thread(s)\n", rtp_batch_globals.send_running ? "running" : "idle", rtp_batch_globals.sender_count);
+
+	for (i = 0; i < rtp_batch_globals.sender_count; i++) {
+		rtp_batch_sender_t *sender = rtp_batch_globals.senders[i];
+
+		stream->write_function(stream, "  tx[%u] sessions=%u packets=%" SWITCH_UINT64_T_FMT " syscalls=%" SWITCH_UINT64_T_FMT
+							   " pkts/syscall=%.2f gso=%s gso_sends=%" SWITCH_UINT64_T_FMT " overflows=%" SWITCH_UINT64_T_FMT
+							   " errors=%" SWITCH_UINT64_T_FMT "\n",
+							   i, sender->count, sender->packets, sender->syscalls,
+							   sender->syscalls ? (double) sender->packets / sender->syscalls : 0.0,
+							   sender->gso ? "on" : "off", sender->gso_sends, sender->overflows, sender->errors);
+	}
+#else
+	stream->write_function(stream, "Send: not supported on this platform\n");
+#endif
+}
+
 SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool)
 {
 #ifdef ENABLE_ZRTP
@@ -1465,6 +2427,8 @@ SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool)
 	srtp_init();
 #endif
 	switch_mutex_init(&port_lock, SWITCH_MUTEX_NESTED, pool);
+	switch_mutex_init(&rtp_batch_globals.mutex, SWITCH_MUTEX_NESTED, pool);
+	rtp_batch_globals.pool = pool;
 	global_init = 1;
 }
 
@@ -2347,6 +3311,13 @@ SWITCH_DECLARE(void) switch_rtp_shutdown(void)
 	switch_core_hash_destroy(&alloc_hash);
 	switch_mutex_unlock(port_lock);
 
+#ifdef RTP_BATCH_RECV
+	rtp_batch_stop();
+#endif
+#ifdef RTP_BATCH_SEND
+	rtp_batch_send_stop();
+#endif
+
 #ifdef ENABLE_ZRTP
 	if (zrtp_on) {
 		zrtp_status_t status = zrtp_status_ok;
@@ -2901,6 +3872,9 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_remote_address(switch_rtp_t *rtp_
 		rtp_session->sock_output = rtp_session->sock_input;
 	} else {
 		if (rtp_session->sock_output && rtp_session->sock_output != rtp_session->sock_input) {
+#ifdef RTP_BATCH_SEND
+			rtp_batch_send_drain(rtp_session);
+#endif
 			switch_socket_close(rtp_session->sock_output);
 		}
 		if ((status = switch_socket_create(&rtp_session->sock_output,
@@ -4383,6 +5357,12 @@ SWITCH_DECLARE(void) switch_rtp_kill_socket(switch_rtp_t *rtp_session)
 {
 	switch_assert(rtp_session != NULL);
 	switch_mutex_lock(rtp_session->flag_mutex);
+#ifdef RTP_BATCH_RECV
+	rtp_batch_unregister(rtp_session);
+#endif
+#ifdef RTP_BATCH_SEND
+	rtp_batch_send_detach(rtp_session);
+#endif
 	if (rtp_session->flags[SWITCH_RTP_FLAG_IO]) {
 		rtp_session->flags[SWITCH_RTP_FLAG_IO] = 0;
 		if (rtp_session->sock_input) {
@@ -4978,7 +5958,7 @@ static switch_size_t do_flush(switch_rtp_t *rtp_session, int force, switch_size_
 		do {
 			if (switch_rtp_ready(rtp_session)) {
 				bytes = sizeof(rtp_msg_t);
-				switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, &bytes);
+				rtp_recvfrom(rtp_session, &bytes);
 				
 				if (bytes) {
 					int do_cng = 0;
@@ -5109,7 +6089,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 			}
 		}
 		
-		poll_status = switch_poll(rtp_session->read_pollfd, 1, &fdr, to);
+		poll_status = rtp_poll_input(rtp_session, &fdr, to);
 		
 		if (rtp_session->flags[SWITCH_RTP_FLAG_USE_TIMER] && rtp_session->timer.interval) {
 			switch_core_timer_sync(&rtp_session->timer);
@@ -5131,7 +6111,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 	memset(&rtp_session->last_rtp_hdr, 0, sizeof(rtp_session->last_rtp_hdr));
 
 	if (poll_status == SWITCH_STATUS_SUCCESS) {
-		status = switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, bytes);
+		status = rtp_recvfrom(rtp_session, bytes);
 	} else {
 		*bytes = 0;
 	}
@@ -5602,6 +6582,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 			}
 
 			status = switch_jb_put_packet(rtp_session->jb, (switch_rtp_packet_t *) &rtp_session->recv_msg, *bytes);
+			rtp_count_copy(rtp_session, rtp_read, *bytes);
 			if (status == SWITCH_STATUS_TOO_LATE) {
 				goto more;
 			}
@@ -5654,6 +6635,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 			default:
 				{
 					rtp_session->stats.inbound.jb_packet_count++;
+					rtp_count_copy(rtp_session, rtp_read, *bytes);
 					status = SWITCH_STATUS_SUCCESS;
 					rtp_session->last_rtp_hdr = rtp_session->recv_msg.header;
 					if (++rtp_session->clean > 200) {
@@ -6110,7 +7092,9 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 
 	READ_INC(rtp_session);
 
-
+#ifdef RTP_BATCH_RECV
+	rtp_batch_check(rtp_session);
+#endif
 
 	while (switch_rtp_ready(rtp_session)) {
 		int do_cng = 0;
@@ -6127,7 +7111,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 			rtp_session->read_pollfd) {
 			
 			if (rtp_session->jb && !rtp_session->pause_jb && jb_valid(rtp_session)) {
-				while (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+				while (rtp_poll_input(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 					status = read_rtp_packet(rtp_session, &bytes, flags, SWITCH_STATUS_SUCCESS, SWITCH_FALSE);
 
 					if (status == SWITCH_STATUS_GENERR) {
@@ -6150,7 +7134,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 				
 			} else if ((rtp_session->flags[SWITCH_RTP_FLAG_AUTOFLUSH] || rtp_session->flags[SWITCH_RTP_FLAG_STICKY_FLUSH])) {
 				
-				if (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+				if (rtp_poll_input(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 					status = read_rtp_packet(rtp_session, &bytes, flags, SWITCH_STATUS_SUCCESS, SWITCH_FALSE);
 					if (status == SWITCH_STATUS_GENERR) {
 						ret = -1;
@@ -6169,7 +7153,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 					}
 
 					if (bytes) {
-						if (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+						if (rtp_poll_input(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 							rtp_session->hot_hits++;//+= rtp_session->samples_per_interval;
 							
 							switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG10, "%s Hot Hit %d\n", 
@@ -6269,7 +7253,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 				}
 			}
 			
-			poll_status = switch_poll(rtp_session->read_pollfd, 1, &fdr, pt);
+			poll_status = rtp_poll_input(rtp_session, &fdr, pt);
 
 
 			//if (rtp_session->flags[SWITCH_RTP_FLAG_VIDEO]) {
@@ -7111,8 +8095,25 @@ static int rtp_write_ready(switch_rtp_t *rtp_session, uint32_t bytes, int line)
 
 
 
-static int rtp_common_write(switch_rtp_t *rtp_session,
-							rtp_msg_t *send_msg, void *data, uint32_t datalen, switch_payload_t payload, uint32_t timestamp, switch_frame_flag_t *flags)
+/* payload can be sent from the packet it arrived in: nothing below touches the body in place */
+static inline int rtp_write_zerocopy_ok(switch_rtp_t *rtp_session)
+{
+#ifdef ENABLE_ZRTP
+	if (zrtp_on) {
+		return 0;
+	}
+#endif
+
+	return !rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND] && !rtp_session->flags[SWITCH_RTP_FLAG_BYTESWAP] &&
+		!rtp_session->flags[SWITCH_RTP_FLAG_VIDEO] && !rtp_session->flags[SWITCH_RTP_FLAG_NACK];
+}
+
+/*
+  recv_msg, when not NULL, is the received packet whose body is data (see switch_rtp_zerocopy_read_frame).
+  Its header is borrowed to send the payload without copying it and restored before returning.
+*/
+static int rtp_common_write(switch_rtp_t *rtp_session, rtp_msg_t *send_msg, rtp_msg_t *recv_msg,
+							void *data, uint32_t datalen, switch_payload_t payload, uint32_t timestamp, switch_frame_flag_t *flags)
 {
 	switch_size_t bytes;
 	uint8_t send = 1;
@@ -7120,6 +8121,8 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 	int ret;
 	switch_time_t now;
 	uint8_t m = 0;
+	rtp_msg_t *zc_msg = NULL;
+	srtp_hdr_t zc_header = { 0 };
 
 	if (!switch_rtp_ready(rtp_session)) {
 		return -1;
@@ -7164,7 +8167,16 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 
 		rtp_session->send_msg.header.ts = htonl(rtp_session->ts);
 
-		memcpy(send_msg->body, data, datalen);
+		if (recv_msg && recv_msg->body == data && rtp_write_zerocopy_ok(rtp_session)) {
+			zc_msg = recv_msg;
+			zc_header = zc_msg->header;
+			zc_msg->header = send_msg->header;
+			send_msg = zc_msg;
+			rtp_count_copy(rtp_session, rtp_write_zerocopy, datalen);
+		} else {
+			memcpy(send_msg->body, data, datalen);
+			rtp_count_copy(rtp_session, rtp_write, datalen);
+		}
 		bytes = datalen + rtp_header_len;
 	}
 
@@ -7512,7 +8524,7 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ALERT, 
 								  "Simulate dropping packet ......... ts: %u seq: %u\n", ntohl(send_msg->header.ts), ntohs(send_msg->header.seq));
 			} else {
-				if (switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
+				if (rtp_sendto(rtp_session, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
 					rtp_session->seq--;
 					ret = -1;
 					goto end;
@@ -7526,7 +8538,7 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 		//
 		//	//switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "SEND %u\n", ntohs(send_msg->header.seq));
 		//}
-		if (switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
+		if (rtp_sendto(rtp_session, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
 			rtp_session->seq--;
 			ret = -1;
 			goto end;
@@ -7565,6 +8577,11 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 
  end:
 
+	if (zc_msg) {
+		rtp_session->send_msg.header = zc_msg->header;
+		zc_msg->header = zc_header;
+	}
+
 	WRITE_DEC(rtp_session);
 
 	return ret;
@@ -7645,7 +8662,7 @@ SWITCH_DECLARE(int) switch_rtp_write_frame(switch_rtp_t *rtp_session, switch_fra
 	void *data = NULL;
 	uint32_t len, ts = 0;
 	switch_payload_t payload = 0;
-	rtp_msg_t *send_msg = NULL;
+	rtp_msg_t *send_msg = NULL, *recv_msg = NULL;
 	srtp_hdr_t local_header;
 	int r = 0;
 
@@ -7689,7 +8706,7 @@ SWITCH_DECLARE(int) switch_rtp_write_frame(switch_rtp_t *rtp_session, switch_fra
 			send_msg->header.seq = htons(++rtp_session->seq);
 		}
 
-		if (switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, frame->packet, &bytes) != SWITCH_STATUS_SUCCESS) {
+		if (rtp_sendto(rtp_session, frame->packet, &bytes) != SWITCH_STATUS_SUCCESS) {
 			return -1;
 		}
 
@@ -7823,6 +8840,10 @@ SWITCH_DECLARE(int) switch_rtp_write_frame(switch_rtp_t *rtp_session, switch_fra
 		data = frame->data;
 		len = frame->datalen;
 		ts = rtp_session->flags[SWITCH_RTP_FLAG_RAW_WRITE] ? (uint32_t) frame->timestamp : 0;
+
+		if (switch_test_flag(frame, SFF_RAW_RTP) && frame->packet) {
+			recv_msg = (rtp_msg_t *) frame->packet;
+		}
 	}
 
 	/*
@@ -7831,7 +8852,7 @@ SWITCH_DECLARE(int) switch_rtp_write_frame(switch_rtp_t *rtp_session, switch_fra
 	  }
 	*/
 
-	r = rtp_common_write(rtp_session, send_msg, data, len, payload, ts, &frame->flags);
+	r = rtp_common_write(rtp_session, send_msg, recv_msg, data, len, payload, ts, &frame->flags);
 
 	if (send_msg) {
 		send_msg->header = local_header;
@@ -7993,7 +9014,7 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_write_raw(switch_rtp_t *rtp_session,
 #endif
 	}
 
-	status = switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, data, bytes);
+	status = rtp_sendto(rtp_session, data, bytes);
 
  end:
 
@@ -0,0 +1,1186 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_simd.c -- Vectorized PCM kernels
+ *
+ */
+
+#include <switch.h>
+#include <switch_simd.h>
+#include <g711.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SWITCH_SIMD_DISABLE)
+#define SIMD_X86 1
+#include <immintrin.h>
+#define SIMD_TARGET(_t) __attribute__((target(_t)))
+#elif defined(__aarch64__) && defined(__ARM_NEON) && !defined(SWITCH_SIMD_DISABLE)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef struct {
+	void (*ulaw_encode)(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples);
+	void (*ulaw_decode)(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples);
+	void (*alaw_encode)(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples);
+	void (*alaw_decode)(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples);
+	void (*add_saturate)(int16_t *data, const int16_t *other_data, uint32_t samples);
+	void (*subtract)(int16_t *data, const int16_t *other_data, uint32_t samples);
+	void (*scale)(int16_t *data, uint32_t samples, double factor);
+	void (*downmix_stereo)(int16_t *data, uint32_t samples);
+	void (*upmix_mono)(int16_t *data, uint32_t samples);
+	void (*accumulate)(int32_t *mix, const int16_t *data, uint32_t samples);
+	void (*mix_minus)(int16_t *out, const int32_t *mix, const int16_t *self, uint32_t samples);
+} simd_ops_t;
+
+
+/* Portable versions, these define the expected output of every other variant */
+
+static void scalar_ulaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		ebuf[i] = linear_to_ulaw(dbuf[i]);
+	}
+}
+
+static void scalar_ulaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		dbuf[i] = ulaw_to_linear(ebuf[i]);
+	}
+}
+
+static void scalar_alaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		ebuf[i] = linear_to_alaw(dbuf[i]);
+	}
+}
+
+static void scalar_alaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		dbuf[i] = alaw_to_linear(ebuf[i]);
+	}
+}
+
+static void scalar_add_saturate(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+	int32_t z;
+
+	for (i = 0; i < samples; i++) {
+		z = data[i] + other_data[i];
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+static void scalar_subtract(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		data[i] -= other_data[i];
+	}
+}
+
+static void scalar_scale(int16_t *data, uint32_t samples, double factor)
+{
+	uint32_t i;
+	int32_t tmp;
+
+	for (i = 0; i < samples; i++) {
+		tmp = (int32_t) (data[i] * factor);
+		switch_normalize_to_16bit(tmp);
+		data[i] = (int16_t) tmp;
+	}
+}
+
+static void scalar_downmix_stereo_range(int16_t *data, uint32_t from, uint32_t to)
+{
+	uint32_t i;
+	int32_t z;
+
+	for (i = from; i < to; i++) {
+		z = data[i * 2] + data[i * 2 + 1];
+		switch_normalize_to_16bit(z);
+		data[i] = (int16_t) z;
+	}
+}
+
+static void scalar_downmix_stereo(int16_t *data, uint32_t samples)
+{
+	scalar_downmix_stereo_range(data, 0, samples);
+}
+
+/* walks backwards so the source samples are read before they are overwritten */
+static void scalar_upmix_mono_range(int16_t *data, uint32_t from, uint32_t to)
+{
+	uint32_t i;
+
+	for (i = to; i > from; i--) {
+		data[(i - 1) * 2 + 1] = data[(i - 1) * 2] = data[i - 1];
+	}
+}
+
+static void scalar_upmix_mono(int16_t *data, uint32_t samples)
+{
+	scalar_upmix_mono_range(data, 0, samples);
+}
+
+static void scalar_accumulate(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		mix[i] += data[i];
+	}
+}
+
+static void scalar_mix_minus(int16_t *out, const int32_t *mix, const int16_t *self, uint32_t samples)
+{
+	uint32_t i;
+	int32_t z;
+
+	for (i = 0; i < samples; i++) {
+		z = self ? mix[i] - self[i] : mix[i];
+		switch_normalize_to_16bit(z);
+		out[i] = (int16_t) z;
+	}
+}
+
+static const simd_ops_t scalar_ops = {
+	scalar_ulaw_encode,
+	scalar_ulaw_decode,
+	scalar_alaw_encode,
+	scalar_alaw_decode,
+	scalar_add_saturate,
+	scalar_subtract,
+	scalar_scale,
+	scalar_downmix_stereo,
+	scalar_upmix_mono,
+	scalar_accumulate,
+	scalar_mix_minus
+};
+
+
+#ifdef SIMD_X86
+
+/*
+ * x86 has no per lane 16 bit shifts below AVX-512, so the G.711 segment is counted with compares against
+ * the segment thresholds and the variable shifts are done as three conditional shifts, one per bit of the
+ * 0..7 shift count.
+ */
+
+#define sse2_select(_m, _a, _b) _mm_or_si128(_mm_and_si128(_m, _a), _mm_andnot_si128(_m, _b))
+
+SIMD_TARGET("sse2") static inline __m128i sse2_shl_var(__m128i v, __m128i count)
+{
+	const __m128i one = _mm_set1_epi16(1), two = _mm_set1_epi16(2), four = _mm_set1_epi16(4);
+
+	v = sse2_select(_mm_cmpeq_epi16(_mm_and_si128(count, one), one), _mm_slli_epi16(v, 1), v);
+	v = sse2_select(_mm_cmpeq_epi16(_mm_and_si128(count, two), two), _mm_slli_epi16(v, 2), v);
+	v = sse2_select(_mm_cmpeq_epi16(_mm_and_si128(count, four), four), _mm_slli_epi16(v, 4), v);
+
+	return v;
+}
+
+SIMD_TARGET("sse2") static inline __m128i sse2_shr_var(__m128i v, __m128i count)
+{
+	const __m128i one = _mm_set1_epi16(1), two = _mm_set1_epi16(2), four = _mm_set1_epi16(4);
+
+	v = sse2_select(_mm_cmpeq_epi16(_mm_and_si128(count, one), one), _mm_srli_epi16(v, 1), v);
+	v = sse2_select(_mm_cmpeq_epi16(_mm_and_si128(count, two), two), _mm_srli_epi16(v, 2), v);
+	v = sse2_select(_mm_cmpeq_epi16(_mm_and_si128(count, four), four), _mm_srli_epi16(v, 4), v);
+
+	return v;
+}
+
+/* top_bit(v | 0xFF) - 7 for 0 <= v < 0x8000, counted against the segment thresholds */
+SIMD_TARGET("sse2") static inline __m128i sse2_segment(__m128i v)
+{
+	__m128i seg = _mm_sub_epi16(_mm_setzero_si128(), _mm_cmpgt_epi16(v, _mm_set1_epi16(0xFF)));
+
+	seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(v, _mm_set1_epi16(0x1FF)));
+	seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(v, _mm_set1_epi16(0x3FF)));
+	seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(v, _mm_set1_epi16(0x7FF)));
+	seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(v, _mm_set1_epi16(0xFFF)));
+	seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(v, _mm_set1_epi16(0x1FFF)));
+	seg = _mm_sub_epi16(seg, _mm_cmpgt_epi16(v, _mm_set1_epi16(0x3FFF)));
+
+	return seg;
+}
+
+SIMD_TARGET("sse2") static inline __m128i sse2_ulaw_encode8(__m128i x)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i neg = _mm_cmpgt_epi16(zero, x);
+	__m128i mag = _mm_add_epi16(_mm_sub_epi16(_mm_xor_si128(x, neg), neg), _mm_set1_epi16(ULAW_BIAS));
+	__m128i big = _mm_srai_epi16(mag, 15);
+	__m128i seg, m, u;
+
+	seg = sse2_segment(mag);
+	m = sse2_shr_var(_mm_srli_epi16(mag, 3), seg);
+
+	u = _mm_or_si128(_mm_slli_epi16(seg, 4), _mm_and_si128(m, _mm_set1_epi16(0x0F)));
+	u = sse2_select(big, _mm_set1_epi16(0x7F), u);
+
+	return _mm_xor_si128(u, _mm_xor_si128(_mm_set1_epi16(0xFF), _mm_and_si128(neg, _mm_set1_epi16(0x80))));
+}
+
+SIMD_TARGET("sse2") static inline __m128i sse2_alaw_encode8(__m128i x)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i neg = _mm_cmpgt_epi16(zero, x);
+	__m128i lin = sse2_select(neg, _mm_sub_epi16(_mm_sub_epi16(zero, x), _mm_set1_epi16(8)), x);
+	__m128i m, seg, a;
+
+	/* the few negative values that land below zero all encode like zero */
+	lin = _mm_max_epi16(lin, zero);
+
+	seg = sse2_segment(lin);
+
+	/* seg + 3, or 4 for the first segment */
+	m = sse2_shr_var(_mm_srli_epi16(lin, 4), _mm_subs_epu16(seg, _mm_set1_epi16(1)));
+
+	a = _mm_or_si128(_mm_slli_epi16(seg, 4), _mm_and_si128(m, _mm_set1_epi16(0x0F)));
+
+	return _mm_xor_si128(a, _mm_xor_si128(_mm_set1_epi16(ALAW_AMI_MASK | 0x80), _mm_and_si128(neg, _mm_set1_epi16(0x80))));
+}
+
+SIMD_TARGET("sse2") static inline __m128i sse2_ulaw_decode8(__m128i u)
+{
+	__m128i t, r, sign;
+
+	u = _mm_xor_si128(u, _mm_set1_epi16(0xFF));
+	t = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(u, _mm_set1_epi16(0x0F)), 3), _mm_set1_epi16(ULAW_BIAS));
+	t = sse2_shl_var(t, _mm_srli_epi16(_mm_and_si128(u, _mm_set1_epi16(0x70)), 4));
+	sign = _mm_cmpgt_epi16(u, _mm_set1_epi16(0x7F));
+	r = _mm_sub_epi16(t, _mm_set1_epi16(ULAW_BIAS));
+
+	return _mm_sub_epi16(_mm_xor_si128(r, sign), sign);
+}
+
+SIMD_TARGET("sse2") static inline __m128i sse2_alaw_decode8(__m128i a)
+{
+	__m128i i, seg, nz, neg;
+
+	a = _mm_xor_si128(a, _mm_set1_epi16(ALAW_AMI_MASK));
+	i = _mm_slli_epi16(_mm_and_si128(a, _mm_set1_epi16(0x0F)), 4);
+	seg = _mm_srli_epi16(_mm_and_si128(a, _mm_set1_epi16(0x70)), 4);
+	nz = _mm_cmpgt_epi16(seg, _mm_setzero_si128());
+	i = _mm_add_epi16(i, sse2_select(nz, _mm_set1_epi16(0x108), _mm_set1_epi16(8)));
+	i = sse2_shl_var(i, _mm_subs_epu16(seg, _mm_set1_epi16(1)));
+	neg = _mm_cmpgt_epi16(_mm_set1_epi16(0x80), a);
+
+	return _mm_sub_epi16(_mm_xor_si128(i, neg), neg);
+}
+
+SIMD_TARGET("sse2") static void sse2_ulaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m128i lo = sse2_ulaw_encode8(_mm_loadu_si128((const __m128i *) (dbuf + i)));
+		__m128i hi = sse2_ulaw_encode8(_mm_loadu_si128((const __m128i *) (dbuf + i + 8)));
+		_mm_storeu_si128((__m128i *) (ebuf + i), _mm_packus_epi16(lo, hi));
+	}
+
+	scalar_ulaw_encode(ebuf + i, dbuf + i, samples - i);
+}
+
+SIMD_TARGET("sse2") static void sse2_alaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m128i lo = sse2_alaw_encode8(_mm_loadu_si128((const __m128i *) (dbuf + i)));
+		__m128i hi = sse2_alaw_encode8(_mm_loadu_si128((const __m128i *) (dbuf + i + 8)));
+		_mm_storeu_si128((__m128i *) (ebuf + i), _mm_packus_epi16(lo, hi));
+	}
+
+	scalar_alaw_encode(ebuf + i, dbuf + i, samples - i);
+}
+
+SIMD_TARGET("sse2") static void sse2_ulaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m128i e = _mm_loadu_si128((const __m128i *) (ebuf + i));
+		_mm_storeu_si128((__m128i *) (dbuf + i), sse2_ulaw_decode8(_mm_unpacklo_epi8(e, zero)));
+		_mm_storeu_si128((__m128i *) (dbuf + i + 8), sse2_ulaw_decode8(_mm_unpackhi_epi8(e, zero)));
+	}
+
+	scalar_ulaw_decode(dbuf + i, ebuf + i, samples - i);
+}
+
+SIMD_TARGET("sse2") static void sse2_alaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m128i e = _mm_loadu_si128((const __m128i *) (ebuf + i));
+		_mm_storeu_si128((__m128i *) (dbuf + i), sse2_alaw_decode8(_mm_unpacklo_epi8(e, zero)));
+		_mm_storeu_si128((__m128i *) (dbuf + i + 8), sse2_alaw_decode8(_mm_unpackhi_epi8(e, zero)));
+	}
+
+	scalar_alaw_decode(dbuf + i, ebuf + i, samples - i);
+}
+
+SIMD_TARGET("sse2") static void sse2_add_saturate(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (other_data + i));
+		_mm_storeu_si128((__m128i *) (data + i), _mm_adds_epi16(a, b));
+	}
+
+	scalar_add_saturate(data + i, other_data + i, samples - i);
+}
+
+SIMD_TARGET("sse2") static void sse2_subtract(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (other_data + i));
+		_mm_storeu_si128((__m128i *) (data + i), _mm_sub_epi16(a, b));
+	}
+
+	scalar_subtract(data + i, other_data + i, samples - i);
+}
+
+SIMD_TARGET("sse2") static inline __m128i sse2_scale4(__m128i v32, __m128d f)
+{
+	__m128i lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(v32), f));
+	__m128i hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(v32, 0x0E)), f));
+
+	return _mm_unpacklo_epi64(lo, hi);
+}
+
+/* the multiply stays in double precision so the truncated result matches the scalar code exactly */
+SIMD_TARGET("sse2") static void sse2_scale(int16_t *data, uint32_t samples, double factor)
+{
+	const __m128d f = _mm_set1_pd(factor);
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i lo = sse2_scale4(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), f);
+		__m128i hi = sse2_scale4(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), f);
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(lo, hi));
+	}
+
+	scalar_scale(data + i, samples - i, factor);
+}
+
+SIMD_TARGET("sse2") static inline __m128i sse2_pair_sum(__m128i v)
+{
+	return _mm_add_epi32(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16), _mm_srai_epi32(v, 16));
+}
+
+SIMD_TARGET("sse2") static void sse2_downmix_stereo(int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (data + i * 2));
+		__m128i b = _mm_loadu_si128((const __m128i *) (data + i * 2 + 8));
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(sse2_pair_sum(a), sse2_pair_sum(b)));
+	}
+
+	scalar_downmix_stereo_range(data, i, samples);
+}
+
+SIMD_TARGET("sse2") static void sse2_upmix_mono(int16_t *data, uint32_t samples)
+{
+	uint32_t i = samples & ~7U;
+
+	scalar_upmix_mono_range(data, i, samples);
+
+	while (i) {
+		__m128i v;
+
+		i -= 8;
+		v = _mm_loadu_si128((const __m128i *) (data + i));
+		_mm_storeu_si128((__m128i *) (data + i * 2 + 8), _mm_unpackhi_epi16(v, v));
+		_mm_storeu_si128((__m128i *) (data + i * 2), _mm_unpacklo_epi16(v, v));
+	}
+}
+
+SIMD_TARGET("sse2") static void sse2_accumulate(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i lo = _mm_add_epi32(_mm_loadu_si128((const __m128i *) (mix + i)), _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+		__m128i hi = _mm_add_epi32(_mm_loadu_si128((const __m128i *) (mix + i + 4)), _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+		_mm_storeu_si128((__m128i *) (mix + i), lo);
+		_mm_storeu_si128((__m128i *) (mix + i + 4), hi);
+	}
+
+	scalar_accumulate(mix + i, data + i, samples - i);
+}
+
+SIMD_TARGET("sse2") static void sse2_mix_minus(int16_t *out, const int32_t *mix, const int16_t *self, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *) (mix + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *) (mix + i + 4));
+
+		if (self) {
+			__m128i v = _mm_loadu_si128((const __m128i *) (self + i));
+			lo = _mm_sub_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+			hi = _mm_sub_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+		}
+
+		_mm_storeu_si128((__m128i *) (out + i), _mm_packs_epi32(lo, hi));
+	}
+
+	scalar_mix_minus(out + i, mix + i, self ? self + i : NULL, samples - i);
+}
+
+static const simd_ops_t sse2_ops = {
+	sse2_ulaw_encode,
+	sse2_ulaw_decode,
+	sse2_alaw_encode,
+	sse2_alaw_decode,
+	sse2_add_saturate,
+	sse2_subtract,
+	sse2_scale,
+	sse2_downmix_stereo,
+	sse2_upmix_mono,
+	sse2_accumulate,
+	sse2_mix_minus
+};
+
+
+#define avx2_select(_m, _a, _b) _mm256_blendv_epi8(_b, _a, _m)
+
+SIMD_TARGET("avx2") static inline __m256i avx2_shl_var(__m256i v, __m256i count)
+{
+	const __m256i one = _mm256_set1_epi16(1), two = _mm256_set1_epi16(2), four = _mm256_set1_epi16(4);
+
+	v = avx2_select(_mm256_cmpeq_epi16(_mm256_and_si256(count, one), one), _mm256_slli_epi16(v, 1), v);
+	v = avx2_select(_mm256_cmpeq_epi16(_mm256_and_si256(count, two), two), _mm256_slli_epi16(v, 2), v);
+	v = avx2_select(_mm256_cmpeq_epi16(_mm256_and_si256(count, four), four), _mm256_slli_epi16(v, 4), v);
+
+	return v;
+}
+
+SIMD_TARGET("avx2") static inline __m256i avx2_shr_var(__m256i v, __m256i count)
+{
+	const __m256i one = _mm256_set1_epi16(1), two = _mm256_set1_epi16(2), four = _mm256_set1_epi16(4);
+
+	v = avx2_select(_mm256_cmpeq_epi16(_mm256_and_si256(count, one), one), _mm256_srli_epi16(v, 1), v);
+	v = avx2_select(_mm256_cmpeq_epi16(_mm256_and_si256(count, two), two), _mm256_srli_epi16(v, 2), v);
+	v = avx2_select(_mm256_cmpeq_epi16(_mm256_and_si256(count, four), four), _mm256_srli_epi16(v, 4), v);
+
+	return v;
+}
+
+/* top_bit(v | 0xFF) - 7 for 0 <= v < 0x8000, counted against the segment thresholds */
+SIMD_TARGET("avx2") static inline __m256i avx2_segment(__m256i v)
+{
+	__m256i seg = _mm256_sub_epi16(_mm256_setzero_si256(), _mm256_cmpgt_epi16(v, _mm256_set1_epi16(0xFF)));
+
+	seg = _mm256_sub_epi16(seg, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(0x1FF)));
+	seg = _mm256_sub_epi16(seg, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(0x3FF)));
+	seg = _mm256_sub_epi16(seg, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(0x7FF)));
+	seg = _mm256_sub_epi16(seg, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(0xFFF)));
+	seg = _mm256_sub_epi16(seg, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(0x1FFF)));
+	seg = _mm256_sub_epi16(seg, _mm256_cmpgt_epi16(v, _mm256_set1_epi16(0x3FFF)));
+
+	return seg;
+}
+
+SIMD_TARGET("avx2") static inline __m256i avx2_ulaw_encode16(__m256i x)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i neg = _mm256_cmpgt_epi16(zero, x);
+	__m256i mag = _mm256_add_epi16(_mm256_abs_epi16(x), _mm256_set1_epi16(ULAW_BIAS));
+	__m256i big = _mm256_srai_epi16(mag, 15);
+	__m256i seg, m, u;
+
+	seg = avx2_segment(mag);
+	m = avx2_shr_var(_mm256_srli_epi16(mag, 3), seg);
+
+	u = _mm256_or_si256(_mm256_slli_epi16(seg, 4), _mm256_and_si256(m, _mm256_set1_epi16(0x0F)));
+	u = avx2_select(big, _mm256_set1_epi16(0x7F), u);
+
+	return _mm256_xor_si256(u, _mm256_xor_si256(_mm256_set1_epi16(0xFF), _mm256_and_si256(neg, _mm256_set1_epi16(0x80))));
+}
+
+SIMD_TARGET("avx2") static inline __m256i avx2_alaw_encode16(__m256i x)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i neg = _mm256_cmpgt_epi16(zero, x);
+	__m256i lin = avx2_select(neg, _mm256_sub_epi16(_mm256_sub_epi16(zero, x), _mm256_set1_epi16(8)), x);
+	__m256i m, seg, a;
+
+	lin = _mm256_max_epi16(lin, zero);
+
+	seg = avx2_segment(lin);
+
+	/* seg + 3, or 4 for the first segment */
+	m = avx2_shr_var(_mm256_srli_epi16(lin, 4), _mm256_subs_epu16(seg, _mm256_set1_epi16(1)));
+
+	a = _mm256_or_si256(_mm256_slli_epi16(seg, 4), _mm256_and_si256(m, _mm256_set1_epi16(0x0F)));
+
+	return _mm256_xor_si256(a, _mm256_xor_si256(_mm256_set1_epi16(ALAW_AMI_MASK | 0x80), _mm256_and_si256(neg, _mm256_set1_epi16(0x80))));
+}
+
+SIMD_TARGET("avx2") static inline __m256i avx2_ulaw_decode16(__m256i u)
+{
+	__m256i t, r, sign;
+
+	u = _mm256_xor_si256(u, _mm256_set1_epi16(0xFF));
+	t = _mm256_add_epi16(_mm256_slli_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0x0F)), 3), _mm256_set1_epi16(ULAW_BIAS));
+	t = avx2_shl_var(t, _mm256_srli_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0x70)), 4));
+	sign = _mm256_cmpgt_epi16(u, _mm256_set1_epi16(0x7F));
+	r = _mm256_sub_epi16(t, _mm256_set1_epi16(ULAW_BIAS));
+
+	return _mm256_sub_epi16(_mm256_xor_si256(r, sign), sign);
+}
+
+SIMD_TARGET("avx2") static inline __m256i avx2_alaw_decode16(__m256i a)
+{
+	__m256i i, seg, nz, neg;
+
+	a = _mm256_xor_si256(a, _mm256_set1_epi16(ALAW_AMI_MASK));
+	i = _mm256_slli_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0x0F)), 4);
+	seg = _mm256_srli_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0x70)), 4);
+	nz = _mm256_cmpgt_epi16(seg, _mm256_setzero_si256());
+	i = _mm256_add_epi16(i, avx2_select(nz, _mm256_set1_epi16(0x108), _mm256_set1_epi16(8)));
+	i = avx2_shl_var(i, _mm256_subs_epu16(seg, _mm256_set1_epi16(1)));
+	neg = _mm256_cmpgt_epi16(_mm256_set1_epi16(0x80), a);
+
+	return _mm256_sub_epi16(_mm256_xor_si256(i, neg), neg);
+}
+
+/* packus works per 128 bit lane, the permute puts the two halves back in sample order */
+#define avx2_pack_bytes(_lo, _hi) _mm256_permute4x64_epi64(_mm256_packus_epi16(_lo, _hi), 0xD8)
+
+SIMD_TARGET("avx2") static void avx2_ulaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 32 <= samples; i += 32) {
+		__m256i lo = avx2_ulaw_encode16(_mm256_loadu_si256((const __m256i *) (dbuf + i)));
+		__m256i hi = avx2_ulaw_encode16(_mm256_loadu_si256((const __m256i *) (dbuf + i + 16)));
+		_mm256_storeu_si256((__m256i *) (ebuf + i), avx2_pack_bytes(lo, hi));
+	}
+
+	sse2_ulaw_encode(ebuf + i, dbuf + i, samples - i);
+}
+
+SIMD_TARGET("avx2") static void avx2_alaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 32 <= samples; i += 32) {
+		__m256i lo = avx2_alaw_encode16(_mm256_loadu_si256((const __m256i *) (dbuf + i)));
+		__m256i hi = avx2_alaw_encode16(_mm256_loadu_si256((const __m256i *) (dbuf + i + 16)));
+		_mm256_storeu_si256((__m256i *) (ebuf + i), avx2_pack_bytes(lo, hi));
+	}
+
+	sse2_alaw_encode(ebuf + i, dbuf + i, samples - i);
+}
+
+SIMD_TARGET("avx2") static void avx2_ulaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m256i e = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (ebuf + i)));
+		_mm256_storeu_si256((__m256i *) (dbuf + i), avx2_ulaw_decode16(e));
+	}
+
+	scalar_ulaw_decode(dbuf + i, ebuf + i, samples - i);
+}
+
+SIMD_TARGET("avx2") static void avx2_alaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m256i e = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (ebuf + i)));
+		_mm256_storeu_si256((__m256i *) (dbuf + i), avx2_alaw_decode16(e));
+	}
+
+	scalar_alaw_decode(dbuf + i, ebuf + i, samples - i);
+}
+
+SIMD_TARGET("avx2") static void avx2_add_saturate(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (data + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (other_data + i));
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_adds_epi16(a, b));
+	}
+
+	sse2_add_saturate(data + i, other_data + i, samples - i);
+}
+
+SIMD_TARGET("avx2") static void avx2_subtract(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (data + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (other_data + i));
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_sub_epi16(a, b));
+	}
+
+	sse2_subtract(data + i, other_data + i, samples - i);
+}
+
+SIMD_TARGET("avx2") static void avx2_scale(int16_t *data, uint32_t samples, double factor)
+{
+	const __m256d f = _mm256_set1_pd(factor);
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + i)));
+		__m128i lo = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), f));
+		__m128i hi = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), f));
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(lo, hi));
+	}
+
+	scalar_scale(data + i, samples - i, factor);
+}
+
+SIMD_TARGET("avx2") static inline __m256i avx2_pair_sum(__m256i v)
+{
+	return _mm256_add_epi32(_mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16), _mm256_srai_epi32(v, 16));
+}
+
+SIMD_TARGET("avx2") static void avx2_downmix_stereo(int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (data + i * 2));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (data + i * 2 + 16));
+		__m256i r = _mm256_packs_epi32(avx2_pair_sum(a), avx2_pair_sum(b));
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_permute4x64_epi64(r, 0xD8));
+	}
+
+	scalar_downmix_stereo_range(data, i, samples);
+}
+
+SIMD_TARGET("avx2") static void avx2_upmix_mono(int16_t *data, uint32_t samples)
+{
+	uint32_t i = samples & ~15U;
+
+	scalar_upmix_mono_range(data, i, samples);
+
+	while (i) {
+		__m256i v, lo, hi;
+
+		i -= 16;
+		v = _mm256_loadu_si256((const __m256i *) (data + i));
+		lo = _mm256_unpacklo_epi16(v, v);
+		hi = _mm256_unpackhi_epi16(v, v);
+		_mm256_storeu_si256((__m256i *) (data + i * 2 + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+		_mm256_storeu_si256((__m256i *) (data + i * 2), _mm256_permute2x128_si256(lo, hi, 0x20));
+	}
+}
+
+SIMD_TARGET("avx2") static void avx2_accumulate(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + i)));
+		_mm256_storeu_si256((__m256i *) (mix + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (mix + i)), v));
+	}
+
+	scalar_accumulate(mix + i, data + i, samples - i);
+}
+
+SIMD_TARGET("avx2") static void avx2_mix_minus(int16_t *out, const int32_t *mix, const int16_t *self, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		__m256i lo = _mm256_loadu_si256((const __m256i *) (mix + i));
+		__m256i hi = _mm256_loadu_si256((const __m256i *) (mix + i + 8));
+
+		if (self) {
+			lo = _mm256_sub_epi32(lo, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (self + i))));
+			hi = _mm256_sub_epi32(hi, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (self + i + 8))));
+		}
+
+		_mm256_storeu_si256((__m256i *) (out + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8));
+	}
+
+	sse2_mix_minus(out + i, mix + i, self ? self + i : NULL, samples - i);
+}
+
+static const simd_ops_t avx2_ops = {
+	avx2_ulaw_encode,
+	avx2_ulaw_decode,
+	avx2_alaw_encode,
+	avx2_alaw_decode,
+	avx2_add_saturate,
+	avx2_subtract,
+	avx2_scale,
+	avx2_downmix_stereo,
+	avx2_upmix_mono,
+	avx2_accumulate,
+	avx2_mix_minus
+};
+
+#endif /* SIMD_X86 */
+
+
+#ifdef SIMD_NEON
+
+static inline uint16x8_t neon_ulaw_encode8(int16x8_t x)
+{
+	uint16x8_t neg = vcltq_s16(x, vdupq_n_s16(0));
+	uint16x8_t mag = vaddq_u16(vreinterpretq_u16_s16(vabsq_s16(x)), vdupq_n_u16(ULAW_BIAS));
+	uint16x8_t big = vcgeq_u16(mag, vdupq_n_u16(0x8000));
+	uint16x8_t seg = vsubq_u16(vdupq_n_u16(8), vclzq_u16(vorrq_u16(mag, vdupq_n_u16(0xFF))));
+	int16x8_t shift = vnegq_s16(vreinterpretq_s16_u16(vaddq_u16(seg, vdupq_n_u16(3))));
+	uint16x8_t m = vandq_u16(vshlq_u16(mag, shift), vdupq_n_u16(0x0F));
+	uint16x8_t u = vbslq_u16(big, vdupq_n_u16(0x7F), vorrq_u16(vshlq_n_u16(seg, 4), m));
+
+	return veorq_u16(u, veorq_u16(vdupq_n_u16(0xFF), vandq_u16(neg, vdupq_n_u16(0x80))));
+}
+
+static inline uint16x8_t neon_alaw_encode8(int16x8_t x)
+{
+	uint16x8_t neg = vcltq_s16(x, vdupq_n_s16(0));
+	int16x8_t slin = vbslq_s16(neg, vsubq_s16(vnegq_s16(x), vdupq_n_s16(8)), x);
+	uint16x8_t lin = vreinterpretq_u16_s16(vmaxq_s16(slin, vdupq_n_s16(0)));
+	uint16x8_t seg = vsubq_u16(vdupq_n_u16(8), vclzq_u16(vorrq_u16(lin, vdupq_n_u16(0xFF))));
+	/* seg + 3, or 4 for the first segment */
+	uint16x8_t sh = vsubq_u16(vaddq_u16(seg, vdupq_n_u16(3)), vceqq_u16(seg, vdupq_n_u16(0)));
+	uint16x8_t m = vandq_u16(vshlq_u16(lin, vnegq_s16(vreinterpretq_s16_u16(sh))), vdupq_n_u16(0x0F));
+	uint16x8_t a = vorrq_u16(vshlq_n_u16(seg, 4), m);
+
+	return veorq_u16(a, veorq_u16(vdupq_n_u16(ALAW_AMI_MASK | 0x80), vandq_u16(neg, vdupq_n_u16(0x80))));
+}
+
+static inline int16x8_t neon_ulaw_decode8(uint8x8_t e)
+{
+	uint16x8_t u = vmovl_u8(vmvn_u8(e));
+	uint16x8_t t = vaddq_u16(vshlq_n_u16(vandq_u16(u, vdupq_n_u16(0x0F)), 3), vdupq_n_u16(ULAW_BIAS));
+	uint16x8_t sign = vtstq_u16(u, vdupq_n_u16(0x80));
+	int16x8_t r;
+
+	t = vshlq_u16(t, vreinterpretq_s16_u16(vshrq_n_u16(vandq_u16(u, vdupq_n_u16(0x70)), 4)));
+	r = vsubq_s16(vreinterpretq_s16_u16(t), vdupq_n_s16(ULAW_BIAS));
+
+	return vbslq_s16(sign, vnegq_s16(r), r);
+}
+
+static inline int16x8_t neon_alaw_decode8(uint8x8_t e)
+{
+	uint16x8_t a = vmovl_u8(veor_u8(e, vdup_n_u8(ALAW_AMI_MASK)));
+	uint16x8_t i = vshlq_n_u16(vandq_u16(a, vdupq_n_u16(0x0F)), 4);
+	uint16x8_t seg = vshrq_n_u16(vandq_u16(a, vdupq_n_u16(0x70)), 4);
+	uint16x8_t pos = vtstq_u16(a, vdupq_n_u16(0x80));
+	int16x8_t r;
+
+	i = vaddq_u16(i, vbslq_u16(vtstq_u16(seg, seg), vdupq_n_u16(0x108), vdupq_n_u16(8)));
+	i = vshlq_u16(i, vreinterpretq_s16_u16(vqsubq_u16(seg, vdupq_n_u16(1))));
+	r = vreinterpretq_s16_u16(i);
+
+	return vbslq_s16(pos, r, vnegq_s16(r));
+}
+
+static void neon_ulaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		uint16x8_t lo = neon_ulaw_encode8(vld1q_s16(dbuf + i));
+		uint16x8_t hi = neon_ulaw_encode8(vld1q_s16(dbuf + i + 8));
+		vst1q_u8(ebuf + i, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+	}
+
+	scalar_ulaw_encode(ebuf + i, dbuf + i, samples - i);
+}
+
+static void neon_alaw_encode(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		uint16x8_t lo = neon_alaw_encode8(vld1q_s16(dbuf + i));
+		uint16x8_t hi = neon_alaw_encode8(vld1q_s16(dbuf + i + 8));
+		vst1q_u8(ebuf + i, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+	}
+
+	scalar_alaw_encode(ebuf + i, dbuf + i, samples - i);
+}
+
+static void neon_ulaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		uint8x16_t e = vld1q_u8(ebuf + i);
+		vst1q_s16(dbuf + i, neon_ulaw_decode8(vget_low_u8(e)));
+		vst1q_s16(dbuf + i + 8, neon_ulaw_decode8(vget_high_u8(e)));
+	}
+
+	scalar_ulaw_decode(dbuf + i, ebuf + i, samples - i);
+}
+
+static void neon_alaw_decode(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= samples; i += 16) {
+		uint8x16_t e = vld1q_u8(ebuf + i);
+		vst1q_s16(dbuf + i, neon_alaw_decode8(vget_low_u8(e)));
+		vst1q_s16(dbuf + i + 8, neon_alaw_decode8(vget_high_u8(e)));
+	}
+
+	scalar_alaw_decode(dbuf + i, ebuf + i, samples - i);
+}
+
+static void neon_add_saturate(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		vst1q_s16(data + i, vqaddq_s16(vld1q_s16(data + i), vld1q_s16(other_data + i)));
+	}
+
+	scalar_add_saturate(data + i, other_data + i, samples - i);
+}
+
+static void neon_subtract(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		vst1q_s16(data + i, vsubq_s16(vld1q_s16(data + i), vld1q_s16(other_data + i)));
+	}
+
+	scalar_subtract(data + i, other_data + i, samples - i);
+}
+
+static inline int32x2_t neon_scale2(int32x2_t v, double factor)
+{
+	float64x2_t d = vmulq_n_f64(vcvtq_f64_s64(vmovl_s32(v)), factor);
+
+	return vqmovn_s64(vcvtq_s64_f64(d));
+}
+
+static inline int16x4_t neon_scale4(int16x4_t v, double factor)
+{
+	int32x4_t w = vmovl_s16(v);
+
+	return vqmovn_s32(vcombine_s32(neon_scale2(vget_low_s32(w), factor), neon_scale2(vget_high_s32(w), factor)));
+}
+
+static void neon_scale(int16_t *data, uint32_t samples, double factor)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		int16x8_t v = vld1q_s16(data + i);
+		vst1q_s16(data + i, vcombine_s16(neon_scale4(vget_low_s16(v), factor), neon_scale4(vget_high_s16(v), factor)));
+	}
+
+	scalar_scale(data + i, samples - i, factor);
+}
+
+static void neon_downmix_stereo(int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		int16x8x2_t lr = vld2q_s16(data + i * 2);
+		vst1q_s16(data + i, vqaddq_s16(lr.val[0], lr.val[1]));
+	}
+
+	scalar_downmix_stereo_range(data, i, samples);
+}
+
+static void neon_upmix_mono(int16_t *data, uint32_t samples)
+{
+	uint32_t i = samples & ~7U;
+
+	scalar_upmix_mono_range(data, i, samples);
+
+	while (i) {
+		int16x8x2_t lr;
+
+		i -= 8;
+		lr.val[0] = lr.val[1] = vld1q_s16(data + i);
+		vst2q_s16(data + i * 2, lr);
+	}
+}
+
+static void neon_accumulate(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		int16x8_t v = vld1q_s16(data + i);
+		vst1q_s32(mix + i, vaddw_s16(vld1q_s32(mix + i), vget_low_s16(v)));
+		vst1q_s32(mix + i + 4, vaddw_s16(vld1q_s32(mix + i + 4), vget_high_s16(v)));
+	}
+
+	scalar_accumulate(mix + i, data + i, samples - i);
+}
+
+static void neon_mix_minus(int16_t *out, const int32_t *mix, const int16_t *self, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i + 8 <= samples; i += 8) {
+		int32x4_t lo = vld1q_s32(mix + i);
+		int32x4_t hi = vld1q_s32(mix + i + 4);
+
+		if (self) {
+			int16x8_t v = vld1q_s16(self + i);
+			lo = vsubw_s16(lo, vget_low_s16(v));
+			hi = vsubw_s16(hi, vget_high_s16(v));
+		}
+
+		vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
+
+	scalar_mix_minus(out + i, mix + i, self ? self + i : NULL, samples - i);
+}
+
+static const simd_ops_t neon_ops = {
+	neon_ulaw_encode,
+	neon_ulaw_decode,
+	neon_alaw_encode,
+	neon_alaw_decode,
+	neon_add_saturate,
+	neon_subtract,
+	neon_scale,
+	neon_downmix_stereo,
+	neon_upmix_mono,
+	neon_accumulate,
+	neon_mix_minus
+};
+
+#endif /* SIMD_NEON */
+
+
+static struct {
+	switch_simd_level_t level;
+	const simd_ops_t *ops;
+} globals = { SWITCH_SIMD_NONE, &scalar_ops };
+
+SWITCH_DECLARE(switch_simd_level_t) switch_simd_detect(void)
+{
+#if defined(SIMD_X86)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		return SWITCH_SIMD_AVX2;
+	}
+
+	if (__builtin_cpu_supports("sse2")) {
+		return SWITCH_SIMD_SSE2;
+	}
+#elif defined(SIMD_NEON)
+	/* Advanced SIMD is part of the aarch64 baseline */
+	return SWITCH_SIMD_NEON;
+#endif
+
+	return SWITCH_SIMD_NONE;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_simd_set_level(switch_simd_level_t level)
+{
+	switch_simd_level_t best = switch_simd_detect();
+	const simd_ops_t *ops = NULL;
+
+	switch (level) {
+	case SWITCH_SIMD_NONE:
+		ops = &scalar_ops;
+		break;
+#ifdef SIMD_X86
+	case SWITCH_SIMD_SSE2:
+		if (best >= SWITCH_SIMD_SSE2) {
+			ops = &sse2_ops;
+		}
+		break;
+	case SWITCH_SIMD_AVX2:
+		if (best >= SWITCH_SIMD_AVX2) {
+			ops = &avx2_ops;
+		}
+		break;
+#endif
+#ifdef SIMD_NEON
+	case SWITCH_SIMD_NEON:
+		ops = &neon_ops;
+		break;
+#endif
+	default:
+		break;
+	}
+
+	if (!ops) {
+		return SWITCH_STATUS_NOTIMPL;
+	}
+
+	globals.ops = ops;
+	globals.level = level;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_simd_level_t) switch_simd_level(void)
+{
+	return globals.level;
+}
+
+SWITCH_DECLARE(void) switch_simd_init(void)
+{
+	switch_simd_set_level(switch_simd_detect());
+}
+
+SWITCH_DECLARE(const char *) switch_simd_level_name(switch_simd_level_t level)
+{
+	switch (level) {
+	case SWITCH_SIMD_SSE2:
+		return "sse2";
+	case SWITCH_SIMD_AVX2:
+		return "avx2";
+	case SWITCH_SIMD_NEON:
+		return "neon";
+	default:
+		return "none";
+	}
+}
+
+SWITCH_DECLARE(switch_simd_level_t) switch_simd_level_from_name(const char *name)
+{
+	if (!zstr(name)) {
+		if (!strcasecmp(name, "sse2")) {
+			return SWITCH_SIMD_SSE2;
+		} else if (!strcasecmp(name, "avx2")) {
+			return SWITCH_SIMD_AVX2;
+		} else if (!strcasecmp(name, "neon")) {
+			return SWITCH_SIMD_NEON;
+		} else if (!strcasecmp(name, "auto")) {
+			return switch_simd_detect();
+		}
+	}
+
+	return SWITCH_SIMD_NONE;
+}
+
+SWITCH_DECLARE(void) switch_g711u_encode_block(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	globals.ops->ulaw_encode(ebuf, dbuf, samples);
+}
+
+SWITCH_DECLARE(void) switch_g711u_decode_block(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	globals.ops->ulaw_decode(dbuf, ebuf, samples);
+}
+
+SWITCH_DECLARE(void) switch_g711a_encode_block(uint8_t *ebuf, const int16_t *dbuf, uint32_t samples)
+{
+	globals.ops->alaw_encode(ebuf, dbuf, samples);
+}
+
+SWITCH_DECLARE(void) switch_g711a_decode_block(int16_t *dbuf, const uint8_t *ebuf, uint32_t samples)
+{
+	globals.ops->alaw_decode(dbuf, ebuf, samples);
+}
+
+SWITCH_DECLARE(void) switch_sln_add_saturate(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	globals.ops->add_saturate(data, other_data, samples);
+}
+
+SWITCH_DECLARE(void) switch_sln_subtract(int16_t *data, const int16_t *other_data, uint32_t samples)
+{
+	globals.ops->subtract(data, other_data, samples);
+}
+
+SWITCH_DECLARE(void) switch_sln_scale(int16_t *data, uint32_t samples, double factor)
+{
+	globals.ops->scale(data, samples, factor);
+}
+
+SWITCH_DECLARE(void) switch_sln_downmix_stereo(int16_t *data, uint32_t samples)
+{
+	globals.ops->downmix_stereo(data, samples);
+}
+
+SWITCH_DECLARE(void) switch_sln_upmix_mono(int16_t *data, uint32_t samples)
+{
+	globals.ops->upmix_mono(data, samples);
+}
+
+SWITCH_DECLARE(void) switch_sln_accumulate(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	globals.ops->accumulate(mix, data, samples);
+}
+
+SWITCH_DECLARE(void) switch_sln_mix_minus(int16_t *out, const int32_t *mix, const int16_t *self, uint32_t samples)
+{
+	globals.ops->mix_minus(out, mix, self, samples);
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
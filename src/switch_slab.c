@@ -0,0 +1,531 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_slab.c -- Size class allocator for short lived core objects
+ *
+ */
+
+#include <switch.h>
+#include <switch_slab.h>
+
+#if !defined(WIN32) && !defined(SWITCH_SLAB_NO_TCACHE)
+#define SLAB_TCACHE 1
+#include <pthread.h>
+#endif
+
+/* every block carries a header so switch_slab_free() does not need the size back */
+#define SLAB_HDR 16
+#define SLAB_MAGIC 0x51AB
+#define SLAB_LARGE 0xFFFF
+/* a large block handed out before init, it was never counted so it is not uncounted either */
+#define SLAB_LARGE_EARLY 0xFFFE
+#define SLAB_PAGE (64 * 1024)
+/* a thread keeps up to SLAB_TCACHE_MAX free blocks per class and trades SLAB_BATCH at a time with the depot */
+#define SLAB_TCACHE_MAX 64
+#define SLAB_BATCH 32
+
+static const uint32_t slab_sizes[] = { 16, 32, 48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 512, 768, 1024, 2048, 4096 };
+#define SLAB_CLASSES (sizeof(slab_sizes) / sizeof(slab_sizes[0]))
+#define SLAB_MAX_SIZE 4096
+
+typedef struct {
+	uint16_t magic;
+	uint16_t cls;
+	uint32_t size;
+} slab_hdr_t;
+
+typedef struct slab_free_s {
+	struct slab_free_s *next;
+} slab_free_t;
+
+typedef struct {
+	uint64_t requests;
+	uint64_t hits;
+	uint64_t frees;
+	uint64_t bytes;
+} slab_counters_t;
+
+typedef struct {
+	switch_mutex_t *mutex;
+	slab_free_t *free;
+	uint32_t free_count;
+	uint32_t blocks;
+	slab_counters_t counters;
+} slab_depot_t;
+
+typedef struct slab_page_s {
+	struct slab_page_s *next;
+} slab_page_t;
+
+static struct {
+	int ready;
+	switch_mutex_t *mutex;
+	slab_depot_t depot[SLAB_CLASSES];
+	uint8_t lookup[SLAB_MAX_SIZE / 16 + 1];
+	slab_page_t *pages;
+	uint64_t page_count;
+	uint64_t large_requests;
+	uint64_t large_bytes;
+	uint64_t system_allocs;
+#ifdef SLAB_TCACHE
+	pthread_key_t key;
+#endif
+} globals;
+
+#ifdef SLAB_TCACHE
+typedef struct {
+	slab_free_t *free[SLAB_CLASSES];
+	uint32_t count[SLAB_CLASSES];
+	/* counted locally and folded into the depot whenever this thread visits it */
+	slab_counters_t counters[SLAB_CLASSES];
+} slab_tcache_t;
+
+static __thread slab_tcache_t *tcache;
+#endif
+
+static void fold_counters(slab_counters_t *into, slab_counters_t *from)
+{
+	into->requests += from->requests;
+	into->hits += from->hits;
+	into->frees += from->frees;
+	into->bytes += from->bytes;
+	memset(from, 0, sizeof(*from));
+}
+
+/* depot mutex held, carve a fresh page into blocks of this class */
+static void depot_grow(slab_depot_t *depot, int cls)
+{
+	uint32_t block = SLAB_HDR + slab_sizes[cls], n, i;
+	slab_page_t *page;
+	uint8_t *p;
+
+	if (!(page = malloc(SLAB_PAGE))) {
+		return;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	page->next = globals.pages;
+	globals.pages = page;
+	globals.page_count++;
+	globals.system_allocs++;
+	switch_mutex_unlock(globals.mutex);
+
+	p = (uint8_t *) page + SLAB_HDR;
+	n = (SLAB_PAGE - SLAB_HDR) / block;
+
+	for (i = 0; i < n; i++, p += block) {
+		slab_hdr_t *hdr = (slab_hdr_t *) p;
+		slab_free_t *f = (slab_free_t *) (p + SLAB_HDR);
+
+		hdr->magic = SLAB_MAGIC;
+		hdr->cls = (uint16_t) cls;
+		f->next = depot->free;
+		depot->free = f;
+	}
+
+	depot->free_count += n;
+	depot->blocks += n;
+}
+
+static int slab_class(switch_size_t size)
+{
+	if (size > SLAB_MAX_SIZE) {
+		return -1;
+	}
+
+	return globals.lookup[(size + 15) / 16];
+}
+
+static void *large_alloc(switch_size_t size)
+{
+	slab_hdr_t *hdr;
+
+	if (!(hdr = malloc(SLAB_HDR + size))) {
+		return NULL;
+	}
+
+	hdr->magic = SLAB_MAGIC;
+	hdr->cls = globals.ready ? SLAB_LARGE : SLAB_LARGE_EARLY;
+	hdr->size = (uint32_t) size;
+
+	if (globals.ready) {
+		switch_mutex_lock(globals.mutex);
+		globals.large_requests++;
+		globals.large_bytes += size;
+		globals.system_allocs++;
+		switch_mutex_unlock(globals.mutex);
+	}
+
+	return (uint8_t *) hdr + SLAB_HDR;
+}
+
+#ifdef SLAB_TCACHE
+static void tcache_flush(slab_tcache_t *tc)
+{
+	uint32_t cls;
+
+	for (cls = 0; cls < SLAB_CLASSES; cls++) {
+		slab_depot_t *depot = &globals.depot[cls];
+		slab_free_t *f;
+
+		switch_mutex_lock(depot->mutex);
+		while ((f = tc->free[cls])) {
+			tc->free[cls] = f->next;
+			f->next = depot->free;
+			depot->free = f;
+			depot->free_count++;
+		}
+		tc->count[cls] = 0;
+		fold_counters(&depot->counters, &tc->counters[cls]);
+		switch_mutex_unlock(depot->mutex);
+	}
+}
+
+static void tcache_destroy(void *obj)
+{
+	slab_tcache_t *tc = (slab_tcache_t *) obj;
+
+	if (globals.ready) {
+		tcache_flush(tc);
+	}
+
+	free(tc);
+}
+
+static slab_tcache_t *tcache_get(void)
+{
+	if (!tcache && (tcache = calloc(1, sizeof(*tcache)))) {
+		pthread_setspecific(globals.key, tcache);
+	}
+
+	return tcache;
+}
+#endif
+
+SWITCH_DECLARE(void *) switch_slab_alloc(switch_size_t size)
+{
+	slab_depot_t *depot;
+	slab_free_t *f = NULL;
+	int cls;
+#ifdef SLAB_TCACHE
+	slab_tcache_t *tc;
+#endif
+
+	if (!globals.ready || (cls = slab_class(size)) < 0) {
+		return large_alloc(size);
+	}
+
+	depot = &globals.depot[cls];
+
+#ifdef SLAB_TCACHE
+	if ((tc = tcache_get())) {
+		tc->counters[cls].requests++;
+		tc->counters[cls].bytes += slab_sizes[cls];
+
+		if ((f = tc->free[cls])) {
+			tc->free[cls] = f->next;
+			tc->count[cls]--;
+			tc->counters[cls].hits++;
+			return f;
+		}
+
+		/* refill the thread cache with a batch so the depot lock is taken once per SLAB_BATCH allocations */
+		switch_mutex_lock(depot->mutex);
+		if (!depot->free) {
+			depot_grow(depot, cls);
+		}
+		while (depot->free && tc->count[cls] < SLAB_BATCH) {
+			slab_free_t *b = depot->free;
+
+			depot->free = b->next;
+			depot->free_count--;
+			b->next = tc->free[cls];
+			tc->free[cls] = b;
+			tc->count[cls]++;
+		}
+		fold_counters(&depot->counters, &tc->counters[cls]);
+		switch_mutex_unlock(depot->mutex);
+
+		if ((f = tc->free[cls])) {
+			tc->free[cls] = f->next;
+			tc->count[cls]--;
+		}
+
+		return f;
+	}
+#endif
+
+	switch_mutex_lock(depot->mutex);
+	if (!depot->free) {
+		depot_grow(depot, cls);
+	}
+	if ((f = depot->free)) {
+		depot->free = f->next;
+		depot->free_count--;
+	}
+	depot->counters.requests++;
+	depot->counters.bytes += slab_sizes[cls];
+	switch_mutex_unlock(depot->mutex);
+
+	return f;
+}
+
+SWITCH_DECLARE(void *) switch_slab_zalloc(switch_size_t size)
+{
+	void *ptr;
+
+	if ((ptr = switch_slab_alloc(size))) {
+		memset(ptr, 0, size);
+	}
+
+	return ptr;
+}
+
+SWITCH_DECLARE(char *) switch_slab_strdup(const char *str)
+{
+	size_t len;
+	char *ptr;
+
+	if (!str) {
+		return NULL;
+	}
+
+	len = strlen(str) + 1;
+
+	if ((ptr = switch_slab_alloc(len))) {
+		memcpy(ptr, str, len);
+	}
+
+	return ptr;
+}
+
+SWITCH_DECLARE(void) switch_slab_free(void *ptr)
+{
+	slab_hdr_t *hdr;
+	slab_depot_t *depot;
+	slab_free_t *f = (slab_free_t *) ptr;
+	int cls;
+#ifdef SLAB_TCACHE
+	slab_tcache_t *tc;
+#endif
+
+	if (!ptr) {
+		return;
+	}
+
+	hdr = (slab_hdr_t *) ((uint8_t *) ptr - SLAB_HDR);
+	switch_assert(hdr->magic == SLAB_MAGIC);
+
+	if (hdr->cls == SLAB_LARGE || hdr->cls == SLAB_LARGE_EARLY) {
+		if (globals.ready && hdr->cls == SLAB_LARGE) {
+			switch_mutex_lock(globals.mutex);
+			globals.large_bytes -= hdr->size;
+			switch_mutex_unlock(globals.mutex);
+		}
+		free(hdr);
+		return;
+	}
+
+	if (!globals.ready) {
+		/* the core is gone, the pages go with the process */
+		return;
+	}
+
+	cls = hdr->cls;
+	depot = &globals.depot[cls];
+
+#ifdef SLAB_TCACHE
+	if ((tc = tcache_get())) {
+		f->next = tc->free[cls];
+		tc->free[cls] = f;
+		tc->counters[cls].frees++;
+		tc->counters[cls].bytes -= slab_sizes[cls];
+
+		if (++tc->count[cls] > SLAB_TCACHE_MAX) {
+			/* give a batch back so a thread that only frees (an event consumer) does not hoard blocks */
+			switch_mutex_lock(depot->mutex);
+			while (tc->count[cls] > SLAB_TCACHE_MAX - SLAB_BATCH) {
+				slab_free_t *b = tc->free[cls];
+
+				tc->free[cls] = b->next;
+				tc->count[cls]--;
+				b->next = depot->free;
+				depot->free = b;
+				depot->free_count++;
+			}
+			fold_counters(&depot->counters, &tc->counters[cls]);
+			switch_mutex_unlock(depot->mutex);
+		}
+
+		return;
+	}
+#endif
+
+	switch_mutex_lock(depot->mutex);
+	f->next = depot->free;
+	depot->free = f;
+	depot->free_count++;
+	depot->counters.frees++;
+	depot->counters.bytes -= slab_sizes[cls];
+	switch_mutex_unlock(depot->mutex);
+}
+
+SWITCH_DECLARE(void) switch_slab_thread_flush(void)
+{
+#ifdef SLAB_TCACHE
+	if (globals.ready && tcache) {
+		tcache_flush(tcache);
+	}
+#endif
+}
+
+SWITCH_DECLARE(void) switch_slab_get_totals(uint64_t *requests, uint64_t *system_allocs)
+{
+	uint32_t cls;
+	uint64_t total = 0;
+
+	switch_slab_thread_flush();
+
+	if (!globals.ready) {
+		*requests = *system_allocs = 0;
+		return;
+	}
+
+	for (cls = 0; cls < SLAB_CLASSES; cls++) {
+		switch_mutex_lock(globals.depot[cls].mutex);
+		total += globals.depot[cls].counters.requests;
+		switch_mutex_unlock(globals.depot[cls].mutex);
+	}
+
+	switch_mutex_lock(globals.mutex);
+	*requests = total + globals.large_requests;
+	*system_allocs = globals.system_allocs;
+	switch_mutex_unlock(globals.mutex);
+}
+
+SWITCH_DECLARE(void) switch_slab_stats(switch_stream_handle_t *stream, switch_bool_t reset)
+{
+	uint32_t cls;
+	uint64_t requests = 0, hits = 0;
+	int64_t bytes = 0;
+
+	if (!globals.ready) {
+		stream->write_function(stream, "-ERR slab allocator not running\n");
+		return;
+	}
+
+	/* counters of other threads are folded in as they visit the depot, so this is exact only for the calling thread */
+	switch_slab_thread_flush();
+
+	stream->write_function(stream, "%6s %12s %12s %8s %14s %10s %10s\n", "class", "requests", "in use", "hit %", "bytes in use", "free", "blocks");
+
+	for (cls = 0; cls < SLAB_CLASSES; cls++) {
+		slab_depot_t *depot = &globals.depot[cls];
+		slab_counters_t c;
+		uint32_t free_count, blocks;
+
+		switch_mutex_lock(depot->mutex);
+		c = depot->counters;
+		free_count = depot->free_count;
+		blocks = depot->blocks;
+		if (reset) {
+			depot->counters.requests = depot->counters.hits = 0;
+		}
+		switch_mutex_unlock(depot->mutex);
+
+		if (!blocks && !c.requests) {
+			continue;
+		}
+
+		stream->write_function(stream, "%6u %12" SWITCH_UINT64_T_FMT " %12" SWITCH_INT64_T_FMT " %7.1f%% %14" SWITCH_INT64_T_FMT " %10u %10u\n",
+							   slab_sizes[cls], c.requests, (int64_t) c.bytes / slab_sizes[cls],
+							   c.requests ? (double) c.hits * 100 / c.requests : 0.0, (int64_t) c.bytes, free_count, blocks);
+
+		requests += c.requests;
+		hits += c.hits;
+		bytes += (int64_t) c.bytes;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	stream->write_function(stream, "%6s %12" SWITCH_UINT64_T_FMT " %12s %8s %14" SWITCH_UINT64_T_FMT "\n", "large", globals.large_requests, "", "",
+						   globals.large_bytes);
+	stream->write_function(stream, "\ntotal: %" SWITCH_UINT64_T_FMT " requests, %.1f%% thread cache hits, %" SWITCH_INT64_T_FMT
+						   " bytes in use, %" SWITCH_UINT64_T_FMT " pages (%" SWITCH_UINT64_T_FMT " KB), %" SWITCH_UINT64_T_FMT " system allocations\n",
+						   requests + globals.large_requests, requests ? (double) hits * 100 / requests : 0.0, bytes + (int64_t) globals.large_bytes,
+						   globals.page_count, globals.page_count * SLAB_PAGE / 1024, globals.system_allocs);
+	if (reset) {
+		globals.large_requests = 0;
+		globals.system_allocs = 0;
+	}
+	switch_mutex_unlock(globals.mutex);
+}
+
+SWITCH_DECLARE(void) switch_slab_init(switch_memory_pool_t *pool)
+{
+	uint32_t cls = 0, x;
+
+	if (globals.ready) {
+		return;
+	}
+
+	for (x = 0; x <= SLAB_MAX_SIZE / 16; x++) {
+		while (slab_sizes[cls] < x * 16) {
+			cls++;
+		}
+		globals.lookup[x] = (uint8_t) cls;
+	}
+
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool);
+
+	for (cls = 0; cls < SLAB_CLASSES; cls++) {
+		switch_mutex_init(&globals.depot[cls].mutex, SWITCH_MUTEX_NESTED, pool);
+	}
+
+#ifdef SLAB_TCACHE
+	pthread_key_create(&globals.key, tcache_destroy);
+#endif
+
+	globals.ready = 1;
+}
+
+SWITCH_DECLARE(void) switch_slab_shutdown(void)
+{
+	/* blocks may still be referenced by whatever is winding down, the pages are left to the process exit */
+	globals.ready = 0;
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
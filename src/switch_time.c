@@ -967,6 +967,467 @@ static switch_status_t timer_destroy(switch_timer_t *timer)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+/*
+ * "wheel" timer interface
+ *
+ * Every wheel timer lives in a hierarchical timing wheel driven by one thread at 1ms.
+ * Expirations due on the same tick are collected under a single lock and the
+ * owners are woken per group, one broadcast per group and tick, instead of every
+ * session polling its own interval.  Groups follow the cpu the timer was created
+ * on so the threads sharing a condition tend to share a core.
+ */
+
+#define WHEEL_LEVELS 4
+#define WHEEL_L0_BITS 8
+#define WHEEL_LN_BITS 6
+#define WHEEL_L0_SIZE (1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE (1 << WHEEL_LN_BITS)
+#define WHEEL_LN_MASK (WHEEL_LN_SIZE - 1)
+#define WHEEL_MAX_GROUPS 64
+#define WHEEL_MAX_CATCHUP 100 /* ticks */
+
+typedef struct wheel_group_s {
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	uint32_t count;
+	uint32_t pending;
+} wheel_group_t;
+
+typedef struct wheel_timer_s {
+	switch_timer_t *timer;
+	uint64_t expires;
+	volatile uint64_t tick;
+	uint64_t reference;
+	uint64_t start;
+	uint32_t ready;
+	wheel_group_t *group;
+	struct wheel_timer_s **head;
+	struct wheel_timer_s *next;
+	struct wheel_timer_s *prev;
+} wheel_timer_t;
+
+static struct {
+	volatile int running;
+	uint64_t now;
+	switch_time_t epoch;
+	wheel_timer_t *slots[WHEEL_LEVELS][WHEEL_L0_SIZE];
+	wheel_group_t groups[WHEEL_MAX_GROUPS];
+	wheel_group_t *touched[WHEEL_MAX_GROUPS];
+	uint32_t group_count;
+	uint32_t next_group;
+	uint32_t timer_count;
+	switch_mutex_t *mutex;
+	switch_thread_t *thread;
+	uint64_t ticks;
+	uint64_t expirations;
+	uint64_t wakeups;
+	uint64_t busy_usec;
+	uint64_t late_usec;
+	uint64_t max_late_usec;
+} wheel;
+
+static void wheel_insert(wheel_timer_t *wt)
+{
+	uint64_t delta = wt->expires > wheel.now ? wt->expires - wheel.now : 0;
+	wheel_timer_t **head;
+
+	if (delta < WHEEL_L0_SIZE) {
+		head = &wheel.slots[0][wt->expires & (WHEEL_L0_SIZE - 1)];
+	} else if (delta < (1 << (WHEEL_L0_BITS + WHEEL_LN_BITS))) {
+		head = &wheel.slots[1][(wt->expires >> WHEEL_L0_BITS) & WHEEL_LN_MASK];
+	} else if (delta < (1 << (WHEEL_L0_BITS + 2 * WHEEL_LN_BITS))) {
+		head = &wheel.slots[2][(wt->expires >> (WHEEL_L0_BITS + WHEEL_LN_BITS)) & WHEEL_LN_MASK];
+	} else {
+		head = &wheel.slots[3][(wt->expires >> (WHEEL_L0_BITS + 2 * WHEEL_LN_BITS)) & WHEEL_LN_MASK];
+	}
+
+	wt->head = head;
+	wt->prev = NULL;
+	if ((wt->next = *head)) {
+		wt->next->prev = wt;
+	}
+	*head = wt;
+}
+
+static void wheel_remove(wheel_timer_t *wt)
+{
+	if (!wt->head) {
+		return;
+	}
+
+	if (wt->prev) {
+		wt->prev->next = wt->next;
+	} else {
+		*wt->head = wt->next;
+	}
+
+	if (wt->next) {
+		wt->next->prev = wt->prev;
+	}
+
+	wt->head = NULL;
+	wt->next = wt->prev = NULL;
+}
+
+static void wheel_cascade(int level, uint32_t index)
+{
+	wheel_timer_t *wt = wheel.slots[level][index], *next;
+
+	wheel.slots[level][index] = NULL;
+
+	for (; wt; wt = next) {
+		next = wt->next;
+		wheel_insert(wt);
+	}
+}
+
+/* advance one tick, call with wheel.mutex held; returns the number of groups to wake */
+static uint32_t wheel_advance(uint32_t touched)
+{
+	wheel_timer_t *wt, *next;
+	uint64_t now = ++wheel.now;
+	int level;
+
+	if (!(now & (WHEEL_L0_SIZE - 1))) {
+		for (level = 1; level < WHEEL_LEVELS; level++) {
+			uint32_t index = (uint32_t)(now >> (WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS)) & WHEEL_LN_MASK;
+
+			wheel_cascade(level, index);
+
+			if (index) {
+				break;
+			}
+		}
+	}
+
+	wt = wheel.slots[0][now & (WHEEL_L0_SIZE - 1)];
+	wheel.slots[0][now & (WHEEL_L0_SIZE - 1)] = NULL;
+
+	for (; wt; wt = next) {
+		next = wt->next;
+
+		wt->tick++;
+		wt->expires += wt->timer->interval;
+		wheel_insert(wt);
+		wheel.expirations++;
+
+		if (!wt->group->pending) {
+			wt->group->pending = 1;
+			wheel.touched[touched++] = wt->group;
+		}
+	}
+
+	wheel.ticks++;
+
+	return touched;
+}
+
+static void *SWITCH_THREAD_FUNC wheel_thread_run(switch_thread_t *thread, void *obj)
+{
+	switch_time_t due, now, started;
+	uint32_t i, touched, catchup;
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Timer wheel started with %u wake groups\n", wheel.group_count);
+
+	while (wheel.running == 1) {
+		due = wheel.epoch + (switch_time_t)(wheel.now + 1) * 1000;
+		now = switch_time_ref();
+
+		if (due > now) {
+			do_sleep(due - now);
+			now = switch_time_ref();
+		}
+
+		started = now;
+		touched = 0;
+		catchup = 0;
+
+		switch_mutex_lock(wheel.mutex);
+		if (now > due) {
+			uint64_t late = (uint64_t)(now - due);
+
+			wheel.late_usec += late;
+			if (late > wheel.max_late_usec) {
+				wheel.max_late_usec = late;
+			}
+		}
+
+		do {
+			touched = wheel_advance(touched);
+		} while (wheel.epoch + (switch_time_t)(wheel.now + 1) * 1000 <= now && ++catchup < WHEEL_MAX_CATCHUP);
+		switch_mutex_unlock(wheel.mutex);
+
+		if (catchup == WHEEL_MAX_CATCHUP) {
+			/* we were stalled, don't burst hundreds of ticks at the sessions */
+			wheel.epoch = now - (switch_time_t)wheel.now * 1000;
+		}
+
+		for (i = 0; i < touched; i++) {
+			wheel_group_t *group = wheel.touched[i];
+
+			switch_mutex_lock(group->mutex);
+			group->pending = 0;
+			switch_thread_cond_broadcast(group->cond);
+			switch_mutex_unlock(group->mutex);
+		}
+
+		switch_mutex_lock(wheel.mutex);
+		wheel.wakeups += touched;
+		wheel.busy_usec += (uint64_t)(switch_time_ref() - started);
+		switch_mutex_unlock(wheel.mutex);
+	}
+
+	for (i = 0; i < wheel.group_count; i++) {
+		switch_mutex_lock(wheel.groups[i].mutex);
+		switch_thread_cond_broadcast(wheel.groups[i].cond);
+		switch_mutex_unlock(wheel.groups[i].mutex);
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Timer wheel stopped\n");
+
+	return NULL;
+}
+
+static switch_status_t wheel_start(void)
+{
+	switch_threadattr_t *thd_attr = NULL;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	if (wheel.running == 1) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_lock(wheel.mutex);
+	if (wheel.running == 0) {
+		wheel.epoch = switch_time_ref();
+		wheel.running = 1;
+		switch_threadattr_create(&thd_attr, module_pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+		if (switch_thread_create(&wheel.thread, thd_attr, wheel_thread_run, NULL, module_pool) != SWITCH_STATUS_SUCCESS) {
+			wheel.running = 0;
+		}
+	}
+	if (wheel.running != 1) {
+		status = SWITCH_STATUS_FALSE;
+	}
+	switch_mutex_unlock(wheel.mutex);
+
+	return status;
+}
+
+static void wheel_stop(void)
+{
+	switch_status_t st;
+
+	if (wheel.running != 1) {
+		return;
+	}
+
+	switch_mutex_lock(wheel.mutex);
+	wheel.running = -1;
+	switch_mutex_unlock(wheel.mutex);
+
+	switch_thread_join(&st, wheel.thread);
+	wheel.thread = NULL;
+}
+
+static wheel_group_t *wheel_pick_group(void)
+{
+	uint32_t idx;
+#ifdef HAVE_SCHED_GETCPU
+	int cpu = sched_getcpu();
+
+	if (cpu >= 0) {
+		idx = (uint32_t) cpu % wheel.group_count;
+	} else
+#endif
+	{
+		idx = wheel.next_group++ % wheel.group_count;
+	}
+
+	return &wheel.groups[idx];
+}
+
+static switch_status_t wheel_timer_init(switch_timer_t *timer)
+{
+	wheel_timer_t *wt;
+
+	if (timer->interval < 1 || timer->interval > MAX_ELEMENTS || !wheel.group_count) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (wheel_start() != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!(wt = switch_core_alloc(timer->memory_pool, sizeof(*wt)))) {
+		return SWITCH_STATUS_MEMERR;
+	}
+
+	wt->timer = timer;
+
+	switch_mutex_lock(wheel.mutex);
+	wt->group = wheel_pick_group();
+	wt->group->count++;
+	wheel.timer_count++;
+	wt->expires = wheel.now + timer->interval;
+	wt->start = wt->reference = wt->tick;
+	wt->start -= 2; /* switch_core_timer_init sets samplecount to samples, this makes first next() step once */
+	wt->ready = 1;
+	wheel_insert(wt);
+	switch_mutex_unlock(wheel.mutex);
+
+	timer->private_info = wt;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t wheel_timer_step(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+	uint64_t samples;
+
+	if (!wt || !wt->ready || wheel.running != 1) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	samples = (uint64_t)timer->samples * (wt->reference - wt->start);
+
+	if (samples > UINT32_MAX) {
+		wt->start = wt->reference - 1; /* Must have a diff */
+		samples = timer->samples;
+	}
+
+	timer->samplecount = (uint32_t) samples;
+	wt->reference++;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t wheel_timer_sync(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+
+	if (!wt || !wt->ready || wheel.running != 1) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	/* sync the clock */
+	wt->reference = (switch_size_t)(timer->tick = wt->tick);
+
+	/* apply timestamp */
+	wheel_timer_step(timer);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t wheel_timer_next(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+
+	if (!wt || !wt->ready) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	/* sync up timer if it's not been called for a while otherwise it will return instantly several times until it catches up */
+	if ((int64_t)(wt->reference - wt->tick) < -1) {
+		wt->reference = (switch_size_t)(timer->tick = wt->tick);
+	}
+	wheel_timer_step(timer);
+
+	if (wt->tick < wt->reference) {
+		switch_mutex_lock(wt->group->mutex);
+		while (wheel.running == 1 && wt->ready && wt->tick < wt->reference) {
+			switch_thread_cond_timedwait(wt->group->cond, wt->group->mutex, (switch_interval_time_t)timer->interval * 2000);
+		}
+		switch_mutex_unlock(wt->group->mutex);
+	}
+
+	timer->tick = wt->tick;
+
+	return wheel.running == 1 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+static switch_status_t wheel_timer_check(switch_timer_t *timer, switch_bool_t step)
+{
+	wheel_timer_t *wt = timer->private_info;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	if (!wt || !wt->ready || wheel.running != 1) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	timer->tick = wt->tick;
+
+	if (timer->tick < wt->reference) {
+		timer->diff = (switch_size_t)(wt->reference - timer->tick);
+	} else {
+		timer->diff = 0;
+	}
+
+	if (timer->diff) {
+		status = SWITCH_STATUS_FALSE;
+	} else if (step) {
+		wheel_timer_step(timer);
+	}
+
+	return status;
+}
+
+static switch_status_t wheel_timer_destroy(switch_timer_t *timer)
+{
+	wheel_timer_t *wt = timer->private_info;
+
+	if (!wt) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_lock(wheel.mutex);
+	if (wt->ready) {
+		wheel_remove(wt);
+		wt->group->count--;
+		wheel.timer_count--;
+		wt->ready = 0;
+	}
+	switch_mutex_unlock(wheel.mutex);
+
+	timer->private_info = NULL;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_time_wheel_stats(switch_stream_handle_t *stream, switch_bool_t reset)
+{
+	uint32_t i;
+
+	if (!wheel.mutex) {
+		stream->write_function(stream, "-ERR timer wheel not loaded\n");
+		return;
+	}
+
+	switch_mutex_lock(wheel.mutex);
+	stream->write_function(stream, "running: %s\ntimers: %u\ngroups: %u\n", wheel.running == 1 ? "true" : "false", wheel.timer_count, wheel.group_count);
+	for (i = 0; i < wheel.group_count; i++) {
+		if (wheel.groups[i].count) {
+			stream->write_function(stream, "group %u: %u timers\n", i, wheel.groups[i].count);
+		}
+	}
+	stream->write_function(stream, "ticks: %" SWITCH_UINT64_T_FMT "\nexpirations: %" SWITCH_UINT64_T_FMT "\nwakeups: %" SWITCH_UINT64_T_FMT "\n",
+						   wheel.ticks, wheel.expirations, wheel.wakeups);
+	stream->write_function(stream, "expirations per wakeup: %.2f\n", wheel.wakeups ? (double) wheel.expirations / wheel.wakeups : 0.0);
+	stream->write_function(stream, "tick cost: %.2fus\ncost per expiration: %.3fus\n",
+						   wheel.ticks ? (double) wheel.busy_usec / wheel.ticks : 0.0,
+						   wheel.expirations ? (double) wheel.busy_usec / wheel.expirations : 0.0);
+	stream->write_function(stream, "tick jitter: avg %.2fus max %" SWITCH_UINT64_T_FMT "us\n",
+						   wheel.ticks ? (double) wheel.late_usec / wheel.ticks : 0.0, wheel.max_late_usec);
+	if (reset) {
+		wheel.ticks = wheel.expirations = wheel.wakeups = 0;
+		wheel.busy_usec = wheel.late_usec = wheel.max_late_usec = 0;
+	}
+	switch_mutex_unlock(wheel.mutex);
+}
+
 static void win32_init_timers(void)
 {
 #ifdef WIN32
@@ -1495,6 +1956,7 @@ SWITCH_DECLARE(switch_status_t) switch_strftime_tz(const char *tz, const char *f
 SWITCH_MODULE_LOAD_FUNCTION(softtimer_load)
 {
 	switch_timer_interface_t *timer_interface;
+	uint32_t x;
 	module_pool = pool;
 
 #ifdef WIN32
@@ -1524,6 +1986,28 @@ SWITCH_MODULE_LOAD_FUNCTION(softtimer_load)
 	timer_interface->timer_check = timer_check;
 	timer_interface->timer_destroy = timer_destroy;
 
+	memset(&wheel, 0, sizeof(wheel));
+	switch_mutex_init(&wheel.mutex, SWITCH_MUTEX_NESTED, module_pool);
+	wheel.group_count = switch_core_cpu_count();
+	if (wheel.group_count < 1) {
+		wheel.group_count = 1;
+	} else if (wheel.group_count > WHEEL_MAX_GROUPS) {
+		wheel.group_count = WHEEL_MAX_GROUPS;
+	}
+	for (x = 0; x < wheel.group_count; x++) {
+		switch_mutex_init(&wheel.groups[x].mutex, SWITCH_MUTEX_NESTED, module_pool);
+		switch_thread_cond_create(&wheel.groups[x].cond, module_pool);
+	}
+
+	timer_interface = switch_loadable_module_create_interface(*module_interface, SWITCH_TIMER_INTERFACE);
+	timer_interface->interface_name = "wheel";
+	timer_interface->timer_init = wheel_timer_init;
+	timer_interface->timer_next = wheel_timer_next;
+	timer_interface->timer_step = wheel_timer_step;
+	timer_interface->timer_sync = wheel_timer_sync;
+	timer_interface->timer_check = wheel_timer_check;
+	timer_interface->timer_destroy = wheel_timer_destroy;
+
 	if (!switch_test_flag((&runtime), SCF_USE_CLOCK_RT)) {
 		switch_time_set_nanosleep(SWITCH_FALSE);
 	}
@@ -1568,6 +2052,8 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(softtimer_shutdown)
 {
 	globals.use_cond_yield = 0;
 
+	wheel_stop();
+
 	if (globals.RUNNING == 1) {
 		switch_mutex_lock(globals.mutex);
 		globals.RUNNING = -1;
@@ -96,6 +96,48 @@ SWITCH_DECLARE(switch_status_t) switch_frame_alloc(switch_frame_t **frame, switc
 	return SWITCH_STATUS_SUCCESS;
 }
 
+struct switch_frame_data_s {
+	switch_atomic_t refs;
+	switch_size_t size;
+	/* keep the payload 8 byte aligned */
+	uint64_t data[1];
+};
+
+SWITCH_DECLARE(switch_status_t) switch_frame_data_create(switch_frame_data_t **fdP, switch_size_t size)
+{
+	switch_frame_data_t *fd;
+
+	fd = malloc(sizeof(*fd) + size);
+	switch_assert(fd);
+
+	fd->size = size;
+	switch_atomic_set(&fd->refs, 1);
+	*fdP = fd;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(switch_frame_data_t *) switch_frame_data_ref(switch_frame_data_t *fd)
+{
+	switch_atomic_inc(&fd->refs);
+	return fd;
+}
+
+SWITCH_DECLARE(void) switch_frame_data_release(switch_frame_data_t **fdP)
+{
+	switch_frame_data_t *fd = *fdP;
+
+	*fdP = NULL;
+
+	if (fd && !switch_atomic_dec(&fd->refs)) {
+		free(fd);
+	}
+}
+
+SWITCH_DECLARE(void *) switch_frame_data_ptr(switch_frame_data_t *fd)
+{
+	return fd->data;
+}
 
 typedef struct switch_frame_node_s {
 	switch_frame_t *frame;
@@ -266,7 +308,7 @@ SWITCH_DECLARE(switch_status_t) switch_frame_buffer_create(switch_frame_buffer_t
 }
 
 
-SWITCH_DECLARE(switch_status_t) switch_frame_dup(switch_frame_t *orig, switch_frame_t **clone)
+static switch_status_t frame_copy(switch_frame_t *orig, switch_frame_t **clone, switch_bool_t share)
 {
 	switch_frame_t *new_frame;
 
@@ -282,14 +324,17 @@ SWITCH_DECLARE(switch_status_t) switch_frame_dup(switch_frame_t *orig, switch_fr
 	*new_frame = *orig;
 	switch_set_flag(new_frame, SFF_DYNAMIC);
 
-	if (orig->packet) {
-		new_frame->packet = malloc(SWITCH_RTP_MAX_BUF_LEN);
+	if (share && orig->ref) {
+		new_frame->ref = switch_frame_data_ref(orig->ref);
+	} else if (orig->packet) {
+		switch_frame_data_create(&new_frame->ref, SWITCH_RTP_MAX_BUF_LEN);
+		new_frame->packet = switch_frame_data_ptr(new_frame->ref);
 		memcpy(new_frame->packet, orig->packet, orig->packetlen);
 		new_frame->data = ((unsigned char *)new_frame->packet) + 12;
 	} else {
+		switch_frame_data_create(&new_frame->ref, new_frame->buflen);
 		new_frame->packet = NULL;
-		new_frame->data = malloc(new_frame->buflen);
-		switch_assert(new_frame->data);
+		new_frame->data = switch_frame_data_ptr(new_frame->ref);
 		memcpy(new_frame->data, orig->data, orig->datalen);
 	}
 
@@ -305,6 +350,16 @@ SWITCH_DECLARE(switch_status_t) switch_frame_dup(switch_frame_t *orig, switch_fr
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_frame_dup(switch_frame_t *orig, switch_frame_t **clone)
+{
+	return frame_copy(orig, clone, SWITCH_FALSE);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_frame_share(switch_frame_t *orig, switch_frame_t **clone)
+{
+	return frame_copy(orig, clone, SWITCH_TRUE);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_frame_free(switch_frame_t **frame)
 {
 	switch_frame_t * f;
@@ -325,7 +380,9 @@ SWITCH_DECLARE(switch_status_t) switch_frame_free(switch_frame_t **frame)
 		switch_img_free(&(f->img));
 	}
 
-	if (f->packet) {
+	if (f->ref) {
+		switch_frame_data_release(&f->ref);
+	} else if (f->packet) {
 		switch_safe_free(f->packet);
 	} else {
 		switch_safe_free(f->data);
@@ -3249,6 +3306,43 @@ SWITCH_DECLARE(char *) switch_url_encode(const char *url, char *buf, size_t len)
 	return switch_url_encode_opt(url, buf, len, SWITCH_FALSE);
 }
 
+/* printable characters that are not in SWITCH_URL_UNSAFE, one bit per character */
+static const uint32_t URL_SAFE_MAP[8] = { 0x00000000, 0x03fff792, 0x87fffffe, 0x47fffffe, 0x00000000, 0x00000000, 0x00000000, 0x00000000 };
+
+#define url_safe_char(_c) (URL_SAFE_MAP[(uint8_t) (_c) >> 5] & (1U << ((uint8_t) (_c) & 31)))
+#define url_hex_char(_c) (((_c) >= '0' && (_c) <= '9') || ((_c) >= 'A' && (_c) <= 'F'))
+
+SWITCH_DECLARE(void) switch_url_encode_stream(switch_stream_handle_t *stream, const char *url)
+{
+	const char *p, *run;
+	const char hex[] = "0123456789ABCDEF";
+	char esc[3];
+
+	if (!url) {
+		return;
+	}
+
+	for (run = p = url; *p; p++) {
+		if (url_safe_char(*p) || (*p == '%' && url_hex_char(*(p + 1)) && url_hex_char(*(p + 2)))) {
+			continue;
+		}
+
+		if (p > run) {
+			stream->raw_write_function(stream, (uint8_t *) run, p - run);
+		}
+
+		esc[0] = '%';
+		esc[1] = hex[(*p >> 4) & 0x0f];
+		esc[2] = hex[*p & 0x0f];
+		stream->raw_write_function(stream, (uint8_t *) esc, 3);
+		run = p + 1;
+	}
+
+	if (p > run) {
+		stream->raw_write_function(stream, (uint8_t *) run, p - run);
+	}
+}
+
 SWITCH_DECLARE(char *) switch_url_decode(char *s)
 {
 	char *o;
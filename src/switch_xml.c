@@ -158,6 +158,7 @@ struct switch_xml_root {		/* additional data for the root tag */
 	char ***pi;					/* processing instructions */
 	short standalone;			/* non-zero if <?xml standalone="yes"?> */
 	char err[SWITCH_XML_ERRL];	/* error string */
+	struct xml_dir_index *dir_index;	/* directory lookup index, built when installed as the main root */
 };
 
 char *SWITCH_XML_NIL[] = { NULL };	/* empty, null terminated array of strings */
@@ -171,7 +172,7 @@ struct switch_xml_binding {
 
 
 static switch_xml_binding_t *BINDINGS = NULL;
-static switch_xml_t MAIN_XML_ROOT = NULL;
+static switch_xml_t volatile MAIN_XML_ROOT = NULL;
 static switch_memory_pool_t *XML_MEMORY_POOL = NULL;
 
 static switch_thread_rwlock_t *B_RWLOCK = NULL;
@@ -180,6 +181,24 @@ static switch_mutex_t *CACHE_MUTEX = NULL;
 static switch_mutex_t *REFLOCK = NULL;
 static switch_mutex_t *FILE_LOCK = NULL;
 
+/*
+ * switch_xml_root() pins MAIN_XML_ROOT with an atomic reference and no lock.  The only thing to guard against is
+ * a reader that loaded the old root pointer but has not taken its reference yet when switch_xml_set_root() drops
+ * the last one.  Readers count themselves in one of XML_READER_SLOTS counters (picked by thread, so readers on
+ * different cores do not share a cache line) for the few instructions in between, and the writer waits for the
+ * counters of the current epoch to drain after publishing the new root.  Readers arriving during the wait count
+ * in the next epoch, so a steady stream of readers can not hold a writer off.
+ */
+#define XML_READER_SLOTS 64
+
+typedef struct {
+	switch_atomic_t active[2];
+	char pad[64 - 2 * sizeof(switch_atomic_t)];
+} xml_reader_slot_t;
+
+static xml_reader_slot_t XML_READERS[XML_READER_SLOTS];
+static switch_atomic_t XML_EPOCH = 0;
+
 SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const char **err, void *user_data);
 
 static switch_xml_open_root_function_t XML_OPEN_ROOT_FUNCTION = (switch_xml_open_root_function_t)__switch_xml_open_root;
@@ -188,6 +207,31 @@ static void *XML_OPEN_ROOT_FUNCTION_USER_DATA = NULL;
 static switch_hash_t *CACHE_HASH = NULL;
 static switch_hash_t *CACHE_EXPIRES_HASH = NULL;
 
+/*
+ * switch_xml_locate_user() used to walk every <user> of every group of a domain on each lookup.  When a root is
+ * installed with switch_xml_set_root() its directory is indexed once: per domain, the first user in document order
+ * for each id or number-alias and for each ip, with the group it was found in.  Lookups the index can not answer
+ * exactly as the walk would (other keys, a user_type param, users with a type other than pointer, roots that came
+ * from a binding) still walk the tree.
+ */
+typedef struct {
+	switch_xml_t user;
+	switch_xml_t group;
+	/* the group's position, so an ip match and a name match resolve to the one the walk would find first */
+	uint32_t ord;
+} xml_dir_user_t;
+
+typedef struct {
+	switch_xml_t domain;
+	switch_hash_t *ids;
+	switch_hash_t *ips;
+} xml_dir_domain_t;
+
+struct xml_dir_index {
+	switch_memory_pool_t *pool;
+	switch_hash_t *domains;
+};
+
 struct xml_section_t {
 	const char *name;
 	/* switch_xml_section_t section; */
@@ -1694,11 +1738,16 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate(const char *section,
 	switch_xml_t xml = NULL;
 	switch_xml_binding_t *binding;
 	uint8_t loops = 0;
+	int locked = 0;
 	switch_xml_section_t sections = BINDINGS ? switch_xml_parse_section_string(section) : 0;
 
-	switch_thread_rwlock_rdlock(B_RWLOCK);
+	/* a binding added while we look is as good as one added just after, removing one waits for the write lock */
+	if (BINDINGS) {
+		switch_thread_rwlock_rdlock(B_RWLOCK);
+		locked = 1;
+	}
 
-	for (binding = BINDINGS; binding; binding = binding->next) {
+	for (binding = locked ? BINDINGS : NULL; binding; binding = binding->next) {
 		if (binding->sections && !(sections & binding->sections)) {
 			continue;
 		}
@@ -1729,7 +1778,10 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate(const char *section,
 			}
 		}
 	}
-	switch_thread_rwlock_unlock(B_RWLOCK);
+
+	if (locked) {
+		switch_thread_rwlock_unlock(B_RWLOCK);
+	}
 
 	for (;;) {
 		if (!xml) {
@@ -1832,6 +1884,177 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate_group(const char *group_name,
 	return status;
 }
 
+static void xml_dir_index_destroy(struct xml_dir_index **indexp)
+{
+	struct xml_dir_index *index = *indexp;
+	switch_hash_index_t *hi;
+	xml_dir_domain_t *xd;
+	void *val;
+
+	*indexp = NULL;
+
+	for (hi = switch_core_hash_first(index->domains); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		xd = (xml_dir_domain_t *) val;
+		switch_core_hash_destroy(&xd->ids);
+		switch_core_hash_destroy(&xd->ips);
+	}
+
+	switch_core_hash_destroy(&index->domains);
+	switch_core_destroy_memory_pool(&index->pool);
+}
+
+static xml_dir_user_t *xml_dir_index_user(switch_memory_pool_t *pool, switch_hash_t *hash, const char *key,
+										  switch_xml_t user, switch_xml_t group, uint32_t ord)
+{
+	xml_dir_user_t *du;
+
+	/* the walk stops at the first match, so the first user to claim a key keeps it */
+	if (zstr(key) || switch_core_hash_find(hash, key)) {
+		return NULL;
+	}
+
+	du = switch_core_alloc(pool, sizeof(*du));
+	du->user = user;
+	du->group = group;
+	du->ord = ord;
+	switch_core_hash_insert(hash, key, du);
+
+	return du;
+}
+
+static switch_bool_t xml_dir_index_users(switch_memory_pool_t *pool, xml_dir_domain_t *xd, switch_xml_t tag, switch_xml_t group, uint32_t ord)
+{
+	switch_xml_t user;
+	const char *type;
+
+	for (user = switch_xml_child(tag, "user"); user; user = user->next) {
+		/* find_user_in_tag() matches any user whose type is not "pointer" whatever the key, only the walk gets that right */
+		if ((type = switch_xml_attr(user, "type")) && strcasecmp(type, "pointer")) {
+			return SWITCH_FALSE;
+		}
+
+		xml_dir_index_user(pool, xd->ids, switch_xml_attr(user, "id"), user, group, ord);
+		xml_dir_index_user(pool, xd->ids, switch_xml_attr(user, "number-alias"), user, group, ord);
+		xml_dir_index_user(pool, xd->ips, switch_xml_attr(user, "ip"), user, group, ord);
+	}
+
+	return SWITCH_TRUE;
+}
+
+static struct xml_dir_index *xml_dir_index_create(switch_xml_t root)
+{
+	struct xml_dir_index *index;
+	switch_memory_pool_t *pool = NULL;
+	switch_xml_t section, domain, groups, group, users;
+	xml_dir_domain_t *xd;
+	switch_bool_t ok;
+	char key[32];
+	uint32_t ord;
+
+	if (!(section = switch_xml_find_child(root, "section", "name", "directory"))) {
+		return NULL;
+	}
+
+	switch_core_new_memory_pool(&pool);
+	index = switch_core_alloc(pool, sizeof(*index));
+	index->pool = pool;
+	switch_core_hash_init(&index->domains);
+
+	for (domain = switch_xml_child(section, "domain"); domain; domain = domain->next) {
+		xd = switch_core_alloc(pool, sizeof(*xd));
+		xd->domain = domain;
+		switch_core_hash_init_nocase(&xd->ids);
+		switch_core_hash_init_nocase(&xd->ips);
+
+		ok = SWITCH_TRUE;
+		ord = 0;
+
+		/* the same order switch_xml_locate_user() looks in: the users of each group, then the domain's own */
+		if ((groups = switch_xml_child(domain, "groups"))) {
+			for (group = switch_xml_child(groups, "group"); ok && group; group = group->next) {
+				if ((users = switch_xml_child(group, "users"))) {
+					ok = xml_dir_index_users(pool, xd, users, group, ord++);
+				}
+			}
+		}
+
+		if (ok) {
+			ok = xml_dir_index_users(pool, xd, domain, NULL, ord);
+		}
+
+		if (!ok) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Not indexing domain %s, it has typed users\n",
+							  switch_str_nil(switch_xml_attr(domain, "name")));
+			switch_core_hash_destroy(&xd->ids);
+			switch_core_hash_destroy(&xd->ips);
+			continue;
+		}
+
+		/* keyed by the node, whichever name or alias found the domain */
+		switch_snprintf(key, sizeof(key), "%p", (void *) domain);
+		switch_core_hash_insert(index->domains, key, xd);
+	}
+
+	return index;
+}
+
+/*
+ * SWITCH_STATUS_SUCCESS or SWITCH_STATUS_NOTFOUND when the index answered, SWITCH_STATUS_FALSE when the caller
+ * has to walk the domain itself.
+ */
+static switch_status_t xml_dir_index_find(switch_xml_t domain, const char *ip, const char *user_name, const char *key,
+										  switch_event_t *params, switch_bool_t domain_users, switch_xml_t *user, switch_xml_t *ingroup)
+{
+	struct xml_dir_index *index;
+	xml_dir_domain_t *xd;
+	xml_dir_user_t *by_ip = NULL, *by_name = NULL, *found;
+	switch_xml_t root;
+	char dkey[32];
+
+	for (root = domain; root && root->parent; root = root->parent);
+
+	if (!root || !switch_test_flag(root, SWITCH_XML_ROOT) || !(index = ((switch_xml_root_t) root)->dir_index)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if ((user_name && strcasecmp(key, "id")) || (params && switch_event_get_header(params, "user_type"))) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_snprintf(dkey, sizeof(dkey), "%p", (void *) domain);
+
+	if (!(xd = switch_core_hash_find(index->domains, dkey))) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (ip) {
+		by_ip = switch_core_hash_find(xd->ips, ip);
+	}
+
+	if (user_name) {
+		by_name = switch_core_hash_find(xd->ids, user_name);
+	}
+
+	/* within a group the walk tries the ip first */
+	found = by_ip;
+	if (by_name && (!found || by_name->ord < found->ord)) {
+		found = by_name;
+	}
+
+	if (!found || (!found->group && !domain_users)) {
+		return SWITCH_STATUS_NOTFOUND;
+	}
+
+	*user = found->user;
+
+	if (ingroup && found->group) {
+		*ingroup = found->group;
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 static switch_status_t find_user_in_tag(switch_xml_t tag, const char *ip, const char *user_name,
 										const char *key, switch_event_t *params, switch_xml_t *user)
 {
@@ -1873,6 +2096,10 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate_user_in_domain(const char *use
 	switch_xml_t group = NULL, groups = NULL, users = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
+	if ((status = xml_dir_index_find(domain, NULL, user_name, "id", NULL, SWITCH_FALSE, user, ingroup)) != SWITCH_STATUS_FALSE) {
+		return status == SWITCH_STATUS_SUCCESS ? status : SWITCH_STATUS_FALSE;
+	}
+
 	if ((groups = switch_xml_child(domain, "groups"))) {
 		for (group = switch_xml_child(groups, "group"); group; group = group->next) {
 			if ((users = switch_xml_child(group, "users"))) {
@@ -2160,7 +2387,12 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate_user(const char *key,
 		goto end;
 	}
 
-	status = SWITCH_STATUS_FALSE;
+	if ((status = xml_dir_index_find(*domain, ip, user_name, key, params, SWITCH_TRUE, user, ingroup)) != SWITCH_STATUS_FALSE) {
+		if (status != SWITCH_STATUS_SUCCESS) {
+			status = SWITCH_STATUS_FALSE;
+		}
+		goto end;
+	}
 
 	if ((groups = switch_xml_child(*domain, "groups"))) {
 		for (group = switch_xml_child(groups, "group"); group; group = group->next) {
@@ -2194,14 +2426,52 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate_user(const char *key,
 	return status;
 }
 
+static xml_reader_slot_t *xml_reader_slot(void)
+{
+	uint64_t id = (uint64_t) (uintptr_t) switch_thread_self();
+
+	/* thread ids are often aligned addresses, spread them over the slots */
+	return &XML_READERS[(id * 0x9E3779B97F4A7C15ULL) >> 58];
+}
+
+/* call with REFLOCK held, after publishing a new MAIN_XML_ROOT */
+static void xml_reader_synchronize(void)
+{
+	uint32_t epoch = switch_atomic_read(&XML_EPOCH) & 1;
+	int i;
+
+	switch_atomic_inc(&XML_EPOCH);
+
+	for (i = 0; i < XML_READER_SLOTS; i++) {
+		while (switch_atomic_read(&XML_READERS[i].active[epoch])) {
+			switch_cond_next();
+		}
+	}
+}
+
 SWITCH_DECLARE(switch_xml_t) switch_xml_root(void)
 {
+	xml_reader_slot_t *slot = xml_reader_slot();
+	uint32_t epoch;
 	switch_xml_t xml;
 
-	switch_mutex_lock(REFLOCK);
-	xml = MAIN_XML_ROOT;
-	xml->refs++;
-	switch_mutex_unlock(REFLOCK);
+	/* a writer that moved on to the next epoch before we counted ourselves would not wait for us */
+	for (;;) {
+		epoch = switch_atomic_read(&XML_EPOCH);
+		switch_atomic_inc(&slot->active[epoch & 1]);
+
+		if (switch_atomic_read(&XML_EPOCH) == epoch) {
+			break;
+		}
+
+		switch_atomic_dec(&slot->active[epoch & 1]);
+	}
+
+	if ((xml = MAIN_XML_ROOT)) {
+		switch_atomic_inc(&xml->refs);
+	}
+
+	switch_atomic_dec(&slot->active[epoch & 1]);
 
 	return xml;
 }
@@ -2247,25 +2517,27 @@ SWITCH_DECLARE(switch_status_t) switch_xml_set_root(switch_xml_t new_main)
 {
 	switch_xml_t old_root = NULL;
 
+	switch_set_flag(new_main, SWITCH_XML_ROOT);
+	switch_atomic_inc(&new_main->refs);
+
+	/* nobody else sees the new root yet, build the index before it is published */
+	if (!new_main->parent && !((switch_xml_root_t) new_main)->dir_index) {
+		((switch_xml_root_t) new_main)->dir_index = xml_dir_index_create(new_main);
+	}
+
 	switch_mutex_lock(REFLOCK);
 
 	old_root = MAIN_XML_ROOT;
 	MAIN_XML_ROOT = new_main;
-	switch_set_flag(MAIN_XML_ROOT, SWITCH_XML_ROOT);
-	MAIN_XML_ROOT->refs++;
+	xml_reader_synchronize();
 
-	if (old_root) {
-		if (old_root->refs) {
-			old_root->refs--;
-		}
+	switch_mutex_unlock(REFLOCK);
 
-		if (!old_root->refs) {
-			switch_xml_free(old_root);
-		}
+	/* the root's own reference, it goes now or with the last reader still holding it */
+	if (old_root) {
+		switch_xml_free(old_root);
 	}
 
-	switch_mutex_unlock(REFLOCK);
-
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -2397,6 +2669,7 @@ SWITCH_DECLARE(switch_status_t) switch_xml_destroy(void)
 	if (MAIN_XML_ROOT) {
 		switch_xml_t xml = MAIN_XML_ROOT;
 		MAIN_XML_ROOT = NULL;
+		xml_reader_synchronize();
 		switch_xml_free(xml);
 		status = SWITCH_STATUS_SUCCESS;
 	}
@@ -2686,6 +2959,37 @@ SWITCH_DECLARE(char *) switch_xml_tohtml(switch_xml_t xml, switch_bool_t prn_hea
 	return h;
 }
 
+SWITCH_DECLARE(void) switch_xml_ampencode_stream(switch_stream_handle_t *stream, const char *txt)
+{
+	const char *p;
+	char *buf;
+	switch_size_t len = 0, max;
+
+	if (zstr(txt)) {
+		return;
+	}
+
+	/* most text has nothing to escape, hand it over as it is */
+	for (p = txt; *p; p++) {
+		if (*p == '&' || *p == '<' || *p == '>' || *p == '\r' || (*p & 0x80)) {
+			break;
+		}
+	}
+
+	if (!*p) {
+		stream->raw_write_function(stream, (uint8_t *) txt, p - txt);
+		return;
+	}
+
+	max = strlen(txt) + SWITCH_XML_BUFSIZE;
+	buf = (char *) malloc(max);
+	switch_assert(buf);
+
+	buf = switch_xml_ampencode(txt, 0, &buf, &len, &max, 0);
+	stream->raw_write_function(stream, (uint8_t *) buf, len);
+	free(buf);
+}
+
 /* converts a switch_xml structure back to xml, returning a string of xml data that
    must be freed */
 SWITCH_DECLARE(char *) switch_xml_toxml_buf(switch_xml_t xml, char *buf, switch_size_t buflen, switch_size_t offset, switch_bool_t prn_header)
@@ -2773,13 +3077,9 @@ SWITCH_DECLARE(void) switch_xml_free(switch_xml_t xml)
 	}
 
 	if (switch_test_flag(xml, SWITCH_XML_ROOT)) {
-		switch_mutex_lock(REFLOCK);
-
-		if (xml->refs) {
-			xml->refs--;
-			refs = xml->refs;
+		if (switch_atomic_read(&xml->refs)) {
+			refs = switch_atomic_dec(&xml->refs);
 		}
-		switch_mutex_unlock(REFLOCK);
 	}
 
 	if (refs) {
@@ -2822,6 +3122,8 @@ SWITCH_DECLARE(void) switch_xml_free(switch_xml_t xml)
 		if (root->pi[0])
 			free(root->pi);		/* free processing instructions */
 
+		if (root->dir_index)
+			xml_dir_index_destroy(&root->dir_index);
 		if (root->dynamic == 1)
 			free(root->m);		/* malloced xml data */
 		if (root->u)
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+#include "sofia_reg_store.h"
+
+#define NOW 1000000
+
+static void add_reg(sofia_reg_store_t *store, const char *call_id, const char *user, const char *contact,
+                    const char *presence_hosts, long expires)
+{
+  sofia_reg_t reg = { 0 };
+
+  reg.call_id = (char *) call_id;
+  reg.sip_user = (char *) user;
+  reg.sip_host = "example.com";
+  reg.contact = (char *) contact;
+  reg.presence_hosts = (char *) presence_hosts;
+  reg.expires = expires;
+  sofia_reg_mem_add(store, &reg);
+}
+
+/* the call_ids of a list, in list order */
+static void list_ids(sofia_reg_t *list, char *buf, switch_size_t len)
+{
+  sofia_reg_t *reg;
+
+  *buf = '\0';
+  for (reg = list; reg; reg = reg->wheel_next) {
+    switch_snprintf(buf + strlen(buf), len - strlen(buf), "%s%s", *buf ? "," : "", reg->call_id);
+  }
+}
+
+static int contact_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+  switch_copy_string((char *) pArg, argv[0], 64);
+  return 0;
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_memory_pool_t *pool = NULL;
+  sofia_reg_store_t *store;
+  sofia_reg_match_t match = { 0 };
+  sofia_reg_t changes = { 0 }, *list = NULL;
+  char contact[64] = "", ids[256];
+
+  plan(9);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  switch_core_new_memory_pool(&pool);
+  store = sofia_reg_mem_create(pool);
+
+  add_reg(store, "call-1", "1000", "sip:1000@10.0.0.1", "", NOW + 60);
+  add_reg(store, "call-2", "1000", "sip:1000@10.0.0.2", "", NOW + 120);
+  add_reg(store, "call-3", "1001", "sip:1001@10.0.0.3", "example.org", NOW + 60);
+  /* further out than one lap of the wheel */
+  add_reg(store, "call-4", "1002", "sip:1002@10.0.0.4", "", NOW + SOFIA_REG_WHEEL_SLOTS + 60);
+
+  match.sip_user = "1000";
+  match.sip_host = "example.com";
+  ok(sofia_reg_mem_count(store, &match) == 2, "Both registrations of a user count");
+
+  memset(&match, 0, sizeof(match));
+  match.sip_user = "1001";
+  match.sip_host = "example.org";
+  ok(!sofia_reg_mem_count(store, &match), "The host does not match a presence host unless asked to");
+
+  match.presence_hosts = SWITCH_TRUE;
+  ok(sofia_reg_mem_count(store, &match) == 1, "The host matches a presence host when asked to");
+
+  memset(&match, 0, sizeof(match));
+  match.call_id = "call-2";
+  ok(sofia_reg_mem_find(store, &match, contact_callback, contact) == 1 && !strcmp(contact, "sip:1000@10.0.0.2"),
+     "A lookup by call_id hands back the contact");
+
+  memset(&match, 0, sizeof(match));
+  match.call_id = "call-1";
+  changes.expires = NOW + 600;
+  sofia_reg_mem_update(store, &match, &changes);
+
+  list = sofia_reg_mem_take_expired(store, NOW + 60);
+  list_ids(list, ids, sizeof(ids));
+  sofia_reg_mem_free(list);
+  ok(!strcmp(ids, "call-3"), "The sweep takes what is due and leaves a refreshed registration alone");
+
+  list = sofia_reg_mem_take_expired(store, NOW + 600);
+  list_ids(list, ids, sizeof(ids));
+  sofia_reg_mem_free(list);
+  memset(&match, 0, sizeof(match));
+  ok(!strcmp(ids, "call-1,call-2") && sofia_reg_mem_count(store, &match) == 1,
+     "A later sweep takes the rest of what is due but not a registration a lap away");
+
+  match.sip_user = "1002";
+  list = NULL;
+  ok(sofia_reg_mem_take(store, &match, &list) == 1 && list && !strcmp(list->call_id, "call-4"), "A registration can be taken by user");
+  sofia_reg_mem_free(list);
+
+  memset(&match, 0, sizeof(match));
+  ok(!sofia_reg_mem_count(store, &match) && !store->count && !sofia_reg_mem_destroy(store), "Nothing is left behind");
+
+  switch_core_destroy_memory_pool(&pool);
+  switch_core_destroy();
+
+  done_testing();
+}
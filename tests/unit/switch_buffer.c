@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#define FRAME 320
+#define RING 65536
+
+#ifdef BENCHMARK
+#define FRAMES 5000000
+#else
+#define FRAMES 1000
+#endif
+
+typedef struct {
+  switch_buffer_t *buffer;
+  switch_mutex_t *mutex;
+  int frames;
+  int bad;
+} buffer_pair_t;
+
+static void fill_frame(uint8_t *frame, uint32_t seq)
+{
+  int x;
+
+  for (x = 0; x < FRAME; x++) {
+    frame[x] = (uint8_t) (seq + x);
+  }
+}
+
+static void *SWITCH_THREAD_FUNC producer_run(switch_thread_t *thread, void *obj)
+{
+  buffer_pair_t *pair = (buffer_pair_t *) obj;
+  uint8_t frame[FRAME];
+  uint32_t seq = 0;
+  switch_size_t w;
+
+  while (seq < (uint32_t) pair->frames) {
+    fill_frame(frame, seq);
+
+    if (pair->mutex) switch_mutex_lock(pair->mutex);
+    w = switch_buffer_write(pair->buffer, frame, FRAME);
+    if (pair->mutex) switch_mutex_unlock(pair->mutex);
+
+    if (w) {
+      seq++;
+    } else {
+      switch_os_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void *SWITCH_THREAD_FUNC consumer_run(switch_thread_t *thread, void *obj)
+{
+  buffer_pair_t *pair = (buffer_pair_t *) obj;
+  uint8_t frame[FRAME], want[FRAME];
+  uint32_t seq = 0;
+  switch_size_t r;
+
+  while (seq < (uint32_t) pair->frames) {
+    r = 0;
+
+    if (pair->mutex) switch_mutex_lock(pair->mutex);
+    if (switch_buffer_inuse(pair->buffer) >= FRAME) {
+      r = switch_buffer_read(pair->buffer, frame, FRAME);
+    }
+    if (pair->mutex) switch_mutex_unlock(pair->mutex);
+
+    if (r == FRAME) {
+      fill_frame(want, seq);
+      pair->bad += !!memcmp(frame, want, FRAME);
+      seq++;
+    } else {
+      switch_os_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/* one writer and one reader hammering the same buffer, a mutex around a dynamic buffer against the spsc ring */
+static switch_time_t run_pair(switch_memory_pool_t *pool, int spsc, int *bad)
+{
+  buffer_pair_t pair = { 0 };
+  switch_threadattr_t *thd_attr = NULL;
+  switch_thread_t *producer, *consumer;
+  switch_status_t st;
+  switch_time_t start;
+
+  pair.frames = FRAMES;
+
+  if (spsc) {
+    switch_buffer_create_spsc(&pair.buffer, RING);
+  } else {
+    switch_buffer_create_dynamic(&pair.buffer, RING, RING, RING);
+    switch_mutex_init(&pair.mutex, SWITCH_MUTEX_NESTED, pool);
+  }
+
+  switch_threadattr_create(&thd_attr, pool);
+  switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+  start = switch_time_now();
+  switch_thread_create(&consumer, thd_attr, consumer_run, &pair, pool);
+  switch_thread_create(&producer, thd_attr, producer_run, &pair, pool);
+  switch_thread_join(&st, producer);
+  switch_thread_join(&st, consumer);
+
+  *bad = pair.bad;
+  switch_buffer_destroy(&pair.buffer);
+
+  return switch_time_now() - start;
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_memory_pool_t *pool = NULL;
+  switch_buffer_t *buffer = NULL;
+  uint8_t in[256], out[256];
+  const void *ptr = NULL;
+  switch_time_t locked, lockfree;
+  int x, bad = 0;
+
+  plan(7);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  switch_core_new_memory_pool(&pool);
+
+  for (x = 0; x < 256; x++) {
+    in[x] = (uint8_t) x;
+  }
+
+  ok(switch_buffer_create_spsc(&buffer, 100) == SWITCH_STATUS_SUCCESS && switch_buffer_len(buffer) == 128, "Ring is rounded up to a power of two");
+
+  /* walk the ring around many times so every path through the wrap is taken */
+  for (x = 0; x < 100; x++) {
+    bad += switch_buffer_write(buffer, in, 90) != 90;
+    bad += switch_buffer_write(buffer, in, 90) != 0;
+    bad += switch_buffer_peek(buffer, out, 10) != 10 || memcmp(out, in, 10);
+    bad += switch_buffer_toss(buffer, 5) != 85;
+    bad += switch_buffer_freespace(buffer) != 128 - 85;
+    bad += switch_buffer_read(buffer, out, 200) != 85 || memcmp(out, in + 5, 85);
+    bad += switch_buffer_inuse(buffer) != 0;
+  }
+  ok(bad == 0, "Write, peek, toss and read keep the data in order across the wrap");
+
+  bad = 0;
+  for (x = 0; x < 100; x++) {
+    switch_size_t len;
+
+    switch_buffer_write(buffer, in, 50 + x % 30);
+    len = switch_buffer_peek_zerocopy(buffer, &ptr);
+    bad += !len || memcmp(ptr, in, len);
+    switch_buffer_zero(buffer);
+    bad += switch_buffer_inuse(buffer) != 0;
+  }
+  ok(bad == 0, "Zero copy peek and zero work on the ring");
+
+  ok(switch_buffer_zwrite(buffer, in, 200) == 0 && switch_buffer_inuse(buffer) == 0, "An oversized write is refused without touching the reader's side");
+  switch_buffer_destroy(&buffer);
+
+  locked = run_pair(pool, 0, &bad);
+  ok(bad == 0, "Mutex protected dynamic buffer delivered %d frames intact", FRAMES);
+
+  lockfree = run_pair(pool, 1, &bad);
+  ok(bad == 0, "Lock free ring delivered %d frames intact", FRAMES);
+
+  note("%d x %d byte frames between two threads: mutex %ldus spsc %ldus (%.2fx)\n", FRAMES, FRAME,
+       (long) locked, (long) lockfree, lockfree ? (double) locked / lockfree : 0.0);
+
+  switch_core_destroy_memory_pool(&pool);
+  switch_core_destroy();
+
+  done_testing();
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#ifdef BENCHMARK
+#define CHANNELS 100000
+#else
+#define CHANNELS 1000
+#endif
+
+typedef struct {
+  int rows;
+  int argc;
+  char first[64];
+  char b_uuid[64];
+} row_holder_t;
+
+static switch_event_t *channel_event(switch_event_types_t id, const char *uuid)
+{
+  switch_event_t *event = NULL;
+
+  switch_event_create_plain(&event, id);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Unique-ID", uuid);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Event-Date-Local", "2026-10-18 10:00:00");
+
+  return event;
+}
+
+static void apply(switch_event_t *event)
+{
+  switch_call_registry_apply_event(event);
+  switch_event_destroy(&event);
+}
+
+static void create_channel(const char *uuid, const char *name)
+{
+  switch_event_t *event = channel_event(SWITCH_EVENT_CHANNEL_CREATE, uuid);
+
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Call-Direction", "inbound");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-Name", name);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-State", "CS_INIT");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Caller-Caller-ID-Number", "1000");
+  apply(event);
+}
+
+static void route_channel(const char *uuid, const char *presence_id)
+{
+  switch_event_t *event = channel_event(SWITCH_EVENT_CHANNEL_STATE, uuid);
+
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-State", "CS_ROUTING");
+  switch_event_add_header(event, SWITCH_STACK_BOTTOM, "Channel-State-Number", "%d", CS_ROUTING);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-Presence-ID", presence_id);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Caller-Destination-Number", "2000");
+  apply(event);
+}
+
+static int row_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+  row_holder_t *holder = (row_holder_t *) pArg;
+  int x;
+
+  if (!holder->rows++) {
+    switch_copy_string(holder->first, switch_str_nil(argv[0]), sizeof(holder->first));
+  }
+  for (x = 0; x < argc; x++) {
+    if (!strcmp(columnNames[x], "b_uuid")) {
+      switch_copy_string(holder->b_uuid, switch_str_nil(argv[x]), sizeof(holder->b_uuid));
+    }
+  }
+  holder->argc = argc;
+
+  return 0;
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_event_t *event;
+  row_holder_t holder;
+  switch_time_t start;
+  char uuid[64];
+  char *val;
+  int x;
+
+  plan(10);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  create_channel("uuid-a", "sofia/internal/1000@example.com");
+  create_channel("uuid-b", "sofia/external/2000@example.com");
+  route_channel("uuid-a", "1000@example.com");
+
+  val = switch_call_registry_get("uuid-a", SCR_COL_DEST);
+  ok(val && !strcmp(val, "2000") && switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_NONE, NULL, NULL, NULL) == 2,
+     "Channels are created and updated from their events");
+  switch_safe_free(val);
+
+  memset(&holder, 0, sizeof(holder));
+  switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_PRESENCE_ID, "1000@example.com", row_callback, &holder);
+  ok(holder.rows == 1 && !strcmp(holder.first, "uuid-a") && holder.argc == SCR_COL_MAX, "The presence_id index finds its channel");
+
+  ok(switch_call_registry_query(SCR_VIEW_CALLS, SCR_INDEX_NONE, NULL, NULL, NULL) == 2 &&
+     switch_call_registry_query(SCR_VIEW_BRIDGED_CALLS, SCR_INDEX_NONE, NULL, NULL, NULL) == 0,
+     "Unbridged channels are calls of their own without a b leg");
+
+  event = channel_event(SWITCH_EVENT_CHANNEL_BRIDGE, "uuid-a");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Bridge-A-Unique-ID", "uuid-a");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Bridge-B-Unique-ID", "uuid-b");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-Call-UUID", "uuid-a");
+  apply(event);
+
+  memset(&holder, 0, sizeof(holder));
+  switch_call_registry_query(SCR_VIEW_BRIDGED_CALLS, SCR_INDEX_NONE, NULL, row_callback, &holder);
+  ok(holder.rows == 1 && !strcmp(holder.first, "uuid-a") && !strcmp(holder.b_uuid, "uuid-b") && holder.argc == 39,
+     "A bridge shows as one basic_calls row with its b leg");
+
+  ok(switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_CALL_UUID, "uuid-a", NULL, NULL) == 2,
+     "Both legs carry the call_uuid of the bridge");
+
+  event = channel_event(SWITCH_EVENT_CHANNEL_UUID, "uuid-c");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Old-Unique-ID", "uuid-a");
+  apply(event);
+
+  ok(!switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_UUID, "uuid-a", NULL, NULL) &&
+     switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_CALL_UUID, "uuid-c", NULL, NULL) == 2,
+     "A uuid change moves the channel and the call_uuid that pointed at it");
+
+  event = channel_event(SWITCH_EVENT_CHANNEL_UNBRIDGE, "uuid-c");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Caller-Unique-ID", "uuid-c");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-Call-UUID", "uuid-c");
+  apply(event);
+
+  val = switch_call_registry_get("uuid-b", SCR_COL_CALL_UUID);
+  ok(val && !strcmp(val, "uuid-b") && !switch_call_registry_query(SCR_VIEW_BRIDGED_CALLS, SCR_INDEX_NONE, NULL, NULL, NULL),
+     "An unbridge drops the call and gives each leg its own call_uuid back");
+  switch_safe_free(val);
+
+  apply(channel_event(SWITCH_EVENT_CHANNEL_DESTROY, "uuid-b"));
+  apply(channel_event(SWITCH_EVENT_CHANNEL_DESTROY, "uuid-c"));
+  ok(!switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_NONE, NULL, NULL, NULL), "Destroyed channels leave the registry");
+
+  start = switch_time_now();
+  for (x = 0; x < CHANNELS; x++) {
+    switch_snprintf(uuid, sizeof(uuid), "uuid-%d", x);
+    create_channel(uuid, "loopback/bench");
+    route_channel(uuid, "bench@example.com");
+  }
+  for (x = 0; x < CHANNELS; x++) {
+    switch_snprintf(uuid, sizeof(uuid), "uuid-%d", x);
+    apply(channel_event(SWITCH_EVENT_CHANNEL_DESTROY, uuid));
+  }
+  ok(!switch_call_registry_query(SCR_VIEW_CHANNELS, SCR_INDEX_PRESENCE_ID, "bench@example.com", NULL, NULL),
+     "%d channels come and go without leaving rows or index entries behind", CHANNELS);
+  note("%d channels created, routed and destroyed in %ldus\n", CHANNELS, (long) (switch_time_now() - start));
+
+  switch_core_destroy();
+
+  done_testing();
+}
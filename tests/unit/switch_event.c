@@ -5,13 +5,18 @@
 // #define BENCHMARK 1
 
 int main () {
-  switch_event_t *event = NULL;
+  switch_event_t *event = NULL, *filters = NULL;
+  switch_event_filter_t *filter = NULL;
   switch_bool_t verbose = SWITCH_TRUE;
   const char *err = NULL;
   switch_time_t start_ts, end_ts;
   int rc = 0, loops = 10, x = 0;
   switch_status_t status = SWITCH_STATUS_SUCCESS;
   char **index = NULL;
+  char *json = NULL, *str = NULL;
+  switch_xml_t xml = NULL;
+  cJSON *cj = NULL;
+  switch_stream_handle_t stream = { 0 };
   unsigned long long micro_total = 0;
   double micro_per = 0;
   double rate_per_sec = 0;
@@ -19,9 +24,9 @@ int main () {
 #ifdef BENCHMARK
   switch_time_t small_start_ts, small_end_ts;
 
-  plan(2);
+  plan(2 + 9);
 #else
-  plan(2 + ( 2 * loops));
+  plan(2 + ( 2 * loops) + 9);
 #endif
 
   status = switch_core_init(SCF_MINIMAL, verbose, &err);
@@ -84,6 +89,68 @@ int main () {
 #endif
 
 
+  /* compiled filters, event socket syntax: any include passes, any matching exclude rejects */
+  switch_event_create_plain(&filters, SWITCH_EVENT_CLONE);
+  switch_clear_flag(filters, EF_UNIQ_HEADERS);
+  switch_event_add_header_string(filters, SWITCH_STACK_BOTTOM, index[1], "nope");
+  switch_event_add_header_string(filters, SWITCH_STACK_BOTTOM, index[2], "/^[0-9]$/");
+  switch_event_filter_create_from_event(&filter, filters, SWITCH_FALSE);
+  ok(switch_event_filter_match(filter, event), "Event passes a compiled regex filter");
+
+  switch_event_filter_add_string(filter, index[3], "-3");
+  ok(!switch_event_filter_match(filter, event), "A matching exclude rule rejects the event");
+  switch_event_filter_destroy(&filter);
+
+  switch_event_filter_create(&filter);
+  switch_event_filter_add(filter, index[4], SWITCH_EVENT_FILTER_PREFIX, "5", SWITCH_FALSE);
+  ok(!switch_event_filter_match(filter, event), "A prefix rule that does not match rejects the event");
+  switch_event_filter_destroy(&filter);
+
+  switch_event_filter_create_from_event(&filter, filters, SWITCH_TRUE);
+  ok(!switch_event_filter_match(filter, event), "In match all mode every present header has to agree");
+  switch_event_filter_destroy(&filter);
+
+  switch_event_filter_create(&filter);
+  switch_event_filter_set_match_all(filter, SWITCH_TRUE);
+  switch_event_filter_add_string(filter, index[2], "/bad(/");
+  ok(!switch_event_filter_match(filter, event), "A regex that does not compile still never matches");
+  switch_event_filter_destroy(&filter);
+  switch_event_destroy(&filters);
+
+  /* the streaming serializer has to render exactly what cJSON would */
+  switch_event_add_body(event, "quoted \"body\"\r\n\ttext");
+  switch_event_serialize_json_obj(event, &cj);
+  json = cJSON_PrintUnformatted(cj);
+  SWITCH_STANDARD_STREAM(stream);
+  switch_event_serialize_json_stream(event, &stream);
+  is((char *) stream.data, json, "Streamed JSON matches the cJSON rendering");
+  switch_safe_free(stream.data);
+  switch_safe_free(json);
+  cJSON_Delete(cj);
+
+  switch_event_destroy(&event);
+
+  /* values are url encoded only when asked to, plain serialization brackets them as they are */
+  switch_event_create_plain(&event, SWITCH_EVENT_MESSAGE);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Plain", "a b");
+
+  switch_event_serialize(event, &str, SWITCH_TRUE);
+  is(str, "Plain: a%20b\n\n", "Encoded serialization url encodes the value");
+  switch_safe_free(str);
+
+  switch_event_serialize(event, &str, SWITCH_FALSE);
+  is(str, "Plain: [a b]\n\n", "Plain serialization brackets the value");
+  switch_safe_free(str);
+
+  xml = switch_event_xmlize(event, SWITCH_VA_NONE);
+  str = switch_xml_toxml(xml, SWITCH_FALSE);
+  SWITCH_STANDARD_STREAM(stream);
+  switch_event_xmlize_stream(event, &stream);
+  is((char *) stream.data, str, "Streamed XML matches the switch_xml rendering");
+  switch_safe_free(stream.data);
+  switch_safe_free(str);
+  switch_xml_free(xml);
+
   switch_event_destroy(&event);
   /* END LOOPS */
   
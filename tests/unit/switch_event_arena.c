@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#ifdef BENCHMARK
+#define CYCLES 100000
+#else
+#define CYCLES 1000
+#endif
+
+/* a CHANNEL_CREATE sized event: the core headers plus caller profile and presence data columns */
+#define EVENT_HEADERS 80
+#define CONSUMERS 4
+
+static const char *profile_headers[] = {
+  "Unique-ID", "Channel-State", "Channel-Name", "Call-Direction", "Answer-State", "Channel-Presence-ID",
+  "Caller-Caller-ID-Name", "Caller-Caller-ID-Number", "Caller-Destination-Number", "Caller-Context",
+  "Caller-Unique-ID", "Caller-Network-Addr", "Caller-Channel-Created-Time", "Presence-Data-Cols", NULL
+};
+
+static switch_event_t *build_event(int cycle)
+{
+  switch_event_t *event = NULL;
+  char name[64], value[64];
+  int x;
+
+  switch_event_create(&event, SWITCH_EVENT_CHANNEL_CREATE);
+
+  for (x = 0; profile_headers[x]; x++) {
+    switch_event_add_header(event, SWITCH_STACK_BOTTOM, profile_headers[x], "%s-%d", profile_headers[x], cycle);
+  }
+
+  for (; x < EVENT_HEADERS; x++) {
+    switch_snprintf(name, sizeof(name), "PD-variable_presence_col_%d", x);
+    switch_snprintf(value, sizeof(value), "value-%d-%d", cycle, x);
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, name, value);
+  }
+
+  return event;
+}
+
+/* what the dispatcher does with a fired event: every consumer takes a copy and renders it */
+static void deliver(switch_event_t *event)
+{
+  switch_event_t *clone = NULL;
+  char *str = NULL;
+  int y;
+
+  switch_set_flag(event, EF_SEALED);
+
+  for (y = 0; y < CONSUMERS; y++) {
+    switch_event_dup(&clone, event);
+    switch_event_serialize(clone, &str, SWITCH_TRUE);
+    switch_safe_free(str);
+    switch_event_destroy(&clone);
+  }
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_event_t *event = NULL, *clone = NULL;
+  char *before = NULL, *after = NULL, *decoded = NULL;
+  uint64_t requests, system_allocs, requests_after, system_allocs_after;
+  switch_time_t start, duration;
+  int x;
+
+  plan(5);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  event = build_event(0);
+  switch_event_serialize(event, &before, SWITCH_TRUE);
+  switch_set_flag(event, EF_SEALED);
+  switch_event_dup(&clone, event);
+
+  ok(clone->headers == event->headers, "A copy of a sealed event shares its headers");
+
+  switch_event_add_header_string(clone, SWITCH_STACK_BOTTOM, "Channel-State", "CS_EXECUTE");
+  switch_event_del_header(clone, "Unique-ID");
+  switch_event_serialize(event, &after, SWITCH_TRUE);
+
+  ok(!strcmp(before, after) && !switch_event_get_header(clone, "Unique-ID"), "Changing the copy leaves the original alone");
+
+  switch_safe_free(before);
+  switch_safe_free(after);
+  switch_event_destroy(&clone);
+  switch_event_destroy(&event);
+
+  /* what the erlang encoders do with an url encoded value: decode their own copy, never the shared header */
+  event = build_event(0);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Caller-Caller-ID-Name", "John%20Doe");
+  switch_set_flag(event, EF_SEALED);
+  switch_event_dup(&clone, event);
+  decoded = strdup(switch_event_get_header(clone, "Caller-Caller-ID-Name"));
+  switch_url_decode(decoded);
+  switch_event_add_header_string(clone, SWITCH_STACK_BOTTOM, "Caller-Caller-ID-Name", decoded);
+
+  ok(!strcmp(switch_event_get_header(event, "Caller-Caller-ID-Name"), "John%20Doe") &&
+     !strcmp(switch_event_get_header(clone, "Caller-Caller-ID-Name"), "John Doe"),
+     "Decoding a header of a copy leaves the value the original shares alone");
+
+  switch_safe_free(decoded);
+  switch_event_destroy(&clone);
+  switch_event_destroy(&event);
+
+  /* warm up so the pages the benchmark needs are already carved */
+  event = build_event(0);
+  deliver(event);
+  switch_event_destroy(&event);
+
+  switch_slab_get_totals(&requests, &system_allocs);
+  start = switch_time_now();
+
+  for (x = 0; x < CYCLES; x++) {
+    event = build_event(x);
+    deliver(event);
+    switch_event_destroy(&event);
+  }
+
+  duration = switch_time_now() - start;
+  switch_slab_get_totals(&requests_after, &system_allocs_after);
+
+  requests = requests_after - requests;
+  system_allocs = system_allocs_after - system_allocs;
+
+  ok(requests < (uint64_t) CYCLES * EVENT_HEADERS, "Building and copying an event takes fewer allocations than it has headers");
+
+  note("%d create/dup x%d/serialize/destroy cycles of a %d header event in %ldus, %.1f us per cycle, %.1f slab allocations per cycle\n",
+       CYCLES, CONSUMERS, EVENT_HEADERS, (long) duration, (double) duration / CYCLES, (double) requests / CYCLES);
+
+  switch_core_destroy();
+
+  done_testing();
+}
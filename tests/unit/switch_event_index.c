@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#ifdef BENCHMARK
+#define ROUNDS 200
+#else
+#define ROUNDS 5
+#endif
+
+/* what a dialplan does with the channel variables of a long call: read most of them, overwrite a few */
+static switch_time_t get_set(switch_event_t *vars, int count)
+{
+  char name[64], value[64];
+  switch_time_t start = switch_time_now();
+  int x, y;
+
+  for (y = 0; y < ROUNDS; y++) {
+    for (x = 0; x < count; x++) {
+      switch_snprintf(name, sizeof(name), "variable_%d", (x * 7) % count);
+      switch_event_get_header(vars, name);
+
+      if (!(x % 4)) {
+        switch_snprintf(value, sizeof(value), "value-%d-%d", y, x);
+        switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, name, value);
+      }
+    }
+  }
+
+  return switch_time_now() - start;
+}
+
+static switch_event_t *build_vars(int count, switch_bool_t indexed)
+{
+  switch_event_t *vars = NULL;
+  char name[64], value[64];
+  int x;
+
+  switch_event_create_plain(&vars, SWITCH_EVENT_CHANNEL_DATA);
+
+  if (indexed) {
+    switch_event_index_headers(vars);
+  }
+
+  for (x = 0; x < count; x++) {
+    switch_snprintf(name, sizeof(name), "variable_%d", x);
+    switch_snprintf(value, sizeof(value), "value-%d", x);
+    switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, name, value);
+  }
+
+  return vars;
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_event_t *plain = NULL, *indexed = NULL;
+  char *a = NULL, *b = NULL;
+  int counts[] = { 50, 300, 1000 };
+  switch_time_t plain_us, indexed_us;
+  int x;
+
+  plan(3);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  /* the same changes on an indexed and a plain event have to leave the same headers in the same order */
+  plain = build_vars(300, SWITCH_FALSE);
+  indexed = build_vars(300, SWITCH_TRUE);
+
+  for (x = 0; x < 2; x++) {
+    switch_event_t *vars = x ? indexed : plain;
+
+    get_set(vars, 300);
+    switch_event_add_header_string(vars, SWITCH_STACK_TOP, "variable_10", "top");
+    switch_event_add_header_string(vars, SWITCH_STACK_PUSH, "variable_20", "pushed");
+    switch_event_del_header(vars, "variable_30");
+    switch_event_rename_header(vars, "variable_40", "VARIABLE_50");
+    switch_event_del_header(vars, "variable_50");
+  }
+
+  switch_event_serialize(plain, &a, SWITCH_FALSE);
+  switch_event_serialize(indexed, &b, SWITCH_FALSE);
+
+  ok(!strcmp(a, b), "An indexed event keeps the headers and their order");
+  ok(switch_event_get_header(indexed, "variable_10") && !strcmp(switch_event_get_header(indexed, "VARIABLE_10"), "top"),
+     "Lookups through the index stay case insensitive");
+
+  switch_safe_free(a);
+  switch_safe_free(b);
+  switch_event_destroy(&plain);
+  switch_event_destroy(&indexed);
+
+  for (x = 0; x < 3; x++) {
+    plain = build_vars(counts[x], SWITCH_FALSE);
+    indexed = build_vars(counts[x], SWITCH_TRUE);
+
+    plain_us = get_set(plain, counts[x]);
+    indexed_us = get_set(indexed, counts[x]);
+
+    note("%4d variables: %d gets and %d sets in %ldus plain, %ldus indexed\n",
+         counts[x], ROUNDS * counts[x], ROUNDS * ((counts[x] + 3) / 4), (long) plain_us, (long) indexed_us);
+
+    switch_event_destroy(&plain);
+    switch_event_destroy(&indexed);
+  }
+
+  switch_core_destroy();
+
+  done_testing();
+}
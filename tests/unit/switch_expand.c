@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#ifdef BENCHMARK
+#define ROUNDS 500000
+#else
+#define ROUNDS 1000
+#endif
+
+static const char *dial_string = "{origination_caller_id_number=${caller_id_number},sip_h_X-Account=${account_code}}"
+  "sofia/gateway/${gateway}/${destination_number:1}@${domain_name}";
+static char plain[] = "no variables here";
+
+/* nested, escaped, global and api forms, each has to come out of the template the way the old parser writes it */
+static const char *parity[] = {
+  "${gate${suffix}}@${domain_name}",
+  "cost \\$5 and \\${gateway}",
+  "$${expand_test_global}/${gateway}",
+  "${expand_test_no_such_api(some args)}|${gateway}",
+  "${destination_number:1:3}-${caller_id_number:-4}",
+  "it\\'s ${account_code}",
+  "${${inner}} [${no_such_var}] [$${expand_test_no_such_global}]"
+};
+
+#define PARITY_COUNT (int) (sizeof(parity) / sizeof(parity[0]))
+/* longer than any string the template cache takes, so the input goes through the old parser */
+#define PARITY_PAD 4096
+
+static char *expand_old(switch_event_t *vars, const char *in)
+{
+  size_t len = strlen(in);
+  char *padded = malloc(len + PARITY_PAD + 1), *out, *r;
+
+  memcpy(padded, in, len);
+  memset(padded + len, 'x', PARITY_PAD);
+  padded[len + PARITY_PAD] = '\0';
+
+  out = switch_event_expand_headers(vars, padded);
+  len = strlen(out);
+  r = len >= PARITY_PAD ? strndup(out, len - PARITY_PAD) : strdup("");
+
+  if (out != padded) free(out);
+  free(padded);
+
+  return r;
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_event_t *vars = NULL;
+  switch_expand_template_t *tpl = NULL, *hot = NULL;
+  switch_time_t start;
+  char *a = NULL, *b = NULL;
+  char key[64];
+  int x;
+
+  plan(8 + PARITY_COUNT);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  switch_event_create_plain(&vars, SWITCH_EVENT_CHANNEL_DATA);
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "caller_id_number", "15551234567");
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "account_code", "acct-42");
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "gateway", "carrier1");
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "destination_number", "118005551212");
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "domain_name", "example.com");
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "inner", "gateway");
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "gate", "not this one");
+  switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, "suffix", "way");
+  switch_core_set_variable("expand_test_global", "g1");
+
+  a = switch_event_expand_headers(vars, dial_string);
+  ok(!strcmp(a, "{origination_caller_id_number=15551234567,sip_h_X-Account=acct-42}sofia/gateway/carrier1/18005551212@example.com"),
+     "Variables and offsets are expanded");
+
+  b = switch_event_expand_headers(vars, dial_string);
+  ok(!strcmp(a, b), "The cached template expands to the same string");
+
+  tpl = switch_expand_template_get(dial_string);
+  ok(tpl && tpl->op_count == 10, "The string is cached as literals and variable references");
+  switch_expand_template_release(&tpl);
+
+  if (a != dial_string) free(a);
+  if (b != dial_string) free(b);
+
+  a = switch_event_expand_headers(vars, "\\${gateway} ${${inner}} [${no_such_var}]");
+  ok(!strcmp(a, "${gateway} carrier1 []"), "Escapes, nested names and unset variables expand as before");
+  free(a);
+
+  a = switch_event_expand_headers(vars, plain);
+  ok(a == plain, "A string without variables is returned as is");
+
+  for (x = 0; x < PARITY_COUNT; x++) {
+    a = switch_event_expand_headers(vars, parity[x]);
+    b = expand_old(vars, parity[x]);
+    is(a, b, parity[x]);
+    if (a != parity[x]) free(a);
+    free(b);
+  }
+
+  start = switch_time_now();
+
+  for (x = 0; x < ROUNDS; x++) {
+    a = switch_event_expand_headers(vars, dial_string);
+    free(a);
+  }
+
+  note("%d dial string expansions in %ldus\n", ROUNDS, (long) (switch_time_now() - start));
+
+  switch_event_destroy(&vars);
+
+  /* twice the cache size of one off strings, the string used in between stays cached */
+  hot = switch_expand_template_get("${expand_test_hot}");
+  for (x = 0; x < 8192; x++) {
+    switch_snprintf(key, sizeof(key), "${expand_test_%d}", x);
+    tpl = switch_expand_template_get(key);
+    switch_expand_template_release(&tpl);
+    tpl = switch_expand_template_get("${expand_test_hot}");
+    switch_expand_template_release(&tpl);
+  }
+  tpl = switch_expand_template_get("${expand_test_hot}");
+  ok(hot && tpl == hot, "A template in steady use is not evicted when the cache fills up");
+  switch_expand_template_release(&tpl);
+  switch_expand_template_release(&hot);
+
+  tpl = switch_expand_template_compile("${strftime(%Y)} $${hostname}");
+  ok(tpl && tpl->op_count == 3 && tpl->ops[0].type == SWITCH_EXPAND_API && tpl->ops[2].type == SWITCH_EXPAND_GLOBAL,
+     "Api calls and globals compile to their own ops");
+  switch_expand_template_release(&tpl);
+
+  switch_core_destroy();
+
+  done_testing();
+}
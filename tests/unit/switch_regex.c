@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_regex_t *re = NULL;
+  switch_stream_handle_t stream = { 0 };
+  char substituted[64] = "";
+  int ovector[30];
+  int proceed, x;
+
+  plan(6);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  SWITCH_STANDARD_STREAM(stream);
+  switch_regex_cache_stats(&stream, SWITCH_TRUE);
+  switch_safe_free(stream.data);
+
+  for (x = 0; x < 3; x++) {
+    proceed = switch_regex_perform("18005551212", "^1(\\d{3})(\\d+)$", &re, ovector, sizeof(ovector) / sizeof(ovector[0]));
+    switch_perform_substitution(re, proceed, "$1-$2", "18005551212", substituted, sizeof(substituted), ovector);
+    switch_regex_safe_free(re);
+  }
+
+  ok(proceed == 3 && !strcmp(substituted, "800-5551212"), "A cached pattern still captures");
+  ok(!switch_regex_perform("28005551212", "^1(\\d{3})(\\d+)$", &re, ovector, sizeof(ovector) / sizeof(ovector[0])) && !re,
+     "No regex is handed out when there is no match");
+  ok(switch_regex_match("Alice", "/^alice$/i") == SWITCH_STATUS_SUCCESS, "Flags are part of the cached pattern");
+  ok(switch_regex_match("alice", "^Alice$") == SWITCH_STATUS_FALSE, "The same pattern without flags is a different entry");
+
+  SWITCH_STANDARD_STREAM(stream);
+  switch_regex_cache_stats(&stream, SWITCH_FALSE);
+  ok(strstr((char *) stream.data, "hits: 3\n") != NULL, "Reusing a pattern is a cache hit");
+  note("%s", (char *) stream.data);
+  switch_safe_free(stream.data);
+
+  switch_core_destroy();
+
+  done_testing();
+}
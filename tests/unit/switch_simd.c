@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#define FRAME 160
+#define BUFLEN 65536
+
+#ifdef BENCHMARK
+#define LOOPS 1000000
+#else
+#define LOOPS 10000
+#endif
+
+static int16_t lin[BUFLEN], other[BUFLEN], ref[BUFLEN * 2], out[BUFLEN * 2];
+static int32_t mix_ref[BUFLEN], mix_out[BUFLEN];
+static uint8_t enc_ref[BUFLEN], enc_out[BUFLEN], all_codes[256];
+
+static void fill_random(int16_t *data, uint32_t len)
+{
+  uint32_t x;
+
+  for (x = 0; x < len; x++) {
+    data[x] = (int16_t) (rand() & 0xFFFF);
+  }
+}
+
+/* odd lengths make every variant run its scalar tail as well */
+static void check_level(switch_simd_level_t level)
+{
+  const char *name = switch_simd_level_name(level);
+  uint32_t x, len;
+  int bad;
+
+  for (x = 0; x < BUFLEN; x++) {
+    lin[x] = (int16_t) (x - 32768);
+  }
+
+  for (x = 0; x < 256; x++) {
+    all_codes[x] = (uint8_t) x;
+  }
+
+  switch_simd_set_level(SWITCH_SIMD_NONE);
+  switch_g711u_encode_block(enc_ref, lin, BUFLEN - 3);
+  switch_simd_set_level(level);
+  switch_g711u_encode_block(enc_out, lin, BUFLEN - 3);
+  ok(!memcmp(enc_ref, enc_out, BUFLEN - 3), "%s: ulaw encode matches for every sample value", name);
+
+  switch_simd_set_level(SWITCH_SIMD_NONE);
+  switch_g711a_encode_block(enc_ref, lin, BUFLEN - 3);
+  switch_simd_set_level(level);
+  switch_g711a_encode_block(enc_out, lin, BUFLEN - 3);
+  ok(!memcmp(enc_ref, enc_out, BUFLEN - 3), "%s: alaw encode matches for every sample value", name);
+
+  switch_simd_set_level(SWITCH_SIMD_NONE);
+  switch_g711u_decode_block(ref, all_codes, 256);
+  switch_simd_set_level(level);
+  switch_g711u_decode_block(out, all_codes, 256);
+  ok(!memcmp(ref, out, 256 * 2), "%s: ulaw decode matches for every code", name);
+
+  switch_simd_set_level(SWITCH_SIMD_NONE);
+  switch_g711a_decode_block(ref, all_codes, 256);
+  switch_simd_set_level(level);
+  switch_g711a_decode_block(out, all_codes, 256);
+  ok(!memcmp(ref, out, 256 * 2), "%s: alaw decode matches for every code", name);
+
+  bad = 0;
+  for (x = 0; x < 100; x++) {
+    len = FRAME * 2 + x;
+    fill_random(ref, len * 2);
+    fill_random(other, len);
+    memcpy(out, ref, len * 4);
+
+    switch_simd_set_level(SWITCH_SIMD_NONE);
+    switch_merge_sln(ref, len, other, len, 1);
+    switch_simd_set_level(level);
+    switch_merge_sln(out, len, other, len, 1);
+    bad += !!memcmp(ref, out, len * 2);
+
+    switch_simd_set_level(SWITCH_SIMD_NONE);
+    switch_unmerge_sln(ref, len, other, len, 1);
+    switch_simd_set_level(level);
+    switch_unmerge_sln(out, len, other, len, 1);
+    bad += !!memcmp(ref, out, len * 2);
+
+    switch_simd_set_level(SWITCH_SIMD_NONE);
+    switch_change_sln_volume_granular(ref, len, (int32_t) (x % 27) - 13);
+    switch_simd_set_level(level);
+    switch_change_sln_volume_granular(out, len, (int32_t) (x % 27) - 13);
+    bad += !!memcmp(ref, out, len * 2);
+  }
+  ok(bad == 0, "%s: merge, unmerge and volume match on random audio", name);
+
+  bad = 0;
+  for (x = 0; x < 100; x++) {
+    len = FRAME + x;
+    fill_random(ref, len * 2);
+    memcpy(out, ref, len * 4);
+
+    switch_simd_set_level(SWITCH_SIMD_NONE);
+    switch_mux_channels(ref, len, 2, 1);
+    switch_simd_set_level(level);
+    switch_mux_channels(out, len, 2, 1);
+    bad += !!memcmp(ref, out, len * 2);
+
+    switch_simd_set_level(SWITCH_SIMD_NONE);
+    switch_mux_channels(ref, len, 1, 2);
+    switch_simd_set_level(level);
+    switch_mux_channels(out, len, 1, 2);
+    bad += !!memcmp(ref, out, len * 4);
+  }
+  ok(bad == 0, "%s: stereo downmix and mono upmix match on random audio", name);
+
+  bad = 0;
+  for (x = 0; x < 100; x++) {
+    uint32_t y;
+
+    len = FRAME + x;
+    memset(mix_ref, 0, len * sizeof(int32_t));
+    memset(mix_out, 0, len * sizeof(int32_t));
+
+    for (y = 0; y < 4; y++) {
+      fill_random(other, len);
+      switch_simd_set_level(SWITCH_SIMD_NONE);
+      switch_sln_accumulate(mix_ref, other, len);
+      switch_simd_set_level(level);
+      switch_sln_accumulate(mix_out, other, len);
+    }
+    bad += !!memcmp(mix_ref, mix_out, len * sizeof(int32_t));
+
+    switch_simd_set_level(SWITCH_SIMD_NONE);
+    switch_sln_mix_minus(ref, mix_ref, (x & 1) ? other : NULL, len);
+    switch_simd_set_level(level);
+    switch_sln_mix_minus(out, mix_out, (x & 1) ? other : NULL, len);
+    bad += !!memcmp(ref, out, len * 2);
+  }
+  ok(bad == 0, "%s: conference accumulate and mix-minus match on random audio", name);
+}
+
+static switch_time_t time_level(switch_simd_level_t level, int kernel)
+{
+  switch_time_t start;
+  int x;
+
+  switch_simd_set_level(level);
+  fill_random(other, FRAME);
+  start = switch_time_now();
+
+  for (x = 0; x < LOOPS; x++) {
+    switch (kernel) {
+    case 0:
+      switch_g711u_encode_block(enc_out, lin, FRAME);
+      break;
+    case 1:
+      switch_g711u_decode_block(out, enc_out, FRAME);
+      break;
+    case 2:
+      switch_g711a_encode_block(enc_out, lin, FRAME);
+      break;
+    case 3:
+      switch_g711a_decode_block(out, enc_out, FRAME);
+      break;
+    case 4:
+      switch_merge_sln(out, FRAME, other, FRAME, 1);
+      break;
+    case 5:
+      switch_change_sln_volume_granular(out, FRAME, (x & 1) ? 4 : -4);
+      break;
+    case 6:
+      switch_sln_mix_minus(out, mix_out, other, FRAME);
+      break;
+    default:
+      switch_mux_channels(out, FRAME, 2, 1);
+      break;
+    }
+  }
+
+  return switch_time_now() - start;
+}
+
+static void bench_level(switch_simd_level_t level)
+{
+  static const char *kernels[] = { "ulaw encode", "ulaw decode", "alaw encode", "alaw decode", "merge", "volume", "mix-minus", "downmix" };
+  switch_time_t scalar, vector;
+  int k;
+
+  for (k = 0; k < (int) (sizeof(kernels) / sizeof(kernels[0])); k++) {
+    scalar = time_level(SWITCH_SIMD_NONE, k);
+    vector = time_level(level, k);
+    note("%-12s %d x %d samples: scalar %ldus %s %ldus (%.2fx)\n", kernels[k], LOOPS, FRAME,
+         (long) scalar, switch_simd_level_name(level), (long) vector, vector ? (double) scalar / vector : 0.0);
+  }
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_simd_level_t best, level;
+  int levels = 0;
+
+  best = switch_simd_detect();
+
+  for (level = SWITCH_SIMD_SSE2; level <= SWITCH_SIMD_NEON; level++) {
+    if (level == best || (level == SWITCH_SIMD_SSE2 && best == SWITCH_SIMD_AVX2)) {
+      levels++;
+    }
+  }
+
+  plan(2 + (levels * 7));
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  ok(switch_simd_level() == best, "Core selected the %s kernels", switch_simd_level_name(best));
+
+  for (level = SWITCH_SIMD_SSE2; level <= SWITCH_SIMD_NEON; level++) {
+    if (level == best || (level == SWITCH_SIMD_SSE2 && best == SWITCH_SIMD_AVX2)) {
+      check_level(level);
+      bench_level(level);
+    }
+  }
+
+  switch_simd_set_level(best);
+  switch_core_destroy();
+
+  done_testing();
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#ifdef BENCHMARK
+#define CALLS 100000
+#else
+#define CALLS 1000
+#endif
+
+/* roughly what a channel carries by the time it is answered */
+#define CALL_HEADERS 80
+
+/* the events a call sets up on its way to answer: create, progress, answer, park, each a copy of the channel data */
+static void call_setup(int call)
+{
+  switch_event_t *vars = NULL, *event = NULL;
+  char name[64], value[64];
+  int x, y;
+
+  switch_event_create(&vars, SWITCH_EVENT_CHANNEL_DATA);
+
+  for (x = 0; x < CALL_HEADERS; x++) {
+    switch_snprintf(name, sizeof(name), "variable_setup_header_%d", x);
+    switch_snprintf(value, sizeof(value), "value-%d-%d", call, x);
+    switch_event_add_header_string(vars, SWITCH_STACK_BOTTOM, name, value);
+  }
+
+  for (y = 0; y < 4; y++) {
+    switch_event_dup(&event, vars);
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-State", "CS_EXECUTE");
+    switch_event_destroy(&event);
+  }
+
+  switch_event_destroy(&vars);
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  uint64_t requests, system_allocs, requests_after, system_allocs_after;
+  void *ptrs[64];
+  switch_time_t start, duration;
+  int x, bad = 0;
+
+  plan(5);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  for (x = 0; x < 64; x++) {
+    ptrs[x] = switch_slab_alloc(x * 97 + 1);
+    memset(ptrs[x], x, x * 97 + 1);
+  }
+  for (x = 0; x < 64; x++) {
+    bad += ((uint8_t *) ptrs[x])[x * 97] != (uint8_t) x;
+    switch_slab_free(ptrs[x]);
+  }
+  ok(bad == 0, "Blocks of every size class and beyond hold their data");
+
+  ptrs[0] = switch_slab_alloc(100);
+  switch_slab_free(ptrs[0]);
+  ptrs[1] = switch_slab_alloc(100);
+  ok(ptrs[0] == ptrs[1], "A freed block is handed straight back by the thread cache");
+  switch_slab_free(ptrs[1]);
+
+  /* warm up so the pages the benchmark needs are already carved */
+  call_setup(0);
+
+  switch_slab_get_totals(&requests, &system_allocs);
+  start = switch_time_now();
+
+  for (x = 0; x < CALLS; x++) {
+    call_setup(x);
+  }
+
+  duration = switch_time_now() - start;
+  switch_slab_get_totals(&requests_after, &system_allocs_after);
+
+  requests = requests_after - requests;
+  system_allocs = system_allocs_after - system_allocs;
+
+  ok(requests >= (uint64_t) CALLS * CALL_HEADERS * 5 * 2, "Event structs, headers and names are served by the slab");
+  ok(system_allocs == 0, "Steady state call setup never reaches the system heap for them");
+
+  note("%d calls in %ldus: %.1f allocations per call went to malloc before, %.3f per call reach the system heap now\n",
+       CALLS, (long) duration, (double) requests / CALLS, (double) system_allocs / CALLS);
+
+  switch_core_destroy();
+
+  done_testing();
+}
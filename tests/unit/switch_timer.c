@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <sys/resource.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#define INTERVAL 20
+#define SAMPLES 160
+
+#ifdef BENCHMARK
+#define LOOPS 250
+static int levels[] = { 1000, 5000, 10000 };
+#else
+#define LOOPS 25
+static int levels[] = { 100 };
+#endif
+
+static const char *timer_names[] = { "soft", "wheel" };
+
+typedef struct {
+  switch_timer_t timer;
+  switch_thread_t *thread;
+  int loops;
+  switch_time_t late_total;
+  switch_time_t late_max;
+} timer_worker_t;
+
+static void *SWITCH_THREAD_FUNC timer_worker_run(switch_thread_t *thread, void *obj)
+{
+  timer_worker_t *worker = (timer_worker_t *) obj;
+  switch_time_t first = 0, now, want, late;
+  int x;
+
+  for (x = 0; x < LOOPS; x++) {
+    if (switch_core_timer_next(&worker->timer) != SWITCH_STATUS_SUCCESS) {
+      break;
+    }
+
+    now = switch_time_now();
+
+    if (!first) {
+      first = now;
+      continue;
+    }
+
+    /* lateness against the schedule set by the first tick, so a skipped tick shows up as jitter */
+    want = first + (switch_time_t) x * INTERVAL * 1000;
+    late = now > want ? now - want : want - now;
+    worker->late_total += late;
+    if (late > worker->late_max) {
+      worker->late_max = late;
+    }
+    worker->loops++;
+  }
+
+  return NULL;
+}
+
+static void run_level(const char *timer_name, int count)
+{
+  switch_memory_pool_t *pool = NULL;
+  switch_threadattr_t *thd_attr = NULL;
+  timer_worker_t *workers;
+  switch_time_t start_ts, end_ts, late_total = 0, late_max = 0;
+  switch_stream_handle_t stream = { 0 };
+  int x, timers = 0, threads = 0, completed = 0;
+  uint64_t wakeups = 0;
+  struct rusage ru_start, ru_end;
+  double cpu_usec;
+
+  switch_core_new_memory_pool(&pool);
+  workers = switch_core_alloc(pool, sizeof(*workers) * count);
+
+  for (x = 0; x < count; x++) {
+    if (switch_core_timer_init(&workers[x].timer, timer_name, INTERVAL, SAMPLES, pool) == SWITCH_STATUS_SUCCESS) {
+      timers++;
+    }
+  }
+
+  ok(timers == count, "Created %d/%d %s timers", timers, count, timer_name);
+
+  if (!strcmp(timer_name, "wheel")) {
+    SWITCH_STANDARD_STREAM(stream);
+    switch_time_wheel_stats(&stream, SWITCH_TRUE);
+    switch_safe_free(stream.data);
+  }
+
+  getrusage(RUSAGE_SELF, &ru_start);
+  start_ts = switch_time_now();
+
+  switch_threadattr_create(&thd_attr, pool);
+  switch_threadattr_stacksize_set(thd_attr, 128 * 1024);
+
+  for (x = 0; x < timers; x++) {
+    if (switch_thread_create(&workers[x].thread, thd_attr, timer_worker_run, &workers[x], pool) == SWITCH_STATUS_SUCCESS) {
+      threads++;
+    }
+  }
+
+  for (x = 0; x < threads; x++) {
+    switch_status_t st;
+    switch_thread_join(&st, workers[x].thread);
+    if (workers[x].loops == LOOPS - 1) {
+      completed++;
+    }
+    late_total += workers[x].late_total;
+    wakeups += workers[x].loops;
+    if (workers[x].late_max > late_max) {
+      late_max = workers[x].late_max;
+    }
+  }
+
+  end_ts = switch_time_now();
+  getrusage(RUSAGE_SELF, &ru_end);
+
+  ok(completed == count, "%s: %d/%d sessions completed %d ticks", timer_name, completed, count, LOOPS);
+
+  cpu_usec = (double)(ru_end.ru_utime.tv_sec - ru_start.ru_utime.tv_sec + ru_end.ru_stime.tv_sec - ru_start.ru_stime.tv_sec) * 1000000 +
+    (ru_end.ru_utime.tv_usec - ru_start.ru_utime.tv_usec + ru_end.ru_stime.tv_usec - ru_start.ru_stime.tv_usec);
+
+  note("%s %d timers: %ldms wall, jitter avg %.1fus max %ldus, %.2fus cpu per wakeup, %ld voluntary / %ld involuntary context switches\n",
+       timer_name, count, (long)((end_ts - start_ts) / 1000),
+       wakeups ? (double) late_total / wakeups : 0.0, (long) late_max,
+       wakeups ? cpu_usec / wakeups : 0.0,
+       ru_end.ru_nvcsw - ru_start.ru_nvcsw, ru_end.ru_nivcsw - ru_start.ru_nivcsw);
+
+  if (!strcmp(timer_name, "wheel")) {
+    SWITCH_STANDARD_STREAM(stream);
+    switch_time_wheel_stats(&stream, SWITCH_TRUE);
+    note("%s\n", (char *) stream.data);
+    switch_safe_free(stream.data);
+  }
+
+  for (x = 0; x < timers; x++) {
+    switch_core_timer_destroy(&workers[x].timer);
+  }
+
+  switch_core_destroy_memory_pool(&pool);
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  int levels_count = sizeof(levels) / sizeof(levels[0]);
+  int names_count = sizeof(timer_names) / sizeof(timer_names[0]);
+  int x, y;
+
+  plan(2 + (2 * levels_count * names_count));
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  switch_loadable_module_init(SWITCH_FALSE);
+  status = switch_loadable_module_load_module("", "CORE_SOFTTIMER_MODULE", SWITCH_TRUE, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Load the core timer module\n")) {
+    bail_out(0, "Bail due to failure to load timers[%s]", err);
+  }
+
+  for (x = 0; x < levels_count; x++) {
+    for (y = 0; y < names_count; y++) {
+      run_level(timer_names[y], levels[x]);
+    }
+  }
+
+  switch_core_destroy();
+
+  done_testing();
+}
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#define THREADS 32
+#define USERS 200
+
+#ifdef BENCHMARK
+#define ROUNDS 20000
+#else
+#define ROUNDS 200
+#endif
+
+typedef struct {
+  switch_thread_t *thread;
+  int id;
+  int found;
+  int missed;
+} lookup_worker_t;
+
+static volatile int swapping = 0;
+
+static switch_xml_t build_root(void)
+{
+  switch_stream_handle_t stream = { 0 };
+  int x;
+
+  SWITCH_STANDARD_STREAM(stream);
+  stream.write_function(&stream, "<document type=\"freeswitch/xml\"><section name=\"directory\">"
+                        "<domain name=\"example.com\"><groups><group name=\"default\"><users>");
+  for (x = 0; x < USERS; x++) {
+    stream.write_function(&stream, "<user id=\"%d\" number-alias=\"%d\" ip=\"10.0.0.%d\"><params><param name=\"password\" value=\"%d\"/></params></user>",
+                          1000 + x, 5000 + x, x, x);
+  }
+  stream.write_function(&stream, "</users></group><group name=\"sales\"><users><user id=\"1005\" type=\"pointer\"/></users></group></groups>"
+                        "<user id=\"9999\"/></domain></section></document>");
+
+  /* the root takes the buffer over */
+  return switch_xml_parse_str_dynamic((char *) stream.data, SWITCH_FALSE);
+}
+
+static void *SWITCH_THREAD_FUNC lookup_worker_run(switch_thread_t *thread, void *obj)
+{
+  lookup_worker_t *worker = (lookup_worker_t *) obj;
+  switch_xml_t root, domain, user, group;
+  char id[16];
+  int x;
+
+  for (x = 0; x < ROUNDS; x++) {
+    switch_snprintf(id, sizeof(id), "%d", 1000 + (worker->id * 7 + x) % USERS);
+
+    if (switch_xml_locate_user("id", id, "example.com", NULL, &root, &domain, &user, &group, NULL) == SWITCH_STATUS_SUCCESS) {
+      worker->found++;
+      switch_xml_free(root);
+    } else {
+      worker->missed++;
+    }
+  }
+
+  return NULL;
+}
+
+static switch_time_t run_workers(lookup_worker_t *workers, switch_memory_pool_t *pool, int swap)
+{
+  switch_threadattr_t *thd_attr = NULL;
+  switch_time_t start = switch_time_now();
+  switch_status_t st;
+  int x, running;
+
+  switch_threadattr_create(&thd_attr, pool);
+  switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+  for (x = 0; x < THREADS; x++) {
+    memset(&workers[x], 0, sizeof(workers[x]));
+    workers[x].id = x;
+    switch_thread_create(&workers[x].thread, thd_attr, lookup_worker_run, &workers[x], pool);
+  }
+
+  /* keep replacing the root while the lookups run, the way reloadxml would */
+  while (swap) {
+    running = 0;
+    for (x = 0; x < THREADS; x++) {
+      running += workers[x].found + workers[x].missed < ROUNDS;
+    }
+    if (!running) {
+      break;
+    }
+    switch_xml_set_root(build_root());
+    swapping++;
+    switch_yield(1000);
+  }
+
+  for (x = 0; x < THREADS; x++) {
+    switch_thread_join(&st, workers[x].thread);
+  }
+
+  return switch_time_now() - start;
+}
+
+int main () {
+
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  switch_memory_pool_t *pool = NULL;
+  lookup_worker_t workers[THREADS];
+  switch_xml_t root, domain, user, group, walked, walked_domain;
+  switch_time_t elapsed;
+  char id[16];
+  int x, found, missed, same;
+
+  plan(10);
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  switch_core_new_memory_pool(&pool);
+
+  ok(switch_xml_set_root(build_root()) == SWITCH_STATUS_SUCCESS, "Install a directory root");
+
+  ok(switch_xml_locate_user("id", "5003", "example.com", NULL, &root, &domain, &user, &group, NULL) == SWITCH_STATUS_SUCCESS &&
+     !strcmp(switch_xml_attr_soft(user, "id"), "1003") && !strcmp(switch_xml_attr_soft(group, "name"), "default"),
+     "A number-alias finds its user and group");
+  switch_xml_free(root);
+
+  ok(switch_xml_locate_user("id", NULL, "example.com", "10.0.0.7", &root, &domain, &user, &group, NULL) == SWITCH_STATUS_SUCCESS &&
+     !strcmp(switch_xml_attr_soft(user, "id"), "1007"), "An ip finds its user");
+  switch_xml_free(root);
+
+  ok(switch_xml_locate_user("id", "9999", "example.com", NULL, &root, &domain, &user, &group, NULL) == SWITCH_STATUS_SUCCESS &&
+     !group && switch_xml_locate_user_in_domain("9999", domain, &user, &group) != SWITCH_STATUS_SUCCESS,
+     "Users outside the groups are only found by switch_xml_locate_user()");
+  switch_xml_free(root);
+
+  ok(switch_xml_locate_user("id", "4242", "example.com", NULL, &root, &domain, &user, &group, NULL) != SWITCH_STATUS_SUCCESS && !root,
+     "An unknown user is not found");
+
+  /* a root that was never installed has no index, so it shows what walking the domain finds */
+  walked = build_root();
+  walked_domain = switch_xml_find_child(switch_xml_find_child(walked, "section", "name", "directory"), "domain", "name", "example.com");
+  root = switch_xml_root();
+  domain = switch_xml_find_child(switch_xml_find_child(root, "section", "name", "directory"), "domain", "name", "example.com");
+  for (same = x = 0; x < USERS + 10; x++) {
+    switch_xml_t a = NULL, b = NULL, ga = NULL, gb = NULL;
+
+    switch_snprintf(id, sizeof(id), "%d", (x % 2 ? 1000 : 5000) + x);
+    switch_xml_locate_user_in_domain(id, walked_domain, &a, &ga);
+    switch_xml_locate_user_in_domain(id, domain, &b, &gb);
+    same += !strcmp(switch_str_nil(switch_xml_attr(a, "id")), switch_str_nil(switch_xml_attr(b, "id"))) &&
+      !strcmp(switch_str_nil(switch_xml_attr(ga, "name")), switch_str_nil(switch_xml_attr(gb, "name")));
+  }
+  ok(same == USERS + 10, "The index finds the same users as walking the domain");
+  switch_xml_free(root);
+  switch_xml_free(walked);
+
+  elapsed = run_workers(workers, pool, 0);
+  for (found = missed = x = 0; x < THREADS; x++) {
+    found += workers[x].found;
+    missed += workers[x].missed;
+  }
+  ok(found == THREADS * ROUNDS && !missed, "%d threads find every user", THREADS);
+  note("%d lookups on %d threads in %ldus\n", found, THREADS, (long) elapsed);
+
+  elapsed = run_workers(workers, pool, 1);
+  for (found = missed = x = 0; x < THREADS; x++) {
+    found += workers[x].found;
+    missed += workers[x].missed;
+  }
+  ok(found == THREADS * ROUNDS && !missed, "Lookups keep finding users while the root is replaced");
+  note("%d lookups on %d threads across %d root swaps in %ldus\n", found, THREADS, swapping, (long) elapsed);
+
+  root = switch_xml_root();
+  ok(root && switch_atomic_read(&root->refs) == 2, "Every lookup gave its reference on the root back");
+  switch_xml_free(root);
+
+  switch_core_destroy_memory_pool(&pool);
+  switch_core_destroy();
+
+  done_testing();
+}
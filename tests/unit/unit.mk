@@ -15,3 +15,80 @@ tests_unit_switch_hash_CFLAGS = $(SWITCH_AM_CFLAGS)
 tests_unit_switch_hash_LDADD = $(FSLD)
 tests_unit_switch_hash_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
 
+
+check_PROGRAMS += tests/unit/switch_timer
+
+tests_unit_switch_timer_SOURCES = tests/unit/switch_timer.c
+tests_unit_switch_timer_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_timer_LDADD = $(FSLD)
+tests_unit_switch_timer_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_simd
+
+tests_unit_switch_simd_SOURCES = tests/unit/switch_simd.c
+tests_unit_switch_simd_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_simd_LDADD = $(FSLD)
+tests_unit_switch_simd_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_buffer
+
+tests_unit_switch_buffer_SOURCES = tests/unit/switch_buffer.c
+tests_unit_switch_buffer_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_buffer_LDADD = $(FSLD)
+tests_unit_switch_buffer_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_slab
+
+tests_unit_switch_slab_SOURCES = tests/unit/switch_slab.c
+tests_unit_switch_slab_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_slab_LDADD = $(FSLD)
+tests_unit_switch_slab_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_event_arena
+
+tests_unit_switch_event_arena_SOURCES = tests/unit/switch_event_arena.c
+tests_unit_switch_event_arena_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_event_arena_LDADD = $(FSLD)
+tests_unit_switch_event_arena_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_event_index
+
+tests_unit_switch_event_index_SOURCES = tests/unit/switch_event_index.c
+tests_unit_switch_event_index_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_event_index_LDADD = $(FSLD)
+tests_unit_switch_event_index_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_expand
+
+tests_unit_switch_expand_SOURCES = tests/unit/switch_expand.c
+tests_unit_switch_expand_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_expand_LDADD = $(FSLD)
+tests_unit_switch_expand_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_regex
+
+tests_unit_switch_regex_SOURCES = tests/unit/switch_regex.c
+tests_unit_switch_regex_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_regex_LDADD = $(FSLD)
+tests_unit_switch_regex_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_xml
+
+tests_unit_switch_xml_SOURCES = tests/unit/switch_xml.c
+tests_unit_switch_xml_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_xml_LDADD = $(FSLD)
+tests_unit_switch_xml_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_call_registry
+
+tests_unit_switch_call_registry_SOURCES = tests/unit/switch_call_registry.c
+tests_unit_switch_call_registry_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_call_registry_LDADD = $(FSLD)
+tests_unit_switch_call_registry_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/sofia_reg_store
+
+tests_unit_sofia_reg_store_SOURCES = tests/unit/sofia_reg_store.c src/mod/endpoints/mod_sofia/sofia_reg_store.c
+tests_unit_sofia_reg_store_CFLAGS = $(SWITCH_AM_CFLAGS) -I$(switch_srcdir)/src/mod/endpoints/mod_sofia
+tests_unit_sofia_reg_store_LDADD = $(FSLD)
+tests_unit_sofia_reg_store_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap